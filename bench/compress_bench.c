@@ -0,0 +1,233 @@
+// ============================================================================
+// compress_bench.c - Bytes saved and CPU cost of per-connection compression
+// ============================================================================
+//
+// Feeds representative server responses (friend list tables, offline message
+// dumps, notifications, short acks) through one Compressor/Decompressor pair,
+// the same way a single negotiated connection would, and reports wire bytes
+// saved and nanoseconds spent per message on each side.
+
+#include "../common/compress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS 2000
+#define BENCH_VARIANTS 64
+
+// Each case cycles through BENCH_VARIANTS distinct payloads so the deflate
+// window sees realistic similarity between frames rather than exact repeats.
+typedef char* (*PayloadBuilder)(int size, int seed);
+
+typedef struct {
+    const char *name;
+    PayloadBuilder build;
+    int size;
+} BenchCase;
+
+/**
+ * @function now_ns: Monotonic clock in nanoseconds.
+ * 
+ * @return Current monotonic time in nanoseconds.
+ */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @function make_friend_list: Build a FRIEND_LIST response like handle_friend_list.
+ * 
+ * @param rows Number of friends in the table.
+ * @param seed Variant selector for usernames and online states.
+ * 
+ * @return Dynamically allocated response string.
+ */
+static char* make_friend_list(int rows, int seed) {
+    char body[BUFFER_SIZE];
+    int offset = 0;
+    
+    offset += snprintf(body + offset, sizeof(body) - offset,
+                      "\n+-----+----------------------+------------+\n"
+                      "| STT | Username             | Status     |\n"
+                      "+-----+----------------------+------------+\n");
+    for (int i = 0; i < rows && offset < (int)sizeof(body) - 200; i++) {
+        char username[32];
+        snprintf(username, sizeof(username), "user_%04d", (i + seed * 131) * 7919 % 10000);
+        offset += snprintf(body + offset, sizeof(body) - offset,
+                          "| %-3d | %-20s | %-10s |\n",
+                          i + 1, username, ((i + seed) % 3 == 0) ? "Online" : "Offline");
+    }
+    offset += snprintf(body + offset, sizeof(body) - offset,
+                      "+-----+----------------------+------------+\n"
+                      "Total: %d friend(s)", rows);
+    
+    return build_response(STATUS_FRIEND_LIST_OK, body);
+}
+
+/**
+ * @function make_offline_dump: Build an offline message dump like handle_get_offline_messages.
+ * 
+ * @param count Number of messages in the dump.
+ * @param seed Variant selector for sender, timestamps and text.
+ * 
+ * @return Dynamically allocated response string.
+ */
+static char* make_offline_dump(int count, int seed) {
+    static const char *phrases[] = {
+        "hey are you around later today?",
+        "sure, ping me when you are back",
+        "did you see the new assignment for network programming",
+        "meeting moved to 3pm in room B1-204",
+        "ok thanks!",
+    };
+    char body[BUFFER_SIZE];
+    int offset = 0;
+    
+    offset += snprintf(body + offset, sizeof(body) - offset,
+                      "\n=== SHOW OFFLINE MESSAGES FROM user_%04d ===\n", seed * 37);
+    for (int i = 0; i < count && offset < (int)sizeof(body) - 500; i++) {
+        offset += snprintf(body + offset, sizeof(body) - offset,
+                          "[2025-12-%02d %02d:%02d:%02d.%06d] %s (#%d)\n",
+                          1 + seed % 28, seed % 24, i % 60, (i * 13 + seed) % 60,
+                          (i + seed) * 7411 % 1000000, phrases[(i + seed) % 5], i * seed);
+    }
+    offset += snprintf(body + offset, sizeof(body) - offset,
+                      "=== END OF OFFLINE MESSAGES (%d total) ===", count);
+    
+    return build_response(STATUS_GET_OFFLINE_MSG_OK, body);
+}
+
+/**
+ * @function make_notification: Build a pending group invite notification.
+ * 
+ * @param size Unused.
+ * @param seed Variant selector for group and sender.
+ * 
+ * @return Dynamically allocated response string.
+ */
+static char* make_notification(int size, int seed) {
+    (void)size;
+    char body[512];
+    snprintf(body, sizeof(body),
+            "OFFLINE_NOTIFICATION type=\"GROUP_INVITE\" group_id=%d sender=\"user_%04d\" "
+            "message=\"You have been added to group 'group_%d' by user_%04d\" "
+            "time=\"2025-12-19 10:30:%02d.%06d\"",
+            seed, seed * 37, seed, seed * 37, seed % 60, seed * 7411);
+    return build_response(STATUS_OFFLINE_NOTIFICATION, body);
+}
+
+/**
+ * @function make_short_ack: Build a short success acknowledgement.
+ * 
+ * @param size Unused.
+ * @param seed Unused.
+ * 
+ * @return Dynamically allocated response string.
+ */
+static char* make_short_ack(int size, int seed) {
+    (void)size;
+    (void)seed;
+    return build_response(STATUS_MSG_OK, "OK - Message sent successfully (delivered)");
+}
+
+/**
+ * @function run_case: Push one case through a fresh connection BENCH_ROUNDS times.
+ * 
+ * @param bench Benchmark case to run.
+ * 
+ * @return 0 on success, -1 on a round-trip mismatch.
+ */
+static int run_case(const BenchCase *bench) {
+    Compressor *comp = compressor_create(COMPRESSION_DEFAULT_THRESHOLD);
+    Decompressor *decomp = decompressor_create();
+    StreamBuffer *wire = stream_buffer_create();
+    StreamBuffer *plain = stream_buffer_create();
+    if (!comp || !decomp || !wire || !plain) return -1;
+    
+    char *payloads[BENCH_VARIANTS];
+    for (int v = 0; v < BENCH_VARIANTS; v++) {
+        payloads[v] = bench->build(bench->size, v + 1);
+    }
+    
+    unsigned long raw_bytes = 0, wire_bytes = 0;
+    double encode_ns = 0, decode_ns = 0;
+    int failed = 0;
+    
+    for (int i = 0; i < BENCH_ROUNDS && !failed; i++) {
+        const char *payload = payloads[i % BENCH_VARIANTS];
+        size_t len = strlen(payload);
+        size_t frame_len = 0;
+        
+        double t0 = now_ns();
+        char *frame = compressor_encode(comp, payload, len, &frame_len);
+        double t1 = now_ns();
+        
+        const char *out = frame ? frame : payload;
+        size_t out_len = frame ? frame_len : len;
+        
+        double t2 = now_ns();
+        if (!stream_buffer_append(wire, out, out_len) ||
+            decompressor_decode(decomp, wire, plain) < 0) {
+            fprintf(stderr, "%s: decode failed at round %d\n", bench->name, i);
+            failed = 1;
+        }
+        double t3 = now_ns();
+        
+        if (!failed && (plain->length != len || memcmp(plain->data, payload, len) != 0)) {
+            fprintf(stderr, "%s: round-trip mismatch at round %d\n", bench->name, i);
+            failed = 1;
+        }
+        plain->length = 0;
+        
+        raw_bytes += len;
+        wire_bytes += out_len;
+        encode_ns += t1 - t0;
+        decode_ns += t3 - t2;
+        free(frame);
+    }
+    
+    if (!failed) {
+        printf("%-18s %8.0f %8.0f %8.1f%% %12.0f %12.0f\n",
+               bench->name,
+               (double)raw_bytes / BENCH_ROUNDS,
+               (double)wire_bytes / BENCH_ROUNDS,
+               100.0 * (1.0 - (double)wire_bytes / (double)raw_bytes),
+               encode_ns / BENCH_ROUNDS, decode_ns / BENCH_ROUNDS);
+    }
+    
+    for (int v = 0; v < BENCH_VARIANTS; v++) {
+        free(payloads[v]);
+    }
+    stream_buffer_destroy(plain);
+    stream_buffer_destroy(wire);
+    decompressor_destroy(decomp);
+    compressor_destroy(comp);
+    return failed ? -1 : 0;
+}
+
+int main(void) {
+    BenchCase cases[] = {
+        { "friend_list_10",  make_friend_list,  10 },
+        { "friend_list_80",  make_friend_list,  80 },
+        { "offline_dump_5",  make_offline_dump,  5 },
+        { "offline_dump_40", make_offline_dump, 40 },
+        { "notification",    make_notification,  0 },
+        { "short_ack",       make_short_ack,     0 },
+    };
+    int num_cases = sizeof(cases) / sizeof(cases[0]);
+    int failed = 0;
+    
+    printf("threshold=%d level=%d rounds=%d variants=%d (one connection per case)\n",
+           COMPRESSION_DEFAULT_THRESHOLD, COMPRESSION_LEVEL, BENCH_ROUNDS, BENCH_VARIANTS);
+    printf("%-18s %8s %8s %9s %12s %12s\n",
+           "case", "raw_B", "wire_B", "saved", "deflate_ns", "inflate_ns");
+    
+    for (int i = 0; i < num_cases; i++) {
+        if (run_case(&cases[i]) < 0) failed = 1;
+    }
+    
+    return failed;
+}
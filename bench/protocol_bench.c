@@ -0,0 +1,404 @@
+// ============================================================================
+// protocol_bench.c - Microbenchmarks for the protocol.c hot path
+// ============================================================================
+//
+// Covers the functions every byte goes through: stream_buffer_append,
+// stream_buffer_extract_message, parse_protocol_message and build_response.
+// Each case is calibrated to run for at least BENCH_MIN_NS and prints one
+// JSON line:
+//
+//   {"bench":"parse_MSG","iterations":...,"ns_per_op":...,"allocs_per_op":...,"bytes_per_op":...}
+//
+// Allocations are counted by linking with -Wl,--wrap=malloc,... (see the
+// Makefile bench target), so only calls made by protocol.c and this file are
+// counted, which is exactly what a parser or buffer rewrite changes.
+
+#include "../common/protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#define BENCH_MIN_NS 200000000ULL
+#define BENCH_START_ITERATIONS 1000
+#define BENCH_PIPELINE_DEPTH 32
+
+// ============================================================================
+// Allocation Counting (--wrap)
+// ============================================================================
+
+static unsigned long alloc_count = 0;
+static unsigned long alloc_bytes = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+char *__real_strdup(const char *s);
+
+void *__wrap_malloc(size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    alloc_count++;
+    alloc_bytes += count * size;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+char *__wrap_strdup(const char *s) {
+    alloc_count++;
+    alloc_bytes += strlen(s) + 1;
+    return __real_strdup(s);
+}
+
+// ============================================================================
+// Harness
+// ============================================================================
+
+// One benchmark body: performs `iterations` operations on `state`
+typedef void (*BenchBody)(void *state, unsigned long iterations);
+
+// Keeps results observable so the optimizer cannot drop the work
+static volatile unsigned long sink = 0;
+
+/**
+ * @function now_ns: Monotonic clock in nanoseconds.
+ *
+ * @return Current monotonic time in nanoseconds.
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @function run_bench: Calibrate, run and report one benchmark.
+ *
+ * The iteration count doubles until a run lasts BENCH_MIN_NS; the last run
+ * is the one reported.
+ *
+ * @param name Benchmark name.
+ * @param body Benchmark body.
+ * @param state Opaque state passed to the body.
+ *
+ * @return void
+ */
+static void run_bench(const char *name, BenchBody body, void *state) {
+    unsigned long iterations = BENCH_START_ITERATIONS;
+    uint64_t elapsed;
+    unsigned long allocs, bytes;
+
+    body(state, 1);  // Warm caches and lazily initialized libc state
+
+    for (;;) {
+        alloc_count = 0;
+        alloc_bytes = 0;
+        uint64_t start = now_ns();
+        body(state, iterations);
+        elapsed = now_ns() - start;
+        allocs = alloc_count;
+        bytes = alloc_bytes;
+
+        if (elapsed >= BENCH_MIN_NS || iterations >= (1UL << 30)) break;
+        iterations *= 2;
+    }
+
+    printf("{\"bench\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.1f,"
+           "\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f}\n",
+           name, iterations, (double)elapsed / (double)iterations,
+           (double)allocs / (double)iterations, (double)bytes / (double)iterations);
+    fflush(stdout);
+}
+
+// ============================================================================
+// Stream Buffer Cases
+// ============================================================================
+
+typedef struct {
+    const char *wire;       // One or more delimited messages
+    size_t wire_len;
+    size_t chunk;           // Bytes per append (0 = whole wire at once)
+} StreamCase;
+
+/**
+ * @function bench_stream: Feed wire bytes in chunks and extract every message.
+ *
+ * One operation is one message delivered, so fragmented and pipelined cases
+ * are directly comparable with the single-message case.
+ *
+ * @param state Pointer to a StreamCase.
+ * @param iterations Number of messages to deliver.
+ *
+ * @return void
+ */
+static void bench_stream(void *state, unsigned long iterations) {
+    const StreamCase *c = (const StreamCase*)state;
+    StreamBuffer *buffer = stream_buffer_create();
+    size_t chunk = c->chunk ? c->chunk : c->wire_len;
+    unsigned long delivered = 0;
+
+    while (delivered < iterations) {
+        for (size_t offset = 0; offset < c->wire_len; offset += chunk) {
+            size_t len = c->wire_len - offset < chunk ? c->wire_len - offset : chunk;
+            stream_buffer_append(buffer, c->wire + offset, len);
+
+            char *message;
+            while ((message = stream_buffer_extract_message(buffer)) != NULL) {
+                sink += (unsigned char)message[0];
+                free(message);
+                delivered++;
+            }
+        }
+    }
+
+    stream_buffer_destroy(buffer);
+}
+
+// ============================================================================
+// Parser Cases
+// ============================================================================
+
+/**
+ * @function bench_parse: Parse one command line repeatedly.
+ *
+ * @param state Command line without delimiter.
+ * @param iterations Number of parses.
+ *
+ * @return void
+ */
+static void bench_parse(void *state, unsigned long iterations) {
+    const char *line = (const char*)state;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        ParsedCommand *cmd = parse_protocol_message(line);
+        if (cmd) {
+            sink += (unsigned long)cmd->cmd_type + (unsigned long)cmd->param_count;
+            free_parsed_command(cmd);
+        }
+    }
+}
+
+/**
+ * @function bench_receive_path: Append, extract and parse, as server_handle_client_message sees it.
+ *
+ * @param state Pointer to a StreamCase.
+ * @param iterations Number of commands handled.
+ *
+ * @return void
+ */
+static void bench_receive_path(void *state, unsigned long iterations) {
+    const StreamCase *c = (const StreamCase*)state;
+    StreamBuffer *buffer = stream_buffer_create();
+    size_t chunk = c->chunk ? c->chunk : c->wire_len;
+    unsigned long handled = 0;
+
+    while (handled < iterations) {
+        for (size_t offset = 0; offset < c->wire_len; offset += chunk) {
+            size_t len = c->wire_len - offset < chunk ? c->wire_len - offset : chunk;
+            stream_buffer_append(buffer, c->wire + offset, len);
+
+            char *message;
+            while ((message = stream_buffer_extract_message(buffer)) != NULL) {
+                ParsedCommand *cmd = parse_protocol_message(message);
+                if (cmd) {
+                    sink += (unsigned long)cmd->cmd_type;
+                    free_parsed_command(cmd);
+                }
+                free(message);
+                handled++;
+            }
+        }
+    }
+
+    stream_buffer_destroy(buffer);
+}
+
+// ============================================================================
+// Response Builder Cases
+// ============================================================================
+
+typedef struct {
+    int status;
+    const char *message;
+    int large;              // Use build_large_response
+} BuildCase;
+
+/**
+ * @function bench_build: Build and free one response repeatedly.
+ *
+ * @param state Pointer to a BuildCase.
+ * @param iterations Number of responses built.
+ *
+ * @return void
+ */
+static void bench_build(void *state, unsigned long iterations) {
+    const BuildCase *c = (const BuildCase*)state;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        char *response = c->large ? build_large_response(c->status, c->message)
+                                  : build_response(c->status, c->message);
+        if (response) {
+            sink += (unsigned char)response[0];
+            free(response);
+        }
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+/**
+ * @function make_text: Build a printable payload of a given length.
+ *
+ * @param len Payload length in bytes.
+ *
+ * @return Dynamically allocated NUL-terminated payload.
+ */
+static char* make_text(size_t len) {
+    static const char words[] = "the quick brown fox jumps over the lazy dog ";
+    char *text = (char*)malloc(len + 1);
+    if (!text) return NULL;
+
+    for (size_t i = 0; i < len; i++) {
+        text[i] = words[i % (sizeof(words) - 1)];
+    }
+    text[len] = '\0';
+    return text;
+}
+
+/**
+ * @function make_wire: Concatenate a command line `count` times with delimiters.
+ *
+ * @param line Command line without delimiter.
+ * @param count Number of copies.
+ * @param out_len Output: wire length.
+ *
+ * @return Dynamically allocated wire bytes.
+ */
+static char* make_wire(const char *line, int count, size_t *out_len) {
+    size_t one = strlen(line) + strlen(PROTOCOL_DELIMITER);
+    char *wire = (char*)malloc(one * (size_t)count + 1);
+    if (!wire) return NULL;
+
+    size_t offset = 0;
+    for (int i = 0; i < count; i++) {
+        offset += (size_t)sprintf(wire + offset, "%s%s", line, PROTOCOL_DELIMITER);
+    }
+    *out_len = offset;
+    return wire;
+}
+
+int main(void) {
+    static const char *verbs[][2] = {
+        { "REGISTER",               "REGISTER alice_01 s3cretpass" },
+        { "LOGIN",                  "LOGIN alice_01 s3cretpass" },
+        { "LOGOUT",                 "LOGOUT" },
+        { "FRIEND_REQ",             "FRIEND_REQ bob_02" },
+        { "FRIEND_ACCEPT",          "FRIEND_ACCEPT bob_02" },
+        { "FRIEND_DECLINE",         "FRIEND_DECLINE bob_02" },
+        { "FRIEND_REMOVE",          "FRIEND_REMOVE bob_02" },
+        { "FRIEND_LIST",            "FRIEND_LIST" },
+        { "FRIEND_PENDING",         "FRIEND_PENDING" },
+        { "MSG",                    "MSG bob_02 hey, are you around later today?" },
+        { "GROUP_CREATE",           "GROUP_CREATE study_group" },
+        { "GROUP_INVITE",           "GROUP_INVITE study_group bob_02" },
+        { "GROUP_JOIN",             "GROUP_JOIN study_group" },
+        { "GROUP_LEAVE",            "GROUP_LEAVE study_group" },
+        { "GROUP_KICK",             "GROUP_KICK study_group bob_02" },
+        { "GROUP_MSG",              "GROUP_MSG study_group meeting moved to 3pm in room B1-204" },
+        { "GROUP_SEND_OFFLINE_MSG", "GROUP_SEND_OFFLINE_MSG study_group" },
+        { "GROUP_EXIT_MESSAGING",   "GROUP_EXIT_MESSAGING study_group" },
+        { "GROUP_APPROVE",          "GROUP_APPROVE study_group bob_02" },
+        { "GROUP_REJECT",           "GROUP_REJECT study_group bob_02" },
+        { "LIST_JOIN_REQUESTS",     "LIST_JOIN_REQUESTS study_group" },
+        { "SEND_OFFLINE_MSG",       "SEND_OFFLINE_MSG bob_02" },
+        { "GET_OFFLINE_MSG",        "GET_OFFLINE_MSG bob_02 1024" },
+        { "COMPRESS",               "COMPRESS deflate" },
+        { "UNREAD_SUMMARY",         "UNREAD_SUMMARY" },
+        { "UNKNOWN",                "NOT_A_COMMAND with some args" },
+    };
+    int num_verbs = sizeof(verbs) / sizeof(verbs[0]);
+    char name[96];
+
+    // Typical and maximum-length MSG lines; the longest body that still
+    // fits in ParsedCommand.message after "MSG <user> "
+    const char *short_msg = verbs[9][1];
+    char *max_body = make_text(MAX_MESSAGE_LENGTH - 1);
+    char *max_msg = (char*)malloc(MAX_MESSAGE_LENGTH + 32);
+    if (!max_body || !max_msg) return 1;
+    snprintf(max_msg, MAX_MESSAGE_LENGTH + 32, "MSG bob_02 %s", max_body);
+
+    // Stream buffer: whole, fragmented and pipelined delivery
+    size_t short_len, max_len, burst_len;
+    char *short_wire = make_wire(short_msg, 1, &short_len);
+    char *max_wire = make_wire(max_msg, 1, &max_len);
+    char *burst_wire = make_wire(short_msg, BENCH_PIPELINE_DEPTH, &burst_len);
+    if (!short_wire || !max_wire || !burst_wire) return 1;
+
+    StreamCase stream_cases[] = {
+        { short_wire, short_len, 0 },
+        { short_wire, short_len, 1 },
+        { short_wire, short_len, 7 },
+        { max_wire,   max_len,   0 },
+        { max_wire,   max_len,   1460 },
+        { burst_wire, burst_len, 0 },
+        { burst_wire, burst_len, 1460 },
+    };
+    const char *stream_names[] = {
+        "stream_msg_whole", "stream_msg_frag_1b", "stream_msg_frag_7b",
+        "stream_maxmsg_whole", "stream_maxmsg_frag_1460b",
+        "stream_pipeline_32", "stream_pipeline_32_frag_1460b",
+    };
+    for (size_t i = 0; i < sizeof(stream_cases) / sizeof(stream_cases[0]); i++) {
+        run_bench(stream_names[i], bench_stream, &stream_cases[i]);
+    }
+
+    // Parser: every command verb, plus the maximum-length MSG body
+    for (int i = 0; i < num_verbs; i++) {
+        snprintf(name, sizeof(name), "parse_%s", verbs[i][0]);
+        run_bench(name, bench_parse, (void*)verbs[i][1]);
+    }
+    run_bench("parse_MSG_max", bench_parse, max_msg);
+
+    // Full receive path as the server loop runs it
+    run_bench("receive_msg_whole", bench_receive_path, &stream_cases[0]);
+    run_bench("receive_msg_frag_7b", bench_receive_path, &stream_cases[2]);
+    run_bench("receive_maxmsg_frag_1460b", bench_receive_path, &stream_cases[4]);
+    run_bench("receive_pipeline_32", bench_receive_path, &stream_cases[5]);
+
+    // Response builders
+    char *large_body = make_text(3 * MAX_MESSAGE_LENGTH);
+    if (!large_body) return 1;
+    BuildCase build_cases[] = {
+        { STATUS_MSG_OK, "OK - Message sent successfully (delivered)", 0 },
+        { STATUS_LOGIN_OK, "", 0 },
+        { 201, max_body, 0 },
+        { STATUS_GET_OFFLINE_MSG_OK, large_body, 1 },
+    };
+    const char *build_names[] = {
+        "build_response_ack", "build_response_empty",
+        "build_response_max", "build_large_response_12k",
+    };
+    for (size_t i = 0; i < sizeof(build_cases) / sizeof(build_cases[0]); i++) {
+        run_bench(build_names[i], bench_build, &build_cases[i]);
+    }
+
+    free(large_body);
+    free(short_wire);
+    free(max_wire);
+    free(burst_wire);
+    free(max_msg);
+    free(max_body);
+    return 0;
+}
@@ -90,6 +90,15 @@ void client_cleanup(ClientConn *client) {
         stream_buffer_destroy(client->recv_buffer);
         client->recv_buffer = NULL;
     }
+    if (client->wire_buffer) {
+        stream_buffer_destroy(client->wire_buffer);
+        client->wire_buffer = NULL;
+    }
+    if (client->decompressor) {
+        decompressor_destroy(client->decompressor);
+        client->decompressor = NULL;
+    }
+    friend_cache_clear(&client->friends);
     if (client->sockfd >= 0) {
         close(client->sockfd);
         client->sockfd = -1;
@@ -187,6 +196,99 @@ void send_message(ClientConn *client, const char *message) {
     send(client->sockfd, buff, strlen(buff), 0);
 }
 
+/**
+ * @function client_enable_compression: Negotiate compressed responses with the server.
+ * 
+ * @param client Pointer to ClientConn structure.
+ * 
+ * @return 0 on success, -1 on failure.
+ */
+int client_enable_compression(ClientConn *client) {
+    if (!client || !client->connected) return -1;
+    
+    // Decoder must be ready before the request: compressed frames may follow
+    // the acknowledgement in the same read.
+    client->wire_buffer = stream_buffer_create();
+    client->decompressor = decompressor_create();
+    if (!client->wire_buffer || !client->decompressor) {
+        fprintf(stderr, "Failed to initialize decompression\n");
+        return -1;
+    }
+    
+    char request[64];
+    snprintf(request, sizeof(request), "COMPRESS %s", COMPRESSION_ALGORITHM);
+    send_message(client, request);
+    
+    return handle_server_response(client) > 0 ? 0 : -1;
+}
+
+/**
+ * @function client_recv: Receive at most as many bytes as the stream buffer can take.
+ * 
+ * Bursts such as a notification drain can arrive faster than messages are
+ * extracted; capping the read keeps a partial message plus a full socket
+ * read from overflowing the buffer. Unread bytes simply stay in the socket.
+ * 
+ * @param client Pointer to ClientConn structure.
+ * @param buffer Destination buffer.
+ * @param size Size of the destination buffer.
+ * 
+ * @return Number of bytes received, 0 on disconnect, -1 on error.
+ */
+int client_recv(ClientConn *client, char *buffer, size_t size) {
+    StreamBuffer *target = client->decompressor ? client->wire_buffer : client->recv_buffer;
+    size_t space = target->capacity - target->length - 1;
+    size_t len = size - 1;
+    
+    if (space > 0 && space < len) {
+        len = space;
+    }
+    
+    return recv(client->sockfd, buffer, len, 0);
+}
+
+/**
+ * @function client_buffer_data: Queue received bytes for message extraction.
+ * 
+ * @param client Pointer to ClientConn structure.
+ * @param data Bytes received from the socket.
+ * @param len Number of bytes received.
+ * 
+ * @return 1 on success, 0 on buffer overflow or corrupt stream.
+ */
+int client_buffer_data(ClientConn *client, const char *data, size_t len) {
+    if (!client->decompressor) {
+        return stream_buffer_append(client->recv_buffer, data, len);
+    }
+    
+    if (!stream_buffer_append(client->wire_buffer, data, len)) {
+        return 0;
+    }
+    
+    return decompressor_decode(client->decompressor, client->wire_buffer, client->recv_buffer) >= 0;
+}
+
+/**
+ * @function client_next_message: Extract the next complete server message.
+ * 
+ * @param client Pointer to ClientConn structure.
+ * 
+ * @return Pointer to the extracted message (must be freed by caller), or NULL if none.
+ */
+char* client_next_message(ClientConn *client) {
+    char *message = stream_buffer_extract_message(client->recv_buffer);
+    if (message || !client->decompressor) {
+        return message;
+    }
+    
+    // Frames may be waiting for room in the plain buffer
+    if (decompressor_decode(client->decompressor, client->wire_buffer, client->recv_buffer) > 0) {
+        message = stream_buffer_extract_message(client->recv_buffer);
+    }
+    
+    return message;
+}
+
 /**
  * @function handle_server_response: Handle server response messages.
  * 
@@ -198,7 +300,7 @@ int handle_server_response(ClientConn *client) {
     if (!client || !client->connected) return 0;
     
     char buffer[BUFFER_SIZE];
-    int bytes_received = recv(client->sockfd, buffer, sizeof(buffer) - 1, 0);
+    int bytes_received = client_recv(client, buffer, sizeof(buffer));
     
     if (bytes_received <= 0) {
         if (bytes_received == 0) {
@@ -212,14 +314,19 @@ int handle_server_response(ClientConn *client) {
     
     buffer[bytes_received] = '\0';
     
-    if (!stream_buffer_append(client->recv_buffer, buffer, bytes_received)) {
+    if (!client_buffer_data(client, buffer, bytes_received)) {
         fprintf(stderr, "Buffer overflow in client\n");
         return -1;
     }
     
     char *message;
     int messages_processed = 0;
-    while ((message = stream_buffer_extract_message(client->recv_buffer)) != NULL) {
+    while ((message = client_next_message(client)) != NULL) {
+        if (client_handle_presence(client, message)) {
+            free(message);
+            continue;
+        }
+        client->last_status = atoi(message);
         const char *content = extract_message_content(message);
         if (content && strlen(content) > 0) {
             printf("[Server] %s\n", content);
@@ -342,6 +449,46 @@ void display_friend_accept_notification(const char *message) {
 
 }
 
+/**
+ * @function display_unread_summary: Display unread counts per conversation.
+ * 
+ * @param message The UNREAD_SUMMARY response.
+ * 
+ * @return void
+ */
+void display_unread_summary(const char *message) {
+    long direct_total = 0, group_total = 0;
+    const char *field;
+    if ((field = strstr(message, "direct="))) direct_total = atol(field + 7);
+    if ((field = strstr(message, "groups="))) group_total = atol(field + 7);
+    
+    if (direct_total == 0 && group_total == 0) {
+        printf("\n[Unread] You are all caught up.\n");
+        return;
+    }
+    
+    printf("\n[Unread] %ld direct message(s), %ld group message(s)\n",
+           direct_total, group_total);
+    
+    const char *line = strchr(message, '\n');
+    while (line && *(++line)) {
+        const char *next = strchr(line, '\n');
+        int line_len = next ? (int)(next - line) : (int)strlen(line);
+        
+        char kind[16] = {0}, name[128] = {0};
+        int count = 0;
+        char entry[256];
+        snprintf(entry, sizeof(entry), "%.*s", line_len, line);
+        if (sscanf(entry, "%15s %127s %d", kind, name, &count) == 3) {
+            printf("  %s \033[33m%s\033[0m: %d unread\n",
+                   strcmp(kind, "GROUP") == 0 ? "Group" : "From ", name, count);
+        } else if (strncmp(entry, "... ", 4) == 0) {
+            printf("  ... and %d more conversation(s)\n", atoi(entry + 4));
+        }
+        line = next;
+    }
+}
+
 /**
  * @function check_server_messages: Check and process incoming server messages.
  * 
@@ -355,7 +502,7 @@ int check_server_messages(ClientConn *client) {
     set_socket_nonblocking(client->sockfd, 1);
     
     char buffer[BUFFER_SIZE];
-    int bytes_received = recv(client->sockfd, buffer, sizeof(buffer) - 1, 0);
+    int bytes_received = client_recv(client, buffer, sizeof(buffer));
     
     set_socket_nonblocking(client->sockfd, 0);
     
@@ -375,7 +522,7 @@ int check_server_messages(ClientConn *client) {
     
     buffer[bytes_received] = '\0';
     
-    if (!stream_buffer_append(client->recv_buffer, buffer, bytes_received)) {
+    if (!client_buffer_data(client, buffer, bytes_received)) {
         fprintf(stderr, "Buffer overflow in client\n");
         return -1;
     }
@@ -383,9 +530,12 @@ int check_server_messages(ClientConn *client) {
     char *message;
     int notification_count = 0;
     
-    while ((message = stream_buffer_extract_message(client->recv_buffer)) != NULL) {
+    while ((message = client_next_message(client)) != NULL) {
         int displayed = 0;
-        if (strstr(message, "OFFLINE MESSAGES FROM GROUP")) {
+        if (client_handle_presence(client, message)) {
+            displayed = atoi(message) == STATUS_PRESENCE_NOTIFICATION;
+        }
+        else if (strstr(message, "OFFLINE MESSAGES FROM GROUP")) {
             printf("\n");
             char *msg_copy = strdup(message);
             char *line = strtok(msg_copy, "\n");
@@ -430,6 +580,9 @@ int check_server_messages(ClientConn *client) {
             display_new_message_notification(message);
             displayed = 1;
         }
+        else if (strstr(message, "UNREAD_SUMMARY")) {
+            display_unread_summary(message);
+        }
         else if (strstr(message, "FRIEND_REQUEST_NOTIFICATION")) {
             display_friend_request_notification(message);
             displayed = 1;
@@ -479,6 +632,44 @@ int check_server_messages(ClientConn *client) {
     return notification_count;
 }
 
+/**
+ * @function client_wait_message: Wait for the next complete server message.
+ * 
+ * @param client Pointer to ClientConn structure.
+ * @param timeout_sec Seconds to wait for more data before giving up.
+ * 
+ * @return Pointer to the message (must be freed by caller), or NULL on timeout or disconnect.
+ */
+static char* client_wait_message(ClientConn *client, int timeout_sec) {
+    char *message;
+    while ((message = client_next_message(client)) == NULL && client->connected) {
+        fd_set read_fds;
+        struct timeval timeout;
+        FD_ZERO(&read_fds);
+        FD_SET(client->sockfd, &read_fds);
+        timeout.tv_sec = timeout_sec;
+        timeout.tv_usec = 0;
+        
+        if (select(client->sockfd + 1, &read_fds, NULL, NULL, &timeout) <= 0) {
+            return NULL;
+        }
+        
+        char buffer[BUFFER_SIZE];
+        int bytes_received = client_recv(client, buffer, sizeof(buffer));
+        if (bytes_received <= 0) {
+            printf("Server disconnected!\n");
+            client->connected = 0;
+            return NULL;
+        }
+        
+        if (!client_buffer_data(client, buffer, bytes_received)) {
+            fprintf(stderr, "Buffer overflow in client\n");
+            return NULL;
+        }
+    }
+    return message;
+}
+
 // ============================================================================
 // Menu Display Functions
 // ============================================================================
@@ -743,6 +934,208 @@ void display_group_join_request_notification(const char *message) {
     printf("  From: %s\n", requester);
 }
 
+// ============================================================================
+// Friend Cache and Presence
+// ============================================================================
+
+/**
+ * @function friend_cache_clear: Drop all cached friends and the sync version.
+ * 
+ * @param cache Pointer to FriendCache structure.
+ * 
+ * @return void
+ */
+void friend_cache_clear(FriendCache *cache) {
+    free(cache->entries);
+    memset(cache, 0, sizeof(*cache));
+}
+
+/**
+ * @function friend_cache_find: Find a cached friend by username.
+ * 
+ * @param cache Pointer to FriendCache structure.
+ * @param username Friend to look up.
+ * 
+ * @return Index of the entry, or -1 if not cached.
+ */
+static int friend_cache_find(const FriendCache *cache, const char *username) {
+    for (int i = 0; i < cache->count; i++) {
+        if (strcmp(cache->entries[i].username, username) == 0) return i;
+    }
+    return -1;
+}
+
+/**
+ * @function friend_cache_set: Add a friend or update its online flag.
+ * 
+ * @param cache Pointer to FriendCache structure.
+ * @param username Friend to store.
+ * @param online 1 if online, 0 if offline.
+ * 
+ * @return void
+ */
+static void friend_cache_set(FriendCache *cache, const char *username, int online) {
+    int index = friend_cache_find(cache, username);
+    if (index < 0) {
+        if (cache->count == cache->capacity) {
+            CachedFriend *grown = realloc(cache->entries,
+                                          (cache->capacity + FRIEND_CACHE_GROW) * sizeof(CachedFriend));
+            if (!grown) return;
+            cache->entries = grown;
+            cache->capacity += FRIEND_CACHE_GROW;
+        }
+        index = cache->count++;
+        snprintf(cache->entries[index].username, MAX_USERNAME_LENGTH, "%s", username);
+    }
+    cache->entries[index].online = online;
+}
+
+/**
+ * @function friend_cache_remove: Remove a friend from the cache.
+ * 
+ * @param cache Pointer to FriendCache structure.
+ * @param username Friend to remove.
+ * 
+ * @return void
+ */
+static void friend_cache_remove(FriendCache *cache, const char *username) {
+    int index = friend_cache_find(cache, username);
+    if (index < 0) return;
+    cache->entries[index] = cache->entries[--cache->count];
+}
+
+/**
+ * @function print_friend_cache: Print the cached friend list with live status.
+ * 
+ * @param cache Pointer to FriendCache structure.
+ * 
+ * @return void
+ */
+static void print_friend_cache(const FriendCache *cache) {
+    if (cache->count == 0) {
+        printf("You have no friends yet.\n");
+        return;
+    }
+    
+    printf("%-4s %-24s %s\n", "No.", "Username", "Status");
+    for (int i = 0; i < cache->count; i++) {
+        printf("%-4d %-24s %s\n", i + 1, cache->entries[i].username,
+               cache->entries[i].online ? "\033[32monline\033[0m" : "\033[90moffline\033[0m");
+    }
+    if (!cache->subscribed) {
+        printf("(Status as of this fetch; live updates are off)\n");
+    }
+}
+
+/**
+ * @function client_handle_presence: Apply a presence push or subscribe reply.
+ * 
+ * 128 marks the subscription active. Each 253 "PRESENCE <user> online|offline"
+ * updates the cached friend and is announced to the user.
+ * 
+ * @param client Pointer to ClientConn structure.
+ * @param message The full server message.
+ * 
+ * @return 1 if the message was a presence message, 0 otherwise.
+ */
+int client_handle_presence(ClientConn *client, const char *message) {
+    int status_code = atoi(message);
+    
+    if (status_code == STATUS_PRESENCE_SUBSCRIBE_OK) {
+        client->friends.subscribed = 1;
+        return 1;
+    }
+    if (status_code != STATUS_PRESENCE_NOTIFICATION) return 0;
+    
+    char username[MAX_USERNAME_LENGTH] = {0};
+    char state[16] = {0};
+    if (sscanf(extract_message_content(message), "PRESENCE %49s %15s", username, state) == 2) {
+        int online = strcmp(state, "online") == 0;
+        friend_cache_set(&client->friends, username, online);
+        printf("\n[Presence] %s is now %s\n", username, online ? "online" : "offline");
+    }
+    return 1;
+}
+
+/**
+ * @function client_sync_friends: Bring the friend cache up to date.
+ * 
+ * Sends FRIEND_LIST_SYNC with the cached version and applies the 129
+ * FRIEND_SYNC frames: "full" replaces the cache, "delta" adds ("+user 0|1")
+ * or removes ("-user") friends, "unchanged" carries no items. Presence
+ * pushes arriving in between are applied as usual.
+ * 
+ * @param client Pointer to ClientConn structure.
+ * 
+ * @return Number of items applied, or -1 on error.
+ */
+int client_sync_friends(ClientConn *client) {
+    char request[BUFFER_SIZE];
+    if (client->friends.version > 0) {
+        snprintf(request, sizeof(request), "FRIEND_LIST_SYNC %lld", client->friends.version);
+    } else {
+        snprintf(request, sizeof(request), "FRIEND_LIST_SYNC");
+    }
+    send_message(client, request);
+    
+    int applied = 0;
+    int end = 0;
+    while (!end) {
+        char *message = client_wait_message(client, 3);
+        if (!message) return -1;
+        
+        if (client_handle_presence(client, message)) {
+            free(message);
+            continue;
+        }
+        
+        int status_code = atoi(message);
+        const char *content = extract_message_content(message);
+        
+        if (status_code == STATUS_FRIEND_LIST_SYNC_OK && strncmp(content, "FRIEND_SYNC", 11) == 0) {
+            long long version = 0;
+            char mode[16] = {0};
+            int page = 1;
+            const char *field;
+            if ((field = strstr(content, "version="))) version = atoll(field + 8);
+            if ((field = strstr(content, "mode="))) sscanf(field + 5, "%15s", mode);
+            if ((field = strstr(content, "page="))) page = atoi(field + 5);
+            if ((field = strstr(content, "end="))) end = atoi(field + 4);
+            
+            if (strcmp(mode, "full") == 0 && page == 1) {
+                client->friends.count = 0;
+            }
+            
+            const char *line = strchr(content, '\n');
+            while (line && *(++line)) {
+                char username[MAX_USERNAME_LENGTH] = {0};
+                int online = 0;
+                if (line[0] == '+' && sscanf(line + 1, "%49s %d", username, &online) >= 1) {
+                    friend_cache_set(&client->friends, username, online);
+                    applied++;
+                } else if (line[0] == '-' && sscanf(line + 1, "%49s", username) == 1) {
+                    friend_cache_remove(&client->friends, username);
+                    applied++;
+                }
+                line = strchr(line, '\n');
+            }
+            
+            if (end) client->friends.version = version;
+        }
+        else if (status_code >= 400) {
+            printf("[Server] %s\n", content);
+            free(message);
+            return -1;
+        }
+        else if (content && strlen(content) > 0) {
+            printf("[Server] %s\n", content);
+        }
+        free(message);
+    }
+    
+    return applied;
+}
+
 // ============================================================================
 // Authentication Handlers
 // ============================================================================
@@ -816,6 +1209,11 @@ int handle_login(ClientConn *client) {
     int result = handle_server_response(client);
 
     if (result > 0) {
+        if (client->last_status == STATUS_LOGIN_OK) {
+            friend_cache_clear(&client->friends);
+            send_message(client, "PRESENCE_SUBSCRIBE");
+        }
+        send_message(client, "UNREAD_SUMMARY");
         sleep(1);
         check_server_messages(client);
     }
@@ -835,6 +1233,7 @@ int handle_login(ClientConn *client) {
 int handle_logout(ClientConn *client) {
     printf("\n--- LOGOUT ---\n");
     send_message(client, "LOGOUT");
+    friend_cache_clear(&client->friends);
     return handle_server_response(client);
 }
 
@@ -971,8 +1370,9 @@ int handle_friend_remove(ClientConn *client) {
 
     // Display friend list first
     printf("\nFetching your friend list...\n");
-    send_message(client, "FRIEND_LIST");
-    handle_server_response(client);
+    if (client_sync_friends(client) >= 0) {
+        print_friend_cache(&client->friends);
+    }
     printf("\n");
     
     // Enter username to unfriend
@@ -1025,12 +1425,12 @@ int handle_friend_remove(ClientConn *client) {
 int handle_friend_list(ClientConn *client) {
     printf("\n--- MY FRIEND LIST ---\n");
     
-    // Send command to server
-    send_message(client, "FRIEND_LIST");
+    // Only changes since the cached version are transferred
     printf("Fetching friend list...\n");
-    
-    // Receive and display list
-    int result = handle_server_response(client);
+    int result = client_sync_friends(client) >= 0;
+    if (result) {
+        print_friend_cache(&client->friends);
+    }
     
     printf("\nPress Enter to continue...");
     getchar();
@@ -1042,6 +1442,97 @@ int handle_friend_list(ClientConn *client) {
 // Messaging Handler
 // ============================================================================
 
+/**
+ * @function fetch_offline_messages: Pull all offline messages from a sender page by page.
+ * 
+ * Sends GET_OFFLINE_MSG with the last cursor after each window of pages
+ * until the server reports that no more messages remain.
+ * 
+ * @param client Pointer to ClientConn structure.
+ * @param sender Username whose offline messages are requested.
+ * 
+ * @return Number of messages received, or -1 on error.
+ */
+int fetch_offline_messages(ClientConn *client, const char *sender) {
+    char request[BUFFER_SIZE];
+    int cursor = 0;
+    int total = 0;
+    int more = 1;
+    
+    while (more && client->connected) {
+        snprintf(request, sizeof(request), "GET_OFFLINE_MSG %s %d", sender, cursor);
+        send_message(client, request);
+        
+        int end = 0;
+        while (!end) {
+            char *message = client_wait_message(client, 3);
+            if (!message) {
+                return total > 0 ? total : -1;
+            }
+            
+            int status_code = atoi(message);
+            const char *content = extract_message_content(message);
+            
+            if (status_code == STATUS_GET_OFFLINE_MSG_OK && strstr(content, "OFFLINE_PAGE")) {
+                int count = 0, page_more = 0, page_end = 1;
+                const char *field;
+                if ((field = strstr(content, "count="))) count = atoi(field + 6);
+                if ((field = strstr(content, "cursor="))) cursor = atoi(field + 7);
+                if ((field = strstr(content, "more="))) page_more = atoi(field + 5);
+                if ((field = strstr(content, "end="))) page_end = atoi(field + 4);
+                
+                if (total == 0) {
+                    printf("\n=== SHOW OFFLINE MESSAGES FROM %s ===\n", sender);
+                }
+                
+                const char *line = strchr(content, '\n');
+                while (line && *(++line)) {
+                    const char *next = strchr(line, '\n');
+                    int line_len = next ? (int)(next - line) : (int)strlen(line);
+                    const char *close_bracket = memchr(line, ']', line_len);
+                    if (line[0] == '[' && close_bracket) {
+                        printf("\033[90m%.*s\033[0m%.*s\n",
+                               (int)(close_bracket - line + 1), line,
+                               line_len - (int)(close_bracket - line + 1), close_bracket + 1);
+                    } else {
+                        printf("%.*s\n", line_len, line);
+                    }
+                    line = next;
+                }
+                
+                total += count;
+                more = page_more;
+                end = page_end;
+            }
+            else if (status_code == STATUS_NOT_HAVE_OFFLINE_MESSAGE) {
+                if (total == 0) {
+                    printf("[Server] %s\n", content);
+                }
+                more = 0;
+                end = 1;
+            }
+            else if (strstr(message, "NEW_MESSAGE from")) {
+                display_new_message_notification(message);
+            }
+            else if (status_code >= 400) {
+                printf("[Server] %s\n", content);
+                free(message);
+                return -1;
+            }
+            else {
+                printf("[Server] %s\n", content);
+            }
+            
+            free(message);
+        }
+    }
+    
+    if (total > 0) {
+        printf("=== END OF OFFLINE MESSAGES (%d total) ===\n", total);
+    }
+    return total;
+}
+
 /**
  * @function handle_messaging_mode: Handle direct messaging mode with a friend.
  * 
@@ -1064,12 +1555,7 @@ int handle_messaging_mode(ClientConn *client) {
     while (*trimmed_receiver == ' ' || *trimmed_receiver == '\t') 
         trimmed_receiver++;
     
-    char get_offline_cmd[BUFFER_SIZE];
-    snprintf(get_offline_cmd, sizeof(get_offline_cmd), "GET_OFFLINE_MSG %s", trimmed_receiver);
-    send_message(client, get_offline_cmd);
-
-    sleep(1);
-    check_server_messages(client);
+    fetch_offline_messages(client, trimmed_receiver);
 
     printf("\n--- Chatting with: %s ---\n", trimmed_receiver);
     printf("--- Type 'exit' to leave chat ---\n\n");
@@ -1100,7 +1586,7 @@ int handle_messaging_mode(ClientConn *client) {
         
         if (FD_ISSET(client->sockfd, &read_fds)) {
             char buffer[BUFFER_SIZE];
-            int bytes_received = recv(client->sockfd, buffer, sizeof(buffer) - 1, 0);
+            int bytes_received = client_recv(client, buffer, sizeof(buffer));
             
             if (bytes_received <= 0) {
                 if (bytes_received == 0) {
@@ -1114,13 +1600,13 @@ int handle_messaging_mode(ClientConn *client) {
             
             buffer[bytes_received] = '\0';
             
-            if (!stream_buffer_append(client->recv_buffer, buffer, bytes_received)) {
+            if (!client_buffer_data(client, buffer, bytes_received)) {
                 fprintf(stderr, "Buffer overflow\n");
                 break;
             }
             
             char *message;
-            while ((message = stream_buffer_extract_message(client->recv_buffer)) != NULL) {
+            while ((message = client_next_message(client)) != NULL) {
 
                 if (strstr(message, "FRIEND_REQUEST_NOTIFICATION")) {
                     printf("\r\033[K"); 
@@ -1435,109 +1921,102 @@ void handle_group_msg(ClientConn *client) {
              "GROUP_SEND_OFFLINE_MSG %s", trimmed_group);
     send_message(client, get_offline_cmd);
 
-    fd_set validation_fds;
-    struct timeval validation_timeout; 
     int validation_failed = 0;
-    
-    FD_ZERO(&validation_fds);
-    FD_SET(client->sockfd, &validation_fds);
-    validation_timeout.tv_sec = 2;
-    validation_timeout.tv_usec = 0;
-    
-    int activity = select(client->sockfd + 1, &validation_fds, NULL, NULL, &validation_timeout);
-    
-    if (activity > 0 && FD_ISSET(client->sockfd, &validation_fds)) {
-        char buffer[BUFFER_SIZE];
-        int bytes_received = recv(client->sockfd, buffer, sizeof(buffer) - 1, 0);
+    int catching_up = 1;
+    int received_any = 0;
+    int throttled = 0;
+    
+    // Unread history arrives in pages; a window ends with end=1 and, while
+    // more=1, re-sending the request resumes from the server-side read cursor.
+    while (catching_up) {
+        char *message = client_wait_message(client, 2);
+        if (!message) {
+            if (!received_any) {
+                printf("\nNo response from server. Cannot verify group membership.\n");
+                validation_failed = 1;
+            }
+            break;
+        }
+        received_any = 1;
         
-        if (bytes_received > 0) {
-            buffer[bytes_received] = '\0';
+        int status_code = atoi(message);
+        char *msg_line = strchr(message, '\n');
+        
+        if (status_code == STATUS_NOT_IN_GROUP) {
+            printf("\r\033[K");
+            printf("\nWarring: You are not a member of group '%s'\n", trimmed_group);
+            if (msg_line) printf("%s\n", msg_line + 1);
+            validation_failed = 1;
+            catching_up = 0;
+        }
+        else if (status_code == STATUS_NOT_LOGGED_IN) {
+            printf("\r\033[K");
+            printf("\nWarring: You must login first\n");
+            if (msg_line) printf("%s\n", msg_line + 1);
+            validation_failed = 1;
+            catching_up = 0;
+        }
+        else if (status_code == STATUS_GROUP_NOT_FOUND) {
+            printf("\r\033[K");
+            printf("\nERROR: Group '%s' does not exist\n", trimmed_group);
+            if (msg_line) printf("%s\n", msg_line + 1);
+            validation_failed = 1;
+            catching_up = 0;
+        }
+        else if (status_code == 501 || status_code == 502) {
+            printf("\r\033[K");
+            printf("\nERROR: Cannot access group '%s'\n", trimmed_group);
+            if (msg_line) printf("%s\n", msg_line + 1);
+            validation_failed = 1;
+            catching_up = 0;
+        }
+        else if (status_code == STATUS_GET_OFFLINE_MSG_OK) {
+            int more = 0, end = 1;
+            const char *field;
+            if ((field = strstr(message, "more="))) more = atoi(field + 5);
+            if ((field = strstr(message, "end="))) end = atoi(field + 4);
             
-            if (!stream_buffer_append(client->recv_buffer, buffer, bytes_received)) {
-                fprintf(stderr, "Buffer overflow\n");
-                free(group_name);
-                return;
+            // Skip the page header line, print the history lines
+            if (msg_line) {
+                printf("\n%s", msg_line + 1);
+                if (msg_line[strlen(msg_line) - 1] != '\n') printf("\n");
             }
             
-            char *message;
-            while ((message = stream_buffer_extract_message(client->recv_buffer)) != NULL) {
-                if (strstr(message, "421")) {
-                    printf("\r\033[K");
-                    printf("\nWarring: You are not a member of group '%s'\n", trimmed_group);
-                    
-                    char *msg_line = strchr(message, '\n');
-                    if (msg_line) {
-                        printf("%s\n", msg_line + 1);
-                    }
-                    
-                    validation_failed = 1;
-                    free(message);
-                    break;
-                }
-                else if( strstr(message, "305")) {
-                    printf("\r\033[K");
-                    printf("\nWarring: You must login first\n");
-                    
-                    char *msg_line = strchr(message, '\n');
-                    if (msg_line) {
-                        printf("%s\n", msg_line + 1);
-                    }
-                    
-                    validation_failed = 1;
-                    free(message);
-                    break;
-                }
-                else if( strstr(message, "419")) {
-                    printf("\r\033[K");
-                    printf("\nERROR: Group '%s' does not exist\n", trimmed_group);
-                    
-                    char *msg_line = strchr(message, '\n');
-                    if (msg_line) {
-                        printf("%s\n", msg_line + 1);
-                    }
-                    
-                    validation_failed = 1;
-                    free(message);
-                    break;
-                }
-                else if( strstr(message, "501") || strstr(message, "502")) {
-                    
-                    printf("\r\033[K");
-                    printf("\nERROR: Cannot access group '%s'\n", trimmed_group);
-                    
-                    char *msg_line = strchr(message, '\n');
-                    if (msg_line) {
-                        printf("%s\n", msg_line + 1);
-                    }
-                    
-                    validation_failed = 1;
-                    free(message);
-                    break;
-                }
-                else if (strstr(message, "118") || strstr(message, "420")) {
-                    if (strstr(message, "118")) {
-                        char *msg_copy = strdup(message);
-                        char *line = strtok(msg_copy, "\n");
-                        line = strtok(NULL, "\n");
-                        
-                        printf("\n");
-                        while (line != NULL) {
-                            printf("%s\n", line);
-                            line = strtok(NULL, "\n");
-                        }
-                        free(msg_copy);
-                    }
+            throttled = 0;
+            if (end) {
+                if (more) {
+                    send_message(client, get_offline_cmd);
+                } else {
+                    catching_up = 0;
                 }
-                
-                free(message);
             }
         }
-    } else if (activity == 0) {
-        printf("\nNo response from server. Cannot verify group membership.\n");
-        validation_failed = 1;
-    } else {
-        perror("select() error");
-        validation_failed = 1;
+        else if (status_code == STATUS_RATE_LIMITED && throttled < CATCHUP_MAX_RETRIES) {
+            // "429 Slow down, retry in N s": wait it out instead of dropping the backlog
+            int retry_after = 1;
+            const char *field = strstr(message, "retry in ");
+            if (field && atoi(field + 9) > 0) retry_after = atoi(field + 9);
+            throttled++;
+            
+            printf("\r\033[K[Catch-up] Server is throttling, retrying in %d s...\n", retry_after);
+            fflush(stdout);
+            sleep(retry_after);
+            send_message(client, get_offline_cmd);
+        }
+        else if (status_code == STATUS_NOT_HAVE_OFFLINE_MESSAGE ||
+                 status_code == STATUS_INVITE_REQUIRED) {
+            catching_up = 0;
+        }
+        else if (status_code >= 400) {
+            printf("\r\033[K");
+            printf("\nCatch-up stopped, unread history may be incomplete: %s\n", message);
+            catching_up = 0;
+        }
+        else if (strstr(message, "NEW_MESSAGE from")) {
+            display_new_message_notification(message);
+        }
+        
+        free(message);
     }
     
     if (validation_failed) {
@@ -1576,7 +2055,7 @@ void handle_group_msg(ClientConn *client) {
 
         if (FD_ISSET(client->sockfd, &read_fds)) {
             char buffer[BUFFER_SIZE];
-            int bytes_received = recv(client->sockfd, buffer, sizeof(buffer) - 1, 0);
+            int bytes_received = client_recv(client, buffer, sizeof(buffer));
             
             if (bytes_received <= 0) {
                 if (bytes_received == 0) {
@@ -1590,13 +2069,13 @@ void handle_group_msg(ClientConn *client) {
             
             buffer[bytes_received] = '\0';
             
-            if (!stream_buffer_append(client->recv_buffer, buffer, bytes_received)) {
+            if (!client_buffer_data(client, buffer, bytes_received)) {
                 fprintf(stderr, "Buffer overflow\n");
                 break;
             }
             
             char *message;
-            while ((message = stream_buffer_extract_message(client->recv_buffer)) != NULL) {
+            while ((message = client_next_message(client)) != NULL) {
                 
                 if (strstr(message, "FRIEND_REQUEST_NOTIFICATION")) {
                     printf("\r\033[K");
@@ -1872,13 +2351,14 @@ void handle_list_join_requests(ClientConn *client) {
 // ============================================================================
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        printf("Usage: ./chat_client IP_Addr Port_Number\n");
+    if (argc < 3 || argc > 4 || (argc == 4 && strcmp(argv[3], "--compress") != 0)) {
+        printf("Usage: ./chat_client IP_Addr Port_Number [--compress]\n");
         return 1;
     }
     
     char *server_addr = argv[1];
     int server_port = atoi(argv[2]);
+    int use_compression = (argc == 4);
 
      if (client_init(&global_client, server_addr, server_port) < 0) {
         fprintf(stderr, "Failed to initialize client\n");
@@ -1897,6 +2377,10 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    if (use_compression && client_enable_compression(&global_client) < 0) {
+        fprintf(stderr, "Compression negotiation failed, continuing uncompressed\n");
+    }
+
     while (global_client.connected) {
         check_server_messages(&global_client);
         print_main_menu();
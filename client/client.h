@@ -2,6 +2,7 @@
 #define CLIENT_H
 
 #include "../common/protocol.h"
+#include "../common/compress.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,15 +15,34 @@
 
 #define INITIAL_BUFFER_SIZE 64
 #define BUFFER_GROW_SIZE 32
+#define CATCHUP_MAX_RETRIES 5      // Consecutive 429s tolerated during group catch-up
+#define FRIEND_CACHE_GROW 16       // Friend cache entries added per reallocation
 
 // ============================================================================
 // Data Structures
 // ============================================================================
 
+typedef struct {
+    char username[MAX_USERNAME_LENGTH];
+    int online;
+} CachedFriend;
+
+typedef struct {
+    CachedFriend *entries;
+    int count;
+    int capacity;
+    long long version;              // Version from the last FRIEND_LIST_SYNC, 0 before the first
+    int subscribed;                 // Server acknowledged PRESENCE_SUBSCRIBE for this login
+} FriendCache;
+
 typedef struct {
     int sockfd;
     StreamBuffer *recv_buffer;
+    StreamBuffer *wire_buffer;      // Raw socket bytes when compression is on
+    Decompressor *decompressor;     // NULL unless COMPRESS was negotiated
     int connected;
+    int last_status;                // Status code of the last reply seen by handle_server_response
+    FriendCache friends;            // Kept current by FRIEND_LIST_SYNC and 253 presence pushes
 } ClientConn;
 
 typedef enum {
@@ -76,6 +96,10 @@ int get_menu_choice_with_notifications(ClientConn *client);
 
 // Network communication
 void send_message(ClientConn *client, const char *message);
+int client_enable_compression(ClientConn *client);
+int client_recv(ClientConn *client, char *buffer, size_t size);
+int client_buffer_data(ClientConn *client, const char *data, size_t len);
+char* client_next_message(ClientConn *client);
 int handle_server_response(ClientConn *client);
 int check_server_messages(ClientConn *client);
 
@@ -88,6 +112,7 @@ void print_group_menu(void);
 // Notification handlers
 void display_group_invite_notification(const char *message);
 void display_offline_notification(const char *message);
+void display_unread_summary(const char *message);
 void display_group_kick_notification(const char *message);
 void display_group_join_request_notification(const char *message);
 void display_group_join_result_notification(const char *message, int approved);
@@ -104,8 +129,14 @@ int handle_friend_decline(ClientConn *client);
 int handle_friend_remove(ClientConn *client);
 int handle_friend_list(ClientConn *client);
 
+// Friend cache and presence
+void friend_cache_clear(FriendCache *cache);
+int client_handle_presence(ClientConn *client, const char *message);
+int client_sync_friends(ClientConn *client);
+
 // Messaging handlers
 int handle_messaging_mode(ClientConn *client);
+int fetch_offline_messages(ClientConn *client, const char *sender);
 
 // Group chat handlers
 void handle_group_create(ClientConn *client);
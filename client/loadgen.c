@@ -0,0 +1,1289 @@
+// ============================================================================
+// loadgen.c - Headless load generator for the chat server
+// ============================================================================
+//
+// Opens many non-blocking connections, registers and logs in synthetic users,
+// builds a friend ring and fixed-size groups, then drives a weighted mix of
+// MSG / GROUP_MSG / FRIEND_LIST at a target aggregate rate and reports
+// throughput and latency percentiles.
+//
+// Latency is measured from each operation's scheduled send time, so a slow
+// server cannot hide queueing delay by delaying the next request
+// (no coordinated omission).
+//
+// MSG / GROUP_MSG bodies carry "lg src=<sender> seq=<n> ts=<ns>". Sender and
+// receiver live in this process and share CLOCK_MONOTONIC, so receiving
+// sessions compute true one-way delivery latency without clock sync, and
+// per-peer sequence numbers expose loss and reordering of live pushes.
+
+#include "../common/protocol.h"
+#include "../common/histogram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define LOADGEN_SEND_BUFFER_SIZE (MAX_MESSAGE_LENGTH * 4)
+#define LOADGEN_CONNECTS_PER_TICK 50
+#define LOADGEN_RESPONSE_TIMEOUT_NS (30ULL * 1000000000ULL)
+#define LOADGEN_TAG ": lg src="
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+typedef enum {
+    OP_MSG,
+    OP_GROUP_MSG,
+    OP_FRIEND_LIST,
+    OP_COUNT
+} LoadOp;
+
+static const char *op_names[OP_COUNT] = { "MSG", "GROUP_MSG", "FRIEND_LIST" };
+
+typedef enum {
+    CHANNEL_DIRECT,
+    CHANNEL_GROUP,
+    CHANNEL_COUNT
+} Channel;
+
+static const char *channel_names[CHANNEL_COUNT] = { "direct", "group" };
+
+typedef enum {
+    PHASE_CONNECT,
+    PHASE_REGISTER,
+    PHASE_LOGIN,
+    PHASE_FRIEND_REQ,
+    PHASE_FRIEND_ACCEPT,
+    PHASE_GROUP_CREATE,
+    PHASE_GROUP_INVITE,
+    PHASE_GROUP_ENTER,
+    PHASE_RUN,
+    PHASE_DRAIN,
+    PHASE_DONE
+} LoadPhase;
+
+static const char *phase_names[] = {
+    "connect", "register", "login", "friend_req", "friend_accept",
+    "group_create", "group_invite", "group_enter", "run", "drain", "done"
+};
+
+typedef struct {
+    const char *host;
+    int port;
+    int clients;
+    double rate;                // Aggregate operations per second
+    int duration;               // Seconds of steady-state load
+    int friends;                // Friends on each side of the ring
+    int group_size;             // Members per group (0 disables groups)
+    int mix[OP_COUNT];          // Relative weights
+    const char *prefix;
+    const char *password;
+    unsigned int seed;
+    int json;
+    const char *scenario;       // Label used in reports and .hgrm file names
+    int drain;                  // Seconds to keep reading pushes after the run
+    const char *hgrm_prefix;    // Write e2e .hgrm files when set
+} LoadConfig;
+
+typedef struct {
+    int fd;
+    int index;
+    int ready;                  // Welcome received
+    int failed;
+    char username[MAX_USERNAME_LENGTH];
+    StreamBuffer *recv_buffer;
+    char out[LOADGEN_SEND_BUFFER_SIZE];
+    size_t out_len;
+
+    // Scripted setup commands for the current phase
+    char **script;
+    int script_len;
+    int script_pos;
+
+    // Outstanding request
+    int awaiting;
+    int pending_is_op;
+    LoadOp pending_op;
+    uint64_t pending_since_ns;
+
+    // Run phase pacing
+    uint64_t next_due_ns;
+    int op_queued;
+    uint64_t op_due_ns;
+
+    // End-to-end tracking; direct peers are indexed by peer_slot(), group
+    // peers by their position in the group. Sequence numbers start at 1.
+    unsigned long *direct_seq_out;
+    unsigned long *direct_seq_in;
+    unsigned long group_seq_out;
+    unsigned long *group_seq_in;
+} Session;
+
+typedef struct {
+    unsigned long ok[OP_COUNT];
+    unsigned long errors[OP_COUNT];
+    Histogram *latency[OP_COUNT];
+    unsigned long setup_errors;
+    unsigned long pushes;
+    unsigned long timeouts;
+
+    // One-way delivery of MSG / GROUP_MSG pushes
+    Histogram *e2e[CHANNEL_COUNT];
+    unsigned long expected[CHANNEL_COUNT];      // Live deliveries the server acknowledged
+    unsigned long delivered[CHANNEL_COUNT];
+    unsigned long reordered[CHANNEL_COUNT];     // Arrived after a higher sequence number
+} LoadStats;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @function now_ns: Monotonic clock in nanoseconds.
+ *
+ * @return Current monotonic time in nanoseconds.
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @function handle_sigint: Request a graceful stop so partial results are reported.
+ *
+ * @param sig Signal number (unused).
+ *
+ * @return void
+ */
+static void handle_sigint(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+/**
+ * @function group_of: Group index a session belongs to.
+ *
+ * @param config Load configuration.
+ * @param index Session index.
+ *
+ * @return Group index, or -1 if groups are disabled.
+ */
+static int group_of(const LoadConfig *config, int index) {
+    if (config->group_size <= 1) return -1;
+    return index / config->group_size;
+}
+
+/**
+ * @function group_name: Deterministic name of a group.
+ *
+ * @param config Load configuration.
+ * @param group Group index.
+ * @param buffer Output buffer.
+ * @param size Size of the output buffer.
+ *
+ * @return void
+ */
+static void group_name(const LoadConfig *config, int group, char *buffer, size_t size) {
+    snprintf(buffer, size, "%s_g%d", config->prefix, group);
+}
+
+/**
+ * @function peer_slot: Index of a direct-message peer in a session's sequence arrays.
+ *
+ * Peers ahead of the session on the friend ring take slots [0, friends),
+ * peers behind it take [friends, 2 * friends).
+ *
+ * @param config Load configuration.
+ * @param self Session index.
+ * @param peer Peer session index.
+ *
+ * @return Slot index, or -1 if the peer is not a friend.
+ */
+static int peer_slot(const LoadConfig *config, int self, int peer) {
+    int n = config->clients;
+    int offset = (peer - self + n) % n;
+
+    if (offset >= 1 && offset <= config->friends) return offset - 1;
+    offset = n - offset;
+    if (offset >= 1 && offset <= config->friends) return config->friends + offset - 1;
+    return -1;
+}
+
+/**
+ * @function group_live_peers: Connected members of a session's group, excluding itself.
+ *
+ * @param config Load configuration.
+ * @param sessions Array of sessions.
+ * @param index Session index.
+ *
+ * @return Number of members expected to receive the session's GROUP_MSG live.
+ */
+static int group_live_peers(const LoadConfig *config, const Session *sessions, int index) {
+    int group = group_of(config, index);
+    if (group < 0) return 0;
+
+    int first = group * config->group_size;
+    int live = 0;
+    for (int m = first; m < first + config->group_size && m < config->clients; m++) {
+        if (m != index && !sessions[m].failed) live++;
+    }
+    return live;
+}
+
+/**
+ * @function is_push: Whether a server line is an unsolicited notification.
+ *
+ * Pushes share status codes with some responses (201 is both
+ * USERNAME_EXISTS and NEW_MESSAGE), so the body is checked as well.
+ *
+ * @param line Complete server message without delimiter.
+ *
+ * @return 1 for a push, 0 for a response to our request.
+ */
+static int is_push(const char *line) {
+    int code = atoi(line);
+    const char *body = strchr(line, ' ');
+    body = body ? body + 1 : "";
+
+    switch (code) {
+        case STATUS_GROUP_MSG_OK:
+        case STATUS_GROUP_JOIN_REQUEST_NOTIFICATION:
+        case STATUS_GROUP_JOIN_APPROVED:
+        case STATUS_GROUP_JOIN_REJECTED:
+        case STATUS_GROUP_INVITE_NOTIFICATION:
+        case STATUS_OFFLINE_NOTIFICATION:
+        case STATUS_GROUP_KICK_NOTIFICATION:
+            return 1;
+        case 300:
+            return strstr(body, "_NOTIFICATION") != NULL;
+        case 201:
+            return strncmp(body, "NEW_MESSAGE from", 16) == 0;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @function is_partial_page: Whether a line is a non-final page of a paged response.
+ *
+ * @param line Complete server message without delimiter.
+ *
+ * @return 1 if more pages of the same response follow.
+ */
+static int is_partial_page(const char *line) {
+    if (atoi(line) != STATUS_GET_OFFLINE_MSG_OK) return 0;
+    if (!strstr(line, "OFFLINE_PAGE")) return 0;
+
+    const char *end = strstr(line, "end=");
+    return end && atoi(end + 4) == 0;
+}
+
+// ============================================================================
+// Session I/O
+// ============================================================================
+
+/**
+ * @function session_close: Close a session's socket and mark it failed.
+ *
+ * @param session Pointer to the Session.
+ *
+ * @return void
+ */
+static void session_close(Session *session) {
+    if (session->fd >= 0) {
+        close(session->fd);
+        session->fd = -1;
+    }
+    session->failed = 1;
+    session->awaiting = 0;
+}
+
+/**
+ * @function session_queue: Queue one protocol command for sending.
+ *
+ * @param session Pointer to the Session.
+ * @param command Command without delimiter.
+ *
+ * @return 1 on success, 0 if the send buffer is full.
+ */
+static int session_queue(Session *session, const char *command) {
+    size_t len = strlen(command);
+    size_t delim_len = strlen(PROTOCOL_DELIMITER);
+
+    if (session->out_len + len + delim_len > sizeof(session->out)) {
+        return 0;
+    }
+
+    memcpy(session->out + session->out_len, command, len);
+    memcpy(session->out + session->out_len + len, PROTOCOL_DELIMITER, delim_len);
+    session->out_len += len + delim_len;
+    return 1;
+}
+
+/**
+ * @function session_flush: Write as much queued output as the socket accepts.
+ *
+ * @param session Pointer to the Session.
+ *
+ * @return 0 on success (possibly partial), -1 on a fatal socket error.
+ */
+static int session_flush(Session *session) {
+    while (session->out_len > 0) {
+        ssize_t sent = send(session->fd, session->out, session->out_len, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+        memmove(session->out, session->out + sent, session->out_len - (size_t)sent);
+        session->out_len -= (size_t)sent;
+    }
+    return 0;
+}
+
+/**
+ * @function session_connect: Start a non-blocking connect to the server.
+ *
+ * @param session Pointer to the Session.
+ * @param addr Server address.
+ *
+ * @return 0 on success or in progress, -1 on failure.
+ */
+static int session_connect(Session *session, const struct sockaddr_in *addr) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(fd, (const struct sockaddr*)addr, sizeof(*addr)) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+
+    session->fd = fd;
+    return 0;
+}
+
+// ============================================================================
+// Setup Scripts
+// ============================================================================
+
+/**
+ * @function script_free: Free the scripted commands of a session.
+ *
+ * @param session Pointer to the Session.
+ *
+ * @return void
+ */
+static void script_free(Session *session) {
+    for (int i = 0; i < session->script_len; i++) {
+        free(session->script[i]);
+    }
+    free(session->script);
+    session->script = NULL;
+    session->script_len = 0;
+    session->script_pos = 0;
+}
+
+/**
+ * @function script_add: Append a formatted command to a session's script.
+ *
+ * @param session Pointer to the Session.
+ * @param format printf-style format of the command.
+ *
+ * @return void
+ */
+static void script_add(Session *session, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void script_add(Session *session, const char *format, ...) {
+    char command[MAX_MESSAGE_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(command, sizeof(command), format, args);
+    va_end(args);
+
+    char **grown = (char**)realloc(session->script, (session->script_len + 1) * sizeof(char*));
+    if (!grown) return;
+    session->script = grown;
+    session->script[session->script_len++] = strdup(command);
+}
+
+/**
+ * @function build_phase_scripts: Prepare every session's commands for a setup phase.
+ *
+ * @param config Load configuration.
+ * @param sessions Array of sessions.
+ * @param phase Phase being entered.
+ *
+ * @return void
+ */
+static void build_phase_scripts(const LoadConfig *config, Session *sessions, LoadPhase phase) {
+    int n = config->clients;
+    char name[MAX_USERNAME_LENGTH];
+
+    for (int i = 0; i < n; i++) {
+        Session *s = &sessions[i];
+        script_free(s);
+        if (s->failed) continue;
+
+        int group = group_of(config, i);
+        int owner = group >= 0 ? group * config->group_size : -1;
+
+        switch (phase) {
+            case PHASE_REGISTER:
+                script_add(s, "REGISTER %s %s", s->username, config->password);
+                break;
+            case PHASE_LOGIN:
+                script_add(s, "LOGIN %s %s", s->username, config->password);
+                break;
+            case PHASE_FRIEND_REQ:
+                for (int d = 1; d <= config->friends && d < n; d++) {
+                    script_add(s, "FRIEND_REQ %s", sessions[(i + d) % n].username);
+                }
+                break;
+            case PHASE_FRIEND_ACCEPT:
+                for (int d = 1; d <= config->friends && d < n; d++) {
+                    script_add(s, "FRIEND_ACCEPT %s", sessions[(i - d + n) % n].username);
+                }
+                break;
+            case PHASE_GROUP_CREATE:
+                if (group >= 0 && i == owner) {
+                    group_name(config, group, name, sizeof(name));
+                    script_add(s, "GROUP_CREATE %s", name);
+                }
+                break;
+            case PHASE_GROUP_INVITE:
+                if (group >= 0 && i == owner) {
+                    group_name(config, group, name, sizeof(name));
+                    for (int m = owner + 1; m < owner + config->group_size && m < n; m++) {
+                        script_add(s, "GROUP_INVITE %s %s", name, sessions[m].username);
+                    }
+                }
+                break;
+            case PHASE_GROUP_ENTER:
+                if (group >= 0) {
+                    group_name(config, group, name, sizeof(name));
+                    script_add(s, "GROUP_SEND_OFFLINE_MSG %s", name);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// ============================================================================
+// Run Phase
+// ============================================================================
+
+/**
+ * @function pick_op: Choose the next operation according to the mix.
+ *
+ * @param config Load configuration.
+ * @param index Session index (operations it cannot perform are skipped).
+ *
+ * @return Operation to perform.
+ */
+static LoadOp pick_op(const LoadConfig *config, int index) {
+    int weights[OP_COUNT];
+    int total = 0;
+
+    for (int op = 0; op < OP_COUNT; op++) {
+        weights[op] = config->mix[op];
+    }
+    if (config->friends <= 0 || config->clients < 2) weights[OP_MSG] = 0;
+    if (group_of(config, index) < 0) weights[OP_GROUP_MSG] = 0;
+
+    for (int op = 0; op < OP_COUNT; op++) total += weights[op];
+    if (total <= 0) return OP_FRIEND_LIST;
+
+    int r = rand() % total;
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (r < weights[op]) return (LoadOp)op;
+        r -= weights[op];
+    }
+    return OP_FRIEND_LIST;
+}
+
+/**
+ * @function send_op: Queue one load operation for a session.
+ *
+ * @param config Load configuration.
+ * @param sessions Array of sessions.
+ * @param s Session performing the operation.
+ * @param due_ns Scheduled time the latency is measured from.
+ *
+ * @return void
+ */
+static void send_op(const LoadConfig *config, Session *sessions, Session *s, uint64_t due_ns) {
+    LoadOp op = pick_op(config, s->index);
+    char command[MAX_MESSAGE_LENGTH];
+    char name[MAX_USERNAME_LENGTH];
+    int n = config->clients;
+
+    unsigned long long sent_ns = (unsigned long long)now_ns();
+    unsigned long *seq = NULL;
+
+    switch (op) {
+        case OP_MSG: {
+            int d = 1 + rand() % (config->friends < n - 1 ? config->friends : n - 1);
+            int target = (rand() % 2) ? (s->index + d) % n : (s->index - d + n) % n;
+            seq = &s->direct_seq_out[peer_slot(config, s->index, target)];
+            snprintf(command, sizeof(command), "MSG %s lg src=%d seq=%lu ts=%llu",
+                    sessions[target].username, s->index, *seq + 1, sent_ns);
+            break;
+        }
+        case OP_GROUP_MSG:
+            group_name(config, group_of(config, s->index), name, sizeof(name));
+            seq = &s->group_seq_out;
+            snprintf(command, sizeof(command), "GROUP_MSG %s lg src=%d seq=%lu ts=%llu",
+                    name, s->index, *seq + 1, sent_ns);
+            break;
+        default:
+            snprintf(command, sizeof(command), "FRIEND_LIST");
+            break;
+    }
+
+    if (!session_queue(s, command)) return;
+
+    if (seq) (*seq)++;
+    s->awaiting = 1;
+    s->pending_is_op = 1;
+    s->pending_op = op;
+    s->pending_since_ns = due_ns;
+}
+
+/**
+ * @function record_delivery: Account for a MSG / GROUP_MSG push produced by the load generator.
+ *
+ * @param config Load configuration.
+ * @param s Receiving session.
+ * @param line Push without delimiter.
+ * @param stats Statistics to update.
+ *
+ * @return void
+ */
+static void record_delivery(const LoadConfig *config, Session *s, const char *line, LoadStats *stats) {
+    const char *tag = strstr(line, LOADGEN_TAG);
+    int src;
+    unsigned long seq;
+    unsigned long long sent_ns;
+
+    if (!tag || sscanf(tag + strlen(LOADGEN_TAG), "%d seq=%lu ts=%llu", &src, &seq, &sent_ns) != 3) {
+        return;
+    }
+    if (src < 0 || src >= config->clients) return;
+
+    Channel channel;
+    unsigned long *last;
+    if (atoi(line) == STATUS_GROUP_MSG_OK) {
+        int group = group_of(config, s->index);
+        if (group < 0 || group_of(config, src) != group) return;
+        channel = CHANNEL_GROUP;
+        last = &s->group_seq_in[src - group * config->group_size];
+    } else {
+        int slot = peer_slot(config, s->index, src);
+        if (slot < 0) return;
+        channel = CHANNEL_DIRECT;
+        last = &s->direct_seq_in[slot];
+    }
+
+    uint64_t now = now_ns();
+    histogram_record(stats->e2e[channel], now > sent_ns ? (now - sent_ns) / 1000 : 0);
+    stats->delivered[channel]++;
+
+    if (seq <= *last) {
+        stats->reordered[channel]++;
+    } else {
+        *last = seq;
+    }
+}
+
+/**
+ * @function op_succeeded: Whether a response code is a success for an operation.
+ *
+ * @param op Operation that was sent.
+ * @param code Status code received.
+ *
+ * @return 1 on success, 0 otherwise.
+ */
+static int op_succeeded(LoadOp op, int code) {
+    switch (op) {
+        case OP_MSG:         return code == STATUS_MSG_OK || code == STATUS_OFFLINE_MSG_OK;
+        case OP_GROUP_MSG:   return code == STATUS_GROUP_MSG_SENT_OK;
+        case OP_FRIEND_LIST: return code == STATUS_FRIEND_LIST_OK;
+        default:             return 0;
+    }
+}
+
+// ============================================================================
+// Event Handling
+// ============================================================================
+
+/**
+ * @function handle_line: Process one complete server message for a session.
+ *
+ * @param config Load configuration.
+ * @param sessions Array of sessions.
+ * @param phase Current phase.
+ * @param s Session that received the message.
+ * @param line Message without delimiter.
+ * @param stats Statistics to update.
+ *
+ * @return void
+ */
+static void handle_line(const LoadConfig *config, const Session *sessions, LoadPhase phase,
+                        Session *s, const char *line, LoadStats *stats) {
+    int code = atoi(line);
+
+    if (!s->ready) {
+        if (code == 100) s->ready = 1;
+        return;
+    }
+
+    if (is_push(line)) {
+        stats->pushes++;
+        record_delivery(config, s, line, stats);
+        return;
+    }
+
+    if (!s->awaiting || is_partial_page(line)) {
+        return;
+    }
+
+    s->awaiting = 0;
+
+    if (s->pending_is_op) {
+        uint64_t latency_us = (now_ns() - s->pending_since_ns) / 1000;
+        if (op_succeeded(s->pending_op, code)) {
+            stats->ok[s->pending_op]++;
+            histogram_record(stats->latency[s->pending_op], latency_us);
+
+            // 116 means the peer was offline: stored, not pushed
+            if (s->pending_op == OP_MSG && code == STATUS_MSG_OK) {
+                stats->expected[CHANNEL_DIRECT]++;
+            } else if (s->pending_op == OP_GROUP_MSG) {
+                stats->expected[CHANNEL_GROUP] += (unsigned long)group_live_peers(config, sessions, s->index);
+            }
+        } else {
+            stats->errors[s->pending_op]++;
+        }
+        s->pending_is_op = 0;
+        return;
+    }
+
+    // Setup responses: only registration and login are fatal; repeated runs
+    // legitimately hit "already exists / already friends / already in group".
+    if (phase == PHASE_REGISTER && code != STATUS_REGISTER_OK && code != STATUS_USERNAME_EXISTS) {
+        fprintf(stderr, "%s: register failed: %s\n", s->username, line);
+        stats->setup_errors++;
+        session_close(s);
+    } else if (phase == PHASE_LOGIN && code != STATUS_LOGIN_OK) {
+        fprintf(stderr, "%s: login failed: %s\n", s->username, line);
+        stats->setup_errors++;
+        session_close(s);
+    } else if (code >= 400 && code != STATUS_GROUP_EXISTS && code != STATUS_ALREADY_IN_GROUP) {
+        stats->setup_errors++;
+    }
+}
+
+/**
+ * @function session_read: Drain readable bytes from a session's socket.
+ *
+ * @param config Load configuration.
+ * @param sessions Array of sessions.
+ * @param phase Current phase.
+ * @param s Session to read.
+ * @param stats Statistics to update.
+ *
+ * @return void
+ */
+static void session_read(const LoadConfig *config, const Session *sessions, LoadPhase phase,
+                         Session *s, LoadStats *stats) {
+    char buffer[BUFFER_SIZE];
+
+    for (;;) {
+        size_t space = s->recv_buffer->capacity - s->recv_buffer->length - 1;
+        size_t want = space < sizeof(buffer) ? space : sizeof(buffer);
+        if (want == 0) {
+            fprintf(stderr, "%s: receive buffer full\n", s->username);
+            session_close(s);
+            return;
+        }
+
+        ssize_t received = recv(s->fd, buffer, want, 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            session_close(s);
+            return;
+        }
+        if (received == 0) {
+            session_close(s);
+            return;
+        }
+
+        stream_buffer_append(s->recv_buffer, buffer, (size_t)received);
+
+        char *line;
+        while ((line = stream_buffer_extract_message(s->recv_buffer)) != NULL) {
+            handle_line(config, sessions, phase, s, line, stats);
+            free(line);
+        }
+    }
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+/**
+ * @function print_report: Print throughput and latency results.
+ *
+ * @param config Load configuration.
+ * @param stats Collected statistics.
+ * @param run_seconds Measured length of the run phase.
+ * @param setup_seconds Time spent connecting and building the social graph.
+ * @param alive Sessions still connected at the end.
+ *
+ * @return void
+ */
+static void print_report(const LoadConfig *config, const LoadStats *stats,
+                         double run_seconds, double setup_seconds, int alive) {
+    unsigned long total_ok = 0, total_err = 0;
+    for (int op = 0; op < OP_COUNT; op++) {
+        total_ok += stats->ok[op];
+        total_err += stats->errors[op];
+    }
+    double throughput = run_seconds > 0 ? (double)total_ok / run_seconds : 0.0;
+
+    unsigned long lost[CHANNEL_COUNT];
+    for (int c = 0; c < CHANNEL_COUNT; c++) {
+        lost[c] = stats->expected[c] > stats->delivered[c] ? stats->expected[c] - stats->delivered[c] : 0;
+    }
+
+    if (config->json) {
+        printf("{\"scenario\":\"%s\",\"clients\":%d,\"alive\":%d,\"target_rate\":%.1f,\"duration_s\":%.3f,"
+               "\"setup_s\":%.3f,\"throughput\":%.1f,\"ok\":%lu,\"errors\":%lu,"
+               "\"timeouts\":%lu,\"pushes\":%lu,\"ops\":{",
+               config->scenario, config->clients, alive, config->rate, run_seconds, setup_seconds,
+               throughput, total_ok, total_err, stats->timeouts, stats->pushes);
+        for (int op = 0; op < OP_COUNT; op++) {
+            const Histogram *h = stats->latency[op];
+            printf("%s\"%s\":{\"ok\":%lu,\"errors\":%lu,\"mean_us\":%.1f,\"p50_us\":%llu,"
+                   "\"p90_us\":%llu,\"p99_us\":%llu,\"p999_us\":%llu,\"max_us\":%llu}",
+                   op > 0 ? "," : "", op_names[op], stats->ok[op], stats->errors[op],
+                   histogram_mean(h),
+                   (unsigned long long)histogram_value_at_percentile(h, 50.0),
+                   (unsigned long long)histogram_value_at_percentile(h, 90.0),
+                   (unsigned long long)histogram_value_at_percentile(h, 99.0),
+                   (unsigned long long)histogram_value_at_percentile(h, 99.9),
+                   (unsigned long long)(h->total_count ? h->max : 0));
+        }
+        printf("},\"e2e\":{");
+        for (int c = 0; c < CHANNEL_COUNT; c++) {
+            const Histogram *h = stats->e2e[c];
+            printf("%s\"%s\":{\"expected\":%lu,\"delivered\":%lu,\"lost\":%lu,\"reordered\":%lu,"
+                   "\"mean_us\":%.1f,\"p50_us\":%llu,\"p90_us\":%llu,\"p99_us\":%llu,"
+                   "\"p999_us\":%llu,\"max_us\":%llu}",
+                   c > 0 ? "," : "", channel_names[c], stats->expected[c], stats->delivered[c],
+                   lost[c], stats->reordered[c], histogram_mean(h),
+                   (unsigned long long)histogram_value_at_percentile(h, 50.0),
+                   (unsigned long long)histogram_value_at_percentile(h, 90.0),
+                   (unsigned long long)histogram_value_at_percentile(h, 99.0),
+                   (unsigned long long)histogram_value_at_percentile(h, 99.9),
+                   (unsigned long long)(h->total_count ? h->max : 0));
+        }
+        printf("}}\n");
+        return;
+    }
+
+    printf("\n=== LOAD RESULT (%s) ===\n", config->scenario);
+    printf("Clients: %d (%d alive)  Target: %.1f ops/s  Setup: %.2fs  Run: %.2fs\n",
+           config->clients, alive, config->rate, setup_seconds, run_seconds);
+    printf("Throughput: %.1f ops/s  OK: %lu  Errors: %lu  Timeouts: %lu  Pushes: %lu\n",
+           throughput, total_ok, total_err, stats->timeouts, stats->pushes);
+    printf("+-------------+----------+--------+-----------+-----------+-----------+-----------+-----------+\n");
+    printf("| %-11s | %8s | %6s | %9s | %9s | %9s | %9s | %9s |\n",
+           "Operation", "OK", "Errors", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms", "max ms");
+    printf("+-------------+----------+--------+-----------+-----------+-----------+-----------+-----------+\n");
+    for (int op = 0; op < OP_COUNT; op++) {
+        const Histogram *h = stats->latency[op];
+        printf("| %-11s | %8lu | %6lu | %9.3f | %9.3f | %9.3f | %9.3f | %9.3f |\n",
+               op_names[op], stats->ok[op], stats->errors[op],
+               histogram_value_at_percentile(h, 50.0) / 1000.0,
+               histogram_value_at_percentile(h, 90.0) / 1000.0,
+               histogram_value_at_percentile(h, 99.0) / 1000.0,
+               histogram_value_at_percentile(h, 99.9) / 1000.0,
+               (h->total_count ? h->max : 0) / 1000.0);
+    }
+    printf("+-------------+----------+--------+-----------+-----------+-----------+-----------+-----------+\n");
+
+    printf("\nEnd-to-end delivery (sender -> receiver):\n");
+    printf("+----------+-----------+-----------+--------+-----------+-----------+-----------+-----------+-----------+\n");
+    printf("| %-8s | %9s | %9s | %6s | %9s | %9s | %9s | %9s | %9s |\n",
+           "Channel", "Expected", "Delivered", "Lost", "Reordered", "p50 ms", "p99 ms", "p99.9 ms", "max ms");
+    printf("+----------+-----------+-----------+--------+-----------+-----------+-----------+-----------+-----------+\n");
+    for (int c = 0; c < CHANNEL_COUNT; c++) {
+        const Histogram *h = stats->e2e[c];
+        printf("| %-8s | %9lu | %9lu | %6lu | %9lu | %9.3f | %9.3f | %9.3f | %9.3f |\n",
+               channel_names[c], stats->expected[c], stats->delivered[c], lost[c], stats->reordered[c],
+               histogram_value_at_percentile(h, 50.0) / 1000.0,
+               histogram_value_at_percentile(h, 99.0) / 1000.0,
+               histogram_value_at_percentile(h, 99.9) / 1000.0,
+               (h->total_count ? h->max : 0) / 1000.0);
+    }
+    printf("+----------+-----------+-----------+--------+-----------+-----------+-----------+-----------+-----------+\n");
+}
+
+/**
+ * @function write_hgrm_files: Write one .hgrm percentile distribution per delivery channel.
+ *
+ * Files are named <prefix>_<scenario>_<channel>.hgrm with values in
+ * milliseconds; channels that saw no traffic are skipped.
+ *
+ * @param config Load configuration.
+ * @param stats Collected statistics.
+ *
+ * @return void
+ */
+static void write_hgrm_files(const LoadConfig *config, const LoadStats *stats) {
+    for (int c = 0; c < CHANNEL_COUNT; c++) {
+        if (stats->e2e[c]->total_count == 0) continue;
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s_%s_%s.hgrm", config->hgrm_prefix, config->scenario, channel_names[c]);
+
+        FILE *out = fopen(path, "w");
+        if (!out) {
+            fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+            continue;
+        }
+        histogram_write_percentiles(stats->e2e[c], out, 1000.0);
+        fclose(out);
+
+        if (!config->json) {
+            printf("Wrote %s\n", path);
+        }
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+/**
+ * @function parse_mix: Parse "msg=60,group=30,list=10" into operation weights.
+ *
+ * @param spec Mix specification.
+ * @param mix Output weights indexed by LoadOp.
+ *
+ * @return 0 on success, -1 on a malformed specification.
+ */
+static int parse_mix(const char *spec, int mix[OP_COUNT]) {
+    char *copy = strdup(spec);
+    if (!copy) return -1;
+
+    for (int op = 0; op < OP_COUNT; op++) mix[op] = 0;
+
+    int result = 0;
+    for (char *item = strtok(copy, ","); item; item = strtok(NULL, ",")) {
+        char *eq = strchr(item, '=');
+        if (!eq) { result = -1; break; }
+        *eq = '\0';
+        int weight = atoi(eq + 1);
+        if (strcmp(item, "msg") == 0) mix[OP_MSG] = weight;
+        else if (strcmp(item, "group") == 0) mix[OP_GROUP_MSG] = weight;
+        else if (strcmp(item, "list") == 0) mix[OP_FRIEND_LIST] = weight;
+        else { result = -1; break; }
+    }
+
+    free(copy);
+    return result;
+}
+
+/**
+ * @function apply_scenario: Load the preset for a named scenario.
+ *
+ * Presets set clients, rate, friends, group size and mix; options given
+ * after -S override them.
+ *
+ * @param name Scenario name.
+ * @param config Configuration to update.
+ *
+ * @return 0 on success, -1 for an unknown scenario.
+ */
+static int apply_scenario(const char *name, LoadConfig *config) {
+    if (strcmp(name, "mixed") == 0) {
+        config->friends = 2;
+        config->group_size = 10;
+        config->mix[OP_MSG] = 60; config->mix[OP_GROUP_MSG] = 30; config->mix[OP_FRIEND_LIST] = 10;
+    } else if (strcmp(name, "direct") == 0) {
+        config->friends = 2;
+        config->group_size = 0;
+        config->mix[OP_MSG] = 100; config->mix[OP_GROUP_MSG] = 0; config->mix[OP_FRIEND_LIST] = 0;
+    } else if (strcmp(name, "group10") == 0) {
+        config->friends = 0;
+        config->group_size = 10;
+        config->mix[OP_MSG] = 0; config->mix[OP_GROUP_MSG] = 100; config->mix[OP_FRIEND_LIST] = 0;
+    } else if (strcmp(name, "group1000") == 0) {
+        // Every message fans out to 999 members, so keep the send rate low
+        config->clients = 1000;
+        config->rate = 20.0;
+        config->friends = 0;
+        config->group_size = 1000;
+        config->mix[OP_MSG] = 0; config->mix[OP_GROUP_MSG] = 100; config->mix[OP_FRIEND_LIST] = 0;
+    } else {
+        return -1;
+    }
+
+    config->scenario = name;
+    return 0;
+}
+
+/**
+ * @function print_usage: Print command line help.
+ *
+ * @param prog Program name.
+ *
+ * @return void
+ */
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -h HOST        Server address (default 127.0.0.1)\n");
+    printf("  -p PORT        Server port (default 8888)\n");
+    printf("  -c CLIENTS     Concurrent connections / users (default 50)\n");
+    printf("  -r RATE        Aggregate operations per second (default 200)\n");
+    printf("  -d SECONDS     Run phase duration (default 30)\n");
+    printf("  -f FRIENDS     Friends on each side of the friend ring (default 2)\n");
+    printf("  -g SIZE        Members per group, 0 to disable (default 10)\n");
+    printf("  -m MIX         Operation weights (default msg=60,group=30,list=10)\n");
+    printf("  -u PREFIX      Username prefix (default lg)\n");
+    printf("  -w PASSWORD    Password for synthetic users (default loadgen123)\n");
+    printf("  -s SEED        Random seed (default 1)\n");
+    printf("  -j             Print the result as one JSON line\n");
+    printf("  -S SCENARIO    Preset: mixed, direct, group10, group1000 (default mixed;\n");
+    printf("                 put it first, later options override the preset)\n");
+    printf("  -D SECONDS     Keep reading pushes after the run to settle loss counts (default 2)\n");
+    printf("  -o PREFIX      Write end-to-end latency as PREFIX_<scenario>_<channel>.hgrm\n");
+}
+
+int main(int argc, char *argv[]) {
+    LoadConfig config = {
+        .host = "127.0.0.1", .port = 8888, .clients = 50, .rate = 200.0,
+        .duration = 30, .friends = 2, .group_size = 10,
+        .mix = { 60, 30, 10 }, .prefix = "lg", .password = "loadgen123",
+        .seed = 1, .json = 0, .scenario = "mixed", .drain = 2, .hgrm_prefix = NULL
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:c:r:d:f:g:m:u:w:s:jS:D:o:")) != -1) {
+        switch (opt) {
+            case 'h': config.host = optarg; break;
+            case 'p': config.port = atoi(optarg); break;
+            case 'c': config.clients = atoi(optarg); break;
+            case 'r': config.rate = atof(optarg); break;
+            case 'd': config.duration = atoi(optarg); break;
+            case 'f': config.friends = atoi(optarg); break;
+            case 'g': config.group_size = atoi(optarg); break;
+            case 'm':
+                if (parse_mix(optarg, config.mix) < 0) {
+                    fprintf(stderr, "Invalid mix: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'u': config.prefix = optarg; break;
+            case 'w': config.password = optarg; break;
+            case 's': config.seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'j': config.json = 1; break;
+            case 'S':
+                if (apply_scenario(optarg, &config) < 0) {
+                    fprintf(stderr, "Unknown scenario: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'D': config.drain = atoi(optarg); break;
+            case 'o': config.hgrm_prefix = optarg; break;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (config.clients < 1 || config.rate <= 0 || config.duration < 1 || config.drain < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (config.friends > config.clients - 1) {
+        config.friends = config.clients - 1;
+    }
+
+    srand(config.seed);
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, handle_sigint);
+
+    // Thousands of sockets need more descriptors than the usual soft limit
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t)config.clients + 64) {
+        limit.rlim_cur = (rlim_t)config.clients + 64;
+        if (limit.rlim_cur > limit.rlim_max) limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config.port);
+    if (inet_pton(AF_INET, config.host, &addr.sin_addr) <= 0) {
+        fprintf(stderr, "Invalid address: %s\n", config.host);
+        return 1;
+    }
+
+    Session *sessions = (Session*)calloc(config.clients, sizeof(Session));
+    struct pollfd *pfds = (struct pollfd*)calloc(config.clients, sizeof(struct pollfd));
+    if (!sessions || !pfds) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (int i = 0; i < config.clients; i++) {
+        sessions[i].fd = -1;
+        sessions[i].index = i;
+        sessions[i].recv_buffer = stream_buffer_create();
+        snprintf(sessions[i].username, sizeof(sessions[i].username), "%s_%05d", config.prefix, i);
+        sessions[i].direct_seq_out = (unsigned long*)calloc(2 * config.friends + 1, sizeof(unsigned long));
+        sessions[i].direct_seq_in = (unsigned long*)calloc(2 * config.friends + 1, sizeof(unsigned long));
+        sessions[i].group_seq_in = (unsigned long*)calloc(config.group_size + 1, sizeof(unsigned long));
+        if (!sessions[i].recv_buffer || !sessions[i].direct_seq_out ||
+            !sessions[i].direct_seq_in || !sessions[i].group_seq_in) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    LoadStats stats;
+    memset(&stats, 0, sizeof(stats));
+    for (int op = 0; op < OP_COUNT; op++) {
+        stats.latency[op] = histogram_create();
+    }
+    for (int c = 0; c < CHANNEL_COUNT; c++) {
+        stats.e2e[c] = histogram_create();
+    }
+
+    LoadPhase phase = PHASE_CONNECT;
+    int next_connect = 0;
+    uint64_t start_ns = now_ns();
+    uint64_t run_start_ns = 0, run_end_ns = 0, drain_end_ns = 0, last_progress_ns = 0;
+    uint64_t interval_ns = (uint64_t)((double)config.clients * 1e9 / config.rate);
+    unsigned long last_progress_ok = 0;
+
+    if (!config.json) {
+        printf("Load generator [%s]: %d clients -> %s:%d, %.1f ops/s for %ds\n",
+               config.scenario, config.clients, config.host, config.port, config.rate, config.duration);
+    }
+
+    while (phase != PHASE_DONE) {
+        uint64_t now = now_ns();
+
+        if (stop_requested) {
+            if (phase == PHASE_RUN) run_end_ns = now;
+            break;
+        }
+
+        // Ramp up connections a batch per tick so the listen backlog keeps up
+        if (phase == PHASE_CONNECT) {
+            for (int k = 0; k < LOADGEN_CONNECTS_PER_TICK && next_connect < config.clients; k++) {
+                if (session_connect(&sessions[next_connect], &addr) < 0) {
+                    sessions[next_connect].failed = 1;
+                }
+                next_connect++;
+            }
+        }
+
+        // Drive scripted commands and scheduled operations
+        int phase_complete = (phase != PHASE_CONNECT || next_connect == config.clients);
+        for (int i = 0; i < config.clients; i++) {
+            Session *s = &sessions[i];
+            if (s->failed) continue;
+
+            if (phase == PHASE_CONNECT) {
+                if (!s->ready) phase_complete = 0;
+                continue;
+            }
+
+            // A lost response must not stall the session forever
+            if (s->awaiting && now > s->pending_since_ns &&
+                now - s->pending_since_ns > LOADGEN_RESPONSE_TIMEOUT_NS) {
+                stats.timeouts++;
+                if (s->pending_is_op) stats.errors[s->pending_op]++;
+                s->awaiting = 0;
+                s->pending_is_op = 0;
+            }
+
+            if (phase == PHASE_RUN) {
+                if (!s->op_queued && now >= s->next_due_ns) {
+                    s->op_queued = 1;
+                    s->op_due_ns = s->next_due_ns;
+                    s->next_due_ns += interval_ns;
+                }
+                if (s->op_queued && !s->awaiting) {
+                    send_op(&config, sessions, s, s->op_due_ns);
+                    s->op_queued = 0;
+                }
+                continue;
+            }
+            if (phase == PHASE_DRAIN) continue;
+
+            if (!s->awaiting && s->script_pos < s->script_len) {
+                if (session_queue(s, s->script[s->script_pos])) {
+                    s->script_pos++;
+                    s->awaiting = 1;
+                    s->pending_is_op = 0;
+                    s->pending_since_ns = now;
+                }
+            }
+            if (s->awaiting || s->script_pos < s->script_len) {
+                phase_complete = 0;
+            }
+        }
+
+        if (phase == PHASE_RUN && now >= run_start_ns + (uint64_t)config.duration * 1000000000ULL) {
+            run_end_ns = now;
+            if (config.drain == 0) break;
+
+            // Stop sending but keep reading so in-flight pushes are not counted as lost
+            phase = PHASE_DRAIN;
+            drain_end_ns = now + (uint64_t)config.drain * 1000000000ULL;
+            if (!config.json) {
+                printf("[%6.2fs] phase: %s\n", (now - start_ns) / 1e9, phase_names[phase]);
+            }
+        }
+        if (phase == PHASE_DRAIN && now >= drain_end_ns) {
+            break;
+        }
+
+        if (phase < PHASE_RUN && phase_complete) {
+            do {
+                phase = (LoadPhase)(phase + 1);
+            } while ((phase == PHASE_GROUP_CREATE || phase == PHASE_GROUP_INVITE ||
+                      phase == PHASE_GROUP_ENTER) && config.group_size <= 1);
+            while ((phase == PHASE_FRIEND_REQ || phase == PHASE_FRIEND_ACCEPT) &&
+                   config.friends <= 0) {
+                phase = (LoadPhase)(phase + 1);
+            }
+
+            if (!config.json) {
+                printf("[%6.2fs] phase: %s\n", (now - start_ns) / 1e9, phase_names[phase]);
+            }
+
+            if (phase == PHASE_RUN) {
+                run_start_ns = now;
+                last_progress_ns = now;
+                for (int i = 0; i < config.clients; i++) {
+                    script_free(&sessions[i]);
+                    sessions[i].next_due_ns = now + (uint64_t)(rand() % 1000000) * interval_ns / 1000000;
+                }
+            } else {
+                build_phase_scripts(&config, sessions, phase);
+            }
+            continue;
+        }
+
+        if (phase == PHASE_RUN && !config.json && now - last_progress_ns >= 1000000000ULL) {
+            unsigned long ok = 0;
+            for (int op = 0; op < OP_COUNT; op++) ok += stats.ok[op];
+            printf("[%6.2fs] run: %.0f ops/s\n", (now - start_ns) / 1e9,
+                   (double)(ok - last_progress_ok) * 1e9 / (double)(now - last_progress_ns));
+            last_progress_ok = ok;
+            last_progress_ns = now;
+        }
+
+        // Poll every live socket
+        int nfds = 0;
+        for (int i = 0; i < config.clients; i++) {
+            Session *s = &sessions[i];
+            if (s->fd < 0 || s->failed) continue;
+            pfds[nfds].fd = s->fd;
+            pfds[nfds].events = POLLIN | (s->out_len > 0 ? POLLOUT : 0);
+            pfds[nfds].revents = 0;
+            nfds++;
+        }
+
+        int timeout_ms = (phase == PHASE_RUN || phase == PHASE_DRAIN) ? 1 : 10;
+        if (poll(pfds, nfds, timeout_ms) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        for (int k = 0, i = 0; k < nfds; k++) {
+            while (sessions[i].fd != pfds[k].fd) i++;
+            Session *s = &sessions[i];
+
+            if (pfds[k].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(s->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (!(pfds[k].revents & POLLIN)) {
+                    session_close(s);
+                    continue;
+                }
+            }
+            if (pfds[k].revents & POLLIN) {
+                session_read(&config, sessions, phase, s, &stats);
+            }
+            if (!s->failed && (pfds[k].revents & POLLOUT || s->out_len > 0)) {
+                if (session_flush(s) < 0) session_close(s);
+            }
+        }
+    }
+
+    int alive = 0;
+    for (int i = 0; i < config.clients; i++) {
+        if (!sessions[i].failed) alive++;
+    }
+
+    double setup_seconds = run_start_ns ? (run_start_ns - start_ns) / 1e9 : (now_ns() - start_ns) / 1e9;
+    double run_seconds = (run_start_ns && run_end_ns > run_start_ns) ? (run_end_ns - run_start_ns) / 1e9 : 0.0;
+    print_report(&config, &stats, run_seconds, setup_seconds, alive);
+    if (config.hgrm_prefix) {
+        write_hgrm_files(&config, &stats);
+    }
+
+    for (int i = 0; i < config.clients; i++) {
+        script_free(&sessions[i]);
+        if (sessions[i].fd >= 0) close(sessions[i].fd);
+        stream_buffer_destroy(sessions[i].recv_buffer);
+        free(sessions[i].direct_seq_out);
+        free(sessions[i].direct_seq_in);
+        free(sessions[i].group_seq_in);
+    }
+    for (int op = 0; op < OP_COUNT; op++) {
+        histogram_destroy(stats.latency[op]);
+    }
+    for (int c = 0; c < CHANNEL_COUNT; c++) {
+        histogram_destroy(stats.e2e[c]);
+    }
+    free(sessions);
+    free(pfds);
+
+    return (alive == 0 || run_seconds == 0.0) ? 1 : 0;
+}
@@ -5,19 +5,33 @@ Tests the 3 implemented tasks:
 1. Stream processing
 2. Socket I/O
 3. User registration & authentication
+and the session features built on them:
+4. Session resume tokens (RESUME)
+5. Versioned friend lists (FRIEND_LIST_SYNC)
 """
 
+import re
 import socket
 import sys
 import time
 
 DELIMITER = b"\r\n"
 
+# Server defaults (CHAT_RATE_AUTH_IP = 60/20): REGISTER, LOGIN and RESUME per
+# IP per minute, and the burst available at once. The suite must fit in them.
+AUTH_PER_MINUTE = 60
+AUTH_BURST = 20
+
 class ChatClient:
+    # Across every client in the run
+    auth_sent = 0
+    rate_limited = 0
+    
     def __init__(self, host='localhost', port=8888):
         self.host = host
         self.port = port
         self.sock = None
+        self.pending = b""
         
     def connect(self):
         """Connect to the server"""
@@ -51,6 +65,8 @@ class ChatClient:
             full_message = message.encode() + DELIMITER
             self.sock.sendall(full_message)
             print(f"→ Sent: {message}")
+            if message.split(" ", 1)[0] in ("REGISTER", "LOGIN", "RESUME"):
+                ChatClient.auth_sent += 1
             return True
         except Exception as e:
             print(f"✗ Send failed: {e}")
@@ -79,6 +95,8 @@ class ChatClient:
             # Remove delimiter and decode
             message = data.replace(DELIMITER, b"").decode().strip()
             print(f"← Received: {message}")
+            if message.startswith("429"):
+                ChatClient.rate_limited += 1
             return message
         except socket.timeout:
             print("✗ Receive timeout")
@@ -87,6 +105,41 @@ class ChatClient:
             print(f"✗ Receive failed: {e}")
             return None
     
+    def receive_response(self, codes, timeout=2):
+        """Receive until a response with one of the status codes, skipping pushes"""
+        if not self.sock:
+            print("✗ Not connected")
+            return None
+        
+        deadline = time.time() + timeout
+        try:
+            while True:
+                while DELIMITER in self.pending:
+                    line, self.pending = self.pending.split(DELIMITER, 1)
+                    message = line.decode().strip()
+                    if message.startswith("429"):
+                        ChatClient.rate_limited += 1
+                    if message[:3] in codes:
+                        print(f"← Received: {message}")
+                        return message
+                    print(f"← Skipped: {message.splitlines()[0] if message else ''}")
+                
+                remaining = deadline - time.time()
+                if remaining <= 0:
+                    raise socket.timeout()
+                self.sock.settimeout(remaining)
+                chunk = self.sock.recv(4096)
+                if not chunk:
+                    print("✗ Connection closed")
+                    return None
+                self.pending += chunk
+        except socket.timeout:
+            print("✗ Receive timeout")
+            return None
+        except Exception as e:
+            print(f"✗ Receive failed: {e}")
+            return None
+    
     def test_register(self, username, password):
         """Test REGISTER command"""
         print(f"\n=== Testing REGISTER: {username} ===")
@@ -129,6 +182,81 @@ class ChatClient:
                 return False
         return False
     
+    def test_login_token(self, username, password):
+        """Test LOGIN hands out a resume token; returns the token"""
+        print(f"\n=== Testing LOGIN resume token: {username} ===")
+        if self.send(f"LOGIN {username} {password}"):
+            response = self.receive_response(("102", "429"))
+            match = re.search(r"resume=([0-9a-f]+)", response or "")
+            if response and response.startswith("102") and match:
+                print("✓ Login returned a resume token")
+                return match.group(1)
+            print("✗ No resume token in login response")
+        return None
+    
+    def test_resume(self, token, expect_ok=True):
+        """Test RESUME with a token; returns the replacement token (or True for an expected 307)"""
+        print(f"\n=== Testing RESUME ({'valid' if expect_ok else 'spent/invalid'} token) ===")
+        if self.send(f"RESUME {token} 0"):
+            response = self.receive_response(("127", "307", "429", "500"))
+            if expect_ok:
+                match = re.search(r"resume=([0-9a-f]+)", response or "")
+                if response and response.startswith("127") and match and match.group(1) != token:
+                    print("✓ Session resumed with a new token")
+                    return match.group(1)
+                print("✗ Resume failed")
+                return None
+            if response and response.startswith("307"):
+                print("✓ Server refused the token with 307")
+                return True
+            print("✗ Expected 307")
+        return None
+    
+    def test_friend_req(self, username):
+        """Test FRIEND_REQ command"""
+        print(f"\n=== Testing FRIEND_REQ: {username} ===")
+        if self.send(f"FRIEND_REQ {username}"):
+            response = self.receive_response(("104", "429") + tuple(str(c) for c in range(400, 600)))
+            if response and response.startswith("104"):
+                print("✓ Friend request sent")
+                return True
+            print("✗ Friend request failed")
+        return False
+    
+    def test_friend_accept(self, username):
+        """Test FRIEND_ACCEPT command"""
+        print(f"\n=== Testing FRIEND_ACCEPT: {username} ===")
+        if self.send(f"FRIEND_ACCEPT {username}"):
+            response = self.receive_response(("105", "429") + tuple(str(c) for c in range(400, 600)))
+            if response and response.startswith("105"):
+                print("✓ Friend request accepted")
+                return True
+            print("✗ Friend accept failed")
+        return False
+    
+    def test_friend_list_sync(self, version, expected_mode):
+        """Test FRIEND_LIST_SYNC; returns (version, entry lines) or None"""
+        print(f"\n=== Testing FRIEND_LIST_SYNC {version} (expect {expected_mode}) ===")
+        if not self.send(f"FRIEND_LIST_SYNC {version}" if version is not None else "FRIEND_LIST_SYNC"):
+            return None
+        
+        entries = []
+        while True:
+            response = self.receive_response(("129", "429", "500"))
+            header = re.search(r"FRIEND_SYNC version=(\d+) mode=(\w+) .*end=(\d)", response or "")
+            if not header:
+                print("✗ No FRIEND_SYNC frame")
+                return None
+            entries += response.split("\n")[1:]
+            if header.group(3) == "1":
+                break
+        
+        if header.group(2) != expected_mode:
+            print(f"✗ Expected mode={expected_mode}, got mode={header.group(2)}")
+            return None
+        print(f"✓ mode={expected_mode} at version {header.group(1)}")
+        return int(header.group(1)), entries
+    
     def test_invalid_command(self):
         """Test invalid command"""
         print(f"\n=== Testing INVALID COMMAND ===")
@@ -220,6 +348,72 @@ def run_basic_tests():
     print("    TEST SUITE COMPLETE")
     print("=" * 60)
 
+def run_session_tests():
+    """Run RESUME and FRIEND_LIST_SYNC round trips with three fresh users"""
+    print("=" * 60)
+    print("    CHAT SERVER TEST SUITE - Resume & Friend List Sync")
+    print("=" * 60)
+    
+    stamp = int(time.time())
+    alice, bob, carol = f"rs_a_{stamp}", f"rs_b_{stamp}", f"rs_c_{stamp}"
+    password = "password123"
+    results = {}
+    clients = []
+    
+    def session(username):
+        client = ChatClient()
+        if not client.connect():
+            return None
+        clients.append(client)
+        if username:
+            client.test_register(username, password)
+        return client
+    
+    a = session(alice)
+    b = session(bob)
+    c = session(carol)
+    if not a or not b or not c:
+        return
+    
+    # Test 12: RESUME after LOGIN, on a new connection
+    token = a.test_login_token(alice, password)
+    a.disconnect()
+    a = session(None)
+    new_token = a.test_resume(token) if token else None
+    results["RESUME after LOGIN"] = bool(new_token)
+    
+    # Test 13: the spent token, then a made-up one, are refused with 307
+    probe = session(None)
+    results["RESUME spent token -> 307"] = bool(token) and probe.test_resume(token, expect_ok=False) is True
+    results["RESUME invalid token -> 307"] = probe.test_resume("00" * 24, expect_ok=False) is True
+    
+    # Test 14: FRIEND_LIST_SYNC full -> unchanged -> delta after FRIEND_ACCEPT
+    b.test_login(bob, password)
+    c.test_login(carol, password)
+    ok = a.test_friend_req(bob) and b.test_friend_accept(alice)
+    full = a.test_friend_list_sync(None, "full") if ok else None
+    ok = bool(full) and any(line.startswith(f"+{bob}") for line in full[1])
+    unchanged = a.test_friend_list_sync(full[0], "unchanged") if ok else None
+    ok = bool(unchanged) and c.test_friend_req(alice) and a.test_friend_accept(carol)
+    delta = a.test_friend_list_sync(full[0], "delta") if ok else None
+    added = [line for line in delta[1] if line] if delta else []
+    ok = bool(delta) and delta[0] > full[0] and len(added) == 1 and added[0].startswith(f"+{carol}")
+    results["FRIEND_LIST_SYNC full/unchanged/delta"] = ok
+    
+    # Test 15: the whole run (both suites) stays inside the default per-IP auth budget
+    print("\n=== Testing Default Rate Limits ===")
+    results["Default rate limits"] = ChatClient.auth_sent <= AUTH_BURST and ChatClient.rate_limited == 0
+    print(f"{'✓' if results['Default rate limits'] else '✗'} {ChatClient.auth_sent} auth command(s) "
+          f"(burst {AUTH_BURST}, {AUTH_PER_MINUTE}/min), {ChatClient.rate_limited} rate-limited response(s)")
+    
+    for client in clients:
+        client.disconnect()
+    
+    print("\n" + "=" * 60)
+    for name, passed in results.items():
+        print(f"  {'✓' if passed else '✗'} {name}")
+    print("=" * 60)
+
 def interactive_mode():
     """Interactive mode for manual testing"""
     print("=" * 60)
@@ -262,4 +456,5 @@ if __name__ == "__main__":
     if len(sys.argv) > 1 and sys.argv[1] == "-i":
         interactive_mode()
     else:
-        run_basic_tests()
\ No newline at end of file
+        run_basic_tests()
+        run_session_tests()
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "compress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Preset dictionary shared by both ends: the phrases the server repeats in
+// friend tables, offline dumps and notifications. Most useful for the first
+// frames of a connection, before the stream window has history of its own.
+static const char compression_dictionary[] =
+    "+-----+----------------------+------------+\n"
+    "| STT | Username             | Status     |\n"
+    "| Online     |\n| Offline    |\nTotal: friend(s)"
+    "+-----+----------------------+----------------------------+\n"
+    "OFFLINE_NOTIFICATION type=\"GROUP_INVITE\" group_id= sender=\"\" message=\"\" time=\""
+    "GROUP_INVITE_NOTIFICATION group_name=\"\" invited_by=\"\""
+    "GROUP_JOIN_REQUEST_NOTIFICATION requester=\" wants to join group '"
+    "You have been added to group ' by "
+    "=== OFFLINE MESSAGES FROM GROUP '\n"
+    "=== END OF UNREAD MESSAGES ( total) ===\n"
+    "=== SHOW OFFLINE MESSAGES FROM  ===\n"
+    "=== END OF OFFLINE MESSAGES ( total) ===\n"
+    "NEW_MESSAGE from : GROUP_MSG \r\n";
+
+#define COMPRESSION_HEADER_RESERVE 48
+
+/**
+ * @function find_delimiter: Locate the protocol delimiter in a possibly binary buffer.
+ *
+ * @param data Pointer to the buffer.
+ * @param len Number of valid bytes in the buffer.
+ *
+ * @return Offset of the delimiter, or -1 if not present.
+ */
+static long find_delimiter(const char *data, size_t len) {
+    for (size_t i = 0; i + 1 < len; i++) {
+        if (data[i] == '\r' && data[i + 1] == '\n') {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @function stream_buffer_consume: Drop bytes from the front of a StreamBuffer.
+ *
+ * @param buffer Pointer to the StreamBuffer.
+ * @param count Number of bytes to drop.
+ *
+ * @return void
+ */
+static void stream_buffer_consume(StreamBuffer *buffer, size_t count) {
+    if (count >= buffer->length) {
+        buffer->length = 0;
+    } else {
+        memmove(buffer->data, buffer->data + count, buffer->length - count);
+        buffer->length -= count;
+    }
+    buffer->data[buffer->length] = '\0';
+}
+
+// ============================================================================
+// Compressor (sender side)
+// ============================================================================
+
+/**
+ * @function compressor_create: Creates a deflate stream for one connection.
+ *
+ * @param threshold Frames shorter than this many bytes are sent uncompressed.
+ *
+ * @return Pointer to the new Compressor, or NULL on failure.
+ */
+Compressor* compressor_create(size_t threshold) {
+    Compressor *comp = (Compressor*)malloc(sizeof(Compressor));
+    if (!comp) return NULL;
+
+    memset(comp, 0, sizeof(Compressor));
+    comp->threshold = threshold;
+
+    if (deflateInit2(&comp->stream, COMPRESSION_LEVEL, Z_DEFLATED,
+                     -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        free(comp);
+        return NULL;
+    }
+
+    if (deflateSetDictionary(&comp->stream, (const Bytef*)compression_dictionary,
+                             sizeof(compression_dictionary) - 1) != Z_OK) {
+        deflateEnd(&comp->stream);
+        free(comp);
+        return NULL;
+    }
+
+    return comp;
+}
+
+/**
+ * @function compressor_destroy: Frees a Compressor and its deflate stream.
+ *
+ * @param comp Pointer to the Compressor.
+ *
+ * @return void
+ */
+void compressor_destroy(Compressor *comp) {
+    if (comp) {
+        deflateEnd(&comp->stream);
+        free(comp);
+    }
+}
+
+/**
+ * @function compressor_encode: Compresses one outgoing payload into a wire frame.
+ *
+ * @param comp Pointer to the Compressor.
+ * @param data Raw payload (one or more complete responses).
+ * @param len Length of the raw payload.
+ * @param out_len Receives the length of the returned frame.
+ *
+ * @return Dynamically allocated frame (header + compressed bytes), or NULL if
+ *         the payload should be sent uncompressed (below threshold, too large
+ *         or compression error).
+ */
+char* compressor_encode(Compressor *comp, const char *data, size_t len, size_t *out_len) {
+    if (!comp || !data || !out_len) return NULL;
+
+    if (len < comp->threshold || len > COMPRESSION_MAX_RAW_LENGTH) {
+        comp->frames_passthrough++;
+        return NULL;
+    }
+
+    // Generous bound: once bytes enter the stream they must reach the peer,
+    // so the output buffer can never be allowed to run out mid-frame.
+    size_t bound = len + (len >> 3) + 128;
+    char *frame = (char*)malloc(COMPRESSION_HEADER_RESERVE + bound);
+    if (!frame) return NULL;
+
+    char *payload = frame + COMPRESSION_HEADER_RESERVE;
+    comp->stream.next_in = (Bytef*)data;
+    comp->stream.avail_in = (uInt)len;
+    comp->stream.next_out = (Bytef*)payload;
+    comp->stream.avail_out = (uInt)bound;
+
+    int ret = deflate(&comp->stream, Z_SYNC_FLUSH);
+    if (ret != Z_OK || comp->stream.avail_in != 0 || comp->stream.avail_out == 0) {
+        fprintf(stderr, "Compression error: deflate returned %d\n", ret);
+        free(frame);
+        return NULL;
+    }
+
+    size_t compressed_len = bound - comp->stream.avail_out;
+
+    char header[COMPRESSION_HEADER_RESERVE];
+    int header_len = snprintf(header, sizeof(header), "%s%zu %zu%s",
+                              COMPRESSION_FRAME_PREFIX, compressed_len, len,
+                              PROTOCOL_DELIMITER);
+
+    memmove(frame + header_len, payload, compressed_len);
+    memcpy(frame, header, header_len);
+
+    comp->frames_compressed++;
+    comp->bytes_in += len;
+    comp->bytes_out += header_len + compressed_len;
+
+    *out_len = header_len + compressed_len;
+    return frame;
+}
+
+// ============================================================================
+// Decompressor (receiver side)
+// ============================================================================
+
+/**
+ * @function decompressor_create: Creates the inflate stream matching a server Compressor.
+ *
+ * @return Pointer to the new Decompressor, or NULL on failure.
+ */
+Decompressor* decompressor_create(void) {
+    Decompressor *decomp = (Decompressor*)malloc(sizeof(Decompressor));
+    if (!decomp) return NULL;
+
+    memset(decomp, 0, sizeof(Decompressor));
+
+    if (inflateInit2(&decomp->stream, -MAX_WBITS) != Z_OK) {
+        free(decomp);
+        return NULL;
+    }
+
+    if (inflateSetDictionary(&decomp->stream, (const Bytef*)compression_dictionary,
+                             sizeof(compression_dictionary) - 1) != Z_OK) {
+        inflateEnd(&decomp->stream);
+        free(decomp);
+        return NULL;
+    }
+
+    return decomp;
+}
+
+/**
+ * @function decompressor_destroy: Frees a Decompressor and its inflate stream.
+ *
+ * @param decomp Pointer to the Decompressor.
+ *
+ * @return void
+ */
+void decompressor_destroy(Decompressor *decomp) {
+    if (decomp) {
+        inflateEnd(&decomp->stream);
+        free(decomp);
+    }
+}
+
+/**
+ * @function decompressor_decode: Moves complete frames from the wire buffer to the plain buffer.
+ *
+ * Plain "\r\n" lines are copied through unchanged; compressed frames are
+ * inflated. Decoding stops when the wire buffer holds only a partial frame or
+ * when the plain buffer has no room for the next one, so callers should
+ * extract messages from the plain buffer and call again.
+ *
+ * @param decomp Pointer to the Decompressor.
+ * @param wire StreamBuffer holding bytes as received from the socket.
+ * @param plain StreamBuffer receiving decoded protocol messages.
+ *
+ * @return Number of bytes appended to the plain buffer, or -1 on a corrupt stream.
+ */
+int decompressor_decode(Decompressor *decomp, StreamBuffer *wire, StreamBuffer *plain) {
+    if (!decomp || !wire || !plain) return -1;
+
+    int produced_total = 0;
+
+    while (wire->length > 0) {
+        if (decomp->pending_compressed > 0) {
+            if (wire->length < decomp->pending_compressed) break;
+            if (plain->length + decomp->pending_raw >= plain->capacity) break;
+
+            decomp->stream.next_in = (Bytef*)wire->data;
+            decomp->stream.avail_in = (uInt)decomp->pending_compressed;
+            decomp->stream.next_out = (Bytef*)(plain->data + plain->length);
+            decomp->stream.avail_out = (uInt)(plain->capacity - plain->length - 1);
+
+            int ret = inflate(&decomp->stream, Z_SYNC_FLUSH);
+            size_t produced = (plain->capacity - plain->length - 1) - decomp->stream.avail_out;
+
+            if ((ret != Z_OK && ret != Z_BUF_ERROR) || decomp->stream.avail_in != 0 ||
+                produced != decomp->pending_raw) {
+                fprintf(stderr, "Decompression error: inflate returned %d\n", ret);
+                return -1;
+            }
+
+            plain->length += produced;
+            plain->data[plain->length] = '\0';
+            stream_buffer_consume(wire, decomp->pending_compressed);
+
+            decomp->bytes_in += decomp->pending_compressed;
+            decomp->bytes_out += produced;
+            decomp->pending_compressed = 0;
+            decomp->pending_raw = 0;
+            produced_total += (int)produced;
+            continue;
+        }
+
+        long delim = find_delimiter(wire->data, wire->length);
+        if (delim < 0) break;
+
+        size_t line_len = (size_t)delim + strlen(PROTOCOL_DELIMITER);
+
+        if (strncmp(wire->data, COMPRESSION_FRAME_PREFIX, strlen(COMPRESSION_FRAME_PREFIX)) == 0) {
+            size_t compressed_len = 0, raw_len = 0;
+            if (sscanf(wire->data + strlen(COMPRESSION_FRAME_PREFIX), "%zu %zu",
+                       &compressed_len, &raw_len) != 2 ||
+                compressed_len == 0 || raw_len > COMPRESSION_MAX_RAW_LENGTH ||
+                compressed_len >= wire->capacity) {
+                fprintf(stderr, "Decompression error: malformed frame header\n");
+                return -1;
+            }
+
+            stream_buffer_consume(wire, line_len);
+            decomp->pending_compressed = compressed_len;
+            decomp->pending_raw = raw_len;
+            continue;
+        }
+
+        if (plain->length + line_len >= plain->capacity) break;
+
+        memcpy(plain->data + plain->length, wire->data, line_len);
+        plain->length += line_len;
+        plain->data[plain->length] = '\0';
+        stream_buffer_consume(wire, line_len);
+        produced_total += (int)line_len;
+    }
+
+    return produced_total;
+}
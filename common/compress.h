@@ -0,0 +1,54 @@
+// ============================================================================
+// compress.h - Per-connection payload compression (zlib raw deflate)
+// ============================================================================
+
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stddef.h>
+#include <zlib.h>
+#include "protocol.h"
+
+// Negotiation: client sends "COMPRESS deflate", server answers
+// "123 deflate threshold=<n>" and from then on may send compressed frames.
+#define COMPRESSION_ALGORITHM "deflate"
+#define COMPRESSION_DEFAULT_THRESHOLD 256
+#define COMPRESSION_LEVEL 6
+
+// Compressed frame on the wire:
+//   "124 <compressed_len> <raw_len>\r\n" followed by <compressed_len> raw bytes.
+// The payload inflates to one or more ordinary "\r\n"-terminated responses.
+#define COMPRESSION_FRAME_PREFIX "124 "
+#define COMPRESSION_MAX_RAW_LENGTH (MAX_MESSAGE_LENGTH * 2 - 1)
+
+// Sender side (server): one long-lived deflate stream per connection, so later
+// frames can back-reference earlier ones (shared dictionary context).
+typedef struct {
+    z_stream stream;
+    size_t threshold;
+    unsigned long frames_compressed;
+    unsigned long frames_passthrough;
+    unsigned long bytes_in;
+    unsigned long bytes_out;
+} Compressor;
+
+// Receiver side (client): matching inflate stream plus current frame state.
+typedef struct {
+    z_stream stream;
+    size_t pending_compressed;
+    size_t pending_raw;
+    unsigned long bytes_in;
+    unsigned long bytes_out;
+} Decompressor;
+
+// Compressor functions
+Compressor* compressor_create(size_t threshold);
+void compressor_destroy(Compressor *comp);
+char* compressor_encode(Compressor *comp, const char *data, size_t len, size_t *out_len);
+
+// Decompressor functions
+Decompressor* decompressor_create(void);
+void decompressor_destroy(Decompressor *decomp);
+int decompressor_decode(Decompressor *decomp, StreamBuffer *wire, StreamBuffer *plain);
+
+#endif
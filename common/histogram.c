@@ -0,0 +1,234 @@
+#include "histogram.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * @function histogram_bucket_index: Map a value to its bucket.
+ *
+ * @param value Value to record.
+ *
+ * @return Bucket index in [0, HISTOGRAM_BUCKETS).
+ */
+static int histogram_bucket_index(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - (HISTOGRAM_SUB_BUCKET_BITS - 1);
+    int sub = (int)(value >> shift) - HISTOGRAM_HALF_BUCKETS;
+
+    return HISTOGRAM_SUB_BUCKETS + (shift - 1) * HISTOGRAM_HALF_BUCKETS + sub;
+}
+
+/**
+ * @function histogram_bucket_upper: Highest value that maps to a bucket.
+ *
+ * @param index Bucket index.
+ *
+ * @return Largest value equivalent to the bucket.
+ */
+static uint64_t histogram_bucket_upper(int index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+
+    int shift = (index - HISTOGRAM_SUB_BUCKETS) / HISTOGRAM_HALF_BUCKETS + 1;
+    uint64_t sub = (uint64_t)((index - HISTOGRAM_SUB_BUCKETS) % HISTOGRAM_HALF_BUCKETS +
+                              HISTOGRAM_HALF_BUCKETS);
+
+    return ((sub + 1) << shift) - 1;
+}
+
+/**
+ * @function histogram_create: Allocate an empty histogram.
+ *
+ * @return Pointer to the new Histogram, or NULL on failure.
+ */
+Histogram* histogram_create(void) {
+    Histogram *hist = (Histogram*)malloc(sizeof(Histogram));
+    if (!hist) return NULL;
+
+    histogram_reset(hist);
+    return hist;
+}
+
+/**
+ * @function histogram_destroy: Free a histogram.
+ *
+ * @param hist Pointer to the Histogram.
+ *
+ * @return void
+ */
+void histogram_destroy(Histogram *hist) {
+    free(hist);
+}
+
+/**
+ * @function histogram_reset: Clear all recorded values.
+ *
+ * @param hist Pointer to the Histogram.
+ *
+ * @return void
+ */
+void histogram_reset(Histogram *hist) {
+    if (!hist) return;
+
+    memset(hist, 0, sizeof(Histogram));
+    hist->min = UINT64_MAX;
+}
+
+/**
+ * @function histogram_record: Record one value.
+ *
+ * @param hist Pointer to the Histogram.
+ * @param value Value to record (any unit, used consistently).
+ *
+ * @return void
+ */
+void histogram_record(Histogram *hist, uint64_t value) {
+    if (!hist) return;
+
+    hist->counts[histogram_bucket_index(value)]++;
+    hist->total_count++;
+    hist->sum += (double)value;
+    if (value < hist->min) hist->min = value;
+    if (value > hist->max) hist->max = value;
+}
+
+/**
+ * @function histogram_merge: Add every value recorded in src to dst.
+ *
+ * @param dst Histogram receiving the values.
+ * @param src Histogram to add.
+ *
+ * @return void
+ */
+void histogram_merge(Histogram *dst, const Histogram *src) {
+    if (!dst || !src || src->total_count == 0) return;
+
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total_count += src->total_count;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+/**
+ * @function histogram_value_at_percentile: Value below which a percentage of samples fall.
+ *
+ * @param hist Pointer to the Histogram.
+ * @param percentile Percentile in [0, 100].
+ *
+ * @return Highest value equivalent to the bucket holding the percentile
+ *         (capped at the recorded maximum), or 0 if the histogram is empty.
+ */
+uint64_t histogram_value_at_percentile(const Histogram *hist, double percentile) {
+    if (!hist || hist->total_count == 0) return 0;
+
+    if (percentile > 100.0) percentile = 100.0;
+    uint64_t target = (uint64_t)((percentile / 100.0) * (double)hist->total_count + 0.5);
+    if (target < 1) target = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= target) {
+            uint64_t value = histogram_bucket_upper(i);
+            return value < hist->max ? value : hist->max;
+        }
+    }
+
+    return hist->max;
+}
+
+/**
+ * @function histogram_mean: Arithmetic mean of recorded values.
+ *
+ * @param hist Pointer to the Histogram.
+ *
+ * @return Mean, or 0 if the histogram is empty.
+ */
+double histogram_mean(const Histogram *hist) {
+    if (!hist || hist->total_count == 0) return 0.0;
+    return hist->sum / (double)hist->total_count;
+}
+
+/**
+ * @function histogram_count_at_or_below: Number of samples not above a value.
+ *
+ * @param hist Pointer to the Histogram.
+ * @param value Upper bound (inclusive, bucket resolution).
+ *
+ * @return Count of samples whose bucket lies at or below the value's bucket.
+ */
+static uint64_t histogram_count_at_or_below(const Histogram *hist, uint64_t value) {
+    int last = histogram_bucket_index(value);
+    uint64_t count = 0;
+
+    for (int i = 0; i <= last; i++) {
+        count += hist->counts[i];
+    }
+    return count;
+}
+
+/**
+ * @function histogram_write_percentiles: Write the percentile distribution in .hgrm format.
+ *
+ * The layout matches HdrHistogram's outputPercentileDistribution (five
+ * reporting ticks per half-distance to 100%), so the file can be fed to the
+ * standard HdrHistogram plotter and compared across runs.
+ *
+ * @param hist Pointer to the Histogram.
+ * @param out Destination stream.
+ * @param scale Divisor applied to recorded values (e.g. 1000.0 for us -> ms).
+ *
+ * @return void
+ */
+void histogram_write_percentiles(const Histogram *hist, FILE *out, double scale) {
+    const int ticks_per_half = 5;
+
+    if (!hist || !out) return;
+    if (scale <= 0.0) scale = 1.0;
+
+    fprintf(out, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+
+    if (hist->total_count > 0) {
+        double percentile = 0.0;
+        for (;;) {
+            uint64_t value = histogram_value_at_percentile(hist, percentile);
+            uint64_t count = histogram_count_at_or_below(hist, value);
+
+            if (count >= hist->total_count || percentile >= 100.0) {
+                fprintf(out, "%12.3f %14.12f %10llu\n", value / scale, 1.0,
+                        (unsigned long long)hist->total_count);
+                break;
+            }
+            fprintf(out, "%12.3f %14.12f %10llu %14.2f\n", value / scale, percentile / 100.0,
+                    (unsigned long long)count, 1.0 / (1.0 - percentile / 100.0));
+
+            // Halve the remaining distance every ticks_per_half lines
+            double half_distance = floor(log2(100.0 / (100.0 - percentile))) + 1.0;
+            double reporting_ticks = ticks_per_half * pow(2.0, half_distance);
+            percentile += 100.0 / reporting_ticks;
+        }
+    }
+
+    double mean = histogram_mean(hist);
+    double variance = 0.0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS && hist->total_count > 0; i++) {
+        if (hist->counts[i] == 0) continue;
+        double deviation = (double)histogram_bucket_upper(i) - mean;
+        variance += deviation * deviation * (double)hist->counts[i];
+    }
+    if (hist->total_count > 0) variance /= (double)hist->total_count;
+
+    fprintf(out, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean / scale, sqrt(variance) / scale);
+    fprintf(out, "#[Max     = %12.3f, Total count    = %12llu]\n",
+            (hist->total_count ? hist->max : 0) / scale, (unsigned long long)hist->total_count);
+    fprintf(out, "#[Buckets = %12d, SubBuckets     = %12d]\n", 64 - HISTOGRAM_SUB_BUCKET_BITS + 1,
+            HISTOGRAM_SUB_BUCKETS);
+}
@@ -0,0 +1,45 @@
+// ============================================================================
+// histogram.h - Log-linear latency histogram (HDR-style, mergeable)
+// ============================================================================
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Values below HISTOGRAM_SUB_BUCKETS are recorded exactly; above that every
+// power-of-two range is split into HISTOGRAM_SUB_BUCKETS / 2 linear buckets,
+// giving a relative error below 1 / (HISTOGRAM_SUB_BUCKETS / 2) (~1.6%)
+// across the whole uint64_t range.
+#define HISTOGRAM_SUB_BUCKET_BITS 7
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_HALF_BUCKETS (HISTOGRAM_SUB_BUCKETS / 2)
+#define HISTOGRAM_BUCKETS (HISTOGRAM_SUB_BUCKETS + \
+                           HISTOGRAM_HALF_BUCKETS * (64 - HISTOGRAM_SUB_BUCKET_BITS))
+
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total_count;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} Histogram;
+
+// Lifecycle
+Histogram* histogram_create(void);
+void histogram_destroy(Histogram *hist);
+void histogram_reset(Histogram *hist);
+
+// Recording and combining
+void histogram_record(Histogram *hist, uint64_t value);
+void histogram_merge(Histogram *dst, const Histogram *src);
+
+// Queries
+uint64_t histogram_value_at_percentile(const Histogram *hist, double percentile);
+double histogram_mean(const Histogram *hist);
+
+// Output
+void histogram_write_percentiles(const Histogram *hist, FILE *out, double scale);
+
+#endif
@@ -0,0 +1,301 @@
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <strings.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+// Single writer (the server loop), so no locking
+static char ring[LOG_RING_SIZE];
+static uint64_t ring_written = 0;      // Bytes ever appended
+static uint64_t ring_flushed = 0;      // Bytes ever handed to the fd
+static int sink_fd = STDOUT_FILENO;
+static int runtime_level = LOG_LEVEL_INFO;
+static uint64_t dropped_total = 0;
+static uint64_t dropped_unreported = 0;
+
+// Timestamp prefix, reformatted at most once per second
+static time_t stamp_second = 0;
+static char stamp[16];
+
+static const char *level_names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF" };
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @function ring_append: Copy a formatted line into the ring.
+ *
+ * @param data Line bytes.
+ * @param len Line length.
+ *
+ * @return 1 if the line was buffered, 0 if the ring is too full.
+ */
+static int ring_append(const char *data, size_t len) {
+    if (ring_written - ring_flushed + len > LOG_RING_SIZE) return 0;
+
+    size_t pos = (size_t)(ring_written % LOG_RING_SIZE);
+    size_t first = LOG_RING_SIZE - pos;
+    if (first > len) first = len;
+    memcpy(ring + pos, data, first);
+    memcpy(ring, data + first, len - first);
+    ring_written += len;
+    return 1;
+}
+
+/**
+ * @function format_line: Format "HH:MM:SS LEVEL message\n" into a line buffer.
+ *
+ * @param line Output buffer of LOG_LINE_MAX bytes.
+ * @param level Log level.
+ * @param format printf-style format.
+ * @param args Format arguments.
+ *
+ * @return Length of the line including the newline.
+ */
+static size_t format_line(char *line, int level, const char *format, va_list args) {
+    time_t now = time(NULL);
+    if (now != stamp_second) {
+        struct tm tm_info;
+        localtime_r(&now, &tm_info);
+        strftime(stamp, sizeof(stamp), "%H:%M:%S", &tm_info);
+        stamp_second = now;
+    }
+
+    int prefix = snprintf(line, LOG_LINE_MAX, "%s %-5s ", stamp, level_names[level]);
+    int body = vsnprintf(line + prefix, LOG_LINE_MAX - prefix, format, args);
+    if (body < 0) body = 0;
+
+    size_t len = (size_t)prefix + (size_t)body;
+    if (len > LOG_LINE_MAX - 2) {
+        len = LOG_LINE_MAX - 2;
+        memcpy(line + len - 3, "...", 3);
+    }
+
+    // Callers pass protocol lines with their own \r\n; end every entry with one \n
+    while (len > (size_t)prefix && (line[len - 1] == '\n' || line[len - 1] == '\r')) len--;
+    line[len++] = '\n';
+    line[len] = '\0';
+    return len;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+/**
+ * @function log_init: Select the output fd and read CHAT_LOG_LEVEL.
+ *
+ * @param fd Descriptor the ring is drained to.
+ *
+ * @return void
+ */
+void log_init(int fd) {
+    sink_fd = fd;
+
+    const char *env = getenv("CHAT_LOG_LEVEL");
+    if (env) {
+        int level = log_level_from_name(env);
+        if (level >= 0) {
+            runtime_level = level;
+        } else {
+            LOG_WARN("Unknown CHAT_LOG_LEVEL '%s', using %s", env, level_names[runtime_level]);
+        }
+    }
+    if (runtime_level < LOG_COMPILE_LEVEL) {
+        LOG_WARN("Log level %s requested but only %s and above are compiled in",
+                 level_names[runtime_level], level_names[LOG_COMPILE_LEVEL]);
+    }
+}
+
+/**
+ * @function log_shutdown: Write out everything still buffered, blocking if needed.
+ *
+ * @return void
+ */
+void log_shutdown(void) {
+    while (ring_flushed < ring_written) {
+        size_t pos = (size_t)(ring_flushed % LOG_RING_SIZE);
+        size_t chunk = (size_t)(ring_written - ring_flushed);
+        if (chunk > LOG_RING_SIZE - pos) chunk = LOG_RING_SIZE - pos;
+
+        ssize_t n = write(sink_fd, ring + pos, chunk);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) {
+            struct pollfd pfd = { .fd = sink_fd, .events = POLLOUT };
+            poll(&pfd, 1, 100);
+            continue;
+        }
+        if (n <= 0) break;
+        ring_flushed += (uint64_t)n;
+    }
+    ring_flushed = ring_written;
+}
+
+// ============================================================================
+// Levels
+// ============================================================================
+
+/**
+ * @function log_set_level: Set the runtime level.
+ *
+ * @param level One of LOG_LEVEL_*.
+ *
+ * @return void
+ */
+void log_set_level(int level) {
+    if (level < LOG_LEVEL_TRACE) level = LOG_LEVEL_TRACE;
+    if (level > LOG_LEVEL_OFF) level = LOG_LEVEL_OFF;
+    runtime_level = level;
+}
+
+/**
+ * @function log_get_level: Current runtime level.
+ *
+ * @return One of LOG_LEVEL_*.
+ */
+int log_get_level(void) {
+    return runtime_level;
+}
+
+/**
+ * @function log_level_from_name: Parse a level name (case-insensitive).
+ *
+ * @param name "trace", "debug", "info", "warn", "error" or "off".
+ *
+ * @return The LOG_LEVEL_* value, or -1 if unknown.
+ */
+int log_level_from_name(const char *name) {
+    if (!name) return -1;
+    for (int i = LOG_LEVEL_TRACE; i <= LOG_LEVEL_OFF; i++) {
+        if (strcasecmp(name, level_names[i]) == 0) return i;
+    }
+    if (strcasecmp(name, "warning") == 0) return LOG_LEVEL_WARN;
+    return -1;
+}
+
+/**
+ * @function log_enabled: Check the runtime level.
+ *
+ * @param level Level of the line about to be written.
+ *
+ * @return 1 if lines at this level are written, 0 otherwise.
+ */
+int log_enabled(int level) {
+    return level >= runtime_level && level < LOG_LEVEL_OFF;
+}
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+/**
+ * @function log_write: Format a line and buffer it, or count it as dropped.
+ *
+ * Never touches the output fd; use the LOG_* macros rather than calling this
+ * directly so disabled levels cost nothing.
+ *
+ * @param level Log level.
+ * @param format printf-style format.
+ *
+ * @return void
+ */
+void log_write(int level, const char *format, ...) {
+    if (level < LOG_LEVEL_TRACE || level >= LOG_LEVEL_OFF) return;
+
+    char line[LOG_LINE_MAX];
+    va_list args;
+
+    if (dropped_unreported > 0) {
+        char note[96];
+        int len = snprintf(note, sizeof(note), "%s %-5s %llu log line(s) dropped, output too slow\n",
+                           stamp, level_names[LOG_LEVEL_WARN], (unsigned long long)dropped_unreported);
+        if (ring_append(note, (size_t)len)) dropped_unreported = 0;
+    }
+
+    va_start(args, format);
+    size_t len = format_line(line, level, format, args);
+    va_end(args);
+
+    if (!ring_append(line, len)) {
+        dropped_total++;
+        dropped_unreported++;
+    }
+}
+
+// ============================================================================
+// Event Loop Integration
+// ============================================================================
+
+/**
+ * @function log_fill_fdset: Ask select() to wake when buffered lines can be written.
+ *
+ * @param write_fds Write set for select().
+ * @param max_fd Current highest descriptor.
+ *
+ * @return New highest descriptor.
+ */
+int log_fill_fdset(fd_set *write_fds, int max_fd) {
+    if (ring_flushed == ring_written || sink_fd < 0 || sink_fd >= FD_SETSIZE) return max_fd;
+    FD_SET(sink_fd, write_fds);
+    return sink_fd > max_fd ? sink_fd : max_fd;
+}
+
+/**
+ * @function log_flush: Write buffered lines while the fd accepts them without blocking.
+ *
+ * The fd is left in whatever mode it was opened in (stdout is usually shared
+ * with the shell), so each write is preceded by a zero-timeout poll() and
+ * capped at PIPE_BUF, which a writable pipe always accepts in full.
+ *
+ * @return void
+ */
+void log_flush(void) {
+    while (ring_flushed < ring_written) {
+        struct pollfd pfd = { .fd = sink_fd, .events = POLLOUT };
+        if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLOUT)) break;
+
+        size_t pos = (size_t)(ring_flushed % LOG_RING_SIZE);
+        size_t chunk = (size_t)(ring_written - ring_flushed);
+        if (chunk > LOG_RING_SIZE - pos) chunk = LOG_RING_SIZE - pos;
+        if (chunk > PIPE_BUF) chunk = PIPE_BUF;
+
+        ssize_t n = write(sink_fd, ring + pos, chunk);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            // Output is gone (closed pipe, bad fd): discard instead of spinning
+            ring_flushed = ring_written;
+            break;
+        }
+        ring_flushed += (uint64_t)n;
+    }
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+/**
+ * @function log_dropped: Lines dropped because the ring was full.
+ *
+ * @return Total dropped lines since start.
+ */
+uint64_t log_dropped(void) {
+    return dropped_total;
+}
+
+/**
+ * @function log_buffered: Bytes waiting to be written.
+ *
+ * @return Buffered byte count.
+ */
+size_t log_buffered(void) {
+    return (size_t)(ring_written - ring_flushed);
+}
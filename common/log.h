@@ -0,0 +1,72 @@
+// ============================================================================
+// log.h - Leveled logging with a non-blocking buffered sink
+// ============================================================================
+//
+// LOG_TRACE .. LOG_ERROR format a line into an in-memory ring that the server
+// loop drains with log_flush() whenever the output fd is writable. A full
+// ring drops the line and counts it instead of stalling the event loop.
+//
+// Levels below LOG_COMPILE_LEVEL are removed by the preprocessor: their
+// arguments are never evaluated. The default keeps INFO and above (TRACE and
+// above with -DDEBUG); override with -DLOG_COMPILE_LEVEL=LOG_LEVEL_<name>
+// or `make LOG_LEVEL=<NAME>`. The runtime level comes from the environment
+// variable CHAT_LOG_LEVEL (trace, debug, info, warn, error, off).
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/select.h>
+
+#define LOG_LEVEL_TRACE 0   // Per-byte / per-recipient traces, message bodies
+#define LOG_LEVEL_DEBUG 1   // Handler internals
+#define LOG_LEVEL_INFO  2   // Connections, logins, membership changes
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF   5
+
+#ifndef LOG_COMPILE_LEVEL
+#ifdef DEBUG
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#else
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+#define LOG_RING_SIZE (1 << 20)     // Buffered bytes before lines are dropped
+#define LOG_LINE_MAX 1024           // Longer lines are truncated
+
+#define LOG_AT(level, ...) \
+    do { \
+        if ((level) >= LOG_COMPILE_LEVEL && log_enabled(level)) log_write((level), __VA_ARGS__); \
+    } while (0)
+
+#define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+// Lifecycle
+void log_init(int fd);
+void log_shutdown(void);
+
+// Levels
+void log_set_level(int level);
+int log_get_level(void);
+int log_level_from_name(const char *name);
+int log_enabled(int level);
+
+// Writing
+void log_write(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+// Event loop integration
+int log_fill_fdset(fd_set *write_fds, int max_fd);
+void log_flush(void);
+
+// Statistics
+uint64_t log_dropped(void);
+size_t log_buffered(void);
+
+#endif
@@ -0,0 +1,381 @@
+#include "metrics.h"
+#include "query_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libpq-fe.h>
+
+// Time accumulated by the request currently being routed. The libpq
+// wrappers have no Metrics pointer to charge, so this is per thread: each
+// thread routes one request at a time into its own Metrics instance.
+typedef struct {
+    uint64_t db_ns;
+    uint64_t db_calls;
+    uint64_t send_ns;
+    int command;                         // CommandType being handled, -1 between requests
+} RequestAccount;
+
+static __thread RequestAccount request = { 0, 0, 0, -1 };
+
+static const char *command_names[METRICS_COMMANDS] = {
+    [CMD_REGISTER] = "REGISTER",
+    [CMD_LOGIN] = "LOGIN",
+    [CMD_LOGOUT] = "LOGOUT",
+    [CMD_FRIEND_REQ] = "FRIEND_REQ",
+    [CMD_FRIEND_ACCEPT] = "FRIEND_ACCEPT",
+    [CMD_FRIEND_DECLINE] = "FRIEND_DECLINE",
+    [CMD_FRIEND_REMOVE] = "FRIEND_REMOVE",
+    [CMD_FRIEND_LIST] = "FRIEND_LIST",
+    [CMD_MSG] = "MSG",
+    [CMD_GROUP_CREATE] = "GROUP_CREATE",
+    [CMD_GROUP_INVITE] = "GROUP_INVITE",
+    [CMD_GROUP_JOIN] = "GROUP_JOIN",
+    [CMD_GROUP_LEAVE] = "GROUP_LEAVE",
+    [CMD_GROUP_KICK] = "GROUP_KICK",
+    [CMD_GROUP_MSG] = "GROUP_MSG",
+    [CMD_GROUP_SEND_OFFLINE_MSG] = "GROUP_SEND_OFFLINE_MSG",
+    [CMD_GROUP_EXIT_MESSAGING] = "GROUP_EXIT_MESSAGING",
+    [CMD_GROUP_APPROVE] = "GROUP_APPROVE",
+    [CMD_GROUP_REJECT] = "GROUP_REJECT",
+    [CMD_LIST_JOIN_REQUESTS] = "LIST_JOIN_REQUESTS",
+    [CMD_SEND_OFFLINE_MSG] = "SEND_OFFLINE_MSG",
+    [CMD_GET_OFFLINE_MSG] = "GET_OFFLINE_MSG",
+    [CMD_FRIEND_PENDING] = "FRIEND_PENDING",
+    [CMD_COMPRESS] = "COMPRESS",
+    [CMD_UNREAD_SUMMARY] = "UNREAD_SUMMARY",
+    [CMD_STATS] = "STATS",
+    [CMD_RESUME] = "RESUME",
+    [CMD_PRESENCE_SUBSCRIBE] = "PRESENCE_SUBSCRIBE",
+    [CMD_FRIEND_LIST_SYNC] = "FRIEND_LIST_SYNC",
+    [CMD_UNKNOWN] = "UNKNOWN",
+};
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+/**
+ * @function metrics_create: Allocate an empty metrics registry.
+ *
+ * @return Pointer to the new Metrics, or NULL on failure.
+ */
+Metrics* metrics_create(void) {
+    Metrics *metrics = (Metrics*)calloc(1, sizeof(Metrics));
+    if (!metrics) return NULL;
+
+    for (int c = 0; c < METRICS_COMMANDS; c++) {
+        for (int k = 0; k < METRIC_KINDS; k++) {
+            metrics->commands[c].latency[k] = histogram_create();
+            if (!metrics->commands[c].latency[k]) {
+                metrics_destroy(metrics);
+                return NULL;
+            }
+        }
+    }
+
+    metrics->started = time(NULL);
+    return metrics;
+}
+
+/**
+ * @function metrics_destroy: Free a metrics registry.
+ *
+ * @param metrics Pointer to the Metrics.
+ *
+ * @return void
+ */
+void metrics_destroy(Metrics *metrics) {
+    if (!metrics) return;
+
+    for (int c = 0; c < METRICS_COMMANDS; c++) {
+        for (int k = 0; k < METRIC_KINDS; k++) {
+            histogram_destroy(metrics->commands[c].latency[k]);
+        }
+    }
+    free(metrics);
+}
+
+/**
+ * @function metrics_reset: Clear every counter and histogram.
+ *
+ * @param metrics Pointer to the Metrics.
+ *
+ * @return void
+ */
+void metrics_reset(Metrics *metrics) {
+    if (!metrics) return;
+
+    for (int c = 0; c < METRICS_COMMANDS; c++) {
+        CommandMetrics *cm = &metrics->commands[c];
+        cm->requests = 0;
+        cm->db_calls = 0;
+        memset(cm->status_counts, 0, sizeof(cm->status_counts));
+        for (int k = 0; k < METRIC_KINDS; k++) {
+            histogram_reset(cm->latency[k]);
+        }
+    }
+    metrics->started = time(NULL);
+}
+
+/**
+ * @function metrics_merge: Add every count and sample in src to dst.
+ *
+ * @param dst Metrics receiving the values.
+ * @param src Metrics to add.
+ *
+ * @return void
+ */
+void metrics_merge(Metrics *dst, const Metrics *src) {
+    if (!dst || !src) return;
+
+    for (int c = 0; c < METRICS_COMMANDS; c++) {
+        CommandMetrics *d = &dst->commands[c];
+        const CommandMetrics *s = &src->commands[c];
+
+        d->requests += s->requests;
+        d->db_calls += s->db_calls;
+        for (int i = 0; i < METRICS_MAX_STATUS; i++) {
+            d->status_counts[i] += s->status_counts[i];
+        }
+        for (int k = 0; k < METRIC_KINDS; k++) {
+            histogram_merge(d->latency[k], s->latency[k]);
+        }
+    }
+    if (src->started < dst->started) dst->started = src->started;
+}
+
+// ============================================================================
+// Request Accounting
+// ============================================================================
+
+/**
+ * @function metrics_now_ns: Monotonic clock in nanoseconds.
+ *
+ * @return Current monotonic time in nanoseconds.
+ */
+uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @function metrics_begin_request: Start accumulating DB and send time for a new request.
+ *
+ * @return void
+ */
+void metrics_begin_request(void) {
+    request.db_ns = 0;
+    request.db_calls = 0;
+    request.send_ns = 0;
+    request.command = -1;
+}
+
+/**
+ * @function metrics_set_command: Name the handler that the following DB calls belong to.
+ *
+ * @param cmd_type Command being routed.
+ *
+ * @return void
+ */
+void metrics_set_command(CommandType cmd_type) {
+    request.command = (int)cmd_type;
+}
+
+/**
+ * @function metrics_add_db_time: Charge one database round trip to the current request.
+ *
+ * @param elapsed_ns Time spent in libpq.
+ *
+ * @return void
+ */
+void metrics_add_db_time(uint64_t elapsed_ns) {
+    request.db_ns += elapsed_ns;
+    request.db_calls++;
+}
+
+/**
+ * @function metrics_add_send_time: Charge socket write time to the current request.
+ *
+ * @param elapsed_ns Time spent encoding and sending a response.
+ *
+ * @return void
+ */
+void metrics_add_send_time(uint64_t elapsed_ns) {
+    request.send_ns += elapsed_ns;
+}
+
+/**
+ * @function metrics_record_request: Record a finished request.
+ *
+ * @param metrics Pointer to the Metrics.
+ * @param cmd_type Command that was routed.
+ * @param status_code Final response code, or 0 if nothing was sent.
+ * @param elapsed_ns Total time spent handling the request.
+ *
+ * @return void
+ */
+void metrics_record_request(Metrics *metrics, CommandType cmd_type, int status_code, uint64_t elapsed_ns) {
+    if (!metrics) return;
+    if ((int)cmd_type < 0 || cmd_type >= METRICS_COMMANDS) cmd_type = CMD_UNKNOWN;
+    if (status_code < 0 || status_code >= METRICS_MAX_STATUS) status_code = 0;
+
+    CommandMetrics *cm = &metrics->commands[cmd_type];
+    cm->requests++;
+    cm->db_calls += request.db_calls;
+    cm->status_counts[status_code]++;
+    histogram_record(cm->latency[METRIC_TOTAL], elapsed_ns / 1000);
+    histogram_record(cm->latency[METRIC_DB], request.db_ns / 1000);
+    histogram_record(cm->latency[METRIC_SEND], request.send_ns / 1000);
+
+    metrics_begin_request();
+}
+
+// ============================================================================
+// Database Timing (linked with -Wl,--wrap=PQexec,--wrap=PQexecParams,...)
+// ============================================================================
+
+PGresult *__real_PQexec(PGconn *conn, const char *query);
+PGresult *__real_PQexecParams(PGconn *conn, const char *command, int nParams,
+                              const Oid *paramTypes, const char *const *paramValues,
+                              const int *paramLengths, const int *paramFormats, int resultFormat);
+PGresult *__real_PQexecPrepared(PGconn *conn, const char *stmtName, int nParams,
+                                const char *const *paramValues, const int *paramLengths,
+                                const int *paramFormats, int resultFormat);
+
+/**
+ * @function result_rows: Rows returned by a SELECT or affected by a DML statement.
+ *
+ * @param res Statement result.
+ *
+ * @return Row count, 0 if unknown.
+ */
+static long result_rows(PGresult *res) {
+    if (!res) return 0;
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) return PQntuples(res);
+    const char *affected = PQcmdTuples(res);
+    return affected && *affected ? atol(affected) : 0;
+}
+
+/**
+ * @function account_statement: Charge a statement to the request and the per-statement table.
+ *
+ * @param sql Statement text (or "EXECUTE <name>" for prepared statements).
+ * @param start Monotonic start time of the libpq call.
+ * @param res Statement result.
+ *
+ * @return void
+ */
+static void account_statement(const char *sql, uint64_t start, PGresult *res) {
+    uint64_t elapsed = metrics_now_ns() - start;
+    metrics_add_db_time(elapsed);
+    query_stats_record(request.command >= 0 ? metrics_command_name(request.command) : NULL,
+                       sql, elapsed, result_rows(res));
+}
+
+PGresult *__wrap_PQexec(PGconn *conn, const char *query) {
+    uint64_t start = metrics_now_ns();
+    PGresult *res = __real_PQexec(conn, query);
+    account_statement(query, start, res);
+    return res;
+}
+
+PGresult *__wrap_PQexecParams(PGconn *conn, const char *command, int nParams,
+                              const Oid *paramTypes, const char *const *paramValues,
+                              const int *paramLengths, const int *paramFormats, int resultFormat) {
+    uint64_t start = metrics_now_ns();
+    PGresult *res = __real_PQexecParams(conn, command, nParams, paramTypes, paramValues,
+                                        paramLengths, paramFormats, resultFormat);
+    account_statement(command, start, res);
+    return res;
+}
+
+PGresult *__wrap_PQexecPrepared(PGconn *conn, const char *stmtName, int nParams,
+                                const char *const *paramValues, const int *paramLengths,
+                                const int *paramFormats, int resultFormat) {
+    uint64_t start = metrics_now_ns();
+    PGresult *res = __real_PQexecPrepared(conn, stmtName, nParams, paramValues,
+                                          paramLengths, paramFormats, resultFormat);
+    char label[80];
+    snprintf(label, sizeof(label), "EXECUTE %s", stmtName ? stmtName : "");
+    account_statement(label, start, res);
+    return res;
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+/**
+ * @function metrics_command_name: Protocol verb of a command type.
+ *
+ * @param cmd_type Command type.
+ *
+ * @return Static command name.
+ */
+const char* metrics_command_name(CommandType cmd_type) {
+    if ((int)cmd_type < 0 || cmd_type >= METRICS_COMMANDS || !command_names[cmd_type]) {
+        return "UNKNOWN";
+    }
+    return command_names[cmd_type];
+}
+
+/**
+ * @function metrics_format: Render the registry as a text table.
+ *
+ * One row per command that has been seen, with request count, average
+ * database calls, p50/p99/max of total, DB and send time in milliseconds,
+ * followed by the status codes it returned.
+ *
+ * @param metrics Pointer to the Metrics.
+ *
+ * @return Dynamically allocated report, or NULL on failure.
+ */
+char* metrics_format(const Metrics *metrics) {
+    if (!metrics) return NULL;
+
+    size_t capacity = 1024 + METRICS_COMMANDS * 256;
+    char *out = (char*)malloc(capacity);
+    if (!out) return NULL;
+
+    int offset = snprintf(out, capacity,
+            "\n=== SERVER STATS (%lds) ===\n"
+            "%-22s %8s %5s %17s %17s %17s\n"
+            "%-22s %8s %5s %17s %17s %17s\n",
+            (long)(time(NULL) - metrics->started),
+            "Command", "Count", "DB/r", "Total ms", "DB ms", "Send ms",
+            "", "", "", "p50/p99/max", "p50/p99/max", "p50/p99/max");
+
+    for (int c = 0; c < METRICS_COMMANDS && offset < (int)capacity; c++) {
+        const CommandMetrics *cm = &metrics->commands[c];
+        if (cm->requests == 0) continue;
+
+        char cells[METRIC_KINDS][32];
+        for (int k = 0; k < METRIC_KINDS; k++) {
+            const Histogram *h = cm->latency[k];
+            snprintf(cells[k], sizeof(cells[k]), "%.2f/%.2f/%.2f",
+                     histogram_value_at_percentile(h, 50.0) / 1000.0,
+                     histogram_value_at_percentile(h, 99.0) / 1000.0,
+                     (h->total_count ? h->max : 0) / 1000.0);
+        }
+
+        offset += snprintf(out + offset, capacity - offset, "%-22s %8llu %5.1f %17s %17s %17s  ",
+                          metrics_command_name((CommandType)c), (unsigned long long)cm->requests,
+                          (double)cm->db_calls / (double)cm->requests,
+                          cells[METRIC_TOTAL], cells[METRIC_DB], cells[METRIC_SEND]);
+
+        for (int s = 0; s < METRICS_MAX_STATUS && offset < (int)capacity; s++) {
+            if (cm->status_counts[s] == 0) continue;
+            offset += snprintf(out + offset, capacity - offset, " %d:%llu",
+                              s, (unsigned long long)cm->status_counts[s]);
+        }
+        if (offset < (int)capacity) {
+            offset += snprintf(out + offset, capacity - offset, "\n");
+        }
+    }
+
+    if (offset < (int)capacity) {
+        snprintf(out + offset, capacity - offset, "=== END OF STATS ===");
+    }
+    return out;
+}
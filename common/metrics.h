@@ -0,0 +1,64 @@
+// ============================================================================
+// metrics.h - Per-command request counters and latency histograms
+// ============================================================================
+//
+// Every request routed by server_handle_client_message is recorded against
+// its CommandType: a request count, counts per final status code, and
+// latency histograms (microseconds) for the whole request, the time spent
+// inside libpq, and the time spent in server_send_response. Each libpq call
+// is also passed to query_stats with the command that issued it.
+//
+// A Metrics instance has a single writer and takes no locks. A threaded
+// server keeps one instance per thread and combines them with
+// metrics_merge() when reporting; the in-flight request's DB and send time
+// is accumulated per thread as well.
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <time.h>
+#include "protocol.h"
+#include "histogram.h"
+
+#define METRICS_MAX_STATUS 600
+#define METRICS_COMMANDS (CMD_UNKNOWN + 1)
+
+typedef enum {
+    METRIC_TOTAL,
+    METRIC_DB,
+    METRIC_SEND,
+    METRIC_KINDS
+} MetricKind;
+
+typedef struct {
+    uint64_t requests;
+    uint64_t db_calls;
+    Histogram *latency[METRIC_KINDS];
+    uint64_t status_counts[METRICS_MAX_STATUS];  // Index 0: no response sent
+} CommandMetrics;
+
+typedef struct {
+    time_t started;
+    CommandMetrics commands[METRICS_COMMANDS];
+} Metrics;
+
+// Lifecycle
+Metrics* metrics_create(void);
+void metrics_destroy(Metrics *metrics);
+void metrics_reset(Metrics *metrics);
+void metrics_merge(Metrics *dst, const Metrics *src);
+
+// Request accounting
+uint64_t metrics_now_ns(void);
+void metrics_begin_request(void);
+void metrics_set_command(CommandType cmd_type);
+void metrics_add_db_time(uint64_t elapsed_ns);
+void metrics_add_send_time(uint64_t elapsed_ns);
+void metrics_record_request(Metrics *metrics, CommandType cmd_type, int status_code, uint64_t elapsed_ns);
+
+// Reporting
+const char* metrics_command_name(CommandType cmd_type);
+char* metrics_format(const Metrics *metrics);
+
+#endif
@@ -128,6 +128,12 @@ CommandType parse_command_type(const char *cmd_str) {
     if (strcmp(cmd_str, "SEND_OFFLINE_MSG") == 0) return CMD_SEND_OFFLINE_MSG;
     if (strcmp(cmd_str, "FRIEND_PENDING") == 0) return CMD_FRIEND_PENDING;
     if (strcmp(cmd_str, "GET_OFFLINE_MSG") == 0) return CMD_GET_OFFLINE_MSG;
+    if (strcmp(cmd_str, "COMPRESS") == 0) return CMD_COMPRESS;
+    if (strcmp(cmd_str, "UNREAD_SUMMARY") == 0) return CMD_UNREAD_SUMMARY;
+    if (strcmp(cmd_str, "STATS") == 0) return CMD_STATS;
+    if (strcmp(cmd_str, "RESUME") == 0) return CMD_RESUME;
+    if (strcmp(cmd_str, "PRESENCE_SUBSCRIBE") == 0) return CMD_PRESENCE_SUBSCRIBE;
+    if (strcmp(cmd_str, "FRIEND_LIST_SYNC") == 0) return CMD_FRIEND_LIST_SYNC;
 
     return CMD_UNKNOWN;
 }
@@ -179,7 +185,34 @@ ParsedCommand* parse_protocol_message(const char *raw_message) {
             }
             break;
         
+        case CMD_RESUME:
+            // RESUME <token> [last_seen_id]
+            token = strtok(NULL, " ");
+            if (token) {
+                strncpy(cmd->password, token, MAX_PASSWORD_LENGTH - 1);
+                cmd->param_count++;
+            }
+            token = strtok(NULL, " ");
+            if (token) {
+                strncpy(cmd->message, token, MAX_MESSAGE_LENGTH - 1);
+                cmd->param_count++;
+            }
+            break;
+        
         case CMD_GET_OFFLINE_MSG:
+            // GET_OFFLINE_MSG <sender> [cursor]
+            token = strtok(NULL, " ");
+            if (token) {
+                strncpy(cmd->target_user, token, MAX_USERNAME_LENGTH - 1);
+                cmd->param_count++;
+            }
+            token = strtok(NULL, " ");
+            if (token) {
+                strncpy(cmd->message, token, MAX_MESSAGE_LENGTH - 1);
+                cmd->param_count++;
+            }
+            break;
+        
         case CMD_FRIEND_REQ:
         case CMD_FRIEND_ACCEPT:
         case CMD_FRIEND_DECLINE:
@@ -246,9 +279,28 @@ ParsedCommand* parse_protocol_message(const char *raw_message) {
             }
             break;
             
+        case CMD_COMPRESS:
+            token = strtok(NULL, "");
+            if (token) {
+                strncpy(cmd->message, token, MAX_MESSAGE_LENGTH - 1);
+                cmd->param_count++;
+            }
+            break;
+            
+        case CMD_FRIEND_LIST_SYNC:
+            // FRIEND_LIST_SYNC [version]
+            token = strtok(NULL, " ");
+            if (token) {
+                strncpy(cmd->message, token, MAX_MESSAGE_LENGTH - 1);
+                cmd->param_count++;
+            }
+            break;
+            
+        case CMD_STATS:
         case CMD_LOGOUT:
         case CMD_FRIEND_LIST:
         case CMD_FRIEND_PENDING:
+        case CMD_PRESENCE_SUBSCRIBE:
             break;
             
         default:
@@ -299,6 +351,29 @@ char* build_response(int status_code, const char *message) {
     return response;
 }
 
+/**
+ * @function build_large_response: Builds a protocol response sized to its message.
+ * 
+ * Unlike build_response, the message is never truncated at MAX_MESSAGE_LENGTH.
+ * Callers are responsible for keeping the result within what the peer's
+ * StreamBuffer can hold.
+ * 
+ * @param status_code Integer status code.
+ * @param message Pointer to the message string.
+ * 
+ * @return Pointer to the constructed response message (dynamically allocated), or NULL on failure.
+ */
+char* build_large_response(int status_code, const char *message) {
+    if (!message) message = "";
+    
+    size_t size = strlen(message) + strlen(PROTOCOL_DELIMITER) + 16;
+    char *response = (char*)malloc(size);
+    if (!response) return NULL;
+    
+    snprintf(response, size, "%d %s%s", status_code, message, PROTOCOL_DELIMITER);
+    return response;
+}
+
 /**
  * @function build_simple_response: Builds a simple protocol response message with only a status code.
  * 
@@ -38,6 +38,13 @@
 #define STATUS_GROUP_APPROVE_OK 120
 #define STATUS_GROUP_REJECT_OK 121
 #define STATUS_GROUP_MSG_SENT_OK 122
+#define STATUS_COMPRESS_OK 123
+#define STATUS_COMPRESSED_FRAME 124
+#define STATUS_UNREAD_SUMMARY_OK 125
+#define STATUS_STATS_OK 126
+#define STATUS_RESUME_OK 127
+#define STATUS_PRESENCE_SUBSCRIBE_OK 128
+#define STATUS_FRIEND_LIST_SYNC_OK 129
 
 // Status codes - Client errors (2xx)
 #define STATUS_USERNAME_EXISTS 201
@@ -49,6 +56,7 @@
 #define STATUS_GROUP_INVITE_NOTIFICATION 250
 #define STATUS_OFFLINE_NOTIFICATION 251
 #define STATUS_GROUP_KICK_NOTIFICATION 252
+#define STATUS_PRESENCE_NOTIFICATION 253
 
 // Status codes - Auth/Session errors (3xx)
 #define STATUS_INVALID_USERNAME 301
@@ -57,6 +65,7 @@
 #define STATUS_ALREADY_LOGGED_IN 304
 #define STATUS_NOT_LOGGED_IN 305
 #define STATUS_ALREADY_FRIEND 306
+#define STATUS_RESUME_INVALID 307
 
 // Status codes - Database/Server errors (4xx)
 #define STATUS_DATABASE_ERROR 400
@@ -73,9 +82,12 @@
 #define STATUS_INVITE_REQUIRED 420
 #define STATUS_NOT_IN_GROUP 421
 #define STATUS_CANNOT_KICK_OWNER 422
+#define STATUS_COMPRESS_UNSUPPORTED 423
+#define STATUS_RATE_LIMITED 429
 
 // Status codes - System errors (5xx)
 #define STATUS_UNDEFINED_ERROR 500
+#define STATUS_SERVER_BUSY 501
 
 // Command types
 typedef enum {
@@ -102,6 +114,12 @@ typedef enum {
     CMD_SEND_OFFLINE_MSG,
     CMD_GET_OFFLINE_MSG,
     CMD_FRIEND_PENDING,
+    CMD_COMPRESS,
+    CMD_UNREAD_SUMMARY,
+    CMD_STATS,
+    CMD_RESUME,
+    CMD_PRESENCE_SUBSCRIBE,
+    CMD_FRIEND_LIST_SYNC,
     CMD_UNKNOWN
 } CommandType;
 
@@ -139,6 +157,7 @@ void free_parsed_command(ParsedCommand *cmd);
 
 // Protocol response builders
 char* build_response(int status_code, const char *message);
+char* build_large_response(int status_code, const char *message);
 char* build_simple_response(int status_code);
 
 #endif
@@ -0,0 +1,301 @@
+#include "query_stats.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+// Open-addressed by fingerprint; single writer (the server loop)
+static QueryStat slots[QUERY_STATS_SLOTS];
+static size_t slots_used = 0;
+static uint64_t untracked = 0;
+static uint64_t slow_total = 0;
+
+static long slow_threshold_ms = QUERY_SLOW_DEFAULT_MS;
+static FILE *slow_log = NULL;
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @function fingerprint: FNV-1a hash of the normalized text and handler.
+ *
+ * @param sql Normalized statement.
+ * @param handler Command name.
+ *
+ * @return Non-zero 64-bit fingerprint.
+ */
+static uint64_t fingerprint(const char *sql, const char *handler) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const char *p = sql; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= 0xff;
+    hash *= 1099511628211ULL;
+    for (const char *p = handler; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ULL;
+    }
+    return hash ? hash : 1;
+}
+
+/**
+ * @function is_word_char: Identifier character test used to tell numbers from names.
+ *
+ * @param c Character.
+ *
+ * @return Non-zero if c can be part of an identifier or placeholder.
+ */
+static int is_word_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '$';
+}
+
+/**
+ * @function find_slot: Find or claim the slot for a statement.
+ *
+ * @param hash Statement fingerprint.
+ * @param handler Command name.
+ * @param sql Normalized statement.
+ *
+ * @return Slot, or NULL when the table is full.
+ */
+static QueryStat* find_slot(uint64_t hash, const char *handler, const char *sql) {
+    size_t index = (size_t)(hash % QUERY_STATS_SLOTS);
+    for (size_t probe = 0; probe < QUERY_STATS_SLOTS; probe++) {
+        QueryStat *slot = &slots[(index + probe) % QUERY_STATS_SLOTS];
+        if (slot->fingerprint == hash) return slot;
+        if (slot->fingerprint == 0) {
+            // Keep a quarter free so probes stay short
+            if (slots_used >= QUERY_STATS_SLOTS - QUERY_STATS_SLOTS / 4) return NULL;
+            slot->fingerprint = hash;
+            slot->handler = handler;
+            snprintf(slot->sql, sizeof(slot->sql), "%s", sql);
+            slots_used++;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @function write_slow_entry: Append one statement to the slow-query log.
+ *
+ * @param handler Command name.
+ * @param sql Normalized statement.
+ * @param hash Statement fingerprint.
+ * @param elapsed_ns Wall time.
+ * @param rows Rows returned or affected.
+ *
+ * @return void
+ */
+static void write_slow_entry(const char *handler, const char *sql, uint64_t hash,
+                             uint64_t elapsed_ns, long rows) {
+    if (!slow_log) return;
+
+    time_t now = time(NULL);
+    struct tm tm_info;
+    localtime_r(&now, &tm_info);
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%d/%m/%Y %H:%M:%S", &tm_info);
+
+    // Format: [timestamp] ms=... rows=... handler=... id=... sql
+    fprintf(slow_log, "[%s] ms=%.3f rows=%ld handler=%s id=%016llx %s\n",
+            timestamp, elapsed_ns / 1e6, rows, handler, (unsigned long long)hash, sql);
+    fflush(slow_log);
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+/**
+ * @function query_stats_init: Read the slow-query settings and open the log.
+ *
+ * @return void
+ */
+void query_stats_init(void) {
+    const char *threshold = getenv("CHAT_SLOW_QUERY_MS");
+    if (threshold && *threshold) {
+        char *end;
+        long value = strtol(threshold, &end, 10);
+        if (*end == '\0') {
+            slow_threshold_ms = value;
+        } else {
+            LOG_WARN("Invalid CHAT_SLOW_QUERY_MS '%s', using %ld", threshold, slow_threshold_ms);
+        }
+    }
+    if (slow_threshold_ms < 0) return;
+
+    const char *path = getenv("CHAT_SLOW_QUERY_LOG");
+    if (!path || !*path) path = QUERY_SLOW_DEFAULT_LOG;
+
+    slow_log = fopen(path, "a");
+    if (!slow_log) {
+        LOG_WARN("Cannot open slow-query log %s, slow statements will only be counted", path);
+        return;
+    }
+    LOG_INFO("Slow-query log: %s (threshold %ld ms)", path, slow_threshold_ms);
+}
+
+/**
+ * @function query_stats_shutdown: Close the slow-query log.
+ *
+ * @return void
+ */
+void query_stats_shutdown(void) {
+    if (slow_log) {
+        fclose(slow_log);
+        slow_log = NULL;
+    }
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+/**
+ * @function query_normalize: Reduce a statement to its shape.
+ *
+ * String and numeric literals become ?, runs of literals separated by commas
+ * collapse to one ? (IN lists of any length share a shape), whitespace
+ * collapses to a single space, and $n placeholders are kept. Output is
+ * truncated to fit.
+ *
+ * @param sql Statement text.
+ * @param out Output buffer.
+ * @param out_size Size of the output buffer.
+ *
+ * @return Length of the normalized text.
+ */
+size_t query_normalize(const char *sql, char *out, size_t out_size) {
+    if (!out || out_size == 0) return 0;
+    size_t len = 0;
+    out[0] = '\0';
+    if (!sql) return 0;
+
+    const char *p = sql;
+    while (*p && len + 1 < out_size) {
+        char c = *p;
+
+        if (isspace((unsigned char)c)) {
+            while (isspace((unsigned char)*p)) p++;
+            if (len > 0 && out[len - 1] != ' ') out[len++] = ' ';
+            continue;
+        }
+
+        int literal = 0;
+        if (c == '\'') {
+            p++;
+            while (*p) {
+                if (*p == '\'' && p[1] == '\'') { p += 2; continue; }
+                if (*p == '\'') { p++; break; }
+                p++;
+            }
+            literal = 1;
+        } else if (isdigit((unsigned char)c) && (len == 0 || !is_word_char(out[len - 1]))) {
+            p++;
+            while (isdigit((unsigned char)*p) || *p == '.') p++;
+            literal = 1;
+        }
+
+        if (literal) {
+            // "?, ?" -> "?"
+            if (len >= 3 && strncmp(out + len - 3, "?, ", 3) == 0) {
+                len -= 2;
+            } else if (len >= 2 && strncmp(out + len - 2, "?,", 2) == 0) {
+                len -= 1;
+            } else {
+                out[len++] = '?';
+            }
+            continue;
+        }
+
+        out[len++] = c;
+        p++;
+    }
+
+    while (len > 0 && (out[len - 1] == ' ' || out[len - 1] == ';')) len--;
+    out[len] = '\0';
+    return len;
+}
+
+/**
+ * @function query_stats_record: Account one statement and log it if slow.
+ *
+ * @param handler Static name of the command being handled, or NULL outside a request.
+ * @param sql Statement text as sent to libpq.
+ * @param elapsed_ns Wall time of the libpq call.
+ * @param rows Rows returned (SELECT) or affected (INSERT/UPDATE/DELETE).
+ *
+ * @return void
+ */
+void query_stats_record(const char *handler, const char *sql, uint64_t elapsed_ns, long rows) {
+    char normalized[QUERY_SQL_MAX];
+    query_normalize(sql, normalized, sizeof(normalized));
+    if (!handler) handler = "-";
+
+    uint64_t hash = fingerprint(normalized, handler);
+    int slow = slow_threshold_ms >= 0 && elapsed_ns >= (uint64_t)slow_threshold_ms * 1000000ULL;
+
+    QueryStat *slot = find_slot(hash, handler, normalized);
+    if (slot) {
+        slot->calls++;
+        slot->rows += rows > 0 ? (uint64_t)rows : 0;
+        slot->total_ns += elapsed_ns;
+        if (elapsed_ns > slot->max_ns) slot->max_ns = elapsed_ns;
+        if (slow) slot->slow++;
+    } else {
+        untracked++;
+    }
+
+    if (slow) {
+        slow_total++;
+        write_slow_entry(handler, normalized, hash, elapsed_ns, rows);
+    }
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+/**
+ * @function query_stats_slots: Raw slot table for exporters.
+ *
+ * @param count Receives the number of slots (free slots have fingerprint 0).
+ *
+ * @return Pointer to the slot table.
+ */
+const QueryStat* query_stats_slots(size_t *count) {
+    if (count) *count = QUERY_STATS_SLOTS;
+    return slots;
+}
+
+/**
+ * @function query_stats_untracked: Statements not tracked because the table was full.
+ *
+ * @return Untracked statement count.
+ */
+uint64_t query_stats_untracked(void) {
+    return untracked;
+}
+
+/**
+ * @function query_stats_slow_total: Statements over the slow threshold.
+ *
+ * @return Slow statement count.
+ */
+uint64_t query_stats_slow_total(void) {
+    return slow_total;
+}
+
+/**
+ * @function query_stats_slow_threshold_ms: Configured slow threshold.
+ *
+ * @return Threshold in milliseconds, negative when the log is disabled.
+ */
+long query_stats_slow_threshold_ms(void) {
+    return slow_threshold_ms;
+}
@@ -0,0 +1,50 @@
+// ============================================================================
+// query_stats.h - Per-statement database timing and slow-query log
+// ============================================================================
+//
+// The libpq wrappers in metrics.c report every statement here together with
+// the command being handled. Statements are normalized (literals become ?,
+// whitespace collapses) so the dozens of snprintf-built queries group by
+// shape, and each (shape, handler) pair keeps call count, rows and time.
+//
+// Statements slower than CHAT_SLOW_QUERY_MS (default 100; 0 logs every
+// statement, a negative value disables the log) are appended to
+// CHAT_SLOW_QUERY_LOG (default slow_query.log).
+
+#ifndef QUERY_STATS_H
+#define QUERY_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define QUERY_STATS_SLOTS 256            // Distinct (statement, handler) pairs tracked
+#define QUERY_SQL_MAX 256                // Normalized text kept per statement
+#define QUERY_SLOW_DEFAULT_MS 100
+#define QUERY_SLOW_DEFAULT_LOG "slow_query.log"
+
+typedef struct {
+    uint64_t fingerprint;                // 0 marks a free slot
+    const char *handler;                 // Static command name, "-" outside a request
+    char sql[QUERY_SQL_MAX];
+    uint64_t calls;
+    uint64_t rows;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t slow;
+} QueryStat;
+
+// Lifecycle
+void query_stats_init(void);
+void query_stats_shutdown(void);
+
+// Recording
+size_t query_normalize(const char *sql, char *out, size_t out_size);
+void query_stats_record(const char *handler, const char *sql, uint64_t elapsed_ns, long rows);
+
+// Reporting
+const QueryStat* query_stats_slots(size_t *count);
+uint64_t query_stats_untracked(void);
+uint64_t query_stats_slow_total(void);
+long query_stats_slow_threshold_ms(void);
+
+#endif
@@ -8,11 +8,98 @@
 #include "../server/auth.h"
 #include "../server/friend.h"
 #include "../server/message.h"
+#include "router.h"
 #include "../helper/helper.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * @function router_status_detail: Human-readable result for a status code (log.txt).
+ * 
+ * @param status_code Response status code.
+ * 
+ * @return Static description string.
+ */
+const char* router_status_detail(int status_code) {
+    switch (status_code) {
+        // Success codes (1xx)
+        case 101: return "Register Success";
+        case 102: return "Login Success";
+        case 103: return "Logout Success";
+        case 104: return "Friend Request Sent";
+        case 105: return "Friend Request Accepted";
+        case 106: return "Friend Request Declined";
+        case 107: return "Friend Removed";
+        case 108: return "Friend List Retrieved";
+        case 109: return "Message Sent";
+        case 110: return "Group Created";
+        case 111: return "Group Invite Sent";
+        case 112: return "Group Joined";
+        case 113: return "Group Left";
+        case 114: return "Member Kicked";
+        case 115: return "Group Message Sent";
+        case 116: return "Offline Message Retrieved";
+        case 117: return "Pending Requests Retrieved";
+        case 118: return "Offline Messages Retrieved";
+        case 119: return "Join Request Sent";
+        case 120: return "Join Request Approved";
+        case 121: return "Join Request Rejected";
+        case 122: return "Group Message Sent Success";
+        case 123: return "Compression Enabled";
+        case 125: return "Unread Summary Sent";
+        case 126: return "Stats Sent";
+        case 127: return "Session Resumed";
+        case 128: return "Presence Subscribed";
+        case 129: return "Friend List Synced";
+        
+        // Client errors (2xx)
+        case 201: return "Username Already Exists";
+        case 202: return "Wrong Password";
+        case 216: return "Group Join Request Notification";
+        case 217: return "Group Join Approved Notification";
+        case 218: return "No Offline Messages";
+        case 219: return "Group Join Rejected Notification";
+        case 250: return "Group Invite Notification";
+        case 251: return "User Offline Notification";
+        case 252: return "Group Kick Notification";
+        case 253: return "Presence Notification";
+        
+        // Auth/Session errors (3xx)
+        case 301: return "Invalid Username";
+        case 302: return "Invalid Password";
+        case 303: return "User Not Found";
+        case 304: return "Already Logged In";
+        case 305: return "Not Logged In";
+        case 306: return "Already Friends";
+        case 307: return "Invalid Resume Token";
+        
+        // Database/Server errors (4xx)
+        case 400: return "Database Error";
+        case 401: return "Request Already Pending";
+        case 402: return "No Pending Request";
+        case 403: return "Not Friends";
+        case 413: return "User Offline";
+        case 414: return "Message Too Long";
+        case 415: return "Group Already Exists";
+        case 416: return "Invalid Group Name";
+        case 417: return "Not Group Owner";
+        case 418: return "Already In Group";
+        case 419: return "Group Not Found";
+        case 420: return "Invite Required";
+        case 421: return "Not In Group";
+        case 422: return "Cannot Kick Owner";
+        case 423: return "Compression Unsupported";
+        case 429: return "Rate Limited";
+        
+        // System errors (5xx)
+        case 500: return "Undefined Error";
+        case 501: return "Server Busy";
+        
+        default: return "Unknown Status Code";
+    }
+}
+
 /**
  * @function server_handle_client_message: Routes and processes client messages.
  * 
@@ -25,6 +112,9 @@
 void server_handle_client_message(Server *server, ClientSession *client, const char *message) {
     if (!server || !client || !message) return;
     
+    uint64_t started_ns = metrics_now_ns();
+    metrics_begin_request();
+    
     ParsedCommand *cmd = parse_protocol_message(message);
     if (!cmd) {
         char *response = build_simple_response(STATUS_UNDEFINED_ERROR);
@@ -33,8 +123,12 @@ void server_handle_client_message(Server *server, ClientSession *client, const c
         
         const char *username = client->is_authenticated ? client->username : "Guest";
         log_activity(username, "PARSE_ERROR", message, "500", "Failed to parse command");
+        metrics_record_request(server->metrics, CMD_UNKNOWN, STATUS_UNDEFINED_ERROR,
+                               metrics_now_ns() - started_ns);
         return;
     }
+    metrics_set_command(cmd->cmd_type);
+
     const char *cmd_code = "UNKNOWN";
     char cmd_detail[512] = "";
     char result_code[16] = "0";
@@ -43,6 +137,38 @@ void server_handle_client_message(Server *server, ClientSession *client, const c
     const char *log_username = client->is_authenticated ? client->username : "Guest";
     int initial_response_code = client->last_response_code;
     
+    // Per-session budgets are checked before any handler touches the database.
+    // Follow-up windows of a group catch-up are exempt: only the first one
+    // pays, however long the backlog.
+    int retry_after = 0;
+    uint64_t paused_before = client->paused_until_ns;
+    int catchup_followup = cmd->cmd_type == CMD_GROUP_SEND_OFFLINE_MSG && client->catchup_group[0] &&
+                           strcmp(client->catchup_group, cmd->group_name) == 0;
+    if (!catchup_followup &&
+        !rate_session_take(server->rate_limiter, &client->budget, cmd->cmd_type,
+                           &client->paused_until_ns, &retry_after)) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "Slow down, retry in %d s", retry_after);
+        char *response = build_response(STATUS_RATE_LIMITED, msg);
+        send_and_free(client, response);
+        
+        if (client->paused_until_ns != paused_before) {
+            LOG_WARN("Pausing reads from fd=%d (%s) for %.1f s: over %s budget", client->socket_fd,
+                     log_username, (client->paused_until_ns - metrics_now_ns()) / 1e9,
+                     rate_class_name(rate_command_class(cmd->cmd_type)));
+        }
+        // Only the first refusal of a run goes to log.txt; a flood would turn it into the bottleneck
+        if (client->rate_limited_streak++ == 0) {
+            log_activity(log_username, metrics_command_name(cmd->cmd_type), "rate_limited",
+                         "429", router_status_detail(STATUS_RATE_LIMITED));
+        }
+        metrics_record_request(server->metrics, cmd->cmd_type, STATUS_RATE_LIMITED,
+                               metrics_now_ns() - started_ns);
+        free_parsed_command(cmd);
+        return;
+    }
+    client->rate_limited_streak = 0;
+    
     switch (cmd->cmd_type) {
         // ====================================================================
         // Authentication Commands
@@ -66,6 +192,14 @@ void server_handle_client_message(Server *server, ClientSession *client, const c
             handle_logout_command(server, client, cmd);
             break;
             
+        case CMD_RESUME:
+            cmd_code = "RESUME";
+            snprintf(cmd_detail, sizeof(cmd_detail), "last_seen=%.20s",
+                    cmd->message[0] ? cmd->message : "0");
+            handle_resume_command(server, client, cmd);
+            log_username = client->is_authenticated ? client->username : "Guest";
+            break;
+            
         // ====================================================================
         // Friend Management Commands
         // ====================================================================
@@ -105,6 +239,19 @@ void server_handle_client_message(Server *server, ClientSession *client, const c
             handle_friend_list(server, client);
             break;
 
+        case CMD_FRIEND_LIST_SYNC:
+            cmd_code = "FRIEND_LIST_SYNC";
+            snprintf(cmd_detail, sizeof(cmd_detail), "version=%.20s",
+                    cmd->message[0] ? cmd->message : "0");
+            handle_friend_list_sync(server, client, cmd);
+            break;
+
+        case CMD_PRESENCE_SUBSCRIBE:
+            cmd_code = "PRESENCE_SUBSCRIBE";
+            strcpy(cmd_detail, "subscribe_friend_presence");
+            handle_presence_subscribe(server, client);
+            break;
+
         // ====================================================================
         // Direct Messaging Commands
         // ====================================================================
@@ -117,9 +264,16 @@ void server_handle_client_message(Server *server, ClientSession *client, const c
 
         case CMD_GET_OFFLINE_MSG:
             cmd_code = "GET_OFFLINE_MSG";
-            snprintf(cmd_detail, sizeof(cmd_detail), "from=%s", cmd->target_user);
+            snprintf(cmd_detail, sizeof(cmd_detail), "from=%s cursor=%.20s",
+                    cmd->target_user, cmd->message[0] ? cmd->message : "0");
             handle_get_offline_messages(server, client, cmd);
             break;
+
+        case CMD_UNREAD_SUMMARY:
+            cmd_code = "UNREAD_SUMMARY";
+            strcpy(cmd_detail, "get_unread_summary");
+            handle_unread_summary(server, client, cmd);
+            break;
             
         // ====================================================================
         // Group Management Commands
@@ -200,6 +354,22 @@ void server_handle_client_message(Server *server, ClientSession *client, const c
             handle_exit_group_messaging(server, client, cmd);
             break;
             
+        // ====================================================================
+        // Connection Options
+        // ====================================================================
+        case CMD_COMPRESS:
+            cmd_code = "COMPRESS";
+            snprintf(cmd_detail, sizeof(cmd_detail), "algorithm=%.32s", cmd->message);
+            handle_compress_command(server, client, cmd);
+            break;
+            
+        case CMD_STATS:
+            cmd_code = "STATS";
+            snprintf(cmd_detail, sizeof(cmd_detail), "option=%.16s",
+                    cmd->message[0] ? cmd->message : "none");
+            handle_stats_command(server, client, cmd);
+            break;
+            
         // ====================================================================
         // Not Implemented / Unknown Commands
         // ====================================================================
@@ -223,76 +393,21 @@ void server_handle_client_message(Server *server, ClientSession *client, const c
             break;
     }
     
+    // REGISTER/LOGIN handed to the auth pool: auth_handle_completions() records it
+    if (client->auth_pending) {
+        free_parsed_command(cmd);
+        return;
+    }
+    
     if (client->last_response_code != initial_response_code) {
         snprintf(result_code, sizeof(result_code), "%d", client->last_response_code);
-        
-        switch (client->last_response_code) {
-            // Success codes (1xx)
-            case 101: strcpy(result_detail, "Register Success"); break;
-            case 102: strcpy(result_detail, "Login Success"); break;
-            case 103: strcpy(result_detail, "Logout Success"); break;
-            case 104: strcpy(result_detail, "Friend Request Sent"); break;
-            case 105: strcpy(result_detail, "Friend Request Accepted"); break;
-            case 106: strcpy(result_detail, "Friend Request Declined"); break;
-            case 107: strcpy(result_detail, "Friend Removed"); break;
-            case 108: strcpy(result_detail, "Friend List Retrieved"); break;
-            case 109: strcpy(result_detail, "Message Sent"); break;
-            case 110: strcpy(result_detail, "Group Created"); break;
-            case 111: strcpy(result_detail, "Group Invite Sent"); break;
-            case 112: strcpy(result_detail, "Group Joined"); break;
-            case 113: strcpy(result_detail, "Group Left"); break;
-            case 114: strcpy(result_detail, "Member Kicked"); break;
-            case 115: strcpy(result_detail, "Group Message Sent"); break;
-            case 116: strcpy(result_detail, "Offline Message Retrieved"); break;
-            case 117: strcpy(result_detail, "Pending Requests Retrieved"); break;
-            case 118: strcpy(result_detail, "Offline Messages Retrieved"); break;
-            case 119: strcpy(result_detail, "Join Request Sent"); break;
-            case 120: strcpy(result_detail, "Join Request Approved"); break;
-            case 121: strcpy(result_detail, "Join Request Rejected"); break;
-            case 122: strcpy(result_detail, "Group Message Sent Success"); break;
-            
-            // Client errors (2xx)
-            case 201: strcpy(result_detail, "Username Already Exists"); break;
-            case 202: strcpy(result_detail, "Wrong Password"); break;
-            case 216: strcpy(result_detail, "Group Join Request Notification"); break;
-            case 217: strcpy(result_detail, "Group Join Approved Notification"); break;
-            case 218: strcpy(result_detail, "No Offline Messages"); break;
-            case 219: strcpy(result_detail, "Group Join Rejected Notification"); break;
-            case 250: strcpy(result_detail, "Group Invite Notification"); break;
-            case 251: strcpy(result_detail, "User Offline Notification"); break;
-            case 252: strcpy(result_detail, "Group Kick Notification"); break;
-            
-            // Auth/Session errors (3xx)
-            case 301: strcpy(result_detail, "Invalid Username"); break;
-            case 302: strcpy(result_detail, "Invalid Password"); break;
-            case 303: strcpy(result_detail, "User Not Found"); break;
-            case 304: strcpy(result_detail, "Already Logged In"); break;
-            case 305: strcpy(result_detail, "Not Logged In"); break;
-            case 306: strcpy(result_detail, "Already Friends"); break;
-            
-            // Database/Server errors (4xx)
-            case 400: strcpy(result_detail, "Database Error"); break;
-            case 401: strcpy(result_detail, "Request Already Pending"); break;
-            case 402: strcpy(result_detail, "No Pending Request"); break;
-            case 403: strcpy(result_detail, "Not Friends"); break;
-            case 413: strcpy(result_detail, "User Offline"); break;
-            case 414: strcpy(result_detail, "Message Too Long"); break;
-            case 415: strcpy(result_detail, "Group Already Exists"); break;
-            case 416: strcpy(result_detail, "Invalid Group Name"); break;
-            case 417: strcpy(result_detail, "Not Group Owner"); break;
-            case 418: strcpy(result_detail, "Already In Group"); break;
-            case 419: strcpy(result_detail, "Group Not Found"); break;
-            case 420: strcpy(result_detail, "Invite Required"); break;
-            case 421: strcpy(result_detail, "Not In Group"); break;
-            case 422: strcpy(result_detail, "Cannot Kick Owner"); break;
-            
-            // System errors (5xx)
-            case 500: strcpy(result_detail, "Undefined Error"); break;
-            
-            default: strcpy(result_detail, "Unknown Status Code"); break;
-        }
+        snprintf(result_detail, sizeof(result_detail), "%s", router_status_detail(client->last_response_code));
     }
     
+    metrics_record_request(server->metrics, cmd->cmd_type,
+                           client->last_response_code != initial_response_code ? client->last_response_code : 0,
+                           metrics_now_ns() - started_ns);
+    
     log_activity(log_username, cmd_code, cmd_detail, result_code, result_detail);
     
     free_parsed_command(cmd);
@@ -2,5 +2,6 @@
 #define ROUTER_H
 
 void server_handle_client_message(Server *server, ClientSession *client, const char *message);
+const char* router_status_detail(int status_code);
 
 #endif
@@ -0,0 +1,488 @@
+#include "migrate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <time.h>
+
+static const char *schema_version_ddl =
+        "CREATE TABLE IF NOT EXISTS schema_version ("
+        "    version INTEGER PRIMARY KEY,"
+        "    name TEXT NOT NULL,"
+        "    applied_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,"
+        "    duration_ms INTEGER NOT NULL DEFAULT 0"
+        ")";
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @function run_command: Execute a statement that returns no rows.
+ *
+ * @param conn Database connection.
+ * @param sql Statement text.
+ *
+ * @return 1 on success, 0 on failure (error printed).
+ */
+static int run_command(PGconn *conn, const char *sql) {
+    PGresult *res = PQexec(conn, sql);
+    ExecStatusType status = PQresultStatus(res);
+    int ok = status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK;
+    if (!ok) {
+        fprintf(stderr, "    %s", PQerrorMessage(conn));
+    }
+    PQclear(res);
+    return ok;
+}
+
+/**
+ * @function compare_migrations: qsort comparator by version.
+ */
+static int compare_migrations(const void *a, const void *b) {
+    const Migration *ma = (const Migration*)a;
+    const Migration *mb = (const Migration*)b;
+    return (ma->version > mb->version) - (ma->version < mb->version);
+}
+
+/**
+ * @function scan_migrations: Collect <version>_<name>.sql files sorted by version.
+ *
+ * @param dir Migrations directory.
+ * @param out Output array of MIGRATION_MAX_FILES entries.
+ *
+ * @return Number of migrations found, or -1 on error (duplicate version, unreadable dir).
+ */
+static int scan_migrations(const char *dir, Migration *out) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        perror(dir);
+        return -1;
+    }
+
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        const char *file = entry->d_name;
+        size_t len = strlen(file);
+        if (!isdigit((unsigned char)file[0]) || len < 5 || strcmp(file + len - 4, ".sql") != 0) continue;
+
+        char *end;
+        long version = strtol(file, &end, 10);
+        if (*end != '_' || version <= 0) continue;
+
+        if (count == MIGRATION_MAX_FILES) {
+            fprintf(stderr, "Too many migrations in %s (max %d)\n", dir, MIGRATION_MAX_FILES);
+            closedir(d);
+            return -1;
+        }
+
+        Migration *m = &out[count++];
+        m->version = (int)version;
+        snprintf(m->name, sizeof(m->name), "%.*s", (int)(len - 4 - (size_t)(end + 1 - file)), end + 1);
+        snprintf(m->path, sizeof(m->path), "%s/%s", dir, file);
+    }
+    closedir(d);
+
+    qsort(out, (size_t)count, sizeof(Migration), compare_migrations);
+    for (int i = 1; i < count; i++) {
+        if (out[i].version == out[i - 1].version) {
+            fprintf(stderr, "Duplicate migration version %d: %s and %s\n",
+                    out[i].version, out[i - 1].path, out[i].path);
+            return -1;
+        }
+    }
+    return count;
+}
+
+/**
+ * @function read_file: Read a whole file into a NUL-terminated buffer.
+ *
+ * @param path File path.
+ *
+ * @return Dynamically allocated contents, or NULL on failure.
+ */
+static char* read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *data = size >= 0 ? (char*)malloc((size_t)size + 1) : NULL;
+    if (data && fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    if (data) data[size] = '\0';
+    return data;
+}
+
+/**
+ * @function skip_comments: Skip whitespace and comments at the start of a statement.
+ *
+ * @param p Statement text.
+ *
+ * @return Pointer to the first SQL token, or to the terminating NUL.
+ */
+static const char* skip_comments(const char *p) {
+    for (;;) {
+        while (isspace((unsigned char)*p)) p++;
+        if (p[0] == '-' && p[1] == '-') {
+            while (*p && *p != '\n') p++;
+        } else if (p[0] == '/' && p[1] == '*') {
+            const char *close = strstr(p + 2, "*/");
+            p = close ? close + 2 : p + strlen(p);
+        } else {
+            return p;
+        }
+    }
+}
+
+/**
+ * @function next_statement: Cut the next ;-terminated statement out of a script.
+ *
+ * Semicolons inside quotes, quoted identifiers, comments and $tag$ bodies do
+ * not end a statement. The terminating ';' is overwritten with NUL.
+ *
+ * @param cursor In/out position in the script.
+ *
+ * @return Start of the statement (comments skipped), or NULL at end of script.
+ */
+static char* next_statement(char **cursor) {
+    char *p = *cursor;
+    char *start = (char*)skip_comments(p);
+    if (!*start) return NULL;
+
+    p = start;
+    while (*p) {
+        if (*p == '\'' || *p == '"') {
+            char quote = *p++;
+            while (*p && !(*p == quote && p[1] != quote)) {
+                if (*p == quote) p++;
+                p++;
+            }
+            if (*p) p++;
+        } else if (p[0] == '-' && p[1] == '-') {
+            while (*p && *p != '\n') p++;
+        } else if (p[0] == '/' && p[1] == '*') {
+            char *close = strstr(p + 2, "*/");
+            p = close ? close + 2 : p + strlen(p);
+        } else if (*p == '$' && (p == start || !isalnum((unsigned char)p[-1]))) {
+            // Dollar quoting: $$ ... $$ or $tag$ ... $tag$
+            char *tag_end = p + 1;
+            while (isalnum((unsigned char)*tag_end) || *tag_end == '_') tag_end++;
+            if (*tag_end != '$') { p++; continue; }
+            size_t tag_len = (size_t)(tag_end - p) + 1;
+            char *close = tag_end + 1;
+            while ((close = strchr(close, '$')) != NULL && strncmp(close, p, tag_len) != 0) close++;
+            p = close ? close + tag_len : p + strlen(p);
+        } else if (*p == ';') {
+            *p++ = '\0';
+            *cursor = p;
+            return start;
+        } else {
+            p++;
+        }
+    }
+    *cursor = p;
+    return start;
+}
+
+/**
+ * @function contains_word: Case-insensitive search for a keyword outside comments.
+ *
+ * @param script Migration text.
+ * @param word Upper-case keyword.
+ *
+ * @return 1 if found, 0 otherwise.
+ */
+static int contains_word(const char *script, const char *word) {
+    size_t len = strlen(word);
+    const char *p = script;
+    while (*p) {
+        if (p[0] == '-' && p[1] == '-') {
+            while (*p && *p != '\n') p++;
+            continue;
+        }
+        if (strncasecmp(p, word, len) == 0 &&
+            (p == script || !isalnum((unsigned char)p[-1])) && !isalnum((unsigned char)p[len])) {
+            return 1;
+        }
+        p++;
+    }
+    return 0;
+}
+
+/**
+ * @function concurrent_index_name: Index name of CREATE [UNIQUE] INDEX CONCURRENTLY IF NOT EXISTS.
+ *
+ * @param stmt Statement text (comments already skipped).
+ * @param name Output buffer.
+ * @param size Size of the output buffer.
+ *
+ * @return 1 if stmt is such a statement and the name was extracted, 0 otherwise.
+ */
+static int concurrent_index_name(const char *stmt, char *name, size_t size) {
+    char words[7][64];
+    int n = sscanf(stmt, "%63s %63s %63s %63s %63s %63s %63s",
+                   words[0], words[1], words[2], words[3], words[4], words[5], words[6]);
+    int i = 0;
+    if (n < 1 || strcasecmp(words[i++], "CREATE") != 0) return 0;
+    if (n > i && strcasecmp(words[i], "UNIQUE") == 0) i++;
+    if (n < i + 6) return 0;
+    if (strcasecmp(words[i], "INDEX") != 0 || strcasecmp(words[i + 1], "CONCURRENTLY") != 0 ||
+        strcasecmp(words[i + 2], "IF") != 0 || strcasecmp(words[i + 3], "NOT") != 0 ||
+        strcasecmp(words[i + 4], "EXISTS") != 0) {
+        return 0;
+    }
+    snprintf(name, size, "%s", words[i + 5]);
+    return 1;
+}
+
+/**
+ * @function drop_invalid_index: Drop an index left INVALID by an interrupted CONCURRENTLY build.
+ *
+ * Without this, IF NOT EXISTS would treat the broken index as done.
+ *
+ * @param conn Database connection.
+ * @param name Index name.
+ *
+ * @return 1 on success (or nothing to do), 0 on failure.
+ */
+static int drop_invalid_index(PGconn *conn, const char *name) {
+    const char *params[1] = { name };
+    PGresult *res = PQexecParams(conn,
+            "SELECT 1 FROM pg_index i JOIN pg_class c ON c.oid = i.indexrelid "
+            "WHERE c.relname = $1 AND NOT i.indisvalid",
+            1, NULL, params, NULL, NULL, 0);
+    int invalid = PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0;
+    PQclear(res);
+    if (!invalid) return 1;
+
+    char *quoted = PQescapeIdentifier(conn, name, strlen(name));
+    if (!quoted) return 0;
+    char sql[256];
+    snprintf(sql, sizeof(sql), "DROP INDEX CONCURRENTLY IF EXISTS %s", quoted);
+    PQfreemem(quoted);
+
+    printf("    dropping invalid index %s left by an earlier attempt\n", name);
+    return run_command(conn, sql);
+}
+
+/**
+ * @function load_applied: Read the applied versions from schema_version.
+ *
+ * @param conn Database connection.
+ *
+ * @return PGresult with (version, name, applied_at) rows, or NULL on error.
+ */
+static PGresult* load_applied(PGconn *conn) {
+    PGresult *res = PQexec(conn, "SELECT version, name, applied_at FROM schema_version ORDER BY version");
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        fprintf(stderr, "Failed to read schema_version: %s", PQerrorMessage(conn));
+        PQclear(res);
+        return NULL;
+    }
+    return res;
+}
+
+/**
+ * @function applied_row: Find a version in the schema_version result.
+ *
+ * @param applied Result of load_applied.
+ * @param version Migration version.
+ *
+ * @return Row index, or -1 if not applied.
+ */
+static int applied_row(PGresult *applied, int version) {
+    int rows = PQntuples(applied);
+    for (int i = 0; i < rows; i++) {
+        if (atoi(PQgetvalue(applied, i, 0)) == version) return i;
+    }
+    return -1;
+}
+
+/**
+ * @function apply_one: Run one migration file and record it.
+ *
+ * @param conn Database connection.
+ * @param m Migration to apply.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int apply_one(PGconn *conn, const Migration *m) {
+    char *script = read_file(m->path);
+    if (!script) return 0;
+
+    int concurrent = contains_word(script, "CONCURRENTLY");
+    printf("  [%03d] %s%s\n", m->version, m->name, concurrent ? " (online, no transaction)" : "");
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int ok = concurrent || run_command(conn, "BEGIN");
+    char *cursor = script;
+    char *stmt;
+    int statements = 0;
+    while (ok && (stmt = next_statement(&cursor)) != NULL) {
+        char index_name[64];
+        if (concurrent && concurrent_index_name(stmt, index_name, sizeof(index_name))) {
+            ok = drop_invalid_index(conn, index_name);
+        }
+        ok = ok && run_command(conn, stmt);
+        statements++;
+        if (!ok) {
+            fprintf(stderr, "    statement %d of %s failed\n", statements, m->path);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long duration_ms = (end.tv_sec - start.tv_sec) * 1000L + (end.tv_nsec - start.tv_nsec) / 1000000L;
+
+    if (ok) {
+        char version_str[16], duration_str[32];
+        snprintf(version_str, sizeof(version_str), "%d", m->version);
+        snprintf(duration_str, sizeof(duration_str), "%ld", duration_ms);
+        const char *params[3] = { version_str, m->name, duration_str };
+        PGresult *res = PQexecParams(conn,
+                "INSERT INTO schema_version (version, name, duration_ms) VALUES ($1, $2, $3)",
+                3, NULL, params, NULL, NULL, 0);
+        ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (!ok) fprintf(stderr, "    failed to record version: %s", PQerrorMessage(conn));
+        PQclear(res);
+    }
+
+    if (!concurrent && ok) {
+        ok = run_command(conn, "COMMIT");
+    } else if (!concurrent) {
+        run_command(conn, "ROLLBACK");
+    }
+
+    if (ok) {
+        printf("        %d statement(s), %ld ms\n", statements, duration_ms);
+    } else if (concurrent) {
+        fprintf(stderr, "    %s stopped part way; fix the cause and re-run migrate\n", m->path);
+    }
+
+    free(script);
+    return ok;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @function migrate_apply: Apply every pending migration in version order.
+ *
+ * Holds an advisory lock for the duration so two migrators never interleave.
+ * Stops at the first failing migration.
+ *
+ * @param conn Database connection.
+ * @param dir Migrations directory (NULL for MIGRATIONS_DIR).
+ *
+ * @return Number of migrations applied, or -1 on failure.
+ */
+int migrate_apply(PGconn *conn, const char *dir) {
+    if (!conn) return -1;
+    if (!dir) dir = MIGRATIONS_DIR;
+
+    Migration *migrations = (Migration*)calloc(MIGRATION_MAX_FILES, sizeof(Migration));
+    if (!migrations) return -1;
+    int count = scan_migrations(dir, migrations);
+    if (count < 0) {
+        free(migrations);
+        return -1;
+    }
+
+    char lock_sql[64];
+    snprintf(lock_sql, sizeof(lock_sql), "SELECT pg_advisory_lock(%d)", MIGRATION_LOCK_KEY);
+    if (!run_command(conn, lock_sql) || !run_command(conn, schema_version_ddl)) {
+        free(migrations);
+        return -1;
+    }
+
+    PGresult *applied = load_applied(conn);
+    int applied_now = 0;
+    int failed = applied == NULL;
+
+    printf("Applying migrations from %s...\n", dir);
+    for (int i = 0; i < count && !failed; i++) {
+        if (applied_row(applied, migrations[i].version) >= 0) continue;
+        if (apply_one(conn, &migrations[i])) {
+            applied_now++;
+        } else {
+            failed = 1;
+        }
+    }
+    if (applied) PQclear(applied);
+
+    snprintf(lock_sql, sizeof(lock_sql), "SELECT pg_advisory_unlock(%d)", MIGRATION_LOCK_KEY);
+    run_command(conn, lock_sql);
+    free(migrations);
+
+    if (failed) return -1;
+    if (applied_now == 0) {
+        printf("✓ Schema is up to date\n");
+    } else {
+        printf("✓ Applied %d migration(s)\n", applied_now);
+    }
+    return applied_now;
+}
+
+/**
+ * @function migrate_status: Print each migration with its applied time or "pending".
+ *
+ * @param conn Database connection.
+ * @param dir Migrations directory (NULL for MIGRATIONS_DIR).
+ *
+ * @return Number of pending migrations, or -1 on failure.
+ */
+int migrate_status(PGconn *conn, const char *dir) {
+    if (!conn) return -1;
+    if (!dir) dir = MIGRATIONS_DIR;
+
+    Migration *migrations = (Migration*)calloc(MIGRATION_MAX_FILES, sizeof(Migration));
+    if (!migrations) return -1;
+    int count = scan_migrations(dir, migrations);
+    if (count < 0 || !run_command(conn, schema_version_ddl)) {
+        free(migrations);
+        return -1;
+    }
+
+    PGresult *applied = load_applied(conn);
+    if (!applied) {
+        free(migrations);
+        return -1;
+    }
+
+    int pending = 0;
+    printf("%-8s %-40s %s\n", "Version", "Name", "Applied");
+    for (int i = 0; i < count; i++) {
+        int row = applied_row(applied, migrations[i].version);
+        if (row < 0) pending++;
+        printf("%-8d %-40s %s\n", migrations[i].version, migrations[i].name,
+               row >= 0 ? PQgetvalue(applied, row, 2) : "pending");
+    }
+
+    // Versions recorded in the database whose files are gone
+    for (int r = 0; r < PQntuples(applied); r++) {
+        int version = atoi(PQgetvalue(applied, r, 0));
+        int found = 0;
+        for (int i = 0; i < count && !found; i++) found = migrations[i].version == version;
+        if (!found) {
+            printf("%-8d %-40s %s (file missing)\n", version, PQgetvalue(applied, r, 1), PQgetvalue(applied, r, 2));
+        }
+    }
+
+    PQclear(applied);
+    free(migrations);
+    return pending;
+}
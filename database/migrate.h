@@ -0,0 +1,28 @@
+#ifndef MIGRATE_H
+#define MIGRATE_H
+
+#include <libpq-fe.h>
+
+// Numbered schema migrations: <version>_<name>.sql files applied in version
+// order and recorded in schema_version. Each file runs in one transaction,
+// unless it contains CREATE/DROP INDEX CONCURRENTLY, which PostgreSQL refuses
+// inside a transaction block: those files run statement by statement in
+// autocommit mode and must be idempotent (IF NOT EXISTS / IF EXISTS) so a
+// partially applied file can simply be re-run.
+#define MIGRATIONS_DIR "database/migrations"
+#define MIGRATION_MAX_FILES 256
+#define MIGRATION_LOCK_KEY 727274          // pg_advisory_lock key serializing migrators
+
+typedef struct {
+    int version;
+    char name[128];
+    char path[512];
+} Migration;
+
+// Apply every migration not yet recorded in schema_version
+int migrate_apply(PGconn *conn, const char *dir);
+
+// Print applied and pending migrations
+int migrate_status(PGconn *conn, const char *dir);
+
+#endif
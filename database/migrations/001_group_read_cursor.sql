@@ -0,0 +1,19 @@
+-- ============================================================================
+-- 001: Per-member group read cursors by message id
+-- ============================================================================
+-- Replaces the last_read_at timestamp comparison with a message id cursor so
+-- unread catch-up is a keyset range scan on (group_id, id).
+
+ALTER TABLE group_members
+    ADD COLUMN IF NOT EXISTS last_read_message_id INTEGER NOT NULL DEFAULT 0;
+
+-- Carry existing read positions over from last_read_at
+UPDATE group_members m
+SET last_read_message_id = COALESCE((
+        SELECT MAX(g.id) FROM group_messages g
+        WHERE g.group_id = m.group_id AND g.created_at <= m.last_read_at
+    ), 0)
+WHERE m.last_read_message_id = 0 AND m.last_read_at IS NOT NULL;
+
+CREATE INDEX IF NOT EXISTS idx_group_messages_group_id_id
+    ON group_messages (group_id, id);
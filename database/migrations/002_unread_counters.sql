@@ -0,0 +1,37 @@
+-- ============================================================================
+-- 002: Denormalized unread counters
+-- ============================================================================
+-- direct_unread_counts: undelivered direct messages per (receiver, sender).
+-- group_members.unread_count: group messages past the member's read cursor.
+-- Both are maintained by the server on insert and on delivery/read, so
+-- UNREAD_SUMMARY is a pair of indexed lookups.
+
+CREATE TABLE IF NOT EXISTS direct_unread_counts (
+    user_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    sender_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    unread_count INTEGER NOT NULL DEFAULT 0,
+    PRIMARY KEY (user_id, sender_id)
+);
+
+ALTER TABLE group_members
+    ADD COLUMN IF NOT EXISTS unread_count INTEGER NOT NULL DEFAULT 0;
+
+CREATE INDEX IF NOT EXISTS idx_group_members_user_id
+    ON group_members (user_id);
+
+-- Backfill from current state (safe to re-run: values are recomputed)
+INSERT INTO direct_unread_counts (user_id, sender_id, unread_count)
+SELECT receiver_id, sender_id, COUNT(*)
+FROM messages
+WHERE is_delivered = FALSE AND receiver_id IS NOT NULL
+GROUP BY receiver_id, sender_id
+ON CONFLICT (user_id, sender_id)
+DO UPDATE SET unread_count = EXCLUDED.unread_count;
+
+UPDATE group_members m
+SET unread_count = (
+    SELECT COUNT(*) FROM group_messages g
+    WHERE g.group_id = m.group_id
+      AND g.id > m.last_read_message_id
+      AND g.sender_id != m.user_id
+);
@@ -0,0 +1,8 @@
+-- ============================================================================
+-- 003: Index for the login notification drain
+-- ============================================================================
+-- send_pending_notifications reads a user's notifications in id order in
+-- batches (user_id = $1 AND id > $cursor ORDER BY id LIMIT n).
+
+CREATE INDEX IF NOT EXISTS idx_offline_notifications_user_id_id
+    ON offline_notifications (user_id, id);
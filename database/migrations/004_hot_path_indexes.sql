@@ -0,0 +1,27 @@
+-- ============================================================================
+-- 004: Indexes for the hot friend and offline-message queries (online)
+-- ============================================================================
+-- Built with CONCURRENTLY so writes continue during the build; db_manager
+-- migrate runs this file outside a transaction and drops any index left
+-- INVALID by an interrupted build before retrying it.
+--
+-- Already covered elsewhere, so not duplicated here:
+--   users(username)                 UNIQUE constraint on users.username
+--   group_members(group_id, user_id) UNIQUE(group_id, user_id)
+--   offline_notifications(user_id)  prefix of idx_offline_notifications_user_id_id (003)
+--   group_messages(group_id, ...)   reads use the id cursor, idx_group_messages_group_id_id (001)
+
+-- friend_exists / accept / decline: (user_id, friend_id) pair plus status,
+-- answered from the index alone
+CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_friends_user_friend_status
+    ON friends (user_id, friend_id, status);
+
+-- FRIEND_PENDING and the friend_id side of FRIEND_LIST
+CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_friends_friend_status
+    ON friends (friend_id, status);
+
+-- Offline catch-up: undelivered messages for a receiver from one sender in
+-- id order. Partial, so delivered history does not grow the index.
+CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_messages_undelivered
+    ON messages (receiver_id, sender_id, id)
+    WHERE is_delivered = FALSE;
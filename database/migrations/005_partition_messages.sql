@@ -0,0 +1,126 @@
+-- ============================================================================
+-- 005: Monthly range partitioning for messages and group_messages
+-- ============================================================================
+-- Each table becomes a parent partitioned by created_at. The existing rows
+-- stay where they are: the old table is renamed <table>_legacy and attached
+-- as the partition for everything before the month after its newest row, so
+-- no data is copied. New months go to <table>_pYYYY_MM partitions created
+-- ahead of time by `db_manager partitions-create`, and old months are moved
+-- out with `db_manager partitions-archive`. A <table>_default partition
+-- catches rows outside every range so inserts never fail.
+--
+-- Attaching builds the (id, created_at) primary key index on the legacy
+-- table and re-checks its foreign keys, so run this off-peak on large tables.
+-- Requires PostgreSQL 12 or newer.
+
+-- Create missing monthly partitions up to months_ahead months from now.
+-- Rows that already landed in <table>_default for a new month are moved
+-- into its partition; PARTITION OF would otherwise fail on them.
+CREATE OR REPLACE FUNCTION chat_create_month_partitions(parent TEXT, months_ahead INTEGER)
+RETURNS INTEGER LANGUAGE plpgsql AS $fn$
+DECLARE
+    last_month TIMESTAMP := date_trunc('month', LOCALTIMESTAMP) + make_interval(months => months_ahead);
+    default_name TEXT := parent || '_default';
+    month_start TIMESTAMP;
+    covered TIMESTAMP;
+    part_name TEXT;
+    stray BIGINT;
+    created INTEGER := 0;
+BEGIN
+    -- Months below the highest existing upper bound are already covered
+    SELECT max((regexp_match(pg_get_expr(c.relpartbound, c.oid), 'TO \(''([^'']+)''\)'))[1]::timestamp)
+      INTO covered
+      FROM pg_inherits i
+      JOIN pg_class c ON c.oid = i.inhrelid
+     WHERE i.inhparent = parent::regclass;
+
+    month_start := GREATEST(date_trunc('month', LOCALTIMESTAMP), COALESCE(covered, '-infinity'));
+    WHILE month_start <= last_month LOOP
+        part_name := format('%s_p%s', parent, to_char(month_start, 'YYYY_MM'));
+        IF to_regclass(part_name) IS NULL THEN
+            stray := 0;
+            IF to_regclass(default_name) IS NOT NULL THEN
+                EXECUTE format('SELECT count(*) FROM %I WHERE created_at >= %L AND created_at < %L',
+                               default_name, month_start, month_start + interval '1 month') INTO stray;
+            END IF;
+
+            IF stray = 0 THEN
+                EXECUTE format('CREATE TABLE %I PARTITION OF %I FOR VALUES FROM (%L) TO (%L)',
+                               part_name, parent, month_start, month_start + interval '1 month');
+            ELSE
+                -- Block new inserts into the default until its rows for this month are moved
+                EXECUTE format('LOCK TABLE %I IN EXCLUSIVE MODE', default_name);
+                EXECUTE format('CREATE TABLE %I (LIKE %I INCLUDING DEFAULTS INCLUDING CONSTRAINTS INCLUDING STORAGE)',
+                               part_name, parent);
+                EXECUTE format('WITH moved AS (DELETE FROM %I WHERE created_at >= %L AND created_at < %L RETURNING *) '
+                               'INSERT INTO %I SELECT * FROM moved',
+                               default_name, month_start, month_start + interval '1 month', part_name);
+                GET DIAGNOSTICS stray = ROW_COUNT;
+                EXECUTE format('ALTER TABLE %I ATTACH PARTITION %I FOR VALUES FROM (%L) TO (%L)',
+                               parent, part_name, month_start, month_start + interval '1 month');
+                RAISE NOTICE 'moved % row(s) from % into %', stray, default_name, part_name;
+            END IF;
+            created := created + 1;
+        END IF;
+        month_start := month_start + interval '1 month';
+    END LOOP;
+    RETURN created;
+END
+$fn$;
+
+-- Turn a plain table into a partitioned parent with the old table as its first partition
+CREATE OR REPLACE FUNCTION chat_partition_by_month(parent TEXT)
+RETURNS VOID LANGUAGE plpgsql AS $fn$
+DECLARE
+    legacy TEXT := parent || '_legacy';
+    bound TIMESTAMP;
+    seq TEXT;
+    fk RECORD;
+BEGIN
+    IF (SELECT relkind FROM pg_class WHERE oid = parent::regclass) = 'p' THEN
+        RETURN;
+    END IF;
+
+    -- The partition key cannot be NULL
+    EXECUTE format('UPDATE %I SET created_at = CURRENT_TIMESTAMP WHERE created_at IS NULL', parent);
+    EXECUTE format('ALTER TABLE %I ALTER COLUMN created_at SET NOT NULL', parent);
+    EXECUTE format('SELECT date_trunc(''month'', COALESCE(max(created_at), LOCALTIMESTAMP)) + interval ''1 month'' FROM %I',
+                   parent) INTO bound;
+
+    seq := pg_get_serial_sequence(parent, 'id');
+    EXECUTE format('ALTER TABLE %I RENAME TO %I', parent, legacy);
+    EXECUTE format('CREATE TABLE %I (LIKE %I INCLUDING DEFAULTS INCLUDING CONSTRAINTS INCLUDING STORAGE) '
+                   'PARTITION BY RANGE (created_at)', parent, legacy);
+    EXECUTE format('ALTER TABLE %I ADD PRIMARY KEY (id, created_at)', parent);
+
+    -- Keep the id sequence alive when the legacy partition is archived
+    IF seq IS NOT NULL THEN
+        EXECUTE format('ALTER SEQUENCE %s OWNED BY %I.id', seq, parent);
+    END IF;
+
+    EXECUTE format('ALTER TABLE %I ATTACH PARTITION %I FOR VALUES FROM (MINVALUE) TO (%L)', parent, legacy, bound);
+
+    -- LIKE does not copy foreign keys; the legacy partition's keys are reused
+    FOR fk IN SELECT conname, pg_get_constraintdef(oid) AS def
+                FROM pg_constraint
+               WHERE conrelid = legacy::regclass AND contype = 'f' LOOP
+        EXECUTE format('ALTER TABLE %I ADD CONSTRAINT %I %s', parent, fk.conname, fk.def);
+    END LOOP;
+
+    EXECUTE format('CREATE TABLE %I PARTITION OF %I DEFAULT', parent || '_default', parent);
+END
+$fn$;
+
+SELECT chat_partition_by_month('messages');
+SELECT chat_partition_by_month('group_messages');
+
+-- Parent-level indexes; matching indexes already on the legacy partitions
+-- (from 001 and 004) are attached rather than rebuilt
+CREATE INDEX IF NOT EXISTS idx_group_messages_part_group_id_id
+    ON group_messages (group_id, id);
+CREATE INDEX IF NOT EXISTS idx_messages_part_undelivered
+    ON messages (receiver_id, sender_id, id)
+    WHERE is_delivered = FALSE;
+
+SELECT chat_create_month_partitions('messages', 3);
+SELECT chat_create_month_partitions('group_messages', 3);
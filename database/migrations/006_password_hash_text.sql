@@ -0,0 +1,9 @@
+-- ============================================================================
+-- 006: Room for salted password hashes
+-- ============================================================================
+-- Passwords are now stored as "scrypt$<logN>$<r>$<p>$<salt>$<key>" (about
+-- 115 characters) instead of a 64-character SHA-256 hex digest. Existing
+-- digests keep working and are rewritten on each user's next login.
+-- Widening to TEXT does not rewrite the table.
+
+ALTER TABLE users ALTER COLUMN password_hash TYPE TEXT;
@@ -0,0 +1,21 @@
+-- ============================================================================
+-- 007: Versioned friend lists
+-- ============================================================================
+-- One row per side of every accepted or removed friendship, written in the
+-- same statement as the friends change. The row id is the version: a user's
+-- friend list version is the largest id logged for them (0 if none), and
+-- FRIEND_LIST_SYNC answers a cached version with "unchanged" or with the
+-- rows past it. Friendships accepted before this migration have no rows;
+-- clients at version 0 receive the full list, so nothing is backfilled.
+
+CREATE TABLE IF NOT EXISTS friend_list_changes (
+    id BIGSERIAL PRIMARY KEY,
+    user_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    friend_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    added BOOLEAN NOT NULL,
+    changed_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP
+);
+
+-- Current version (MAX(id)) and the delta (id > version) for one user
+CREATE INDEX IF NOT EXISTS idx_friend_list_changes_user_id_id
+    ON friend_list_changes (user_id, id);
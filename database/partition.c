@@ -0,0 +1,329 @@
+#include "partition.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+static const char *partitioned_tables[] = { "messages", "group_messages" };
+#define PARTITIONED_TABLE_COUNT (sizeof(partitioned_tables) / sizeof(partitioned_tables[0]))
+
+// Partitions of $1 with their upper bound (NULL for the default partition)
+static const char *partition_bounds_sql =
+        "SELECT c.relname, "
+        "       (regexp_match(pg_get_expr(c.relpartbound, c.oid), 'TO \\(''([^'']+)''\\)'))[1]::timestamp AS upper_bound, "
+        "       pg_get_expr(c.relpartbound, c.oid) AS bound, "
+        "       c.reltuples::bigint AS est_rows, "
+        "       pg_size_pretty(pg_total_relation_size(c.oid)) AS size "
+        "FROM pg_inherits i JOIN pg_class c ON c.oid = i.inhrelid "
+        "WHERE i.inhparent = $1::regclass";
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @function run_command: Execute a statement and report failure.
+ *
+ * @param conn Database connection.
+ * @param sql Statement text.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int run_command(PGconn *conn, const char *sql) {
+    PGresult *res = PQexec(conn, sql);
+    ExecStatusType status = PQresultStatus(res);
+    int ok = status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK;
+    if (!ok) {
+        fprintf(stderr, "  %s", PQerrorMessage(conn));
+    }
+    PQclear(res);
+    return ok;
+}
+
+/**
+ * @function is_partitioned: Check that migration 005 has run for a table.
+ *
+ * @param conn Database connection.
+ * @param table Table name.
+ *
+ * @return 1 if the table is a partitioned parent, 0 otherwise.
+ */
+static int is_partitioned(PGconn *conn, const char *table) {
+    const char *params[1] = { table };
+    PGresult *res = PQexecParams(conn,
+            "SELECT 1 FROM pg_class WHERE oid = to_regclass($1) AND relkind = 'p'",
+            1, NULL, params, NULL, NULL, 0);
+    int partitioned = PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1;
+    PQclear(res);
+    if (!partitioned) {
+        fprintf(stderr, "%s is not partitioned; run 'make migrate' first\n", table);
+    }
+    return partitioned;
+}
+
+/**
+ * @function copy_to_gzip: Stream COPY ... TO STDOUT output into a gzip file.
+ *
+ * @param conn Database connection (inside a transaction).
+ * @param partition Quoted partition name.
+ * @param path Output file.
+ * @param rows_out Receives the number of rows written.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int copy_to_gzip(PGconn *conn, const char *partition, const char *path, long *rows_out) {
+    gzFile out = gzopen(path, "wb6");
+    if (!out) {
+        fprintf(stderr, "  cannot create %s: %s\n", path, strerror(errno));
+        return 0;
+    }
+
+    char sql[256];
+    snprintf(sql, sizeof(sql), "COPY (SELECT * FROM %s ORDER BY id) TO STDOUT WITH (FORMAT csv, HEADER)", partition);
+    PGresult *res = PQexec(conn, sql);
+    int ok = PQresultStatus(res) == PGRES_COPY_OUT;
+    if (!ok) fprintf(stderr, "  %s", PQerrorMessage(conn));
+    PQclear(res);
+
+    long lines = 0;
+    char *row;
+    int len;
+    while (ok && (len = PQgetCopyData(conn, &row, 0)) > 0) {
+        if (gzwrite(out, row, (unsigned)len) != len) ok = 0;
+        lines++;
+        PQfreemem(row);
+    }
+    if (ok && len == -2) {
+        fprintf(stderr, "  %s", PQerrorMessage(conn));
+        ok = 0;
+    }
+
+    // Drain the final command status even after a local write error
+    while ((res = PQgetResult(conn)) != NULL) {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) ok = 0;
+        PQclear(res);
+    }
+
+    if (gzclose(out) != Z_OK) ok = 0;
+    *rows_out = lines > 0 ? lines - 1 : 0;        // Header line
+    return ok;
+}
+
+/**
+ * @function archive_partition: Export, detach and drop one partition atomically.
+ *
+ * The partition is locked against writes while it is copied; it is only
+ * detached and dropped, in the same transaction, once the archive file is
+ * complete and renamed into place. Dropping group messages also recounts
+ * group_members.unread_count for the groups they belonged to. Any failure
+ * rolls back and leaves the partition attached.
+ *
+ * @param conn Database connection.
+ * @param parent Parent table name.
+ * @param partition Partition name.
+ * @param dir Archive directory.
+ *
+ * @return 1 if archived, 0 if skipped or failed.
+ */
+static int archive_partition(PGconn *conn, const char *parent, const char *partition, const char *dir) {
+    char *quoted = PQescapeIdentifier(conn, partition, strlen(partition));
+    char *quoted_parent = PQescapeIdentifier(conn, parent, strlen(parent));
+    if (!quoted || !quoted_parent) {
+        PQfreemem(quoted);
+        PQfreemem(quoted_parent);
+        return 0;
+    }
+
+    char path[512], tmp_path[520], sql[512];
+    snprintf(path, sizeof(path), "%s/%s.csv.gz", dir, partition);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    int ok = run_command(conn, "BEGIN");
+    snprintf(sql, sizeof(sql), "LOCK TABLE %s IN SHARE MODE", quoted);
+    ok = ok && run_command(conn, sql);
+
+    // Undelivered direct messages would vanish from their receivers' inboxes
+    if (ok && strcmp(parent, "messages") == 0) {
+        snprintf(sql, sizeof(sql), "SELECT 1 FROM %s WHERE is_delivered = FALSE LIMIT 1", quoted);
+        PGresult *res = PQexec(conn, sql);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) > 0) {
+            printf("  %-32s skipped: still holds undelivered messages\n", partition);
+            ok = 0;
+        }
+        PQclear(res);
+    }
+
+    long rows = 0;
+    ok = ok && copy_to_gzip(conn, quoted, tmp_path, &rows);
+    if (ok && rename(tmp_path, path) != 0) {
+        fprintf(stderr, "  cannot rename %s: %s\n", tmp_path, strerror(errno));
+        ok = 0;
+    }
+
+    snprintf(sql, sizeof(sql), "ALTER TABLE %s DETACH PARTITION %s", quoted_parent, quoted);
+    ok = ok && run_command(conn, sql);
+
+    // Unread counters of the affected groups must not count the dropped messages
+    if (ok && strcmp(parent, "group_messages") == 0) {
+        snprintf(sql, sizeof(sql),
+                "UPDATE group_members m SET unread_count = ("
+                "    SELECT COUNT(*) FROM group_messages g"
+                "    WHERE g.group_id = m.group_id"
+                "      AND g.id > m.last_read_message_id"
+                "      AND g.sender_id != m.user_id) "
+                "WHERE m.group_id IN (SELECT DISTINCT group_id FROM %s)",
+                quoted);
+        ok = run_command(conn, sql);
+    }
+
+    snprintf(sql, sizeof(sql), "DROP TABLE %s", quoted);
+    ok = ok && run_command(conn, sql);
+    ok = ok && run_command(conn, "COMMIT");
+
+    if (ok) {
+        printf("  %-32s %ld rows -> %s\n", partition, rows, path);
+    } else {
+        run_command(conn, "ROLLBACK");
+        unlink(tmp_path);
+    }
+
+    PQfreemem(quoted);
+    PQfreemem(quoted_parent);
+    return ok;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @function partition_list: Print the partitions of every partitioned table.
+ *
+ * @param conn Database connection.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int partition_list(PGconn *conn) {
+    if (!conn) return -1;
+
+    for (size_t t = 0; t < PARTITIONED_TABLE_COUNT; t++) {
+        const char *table = partitioned_tables[t];
+        if (!is_partitioned(conn, table)) return -1;
+
+        const char *params[1] = { table };
+        char sql[1024];
+        snprintf(sql, sizeof(sql), "%s ORDER BY upper_bound NULLS LAST", partition_bounds_sql);
+        PGresult *res = PQexecParams(conn, sql, 1, NULL, params, NULL, NULL, 0);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            fprintf(stderr, "Failed to list partitions of %s: %s", table, PQerrorMessage(conn));
+            PQclear(res);
+            return -1;
+        }
+
+        printf("\n=== %s ===\n", table);
+        printf("%-32s %-70s %12s %10s\n", "Partition", "Range", "Rows (est)", "Size");
+        for (int i = 0; i < PQntuples(res); i++) {
+            printf("%-32s %-70s %12s %10s\n", PQgetvalue(res, i, 0), PQgetvalue(res, i, 2),
+                   PQgetvalue(res, i, 3), PQgetvalue(res, i, 4));
+        }
+        PQclear(res);
+    }
+    return 0;
+}
+
+/**
+ * @function partition_create: Create future monthly partitions.
+ *
+ * Meant to run from cron (e.g. daily) so the upcoming months always exist
+ * before rows arrive; otherwise they land in the default partition.
+ *
+ * @param conn Database connection.
+ * @param months_ahead Months beyond the current one to cover.
+ *
+ * @return Number of partitions created, or -1 on failure.
+ */
+int partition_create(PGconn *conn, int months_ahead) {
+    if (!conn || months_ahead < 0) return -1;
+
+    int total = 0;
+    for (size_t t = 0; t < PARTITIONED_TABLE_COUNT; t++) {
+        const char *table = partitioned_tables[t];
+        if (!is_partitioned(conn, table)) return -1;
+
+        char months_str[16];
+        snprintf(months_str, sizeof(months_str), "%d", months_ahead);
+        const char *params[2] = { table, months_str };
+        PGresult *res = PQexecParams(conn, "SELECT chat_create_month_partitions($1, $2::int)",
+                                     2, NULL, params, NULL, NULL, 0);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            fprintf(stderr, "Failed to create partitions for %s: %s", table, PQerrorMessage(conn));
+            PQclear(res);
+            return -1;
+        }
+        int created = atoi(PQgetvalue(res, 0, 0));
+        PQclear(res);
+
+        printf("  %-16s %d partition(s) created\n", table, created);
+        total += created;
+    }
+    printf("✓ Partitions cover the next %d month(s)\n", months_ahead);
+    return total;
+}
+
+/**
+ * @function partition_archive: Archive and drop partitions that ended keep_months ago or earlier.
+ *
+ * @param conn Database connection.
+ * @param keep_months Whole months to keep before the current month.
+ * @param dir Archive directory (created if missing).
+ *
+ * @return Number of partitions archived, or -1 on failure.
+ */
+int partition_archive(PGconn *conn, int keep_months, const char *dir) {
+    if (!conn || keep_months < 0) return -1;
+    if (!dir) dir = PARTITION_ARCHIVE_DIR;
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create archive directory %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    int archived = 0;
+    int failed = 0;
+    for (size_t t = 0; t < PARTITIONED_TABLE_COUNT; t++) {
+        const char *table = partitioned_tables[t];
+        if (!is_partitioned(conn, table)) return -1;
+
+        char keep_str[16];
+        snprintf(keep_str, sizeof(keep_str), "%d", keep_months);
+        const char *params[2] = { table, keep_str };
+        char sql[1024];
+        snprintf(sql, sizeof(sql),
+                "SELECT relname FROM (%s) p "
+                "WHERE upper_bound <= date_trunc('month', LOCALTIMESTAMP) - make_interval(months => $2::int) "
+                "ORDER BY upper_bound",
+                partition_bounds_sql);
+        PGresult *res = PQexecParams(conn, sql, 2, NULL, params, NULL, NULL, 0);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            fprintf(stderr, "Failed to find old partitions of %s: %s", table, PQerrorMessage(conn));
+            PQclear(res);
+            return -1;
+        }
+
+        printf("=== %s: %d partition(s) older than %d month(s) ===\n", table, PQntuples(res), keep_months);
+        for (int i = 0; i < PQntuples(res); i++) {
+            if (archive_partition(conn, table, PQgetvalue(res, i, 0), dir)) {
+                archived++;
+            } else {
+                failed++;
+            }
+        }
+        PQclear(res);
+    }
+
+    printf("✓ Archived %d partition(s)%s\n", archived, failed ? " (some skipped, see above)" : "");
+    return archived;
+}
@@ -0,0 +1,21 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <libpq-fe.h>
+
+// Monthly partitions of messages and group_messages (set up by migration
+// 005). Partitions are named <table>_pYYYY_MM; <table>_legacy holds rows from
+// before partitioning and <table>_default catches anything outside a range.
+#define PARTITION_MONTHS_AHEAD 3
+#define PARTITION_ARCHIVE_DIR "archive"
+
+// Print every partition with its range, estimated rows and size
+int partition_list(PGconn *conn);
+
+// Create missing partitions from the current month to months_ahead months ahead
+int partition_create(PGconn *conn, int months_ahead);
+
+// Export partitions older than keep_months to <dir>/<partition>.csv.gz, then detach and drop them
+int partition_archive(PGconn *conn, int keep_months, const char *dir);
+
+#endif
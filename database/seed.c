@@ -0,0 +1,587 @@
+#include "seed.h"
+#include "database.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <openssl/sha.h>
+
+// Independent random streams, one per generated column family
+typedef enum {
+    STREAM_FRIEND = 1,
+    STREAM_GROUP,
+    STREAM_DIRECT,
+    STREAM_GROUP_MSG,
+    STREAM_CONTENT
+} SeedStream;
+
+typedef struct {
+    uint64_t seed;
+    int64_t users;
+    int64_t groups;
+    int64_t direct;
+    int64_t group_msgs;
+    time_t history_start;
+    char password_hash[SHA256_DIGEST_LENGTH * 2 + 1];
+    int64_t *group_size;                 // [groups], index 0 unused
+    int64_t *group_cumulative;           // Prefix sums of group_size for size-weighted picks
+    int64_t member_rows;
+} Dataset;
+
+typedef struct {
+    PGconn *conn;
+    char buf[SEED_COPY_CHUNK];
+    size_t len;
+    int ok;
+} CopyWriter;
+
+typedef void (*ShardFn)(const Dataset *d, int64_t begin, int64_t end, CopyWriter *w);
+
+static const char *words[] = {
+    "hello", "meeting", "tomorrow", "lunch", "project", "deadline", "review", "coffee",
+    "weekend", "game", "update", "thanks", "see", "you", "later", "today",
+    "network", "server", "client", "socket", "message", "group", "friend", "online",
+    "offline", "pizza", "movie", "music", "photo", "video", "call", "ok",
+    "sure", "maybe", "great", "busy", "free", "now", "soon", "again",
+    "the", "a", "is", "at", "on", "for", "with", "and",
+    "lol", "yes", "no", "why", "how", "when", "where", "what",
+    "exam", "homework", "library", "train", "bus", "home", "office", "night",
+};
+#define WORD_COUNT (sizeof(words) / sizeof(words[0]))
+
+// ============================================================================
+// Deterministic Randomness
+// ============================================================================
+
+/**
+ * @function mix64: splitmix64 finalizer.
+ */
+static uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @function rand64: Random value for (stream, row, k) under the dataset seed.
+ *
+ * @param d Dataset.
+ * @param stream Column family.
+ * @param row Row or entity index.
+ * @param k Draw number within the row.
+ *
+ * @return Uniform 64-bit value.
+ */
+static uint64_t rand64(const Dataset *d, SeedStream stream, int64_t row, uint64_t k) {
+    return mix64(d->seed ^ mix64(((uint64_t)stream << 56) ^ mix64((uint64_t)row) ^ (k * 0xd6e8feb86659fd93ULL)));
+}
+
+/**
+ * @function unit: Uniform double in [0, 1).
+ */
+static double unit(const Dataset *d, SeedStream stream, int64_t row, uint64_t k) {
+    return (double)(rand64(d, stream, row, k) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @function pareto: Power-law integer in [min, max].
+ *
+ * @param u Uniform draw in [0, 1).
+ * @param min Smallest value.
+ * @param max Largest value.
+ * @param alpha Tail exponent (smaller = heavier tail).
+ *
+ * @return Sampled value.
+ */
+static int64_t pareto(double u, int64_t min, int64_t max, double alpha) {
+    double value = (double)min / pow(1.0 - u, 1.0 / alpha);
+    return value >= (double)max ? max : (int64_t)value;
+}
+
+// ============================================================================
+// Entity Generators
+// ============================================================================
+
+/**
+ * @function compare_ids: qsort comparator for user ids.
+ */
+static int compare_ids(const void *a, const void *b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @function friend_targets: Users that user u sent friend requests to.
+ *
+ * Each user links only to lower ids, so no pair is generated twice, and
+ * picks are skewed towards old (low) ids, which become hubs: the degree
+ * distribution is heavy-tailed like a preferential-attachment graph.
+ *
+ * @param d Dataset.
+ * @param u User id (1-based).
+ * @param out Output array of SEED_FRIENDS_MAX ids, sorted and unique.
+ *
+ * @return Number of targets.
+ */
+static int friend_targets(const Dataset *d, int64_t u, int64_t *out) {
+    if (u < 2) return 0;
+    int64_t degree = pareto(unit(d, STREAM_FRIEND, u, 0), SEED_FRIENDS_MIN, SEED_FRIENDS_MAX, 1.1);
+    if (degree > u - 1) degree = u - 1;
+
+    for (int64_t k = 0; k < degree; k++) {
+        double x = unit(d, STREAM_FRIEND, u, (uint64_t)k + 1);
+        out[k] = 1 + (int64_t)((double)(u - 1) * x * x);
+    }
+    qsort(out, (size_t)degree, sizeof(int64_t), compare_ids);
+
+    int count = 0;
+    for (int64_t k = 0; k < degree; k++) {
+        if (count == 0 || out[count - 1] != out[k]) out[count++] = out[k];
+    }
+    return count;
+}
+
+/**
+ * @function friend_pending: Whether the request u -> v is still pending (about 10%).
+ */
+static int friend_pending(const Dataset *d, int64_t u, int64_t v) {
+    return unit(d, STREAM_FRIEND, u, 0x100000000ULL + (uint64_t)v) < 0.10;
+}
+
+/**
+ * @function group_member: The i-th member of group g.
+ *
+ * Members are start + i * stride (mod users) with a prime stride that does
+ * not divide the user count, so the first size entries are distinct.
+ *
+ * @param d Dataset.
+ * @param g Group id (1-based).
+ * @param i Member index; 0 is the owner.
+ *
+ * @return User id.
+ */
+static int64_t group_member(const Dataset *d, int64_t g, int64_t i) {
+    static const int64_t strides[] = { 7919, 104729, 1299709, 15485863, 179424673 };
+    int64_t stride = 1;
+    size_t first = (size_t)(rand64(d, STREAM_GROUP, g, 1) % 5);
+    for (size_t k = 0; k < 5; k++) {
+        int64_t prime = strides[(first + k) % 5];
+        if (d->users % prime != 0) {
+            stride = prime % d->users;
+            break;
+        }
+    }
+    uint64_t start = rand64(d, STREAM_GROUP, g, 2) % (uint64_t)d->users;
+    return 1 + (int64_t)(((uint64_t)stride * (uint64_t)i + start) % (uint64_t)d->users);
+}
+
+/**
+ * @function format_time: "YYYY-MM-DD HH:MM:SS" for an epoch second.
+ */
+static void format_time(time_t t, char *out, size_t size) {
+    struct tm tm_info;
+    gmtime_r(&t, &tm_info);
+    strftime(out, size, "%Y-%m-%d %H:%M:%S", &tm_info);
+}
+
+/**
+ * @function message_time: Creation time of row i of n, increasing with i.
+ */
+static time_t message_time(const Dataset *d, int64_t i, int64_t n) {
+    return d->history_start + (time_t)((double)i / (double)n * SEED_HISTORY_DAYS * 86400.0);
+}
+
+/**
+ * @function message_content: Random chat text of 3-32 words.
+ *
+ * @return Length written.
+ */
+static int message_content(const Dataset *d, SeedStream stream, int64_t row, char *out, size_t size) {
+    int count = 3 + (int)(rand64(d, STREAM_CONTENT, row, stream) % 30);
+    size_t len = 0;
+    for (int w = 0; w < count; w++) {
+        const char *word = words[rand64(d, stream, row, 100 + (uint64_t)w) % WORD_COUNT];
+        int n = snprintf(out + len, size - len, w ? " %s" : "%s", word);
+        if (n < 0 || (size_t)n >= size - len) break;
+        len += (size_t)n;
+    }
+    return (int)len;
+}
+
+// ============================================================================
+// COPY Writer
+// ============================================================================
+
+/**
+ * @function copy_flush: Send buffered rows to the server.
+ */
+static void copy_flush(CopyWriter *w) {
+    if (w->ok && w->len > 0 && PQputCopyData(w->conn, w->buf, (int)w->len) != 1) {
+        fprintf(stderr, "  COPY failed: %s", PQerrorMessage(w->conn));
+        w->ok = 0;
+    }
+    w->len = 0;
+}
+
+/**
+ * @function copy_row: Append one tab-separated row (COPY text format).
+ */
+static void copy_row(CopyWriter *w, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void copy_row(CopyWriter *w, const char *format, ...) {
+    char line[1024];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= sizeof(line)) return;
+
+    if (w->len + (size_t)n > sizeof(w->buf)) copy_flush(w);
+    memcpy(w->buf + w->len, line, (size_t)n);
+    w->len += (size_t)n;
+}
+
+// ============================================================================
+// Table Shards
+// ============================================================================
+
+static void shard_users(const Dataset *d, int64_t begin, int64_t end, CopyWriter *w) {
+    char created[32];
+    for (int64_t u = begin + 1; u <= end && w->ok; u++) {
+        format_time(d->history_start - (time_t)(d->users - u) * 60, created, sizeof(created));
+        copy_row(w, "%lld\tseed_u%07lld\t%s\t%s\tf\n",
+                 (long long)u, (long long)u, d->password_hash, created);
+    }
+}
+
+static void shard_friends(const Dataset *d, int64_t begin, int64_t end, CopyWriter *w) {
+    int64_t targets[SEED_FRIENDS_MAX];
+    char created[32];
+    for (int64_t u = begin + 1; u <= end && w->ok; u++) {
+        int count = friend_targets(d, u, targets);
+        format_time(d->history_start + (time_t)(u % 86400), created, sizeof(created));
+        for (int k = 0; k < count; k++) {
+            copy_row(w, "%lld\t%lld\t%s\t%s\n", (long long)u, (long long)targets[k],
+                     friend_pending(d, u, targets[k]) ? "pending" : "accepted", created);
+        }
+    }
+}
+
+static void shard_groups(const Dataset *d, int64_t begin, int64_t end, CopyWriter *w) {
+    char created[32];
+    for (int64_t g = begin + 1; g <= end && w->ok; g++) {
+        format_time(d->history_start - (time_t)(d->groups - g) * 3600, created, sizeof(created));
+        copy_row(w, "%lld\tseed_group_%06lld\t%lld\t%s\n",
+                 (long long)g, (long long)g, (long long)group_member(d, g, 0), created);
+    }
+}
+
+static void shard_members(const Dataset *d, int64_t begin, int64_t end, CopyWriter *w) {
+    for (int64_t g = begin + 1; g <= end && w->ok; g++) {
+        for (int64_t i = 0; i < d->group_size[g]; i++) {
+            copy_row(w, "%lld\t%lld\t%s\n", (long long)g, (long long)group_member(d, g, i),
+                     i == 0 ? "owner" : "member");
+        }
+    }
+}
+
+static void shard_direct(const Dataset *d, int64_t begin, int64_t end, CopyWriter *w) {
+    int64_t targets[SEED_FRIENDS_MAX];
+    char created[32], content[512];
+    for (int64_t i = begin; i < end && w->ok; i++) {
+        // A user with at least one friend request, and one of those friends
+        int64_t sender, receiver = 0;
+        int count = 0;
+        for (uint64_t attempt = 0; count == 0; attempt++) {
+            sender = 2 + (int64_t)(rand64(d, STREAM_DIRECT, i, attempt) % (uint64_t)(d->users - 1));
+            count = friend_targets(d, sender, targets);
+        }
+        int pick = (int)(rand64(d, STREAM_DIRECT, i, 1000) % (uint64_t)count);
+        for (int k = 0; k < count; k++) {
+            int64_t candidate = targets[(pick + k) % count];
+            if (!friend_pending(d, sender, candidate) || k == count - 1) {
+                receiver = candidate;
+                break;
+            }
+        }
+        if (rand64(d, STREAM_DIRECT, i, 1001) & 1) {
+            int64_t tmp = sender;
+            sender = receiver;
+            receiver = tmp;
+        }
+
+        // The newest 2% of history is half undelivered: a realistic offline backlog
+        int delivered = i < d->direct - d->direct / 50 || unit(d, STREAM_DIRECT, i, 1002) < 0.5;
+        format_time(message_time(d, i, d->direct), created, sizeof(created));
+        message_content(d, STREAM_DIRECT, i, content, sizeof(content));
+        copy_row(w, "%lld\t%lld\t%lld\t%s\t%s\t%s\n", (long long)(i + 1), (long long)sender,
+                 (long long)receiver, content, delivered ? "t" : "f", created);
+    }
+}
+
+static void shard_group_messages(const Dataset *d, int64_t begin, int64_t end, CopyWriter *w) {
+    char created[32], content[512];
+    int64_t total_members = d->group_cumulative[d->groups];
+    for (int64_t i = begin; i < end && w->ok; i++) {
+        // Larger groups talk proportionally more
+        int64_t target = (int64_t)(rand64(d, STREAM_GROUP_MSG, i, 0) % (uint64_t)total_members);
+        int64_t lo = 1, hi = d->groups;
+        while (lo < hi) {
+            int64_t mid = lo + (hi - lo) / 2;
+            if (d->group_cumulative[mid] > target) hi = mid; else lo = mid + 1;
+        }
+        int64_t g = lo;
+        int64_t sender = group_member(d, g, (int64_t)(rand64(d, STREAM_GROUP_MSG, i, 1) % (uint64_t)d->group_size[g]));
+
+        format_time(message_time(d, i, d->group_msgs), created, sizeof(created));
+        message_content(d, STREAM_GROUP_MSG, i, content, sizeof(content));
+        copy_row(w, "%lld\t%lld\t%lld\t%s\t%s\n", (long long)(i + 1), (long long)g,
+                 (long long)sender, content, created);
+    }
+}
+
+// ============================================================================
+// Parallel Loader
+// ============================================================================
+
+/**
+ * @function load_shard: Child process body: COPY one row range over a fresh connection.
+ *
+ * @return Process exit status.
+ */
+static int load_shard(const Dataset *d, const char *copy_sql, ShardFn fn, int64_t begin, int64_t end) {
+    PGconn *conn = connect_to_database();
+    if (!conn) return 1;
+
+    PGresult *res = PQexec(conn, "SET synchronous_commit = off");
+    PQclear(res);
+
+    res = PQexec(conn, copy_sql);
+    int ok = PQresultStatus(res) == PGRES_COPY_IN;
+    if (!ok) fprintf(stderr, "  %s", PQerrorMessage(conn));
+    PQclear(res);
+
+    static CopyWriter writer;
+    writer.conn = conn;
+    writer.len = 0;
+    writer.ok = ok;
+    if (ok) {
+        fn(d, begin, end, &writer);
+        copy_flush(&writer);
+        ok = writer.ok;
+        if (PQputCopyEnd(conn, ok ? NULL : "generator failed") != 1) ok = 0;
+        while ((res = PQgetResult(conn)) != NULL) {
+            if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+                fprintf(stderr, "  %s", PQerrorMessage(conn));
+                ok = 0;
+            }
+            PQclear(res);
+        }
+    }
+
+    disconnect_database(conn);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @function load_table: Load one table with `jobs` parallel COPY connections.
+ *
+ * @param d Dataset.
+ * @param jobs Number of loader processes.
+ * @param label Table name for progress output.
+ * @param copy_sql COPY ... FROM STDIN statement.
+ * @param fn Shard generator.
+ * @param entities Number of entities (rows, users or groups) split across jobs.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int load_table(const Dataset *d, int jobs, const char *label, const char *copy_sql,
+                      ShardFn fn, int64_t entities) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    printf("  %-16s ", label);
+    fflush(stdout);
+    fflush(stderr);
+
+    if (jobs > entities) jobs = entities > 0 ? (int)entities : 1;
+    pid_t pids[64];
+    int started = 0;
+    for (int j = 0; j < jobs; j++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            _exit(load_shard(d, copy_sql, fn, entities * j / jobs, entities * (j + 1) / jobs));
+        }
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        pids[started++] = pid;
+    }
+
+    int ok = started == jobs;
+    for (int j = 0; j < started; j++) {
+        int status;
+        if (waitpid(pids[j], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%s in %.1fs (%d job%s)\n", ok ? "loaded" : "FAILED", seconds, jobs, jobs == 1 ? "" : "s");
+    return ok;
+}
+
+/**
+ * @function run_sql: Execute a statement on the coordinating connection.
+ */
+static int run_sql(PGconn *conn, const char *sql) {
+    PGresult *res = PQexec(conn, sql);
+    ExecStatusType status = PQresultStatus(res);
+    int ok = status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK;
+    if (!ok) fprintf(stderr, "  %s", PQerrorMessage(conn));
+    PQclear(res);
+    return ok;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @function seed_database: Generate and bulk-load the benchmark dataset.
+ *
+ * Tables are loaded in foreign-key order (users; friends and groups; group
+ * members; direct and group messages), each with config->jobs parallel COPY
+ * connections. Ids are assigned explicitly so they are reproducible and
+ * increase with created_at; sequences are advanced afterwards. Finally the
+ * denormalized unread counters (migration 002) are rebuilt: every tenth user
+ * has never opened their groups, the rest are caught up.
+ *
+ * @param conn Coordinating database connection.
+ * @param config Scale, seed and parallelism.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int seed_database(PGconn *conn, const SeedConfig *config) {
+    if (!conn || !config || config->scale < 1 || config->jobs < 1 || config->jobs > 64) {
+        fprintf(stderr, "seed: scale must be >= 1 and jobs in 1..64\n");
+        return -1;
+    }
+
+    static const char *tables[] = { "users", "friends", "groups", "group_members", "messages", "group_messages" };
+    for (size_t t = 0; t < sizeof(tables) / sizeof(tables[0]); t++) {
+        char sql[128];
+        snprintf(sql, sizeof(sql), "SELECT 1 FROM %s LIMIT 1", tables[t]);
+        PGresult *res = PQexec(conn, sql);
+        int empty = PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 0;
+        PQclear(res);
+        if (!empty) {
+            fprintf(stderr, "seed: table %s is not empty (or missing); reset the database first\n", tables[t]);
+            return -1;
+        }
+    }
+
+    Dataset d;
+    memset(&d, 0, sizeof(d));
+    d.seed = config->seed;
+    d.users = (int64_t)config->scale * SEED_USERS_PER_SCALE;
+    d.groups = (int64_t)config->scale * SEED_GROUPS_PER_SCALE;
+    d.direct = (int64_t)config->scale * SEED_DIRECT_PER_SCALE;
+    d.group_msgs = (int64_t)config->scale * SEED_GROUP_MSGS_PER_SCALE;
+    // Fixed origin (2025-01-01 UTC) so timestamps do not depend on when the seed runs
+    d.history_start = (time_t)1735689600;
+
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256((const unsigned char*)SEED_PASSWORD, strlen(SEED_PASSWORD), digest);
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+        sprintf(d.password_hash + i * 2, "%02x", digest[i]);
+    }
+
+    d.group_size = (int64_t*)calloc((size_t)d.groups + 1, sizeof(int64_t));
+    d.group_cumulative = (int64_t*)calloc((size_t)d.groups + 1, sizeof(int64_t));
+    if (!d.group_size || !d.group_cumulative) {
+        free(d.group_size);
+        free(d.group_cumulative);
+        return -1;
+    }
+    int64_t max_size = d.users < SEED_GROUP_MAX ? d.users : SEED_GROUP_MAX;
+    for (int64_t g = 1; g <= d.groups; g++) {
+        d.group_size[g] = pareto(unit(&d, STREAM_GROUP, g, 0), SEED_GROUP_MIN, max_size, 0.9);
+        d.group_cumulative[g] = d.group_cumulative[g - 1] + d.group_size[g];
+    }
+    d.member_rows = d.group_cumulative[d.groups];
+
+    printf("Seeding scale=%d seed=%llu jobs=%d: %lld users, %lld groups (%lld memberships), "
+           "%lld direct + %lld group messages\n",
+           config->scale, (unsigned long long)config->seed, config->jobs, (long long)d.users,
+           (long long)d.groups, (long long)d.member_rows, (long long)d.direct, (long long)d.group_msgs);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int ok =
+        load_table(&d, config->jobs, "users",
+                   "COPY users (id, username, password_hash, created_at, is_online) FROM STDIN",
+                   shard_users, d.users) &&
+        load_table(&d, config->jobs, "friends",
+                   "COPY friends (user_id, friend_id, status, created_at) FROM STDIN",
+                   shard_friends, d.users) &&
+        load_table(&d, config->jobs, "groups",
+                   "COPY groups (id, group_name, creator_id, created_at) FROM STDIN",
+                   shard_groups, d.groups) &&
+        load_table(&d, config->jobs, "group_members",
+                   "COPY group_members (group_id, user_id, role) FROM STDIN",
+                   shard_members, d.groups) &&
+        load_table(&d, config->jobs, "messages",
+                   "COPY messages (id, sender_id, receiver_id, content, is_delivered, created_at) FROM STDIN",
+                   shard_direct, d.direct) &&
+        load_table(&d, config->jobs, "group_messages",
+                   "COPY group_messages (id, group_id, sender_id, content, created_at) FROM STDIN",
+                   shard_group_messages, d.group_msgs);
+
+    if (ok) {
+        printf("  %-16s ", "counters");
+        fflush(stdout);
+        ok = run_sql(conn,
+                "SELECT setval(pg_get_serial_sequence('users', 'id'), (SELECT MAX(id) FROM users)), "
+                "       setval(pg_get_serial_sequence('groups', 'id'), (SELECT MAX(id) FROM groups)), "
+                "       setval(pg_get_serial_sequence('messages', 'id'), (SELECT MAX(id) FROM messages)), "
+                "       setval(pg_get_serial_sequence('group_messages', 'id'), (SELECT MAX(id) FROM group_messages))") &&
+             run_sql(conn,
+                "INSERT INTO direct_unread_counts (user_id, sender_id, unread_count) "
+                "SELECT receiver_id, sender_id, COUNT(*) FROM messages "
+                "WHERE is_delivered = FALSE GROUP BY receiver_id, sender_id "
+                "ON CONFLICT (user_id, sender_id) DO UPDATE SET unread_count = EXCLUDED.unread_count") &&
+             run_sql(conn,
+                "WITH per_group AS ("
+                "    SELECT group_id, MAX(id) AS max_id, COUNT(*) AS total FROM group_messages GROUP BY group_id"
+                "), per_sender AS ("
+                "    SELECT group_id, sender_id, COUNT(*) AS sent FROM group_messages GROUP BY group_id, sender_id"
+                "), cursors AS ("
+                "    SELECT m.group_id, m.user_id, g.max_id, g.total - COALESCE(s.sent, 0) AS unread"
+                "    FROM group_members m JOIN per_group g ON g.group_id = m.group_id"
+                "    LEFT JOIN per_sender s ON s.group_id = m.group_id AND s.sender_id = m.user_id"
+                ") "
+                "UPDATE group_members m SET "
+                "    last_read_message_id = CASE WHEN m.user_id % 10 = 0 THEN 0 ELSE c.max_id END, "
+                "    unread_count = CASE WHEN m.user_id % 10 = 0 THEN c.unread ELSE 0 END "
+                "FROM cursors c WHERE c.group_id = m.group_id AND c.user_id = m.user_id") &&
+             run_sql(conn, "ANALYZE");
+        printf("%s\n", ok ? "rebuilt" : "FAILED");
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(d.group_size);
+    free(d.group_cumulative);
+
+    if (!ok) {
+        fprintf(stderr, "seed: failed; reset the database before retrying\n");
+        return -1;
+    }
+    printf("✓ Seeded in %.1fs (password for every user: %s)\n",
+           (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9, SEED_PASSWORD);
+    return 0;
+}
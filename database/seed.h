@@ -0,0 +1,36 @@
+#ifndef SEED_H
+#define SEED_H
+
+#include <libpq-fe.h>
+#include <stdint.h>
+
+// Synthetic benchmark dataset. Every value is a pure function of
+// (seed, table, row), so the same seed and scale produce the same rows no
+// matter how many parallel loaders are used. Per unit of scale:
+#define SEED_USERS_PER_SCALE 10000
+#define SEED_GROUPS_PER_SCALE 100
+#define SEED_DIRECT_PER_SCALE 100000
+#define SEED_GROUP_MSGS_PER_SCALE 100000
+
+#define SEED_GROUP_MIN 3                 // Group sizes follow a power law in [3, 5000]
+#define SEED_GROUP_MAX 5000
+#define SEED_FRIENDS_MIN 2               // Friend requests sent per user, power law
+#define SEED_FRIENDS_MAX 1000
+#define SEED_HISTORY_DAYS 180            // Messages spread over this many days
+#define SEED_PASSWORD "password123"      // Password of every generated user
+#define SEED_COPY_CHUNK 65536            // Bytes buffered per PQputCopyData call
+
+#define SEED_DEFAULT_SCALE 1
+#define SEED_DEFAULT_SEED 42
+#define SEED_DEFAULT_JOBS 4
+
+typedef struct {
+    int scale;
+    uint64_t seed;
+    int jobs;                            // Parallel COPY connections per table
+} SeedConfig;
+
+// Bulk-load the dataset into empty chat tables
+int seed_database(PGconn *conn, const SeedConfig *config);
+
+#endif
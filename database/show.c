@@ -0,0 +1,394 @@
+#include "show.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SHOW_MAX_PARAMS 5
+#define SHOW_COLUMN_WIDTH 12             // Minimum column width in table format
+#define SHOW_CELL_MAX 48                 // Longer values are truncated in table format
+
+// Builtin type OIDs (pg_type.h is server-side only)
+#define BOOLOID 16
+#define INT8OID 20
+#define INT2OID 21
+#define INT4OID 23
+
+// How each filter applies to a table. Predicates reference $1; NULL means
+// the filter is not supported for that table.
+typedef struct {
+    const char *name;
+    const char *select;
+    const char *user_predicate;
+    const char *group_predicate;
+    const char *time_column;
+    const char *order_by;
+} ShowSource;
+
+static const ShowSource sources[] = {
+    {
+        "users",
+        "SELECT u.id, u.username, u.is_online, u.created_at FROM users u",
+        "u.username = $1",
+        "u.id IN (SELECT user_id FROM group_members WHERE group_id = $1::int)",
+        "u.created_at",
+        "u.id"
+    },
+    {
+        "friends",
+        "SELECT f.id, f.user_id, u1.username AS user_name, f.friend_id, u2.username AS friend_name, "
+        "f.status, f.created_at "
+        "FROM friends f JOIN users u1 ON u1.id = f.user_id JOIN users u2 ON u2.id = f.friend_id",
+        "(u1.username = $1 OR u2.username = $1)",
+        NULL,
+        "f.created_at",
+        "f.id"
+    },
+    {
+        "groups",
+        "SELECT g.id, g.group_name, g.creator_id, u.username AS creator, g.created_at "
+        "FROM groups g LEFT JOIN users u ON u.id = g.creator_id",
+        "g.id IN (SELECT m.group_id FROM group_members m JOIN users mu ON mu.id = m.user_id WHERE mu.username = $1)",
+        "g.id = $1::int",
+        "g.created_at",
+        "g.id"
+    },
+    {
+        "group-members",
+        "SELECT m.group_id, g.group_name, m.user_id, u.username, m.role, m.last_read_message_id, m.unread_count "
+        "FROM group_members m JOIN groups g ON g.id = m.group_id JOIN users u ON u.id = m.user_id",
+        "u.username = $1",
+        "m.group_id = $1::int",
+        NULL,
+        "m.group_id, m.user_id"
+    },
+    {
+        "messages",
+        "SELECT m.id, m.sender_id, s.username AS sender, m.receiver_id, r.username AS receiver, "
+        "m.content, m.is_delivered, m.created_at "
+        "FROM messages m JOIN users s ON s.id = m.sender_id LEFT JOIN users r ON r.id = m.receiver_id",
+        // Resolve the id first so the sender/receiver indexes are usable
+        "(m.sender_id = (SELECT id FROM users WHERE username = $1) "
+        "OR m.receiver_id = (SELECT id FROM users WHERE username = $1))",
+        NULL,
+        "m.created_at",
+        "m.id"
+    },
+    {
+        "group-messages",
+        "SELECT gm.id, gm.group_id, gm.sender_id, u.username AS sender, gm.content, gm.created_at "
+        "FROM group_messages gm JOIN users u ON u.id = gm.sender_id",
+        "gm.sender_id = (SELECT id FROM users WHERE username = $1)",
+        "gm.group_id = $1::int",
+        "gm.created_at",
+        "gm.id"
+    },
+};
+#define SOURCE_COUNT (sizeof(sources) / sizeof(sources[0]))
+
+// ============================================================================
+// Query Building
+// ============================================================================
+
+/**
+ * @function append_predicate: Add "WHERE/AND <predicate>" with $1 renumbered to the next parameter.
+ *
+ * @param sql Query buffer.
+ * @param size Buffer size.
+ * @param predicate Predicate text referencing $1.
+ * @param param Parameter number to substitute.
+ * @param first Whether this is the first predicate.
+ */
+static void append_predicate(char *sql, size_t size, const char *predicate, int param, int first) {
+    size_t len = strlen(sql);
+    len += (size_t)snprintf(sql + len, size - len, first ? " WHERE " : " AND ");
+    for (const char *p = predicate; *p && len + 4 < size; p++) {
+        if (p[0] == '$' && p[1] == '1') {
+            len += (size_t)snprintf(sql + len, size - len, "$%d", param);
+            p++;
+        } else {
+            sql[len++] = *p;
+            sql[len] = '\0';
+        }
+    }
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+/**
+ * @function write_csv_field: Write one CSV field, quoted when needed.
+ */
+static void write_csv_field(const char *value, int is_null) {
+    if (is_null) return;
+    if (strpbrk(value, ",\"\r\n") == NULL) {
+        fputs(value, stdout);
+        return;
+    }
+    putchar('"');
+    for (const char *p = value; *p; p++) {
+        if (*p == '"') putchar('"');
+        putchar(*p);
+    }
+    putchar('"');
+}
+
+/**
+ * @function write_json_string: Write a JSON string literal.
+ */
+static void write_json_string(const char *value) {
+    putchar('"');
+    for (const unsigned char *p = (const unsigned char*)value; *p; p++) {
+        switch (*p) {
+            case '"':  fputs("\\\"", stdout); break;
+            case '\\': fputs("\\\\", stdout); break;
+            case '\n': fputs("\\n", stdout); break;
+            case '\r': fputs("\\r", stdout); break;
+            case '\t': fputs("\\t", stdout); break;
+            default:
+                if (*p < 0x20) printf("\\u%04x", *p);
+                else putchar(*p);
+        }
+    }
+    putchar('"');
+}
+
+/**
+ * @function column_width: Display width of a column in table format.
+ */
+static int column_width(const PGresult *res, int column) {
+    int width = (int)strlen(PQfname(res, column));
+    return width < SHOW_COLUMN_WIDTH ? SHOW_COLUMN_WIDTH : width;
+}
+
+/**
+ * @function write_header: Column names (table and CSV formats).
+ */
+static void write_header(const PGresult *res, ShowFormat format) {
+    int columns = PQnfields(res);
+    if (format == SHOW_FORMAT_JSONL) return;
+
+    for (int c = 0; c < columns; c++) {
+        if (format == SHOW_FORMAT_CSV) {
+            if (c) putchar(',');
+            write_csv_field(PQfname(res, c), 0);
+        } else {
+            printf("%s%-*s", c ? " | " : "", column_width(res, c), PQfname(res, c));
+        }
+    }
+    putchar('\n');
+
+    if (format == SHOW_FORMAT_TABLE) {
+        for (int c = 0; c < columns; c++) {
+            if (c) fputs("-+-", stdout);
+            for (int i = 0; i < column_width(res, c); i++) putchar('-');
+        }
+        putchar('\n');
+    }
+}
+
+/**
+ * @function write_row: Write the single row held by a PGRES_SINGLE_TUPLE result.
+ */
+static void write_row(const PGresult *res, ShowFormat format) {
+    int columns = PQnfields(res);
+
+    if (format == SHOW_FORMAT_JSONL) putchar('{');
+    for (int c = 0; c < columns; c++) {
+        const char *value = PQgetvalue(res, 0, c);
+        int is_null = PQgetisnull(res, 0, c);
+
+        if (format == SHOW_FORMAT_CSV) {
+            if (c) putchar(',');
+            write_csv_field(value, is_null);
+        } else if (format == SHOW_FORMAT_JSONL) {
+            if (c) putchar(',');
+            write_json_string(PQfname(res, c));
+            putchar(':');
+            Oid type = PQftype(res, c);
+            if (is_null) {
+                fputs("null", stdout);
+            } else if (type == BOOLOID) {
+                fputs(value[0] == 't' ? "true" : "false", stdout);
+            } else if (type == INT2OID || type == INT4OID || type == INT8OID) {
+                fputs(value, stdout);
+            } else {
+                write_json_string(value);
+            }
+        } else {
+            int width = column_width(res, c);
+            int len = (int)strlen(value);
+            if (len > SHOW_CELL_MAX) {
+                printf("%s%.*s...", c ? " | " : "", SHOW_CELL_MAX - 3, value);
+            } else {
+                printf("%s%-*s", c ? " | " : "", width, is_null ? "NULL" : value);
+            }
+        }
+    }
+    if (format == SHOW_FORMAT_JSONL) putchar('}');
+    putchar('\n');
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @function show_parse_args: Parse show-* options.
+ *
+ * Accepts "--name value" and "--name=value".
+ *
+ * @param argc Argument count (options only).
+ * @param argv Arguments.
+ * @param filter Output filter, cleared first.
+ *
+ * @return 0 on success, -1 on an unknown option or missing value.
+ */
+int show_parse_args(int argc, char **argv, ShowFilter *filter) {
+    memset(filter, 0, sizeof(*filter));
+
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = NULL;
+        char name[32];
+
+        if (strncmp(arg, "--", 2) != 0) {
+            fprintf(stderr, "Unexpected argument: %s\n", arg);
+            return -1;
+        }
+        const char *eq = strchr(arg, '=');
+        size_t name_len = eq ? (size_t)(eq - arg - 2) : strlen(arg + 2);
+        if (name_len >= sizeof(name)) name_len = sizeof(name) - 1;
+        memcpy(name, arg + 2, name_len);
+        name[name_len] = '\0';
+
+        if (eq) {
+            value = eq + 1;
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            fprintf(stderr, "Missing value for --%s\n", name);
+            return -1;
+        }
+
+        if (strcmp(name, "user") == 0) filter->user = value;
+        else if (strcmp(name, "group") == 0) filter->group = value;
+        else if (strcmp(name, "since") == 0) filter->since = value;
+        else if (strcmp(name, "until") == 0) filter->until = value;
+        else if (strcmp(name, "limit") == 0) filter->limit = value;
+        else if (strcmp(name, "format") == 0) {
+            if (strcmp(value, "table") == 0) filter->format = SHOW_FORMAT_TABLE;
+            else if (strcmp(value, "csv") == 0) filter->format = SHOW_FORMAT_CSV;
+            else if (strcmp(value, "jsonl") == 0) filter->format = SHOW_FORMAT_JSONL;
+            else {
+                fprintf(stderr, "Unknown format: %s (table, csv, jsonl)\n", value);
+                return -1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: --%s\n", name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @function show_table: Stream a table to stdout.
+ *
+ * Filters become bind parameters, never SQL text. Rows arrive one at a time
+ * in single-row mode, so the client holds at most one row regardless of the
+ * table size. The row count goes to stderr for csv/jsonl so stdout stays
+ * machine-readable.
+ *
+ * @param conn Database connection.
+ * @param table Table name as used by the show-* commands.
+ * @param filter Filters and output format.
+ *
+ * @return Number of rows written, or -1 on failure.
+ */
+long show_table(PGconn *conn, const char *table, const ShowFilter *filter) {
+    const ShowSource *source = NULL;
+    for (size_t i = 0; i < SOURCE_COUNT; i++) {
+        if (strcmp(sources[i].name, table) == 0) source = &sources[i];
+    }
+    if (!source) {
+        fprintf(stderr, "Unknown table: %s\n", table);
+        return -1;
+    }
+    if (!conn) return -1;
+
+    if ((filter->user && !source->user_predicate) || (filter->group && !source->group_predicate) ||
+        ((filter->since || filter->until) && !source->time_column)) {
+        fprintf(stderr, "show-%s does not support the %s filter\n", table,
+                filter->user && !source->user_predicate ? "--user" :
+                filter->group && !source->group_predicate ? "--group" : "--since/--until");
+        return -1;
+    }
+
+    char sql[2048];
+    char predicate[128];
+    const char *params[SHOW_MAX_PARAMS];
+    int count = 0;
+
+    snprintf(sql, sizeof(sql), "%s", source->select);
+    if (filter->user) {
+        params[count++] = filter->user;
+        append_predicate(sql, sizeof(sql), source->user_predicate, count, count == 1);
+    }
+    if (filter->group) {
+        params[count++] = filter->group;
+        append_predicate(sql, sizeof(sql), source->group_predicate, count, count == 1);
+    }
+    if (filter->since) {
+        params[count++] = filter->since;
+        snprintf(predicate, sizeof(predicate), "%s >= $1::timestamp", source->time_column);
+        append_predicate(sql, sizeof(sql), predicate, count, count == 1);
+    }
+    if (filter->until) {
+        params[count++] = filter->until;
+        snprintf(predicate, sizeof(predicate), "%s < $1::timestamp", source->time_column);
+        append_predicate(sql, sizeof(sql), predicate, count, count == 1);
+    }
+    size_t len = strlen(sql);
+    len += (size_t)snprintf(sql + len, sizeof(sql) - len, " ORDER BY %s", source->order_by);
+    if (filter->limit) {
+        params[count++] = filter->limit;
+        snprintf(sql + len, sizeof(sql) - len, " LIMIT $%d::bigint", count);
+    }
+
+    if (!PQsendQueryParams(conn, sql, count, NULL, params, NULL, NULL, 0) || !PQsetSingleRowMode(conn)) {
+        fprintf(stderr, "Failed to query %s: %s", table, PQerrorMessage(conn));
+        PGresult *res;
+        while ((res = PQgetResult(conn)) != NULL) PQclear(res);
+        return -1;
+    }
+
+    if (filter->format == SHOW_FORMAT_TABLE) printf("\n=== %s ===\n", table);
+
+    long rows = 0;
+    int ok = 1;
+    PGresult *res;
+    while ((res = PQgetResult(conn)) != NULL) {
+        ExecStatusType status = PQresultStatus(res);
+        if (status == PGRES_SINGLE_TUPLE) {
+            if (rows == 0) write_header(res, filter->format);
+            write_row(res, filter->format);
+            rows++;
+        } else if (status == PGRES_TUPLES_OK) {
+            // Final zero-row result: still print the header for an empty table
+            if (rows == 0) write_header(res, filter->format);
+        } else {
+            fprintf(stderr, "Failed to query %s: %s", table, PQerrorMessage(conn));
+            ok = 0;
+        }
+        PQclear(res);
+    }
+    fflush(stdout);
+
+    if (filter->format == SHOW_FORMAT_TABLE) {
+        printf("(%ld row%s)\n", rows, rows == 1 ? "" : "s");
+    } else {
+        fprintf(stderr, "%ld row%s\n", rows, rows == 1 ? "" : "s");
+    }
+    return ok ? rows : -1;
+}
@@ -0,0 +1,30 @@
+#ifndef SHOW_H
+#define SHOW_H
+
+#include <libpq-fe.h>
+
+// Streaming table dumps for db_manager show-*. Rows are fetched one at a
+// time (PQsetSingleRowMode) and written straight to stdout, so memory use
+// does not depend on table size.
+typedef enum {
+    SHOW_FORMAT_TABLE,                   // Aligned columns for a terminal
+    SHOW_FORMAT_CSV,                     // RFC 4180, header row first
+    SHOW_FORMAT_JSONL                    // One JSON object per line
+} ShowFormat;
+
+typedef struct {
+    const char *user;                    // Username involved in the row, or NULL
+    const char *group;                   // Group id, or NULL
+    const char *since;                   // created_at >= since (timestamp text), or NULL
+    const char *until;                   // created_at < until, or NULL
+    const char *limit;                   // Maximum rows, or NULL
+    ShowFormat format;
+} ShowFilter;
+
+// Parse "--user U --group G --since T --until T --limit N --format table|csv|jsonl"
+int show_parse_args(int argc, char **argv, ShowFilter *filter);
+
+// Stream one table ("users", "friends", "groups", "group-members", "messages", "group-messages")
+long show_table(PGconn *conn, const char *table, const ShowFilter *filter);
+
+#endif
@@ -0,0 +1,1138 @@
+#include "transfer.h"
+#include "database.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <zlib.h>
+
+#define CHUNK_MAGIC 0x43484e4bU          // "CHNK"
+#define FOOTER_MAGIC 0x43454e44U         // "CEND"
+#define CHUNK_HEADER_SIZE 36
+
+// COPY binary file header: signature, flags, header extension length
+static const char copy_signature[11] = { 'P', 'G', 'C', 'O', 'P', 'Y', '\n', '\377', '\r', '\n', '\0' };
+#define COPY_HEADER_SIZE 19
+
+typedef struct {
+    char table[64];
+    int columns;
+    char names[TRANSFER_MAX_COLUMNS][64];
+    uint32_t types[TRANSFER_MAX_COLUMNS];
+    int64_t range_lo;                    // Inclusive
+    int64_t range_hi;                    // Exclusive
+} PartHeader;
+
+typedef struct {
+    uint32_t rows;
+    int64_t min_id;
+    int64_t max_id;
+    uint32_t raw_len;
+    uint32_t packed_len;
+    uint32_t crc;
+} ChunkHeader;
+
+typedef struct {
+    char table[64];
+    char path[512];
+    int64_t range_lo;
+    int64_t range_hi;
+} TransferPart;
+
+// Rows of the chunk being built, as COPY binary fields in row order
+typedef struct {
+    int columns;
+    uint32_t rows;
+    int64_t min_id;
+    int64_t max_id;
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+    uint32_t *field_offsets;             // [rows * columns] offsets into data
+} ChunkBuilder;
+
+typedef int (*PartFn)(const TransferPart *part);
+
+// Snapshot exported by transfer_export's planning transaction; forked
+// export children inherit it and read through it
+static char export_snapshot[64];
+
+// ============================================================================
+// Byte Order Helpers
+// ============================================================================
+
+static void put_be16(unsigned char *p, uint16_t v) { p[0] = (unsigned char)(v >> 8); p[1] = (unsigned char)v; }
+static void put_be32(unsigned char *p, uint32_t v) { put_be16(p, (uint16_t)(v >> 16)); put_be16(p + 2, (uint16_t)v); }
+static void put_be64(unsigned char *p, uint64_t v) { put_be32(p, (uint32_t)(v >> 32)); put_be32(p + 4, (uint32_t)v); }
+static uint16_t get_be16(const unsigned char *p) { return (uint16_t)((p[0] << 8) | p[1]); }
+static uint32_t get_be32(const unsigned char *p) { return ((uint32_t)get_be16(p) << 16) | get_be16(p + 2); }
+static uint64_t get_be64(const unsigned char *p) { return ((uint64_t)get_be32(p) << 32) | get_be32(p + 4); }
+
+/**
+ * @function field_id: Decode an int4/int8 id field value.
+ */
+static int64_t field_id(const unsigned char *value, int32_t len) {
+    if (len == 4) return (int32_t)get_be32(value);
+    if (len == 8) return (int64_t)get_be64(value);
+    return 0;
+}
+
+// ============================================================================
+// File Format
+// ============================================================================
+
+/**
+ * @function write_header: Write the part file header.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int write_header(FILE *f, const PartHeader *h) {
+    unsigned char buf[64];
+    size_t table_len = strlen(h->table);
+
+    memcpy(buf, TRANSFER_MAGIC, 8);
+    put_be16(buf + 8, TRANSFER_VERSION);
+    put_be16(buf + 10, (uint16_t)h->columns);
+    put_be16(buf + 12, (uint16_t)table_len);
+    if (fwrite(buf, 1, 14, f) != 14 || fwrite(h->table, 1, table_len, f) != table_len) return 0;
+
+    for (int c = 0; c < h->columns; c++) {
+        size_t name_len = strlen(h->names[c]);
+        put_be32(buf, h->types[c]);
+        put_be16(buf + 4, (uint16_t)name_len);
+        if (fwrite(buf, 1, 6, f) != 6 || fwrite(h->names[c], 1, name_len, f) != name_len) return 0;
+    }
+
+    put_be64(buf, (uint64_t)h->range_lo);
+    put_be64(buf + 8, (uint64_t)h->range_hi);
+    return fwrite(buf, 1, 16, f) == 16;
+}
+
+/**
+ * @function read_header: Read and validate the part file header.
+ *
+ * @return 1 on success, 0 on a malformed file.
+ */
+static int read_header(FILE *f, PartHeader *h) {
+    unsigned char buf[64];
+    memset(h, 0, sizeof(*h));
+
+    if (fread(buf, 1, 14, f) != 14 || memcmp(buf, TRANSFER_MAGIC, 8) != 0) return 0;
+    if (get_be16(buf + 8) != TRANSFER_VERSION) return 0;
+    h->columns = get_be16(buf + 10);
+    size_t table_len = get_be16(buf + 12);
+    if (h->columns < 1 || h->columns > TRANSFER_MAX_COLUMNS || table_len >= sizeof(h->table)) return 0;
+    if (fread(h->table, 1, table_len, f) != table_len) return 0;
+
+    for (int c = 0; c < h->columns; c++) {
+        if (fread(buf, 1, 6, f) != 6) return 0;
+        h->types[c] = get_be32(buf);
+        size_t name_len = get_be16(buf + 4);
+        if (name_len >= sizeof(h->names[c]) || fread(h->names[c], 1, name_len, f) != name_len) return 0;
+    }
+
+    if (fread(buf, 1, 16, f) != 16) return 0;
+    h->range_lo = (int64_t)get_be64(buf);
+    h->range_hi = (int64_t)get_be64(buf + 8);
+    return 1;
+}
+
+/**
+ * @function read_chunk_header: Read the next record header.
+ *
+ * @return 1 for a chunk, 2 for the footer (rows/chunk counts in *chunk), 0 at EOF or on a torn record.
+ */
+static int read_chunk_header(FILE *f, ChunkHeader *chunk) {
+    unsigned char buf[CHUNK_HEADER_SIZE];
+    if (fread(buf, 1, 4, f) != 4) return 0;
+
+    uint32_t magic = get_be32(buf);
+    if (magic == FOOTER_MAGIC) {
+        if (fread(buf + 4, 1, 12, f) != 12) return 0;
+        memset(chunk, 0, sizeof(*chunk));
+        chunk->rows = get_be32(buf + 4);                    // Chunk count
+        chunk->max_id = (int64_t)get_be64(buf + 8);         // Row count
+        return 2;
+    }
+    if (magic != CHUNK_MAGIC || fread(buf + 4, 1, CHUNK_HEADER_SIZE - 4, f) != CHUNK_HEADER_SIZE - 4) return 0;
+
+    chunk->rows = get_be32(buf + 4);
+    chunk->min_id = (int64_t)get_be64(buf + 8);
+    chunk->max_id = (int64_t)get_be64(buf + 16);
+    chunk->raw_len = get_be32(buf + 24);
+    chunk->packed_len = get_be32(buf + 28);
+    chunk->crc = get_be32(buf + 32);
+    return 1;
+}
+
+/**
+ * @function write_footer: Mark a part file complete.
+ */
+static int write_footer(FILE *f, uint32_t chunks, uint64_t rows) {
+    unsigned char buf[16];
+    put_be32(buf, FOOTER_MAGIC);
+    put_be32(buf + 4, chunks);
+    put_be64(buf + 8, rows);
+    return fwrite(buf, 1, 16, f) == 16;
+}
+
+// ============================================================================
+// Table Description
+// ============================================================================
+
+/**
+ * @function describe_table: Column names and type OIDs, with id first.
+ *
+ * @param conn Database connection.
+ * @param table Table name (from the fixed list, safe to interpolate).
+ * @param h Output header (range left zero).
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int describe_table(PGconn *conn, const char *table, PartHeader *h) {
+    char sql[128];
+    snprintf(sql, sizeof(sql), "SELECT * FROM %s LIMIT 0", table);
+    PGresult *res = PQexec(conn, sql);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        fprintf(stderr, "  %s: %s", table, PQerrorMessage(conn));
+        PQclear(res);
+        return 0;
+    }
+
+    memset(h, 0, sizeof(*h));
+    snprintf(h->table, sizeof(h->table), "%s", table);
+    int id_column = PQfnumber(res, "id");
+    int columns = PQnfields(res);
+    if (id_column < 0 || columns > TRANSFER_MAX_COLUMNS) {
+        fprintf(stderr, "  %s: needs an id column and at most %d columns\n", table, TRANSFER_MAX_COLUMNS);
+        PQclear(res);
+        return 0;
+    }
+
+    snprintf(h->names[0], sizeof(h->names[0]), "id");
+    h->types[0] = PQftype(res, id_column);
+    h->columns = 1;
+    for (int c = 0; c < columns; c++) {
+        if (c == id_column) continue;
+        snprintf(h->names[h->columns], sizeof(h->names[0]), "%s", PQfname(res, c));
+        h->types[h->columns++] = PQftype(res, c);
+    }
+    PQclear(res);
+    return 1;
+}
+
+/**
+ * @function column_list: Comma-separated quoted column names.
+ */
+static void column_list(PGconn *conn, const PartHeader *h, char *out, size_t size) {
+    size_t len = 0;
+    out[0] = '\0';
+    for (int c = 0; c < h->columns; c++) {
+        char *quoted = PQescapeIdentifier(conn, h->names[c], strlen(h->names[c]));
+        if (!quoted) continue;
+        len += (size_t)snprintf(out + len, size - len, "%s%s", c ? ", " : "", quoted);
+        PQfreemem(quoted);
+        if (len >= size) break;
+    }
+}
+
+/**
+ * @function same_columns: Whether two headers describe the same columns and types.
+ */
+static int same_columns(const PartHeader *a, const PartHeader *b) {
+    if (strcmp(a->table, b->table) != 0 || a->columns != b->columns) return 0;
+    for (int c = 0; c < a->columns; c++) {
+        if (a->types[c] != b->types[c] || strcmp(a->names[c], b->names[c]) != 0) return 0;
+    }
+    return 1;
+}
+
+// ============================================================================
+// Chunks
+// ============================================================================
+
+/**
+ * @function builder_append: Add one row (field data in COPY binary encoding).
+ *
+ * @param b Builder.
+ * @param row Start of the first field.
+ * @param end End of the message buffer.
+ *
+ * @return Bytes consumed, or 0 on a malformed row.
+ */
+static size_t builder_append(ChunkBuilder *b, const unsigned char *row, const unsigned char *end) {
+    const unsigned char *p = row;
+    uint32_t *offsets = b->field_offsets + (size_t)b->rows * b->columns;
+
+    for (int c = 0; c < b->columns; c++) {
+        if (end - p < 4) return 0;
+        int32_t len = (int32_t)get_be32(p);
+        size_t field = 4 + (size_t)(len > 0 ? len : 0);
+        if ((size_t)(end - p) < field) return 0;
+
+        if (b->len + field > b->cap) {
+            size_t cap = b->cap ? b->cap * 2 : 1 << 20;
+            while (cap < b->len + field) cap *= 2;
+            unsigned char *data = (unsigned char*)realloc(b->data, cap);
+            if (!data) return 0;
+            b->data = data;
+            b->cap = cap;
+        }
+        offsets[c] = (uint32_t)b->len;
+        memcpy(b->data + b->len, p, field);
+        b->len += field;
+
+        if (c == 0) {
+            int64_t id = field_id(p + 4, len);
+            if (b->rows == 0 || id < b->min_id) b->min_id = id;
+            if (b->rows == 0 || id > b->max_id) b->max_id = id;
+        }
+        p += field;
+    }
+    b->rows++;
+    return (size_t)(p - row);
+}
+
+/**
+ * @function builder_flush: Transpose, compress and write the pending chunk.
+ *
+ * @return 1 on success (or nothing to write), 0 on failure.
+ */
+static int builder_flush(ChunkBuilder *b, FILE *f) {
+    if (b->rows == 0) return 1;
+
+    unsigned char *raw = (unsigned char*)malloc(b->len);
+    uLongf packed_len = compressBound((uLong)b->len);
+    unsigned char *packed = (unsigned char*)malloc(packed_len);
+    int ok = raw && packed;
+
+    if (ok) {
+        // Column-major: every value of column 0, then column 1, ...
+        size_t pos = 0;
+        for (int c = 0; c < b->columns; c++) {
+            for (uint32_t r = 0; r < b->rows; r++) {
+                const unsigned char *field = b->data + b->field_offsets[(size_t)r * b->columns + c];
+                int32_t len = (int32_t)get_be32(field);
+                size_t size = 4 + (size_t)(len > 0 ? len : 0);
+                memcpy(raw + pos, field, size);
+                pos += size;
+            }
+        }
+        ok = compress2(packed, &packed_len, raw, (uLong)b->len, 6) == Z_OK;
+    }
+
+    if (ok) {
+        unsigned char header[CHUNK_HEADER_SIZE];
+        put_be32(header, CHUNK_MAGIC);
+        put_be32(header + 4, b->rows);
+        put_be64(header + 8, (uint64_t)b->min_id);
+        put_be64(header + 16, (uint64_t)b->max_id);
+        put_be32(header + 24, (uint32_t)b->len);
+        put_be32(header + 28, (uint32_t)packed_len);
+        put_be32(header + 32, (uint32_t)crc32(0L, packed, (uInt)packed_len));
+        ok = fwrite(header, 1, sizeof(header), f) == sizeof(header) &&
+             fwrite(packed, 1, packed_len, f) == packed_len &&
+             fflush(f) == 0;
+    }
+
+    free(raw);
+    free(packed);
+    b->rows = 0;
+    b->len = 0;
+    return ok;
+}
+
+/**
+ * @function read_chunk: Read, verify and decompress a chunk's column-major payload.
+ *
+ * @return Malloc'd raw payload (chunk->raw_len bytes), or NULL on failure.
+ */
+static unsigned char *read_chunk(FILE *f, const ChunkHeader *chunk) {
+    unsigned char *packed = (unsigned char*)malloc(chunk->packed_len ? chunk->packed_len : 1);
+    unsigned char *raw = (unsigned char*)malloc(chunk->raw_len ? chunk->raw_len : 1);
+    uLongf raw_len = chunk->raw_len;
+
+    int ok = packed && raw &&
+             fread(packed, 1, chunk->packed_len, f) == chunk->packed_len &&
+             (uint32_t)crc32(0L, packed, chunk->packed_len) == chunk->crc &&
+             uncompress(raw, &raw_len, packed, chunk->packed_len) == Z_OK &&
+             raw_len == chunk->raw_len;
+    free(packed);
+    if (!ok) {
+        free(raw);
+        return NULL;
+    }
+    return raw;
+}
+
+// ============================================================================
+// Export
+// ============================================================================
+
+/**
+ * @function open_export: Create a part file, or reopen one for resuming.
+ *
+ * A resumed file keeps its original id range and is truncated after its
+ * last intact chunk.
+ *
+ * @param part Part (range may be replaced by the file's).
+ * @param h Expected header.
+ * @param resume_from Receives the next id to export.
+ * @param chunks Receives chunks already written.
+ * @param rows Receives rows already written.
+ *
+ * @return Open file, or NULL with *resume_from > range_hi when already complete, or NULL on error.
+ */
+static FILE *open_export(const TransferPart *part, PartHeader *h, int64_t *resume_from,
+                         uint32_t *chunks, uint64_t *rows) {
+    *chunks = 0;
+    *rows = 0;
+    *resume_from = h->range_lo;
+
+    FILE *f = fopen(part->path, "r+b");
+    if (!f) {
+        f = fopen(part->path, "w+b");
+        if (!f || !write_header(f, h) || fflush(f) != 0) {
+            fprintf(stderr, "  cannot create %s: %s\n", part->path, strerror(errno));
+            if (f) fclose(f);
+            return NULL;
+        }
+        return f;
+    }
+
+    PartHeader existing;
+    if (!read_header(f, &existing) || !same_columns(&existing, h)) {
+        fprintf(stderr, "  %s: not a part file for the current %s schema\n", part->path, h->table);
+        fclose(f);
+        return NULL;
+    }
+    h->range_lo = existing.range_lo;
+    h->range_hi = existing.range_hi;
+    *resume_from = h->range_lo;
+
+    long good = ftell(f);
+    ChunkHeader chunk;
+    int kind;
+    while ((kind = read_chunk_header(f, &chunk)) == 1) {
+        unsigned char *raw = read_chunk(f, &chunk);
+        if (!raw) break;
+        free(raw);
+        good = ftell(f);
+        *resume_from = chunk.max_id + 1;
+        (*chunks)++;
+        *rows += chunk.rows;
+    }
+    if (kind == 2) {
+        fclose(f);
+        *resume_from = h->range_hi + 1;
+        return NULL;
+    }
+
+    if (ftruncate(fileno(f), good) != 0 || fseek(f, good, SEEK_SET) != 0) {
+        fprintf(stderr, "  cannot truncate %s: %s\n", part->path, strerror(errno));
+        fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+/**
+ * @function export_part: Child process body: export one id range.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int export_part(const TransferPart *part) {
+    PGconn *conn = connect_to_database();
+    if (!conn) return 1;
+
+    if (export_snapshot[0]) {
+        char sql[128];
+        snprintf(sql, sizeof(sql), "SET TRANSACTION SNAPSHOT '%s'", export_snapshot);
+        PGresult *res = PQexec(conn, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY");
+        int ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        PQclear(res);
+        if (ok) {
+            res = PQexec(conn, sql);
+            ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+            PQclear(res);
+        }
+        if (!ok) {
+            fprintf(stderr, "  %s: cannot join export snapshot: %s", part->path, PQerrorMessage(conn));
+            disconnect_database(conn);
+            return 1;
+        }
+    }
+
+    PartHeader h;
+    if (!describe_table(conn, part->table, &h)) {
+        disconnect_database(conn);
+        return 1;
+    }
+    h.range_lo = part->range_lo;
+    h.range_hi = part->range_hi;
+
+    int64_t resume_from;
+    uint32_t chunks;
+    uint64_t rows;
+    FILE *f = open_export(part, &h, &resume_from, &chunks, &rows);
+    if (!f) {
+        disconnect_database(conn);
+        if (resume_from > h.range_hi) {
+            printf("  %-32s already complete\n", part->path);
+            return 0;
+        }
+        return 1;
+    }
+    uint64_t resumed_rows = rows;
+
+    char columns[2048], sql[2560];
+    column_list(conn, &h, columns, sizeof(columns));
+    snprintf(sql, sizeof(sql),
+            "COPY (SELECT %s FROM %s WHERE id >= %lld AND id < %lld ORDER BY id) TO STDOUT (FORMAT binary)",
+            columns, h.table, (long long)resume_from, (long long)h.range_hi);
+    PGresult *res = PQexec(conn, sql);
+    int ok = PQresultStatus(res) == PGRES_COPY_OUT;
+    if (!ok) fprintf(stderr, "  %s: %s", part->path, PQerrorMessage(conn));
+    PQclear(res);
+
+    ChunkBuilder b;
+    memset(&b, 0, sizeof(b));
+    b.columns = h.columns;
+    b.field_offsets = (uint32_t*)malloc(sizeof(uint32_t) * TRANSFER_CHUNK_ROWS * (size_t)h.columns);
+    if (!b.field_offsets) ok = 0;
+
+    int header_seen = 0;
+    char *msg;
+    int len;
+    while (ok && (len = PQgetCopyData(conn, &msg, 0)) > 0) {
+        const unsigned char *p = (const unsigned char*)msg;
+        const unsigned char *end = p + len;
+
+        if (!header_seen) {
+            if (len < COPY_HEADER_SIZE || memcmp(p, copy_signature, sizeof(copy_signature)) != 0) ok = 0;
+            else p += COPY_HEADER_SIZE + get_be32(p + 15);
+            header_seen = 1;
+        }
+        while (ok && end - p >= 2) {
+            int16_t fields = (int16_t)get_be16(p);
+            p += 2;
+            if (fields == -1) break;                       // Trailer
+            if (fields != h.columns) {
+                ok = 0;
+                break;
+            }
+            size_t used = builder_append(&b, p, end);
+            if (used == 0) ok = 0;
+            p += used;
+            rows++;
+            if (b.rows == TRANSFER_CHUNK_ROWS || b.len >= TRANSFER_CHUNK_BYTES) {
+                ok = ok && builder_flush(&b, f);
+                chunks++;
+            }
+        }
+        PQfreemem(msg);
+    }
+    if (ok && len == -2) {
+        fprintf(stderr, "  %s: %s", part->path, PQerrorMessage(conn));
+        ok = 0;
+    }
+    while ((res = PQgetResult(conn)) != NULL) {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) ok = 0;
+        PQclear(res);
+    }
+
+    if (ok && b.rows > 0) {
+        ok = builder_flush(&b, f);
+        chunks++;
+    }
+    ok = ok && write_footer(f, chunks, rows) && fflush(f) == 0 && fsync(fileno(f)) == 0;
+
+    long size = ftell(f);
+    fclose(f);
+    free(b.data);
+    free(b.field_offsets);
+    disconnect_database(conn);
+
+    if (!ok) {
+        fprintf(stderr, "  %-32s FAILED (re-run to resume)\n", part->path);
+        return 1;
+    }
+    printf("  %-32s %10llu rows %6u chunks %9.1f MB%s\n", part->path, (unsigned long long)rows, chunks,
+           (double)size / (1024.0 * 1024.0), resumed_rows ? " (resumed)" : "");
+    return 0;
+}
+
+// ============================================================================
+// Import
+// ============================================================================
+
+/**
+ * @function chunk_loaded: Whether a chunk was committed by an earlier import.
+ */
+static int chunk_loaded(PGconn *conn, const char *table, int64_t min_id) {
+    char sql[128];
+    snprintf(sql, sizeof(sql), "SELECT 1 FROM %s WHERE id = %lld LIMIT 1", table, (long long)min_id);
+    PGresult *res = PQexec(conn, sql);
+    int loaded = PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0;
+    PQclear(res);
+    return loaded;
+}
+
+/**
+ * @function copy_chunk: Load one chunk with a single COPY FROM STDIN (FORMAT binary).
+ *
+ * @param conn Database connection.
+ * @param copy_sql COPY statement.
+ * @param h Part header.
+ * @param chunk Chunk header.
+ * @param raw Column-major payload.
+ *
+ * @return 1 on success, 0 on failure (the COPY is rolled back).
+ */
+static int copy_chunk(PGconn *conn, const char *copy_sql, const PartHeader *h,
+                      const ChunkHeader *chunk, const unsigned char *raw) {
+    size_t cells = (size_t)chunk->rows * h->columns;
+    uint32_t *offsets = (uint32_t*)malloc(sizeof(uint32_t) * (cells ? cells : 1));
+    unsigned char *stream = (unsigned char*)malloc(COPY_HEADER_SIZE + chunk->raw_len + (size_t)chunk->rows * 2 + 2);
+    if (!offsets || !stream) {
+        free(offsets);
+        free(stream);
+        return 0;
+    }
+
+    // Locate every field in the column-major payload
+    int ok = 1;
+    size_t pos = 0;
+    for (int c = 0; c < h->columns && ok; c++) {
+        for (uint32_t r = 0; r < chunk->rows; r++) {
+            if (pos + 4 > chunk->raw_len) {
+                ok = 0;
+                break;
+            }
+            int32_t len = (int32_t)get_be32(raw + pos);
+            offsets[(size_t)r * h->columns + c] = (uint32_t)pos;
+            pos += 4 + (size_t)(len > 0 ? len : 0);
+            if (pos > chunk->raw_len) {
+                ok = 0;
+                break;
+            }
+        }
+    }
+
+    // Back to row order, framed as a COPY binary stream
+    size_t out = 0;
+    if (ok) {
+        memcpy(stream, copy_signature, sizeof(copy_signature));
+        memset(stream + sizeof(copy_signature), 0, 8);
+        out = COPY_HEADER_SIZE;
+        for (uint32_t r = 0; r < chunk->rows; r++) {
+            put_be16(stream + out, (uint16_t)h->columns);
+            out += 2;
+            for (int c = 0; c < h->columns; c++) {
+                const unsigned char *field = raw + offsets[(size_t)r * h->columns + c];
+                int32_t len = (int32_t)get_be32(field);
+                size_t size = 4 + (size_t)(len > 0 ? len : 0);
+                memcpy(stream + out, field, size);
+                out += size;
+            }
+        }
+        put_be16(stream + out, 0xffff);
+        out += 2;
+    }
+    free(offsets);
+
+    if (ok) {
+        PGresult *res = PQexec(conn, copy_sql);
+        ok = PQresultStatus(res) == PGRES_COPY_IN;
+        PQclear(res);
+    }
+    if (ok) {
+        for (size_t sent = 0; sent < out && ok; sent += TRANSFER_CHUNK_BYTES / 8) {
+            size_t n = out - sent < TRANSFER_CHUNK_BYTES / 8 ? out - sent : TRANSFER_CHUNK_BYTES / 8;
+            ok = PQputCopyData(conn, (const char*)stream + sent, (int)n) == 1;
+        }
+        if (PQputCopyEnd(conn, ok ? NULL : "import aborted") != 1) ok = 0;
+        PGresult *res;
+        while ((res = PQgetResult(conn)) != NULL) {
+            if (PQresultStatus(res) != PGRES_COMMAND_OK) ok = 0;
+            PQclear(res);
+        }
+    }
+    if (!ok) fprintf(stderr, "  chunk %lld..%lld: %s", (long long)chunk->min_id, (long long)chunk->max_id,
+                     PQerrorMessage(conn));
+
+    free(stream);
+    return ok;
+}
+
+/**
+ * @function import_part: Child process body: load one part file.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int import_part(const TransferPart *part) {
+    FILE *f = fopen(part->path, "rb");
+    if (!f) {
+        fprintf(stderr, "  cannot open %s: %s\n", part->path, strerror(errno));
+        return 1;
+    }
+
+    PGconn *conn = connect_to_database();
+    if (!conn) {
+        fclose(f);
+        return 1;
+    }
+
+    PartHeader h, current;
+    int ok = read_header(f, &h);
+    if (!ok) fprintf(stderr, "  %s: not a part file\n", part->path);
+    ok = ok && describe_table(conn, h.table, &current);
+    if (ok && !same_columns(&h, &current)) {
+        fprintf(stderr, "  %s: columns differ from the %s table\n", part->path, h.table);
+        ok = 0;
+    }
+
+    char columns[2048], copy_sql[2560];
+    column_list(conn, &h, columns, sizeof(columns));
+    snprintf(copy_sql, sizeof(copy_sql), "COPY %s (%s) FROM STDIN (FORMAT binary)", h.table, columns);
+
+    PGresult *res = PQexec(conn, "SET synchronous_commit = off");
+    PQclear(res);
+
+    uint64_t loaded = 0, skipped = 0;
+    ChunkHeader chunk;
+    int kind = 0;
+    while (ok && (kind = read_chunk_header(f, &chunk)) == 1) {
+        unsigned char *raw = read_chunk(f, &chunk);
+        if (!raw) {
+            fprintf(stderr, "  %s: corrupt chunk %lld..%lld\n", part->path,
+                    (long long)chunk.min_id, (long long)chunk.max_id);
+            ok = 0;
+            break;
+        }
+        if (chunk_loaded(conn, h.table, chunk.min_id)) {
+            skipped += chunk.rows;
+        } else if ((ok = copy_chunk(conn, copy_sql, &h, &chunk, raw))) {
+            loaded += chunk.rows;
+        }
+        free(raw);
+    }
+    if (ok && kind != 2) {
+        fprintf(stderr, "  %s: incomplete (no footer); finish the export and re-run\n", part->path);
+        ok = 0;
+    }
+
+    fclose(f);
+    disconnect_database(conn);
+
+    if (!ok) {
+        fprintf(stderr, "  %-32s FAILED (re-run to resume)\n", part->path);
+        return 1;
+    }
+    printf("  %-32s %10llu rows loaded, %llu already present\n", part->path,
+           (unsigned long long)loaded, (unsigned long long)skipped);
+    return 0;
+}
+
+// ============================================================================
+// Parallel Runner
+// ============================================================================
+
+/**
+ * @function run_parts: Process parts with at most jobs child processes at a time.
+ *
+ * @return 1 if every part succeeded, 0 otherwise.
+ */
+static int run_parts(const TransferPart *parts, int count, int jobs, PartFn fn) {
+    int next = 0, running = 0, ok = 1;
+    fflush(stdout);
+    fflush(stderr);
+
+    while (next < count || running > 0) {
+        while (next < count && running < jobs) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                int status = fn(&parts[next]);
+                fflush(stdout);
+                fflush(stderr);
+                _exit(status);
+            }
+            if (pid < 0) {
+                perror("fork");
+                ok = 0;
+                next = count;
+                break;
+            }
+            next++;
+            running++;
+        }
+        if (running == 0) break;
+
+        int status;
+        if (wait(&status) > 0) {
+            running--;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = 0;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @function find_parts: Existing <table>.<n>.chc files in dir, sorted by name.
+ *
+ * @return Number of parts found.
+ */
+static int find_parts(const char *dir, const char *table, TransferPart *parts, int max) {
+    DIR *d = opendir(dir);
+    if (!d) return 0;
+
+    size_t table_len = strlen(table);
+    size_t suffix_len = strlen(TRANSFER_SUFFIX);
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL && count < max) {
+        const char *name = entry->d_name;
+        size_t len = strlen(name);
+        if (len <= table_len + 1 + suffix_len || strncmp(name, table, table_len) != 0 || name[table_len] != '.' ||
+            strcmp(name + len - suffix_len, TRANSFER_SUFFIX) != 0) {
+            continue;
+        }
+        int digits = 1;
+        for (const char *p = name + table_len + 1; p < name + len - suffix_len; p++) {
+            if (*p < '0' || *p > '9') digits = 0;
+        }
+        if (!digits) continue;
+
+        TransferPart *part = &parts[count++];
+        memset(part, 0, sizeof(*part));
+        snprintf(part->table, sizeof(part->table), "%s", table);
+        snprintf(part->path, sizeof(part->path), "%s/%s", dir, name);
+    }
+    closedir(d);
+
+    // Zero-padded part numbers sort correctly as strings
+    for (int i = 1; i < count; i++) {
+        for (int j = i; j > 0 && strcmp(parts[j - 1].path, parts[j].path) > 0; j--) {
+            TransferPart tmp = parts[j];
+            parts[j] = parts[j - 1];
+            parts[j - 1] = tmp;
+        }
+    }
+    return count;
+}
+
+/**
+ * @function part_path: <dir>/<table>.<n>.chc for part n.
+ */
+static void part_path(char *out, size_t size, const char *dir, const char *table, int n) {
+    snprintf(out, size, "%s/%s.%03d%s", dir, table, n, TRANSFER_SUFFIX);
+}
+
+/**
+ * @function write_plan: Record every planned range before any part is exported.
+ *
+ * Written to a temporary file and renamed, so a plan is either complete or
+ * absent.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int write_plan(const char *dir, const char *table, const TransferPart *parts, int count) {
+    char path[512], tmp[520];
+    snprintf(path, sizeof(path), "%s/%s%s", dir, table, TRANSFER_PLAN_SUFFIX);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *f = fopen(tmp, "w");
+    if (!f) {
+        fprintf(stderr, "  cannot create %s: %s\n", tmp, strerror(errno));
+        return 0;
+    }
+    int ok = fprintf(f, "%s %s %d\n", TRANSFER_MAGIC, table, count) > 0;
+    for (int p = 0; p < count && ok; p++) {
+        ok = fprintf(f, "%lld %lld\n", (long long)parts[p].range_lo, (long long)parts[p].range_hi) > 0;
+    }
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (ok && rename(tmp, path) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "  cannot write %s: %s\n", path, strerror(errno));
+        unlink(tmp);
+    }
+    return ok;
+}
+
+/**
+ * @function read_plan: Load the parts planned by an earlier export of table.
+ *
+ * @return Number of parts, 0 if there is no plan, -1 if it is unreadable.
+ */
+static int read_plan(const char *dir, const char *table, TransferPart *parts, int max) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s%s", dir, table, TRANSFER_PLAN_SUFFIX);
+    FILE *f = fopen(path, "r");
+    if (!f) return errno == ENOENT ? 0 : -1;
+
+    char magic[16], name[64];
+    int count = -1;
+    if (fscanf(f, "%15s %63s %d", magic, name, &count) != 3 || strcmp(magic, TRANSFER_MAGIC) != 0 ||
+        strcmp(name, table) != 0 || count < 1 || count > max) {
+        count = -1;
+    }
+    for (int p = 0; p < count; p++) {
+        long long lo, hi;
+        if (fscanf(f, "%lld %lld", &lo, &hi) != 2) {
+            count = -1;
+            break;
+        }
+        TransferPart *part = &parts[p];
+        memset(part, 0, sizeof(*part));
+        snprintf(part->table, sizeof(part->table), "%s", table);
+        part_path(part->path, sizeof(part->path), dir, table, p);
+        part->range_lo = lo;
+        part->range_hi = hi;
+    }
+    fclose(f);
+    if (count < 0) fprintf(stderr, "  %s: not a valid export plan\n", path);
+    return count;
+}
+
+/**
+ * @function check_tables: Reject anything outside the transferable tables.
+ */
+static int check_tables(const char **tables, int count) {
+    static const char *allowed[] = TRANSFER_DEFAULT_TABLES;
+    for (int t = 0; t < count; t++) {
+        int found = 0;
+        for (size_t a = 0; a < sizeof(allowed) / sizeof(allowed[0]); a++) {
+            if (strcmp(tables[t], allowed[a]) == 0) found = 1;
+        }
+        if (!found) {
+            fprintf(stderr, "Unsupported table: %s (friends, messages, group_messages)\n", tables[t]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @function elapsed_since: Seconds since a CLOCK_MONOTONIC timestamp.
+ */
+static double elapsed_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @function transfer_export: Snapshot tables into part files.
+ *
+ * Each table's id range [min, max] is split into jobs equal parts, one
+ * file and connection each. The ranges are saved to <table>.plan before
+ * any part starts; if a plan exists the run resumes it instead (parts never
+ * started are exported from scratch), so rows inserted after the first
+ * attempt are not picked up half-way and no range is silently dropped.
+ *
+ * The planning connection holds a REPEATABLE READ transaction for the whole
+ * run and exports its snapshot; every part joins it with SET TRANSACTION
+ * SNAPSHOT, so all tables and ranges reflect the same instant. A resumed
+ * export reads the remaining rows at the new run's instant.
+ *
+ * @param conn Database connection (for planning only).
+ * @param dir Output directory (created if missing).
+ * @param jobs Parallel connections.
+ * @param tables Tables to export, or NULL for the defaults.
+ * @param table_count Number of tables.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int transfer_export(PGconn *conn, const char *dir, int jobs, const char **tables, int table_count) {
+    static const char *defaults[] = TRANSFER_DEFAULT_TABLES;
+    if (!tables || table_count == 0) {
+        tables = defaults;
+        table_count = (int)(sizeof(defaults) / sizeof(defaults[0]));
+    }
+    if (!conn || jobs < 1 || jobs > TRANSFER_MAX_PARTS || !check_tables(tables, table_count)) return -1;
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    PGresult *res = PQexec(conn, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY");
+    int ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    PQclear(res);
+    if (ok) {
+        res = PQexec(conn, "SELECT pg_export_snapshot()");
+        ok = PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1;
+        if (ok) snprintf(export_snapshot, sizeof(export_snapshot), "%s", PQgetvalue(res, 0, 0));
+        PQclear(res);
+    }
+    if (!ok) {
+        fprintf(stderr, "Cannot export a snapshot: %s", PQerrorMessage(conn));
+        PQclear(PQexec(conn, "ROLLBACK"));
+        return -1;
+    }
+
+    static TransferPart parts[TRANSFER_MAX_PARTS];
+    int failed = 0;
+    for (int t = 0; t < table_count; t++) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        int count = read_plan(dir, tables[t], parts, TRANSFER_MAX_PARTS);
+        if (count < 0) {
+            failed = 1;
+            continue;
+        }
+        if (count > 0) {
+            printf("=== %s: resuming %d planned part(s) ===\n", tables[t], count);
+        } else if (find_parts(dir, tables[t], parts, TRANSFER_MAX_PARTS) > 0) {
+            fprintf(stderr, "%s: part files in %s but no %s%s; remove them to start over\n",
+                    tables[t], dir, tables[t], TRANSFER_PLAN_SUFFIX);
+            failed = 1;
+            continue;
+        } else {
+            char sql[128];
+            snprintf(sql, sizeof(sql), "SELECT COALESCE(MIN(id), 0), COALESCE(MAX(id), -1) FROM %s", tables[t]);
+            res = PQexec(conn, sql);
+            if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+                fprintf(stderr, "%s: %s", tables[t], PQerrorMessage(conn));
+                PQclear(res);
+                failed = 1;
+                break;
+            }
+            int64_t lo = strtoll(PQgetvalue(res, 0, 0), NULL, 10);
+            int64_t hi = strtoll(PQgetvalue(res, 0, 1), NULL, 10) + 1;
+            PQclear(res);
+
+            int64_t span = hi - lo;
+            count = span < jobs ? 1 : jobs;
+            for (int p = 0; p < count; p++) {
+                TransferPart *part = &parts[p];
+                snprintf(part->table, sizeof(part->table), "%s", tables[t]);
+                part_path(part->path, sizeof(part->path), dir, tables[t], p);
+                part->range_lo = lo + span * p / count;
+                part->range_hi = lo + span * (p + 1) / count;
+            }
+            printf("=== %s: ids %lld..%lld in %d part(s) ===\n", tables[t], (long long)lo, (long long)hi - 1, count);
+            if (!write_plan(dir, tables[t], parts, count)) {
+                failed = 1;
+                continue;
+            }
+        }
+
+        if (!run_parts(parts, count, jobs, export_part)) failed = 1;
+        printf("  %s exported in %.1fs\n", tables[t], elapsed_since(&start));
+    }
+
+    // Ending the transaction releases the snapshot
+    PQclear(PQexec(conn, "COMMIT"));
+    export_snapshot[0] = '\0';
+
+    if (failed) {
+        fprintf(stderr, "Export incomplete; re-run the same command to resume\n");
+        return -1;
+    }
+    printf("✓ Export complete: %s\n", dir);
+    return 0;
+}
+
+/**
+ * @function transfer_import: Load part files back into their tables.
+ *
+ * Referenced rows (users, groups) must already exist. Sequences are moved
+ * past the imported ids, and the unread counters of migration 002 are
+ * rebuilt: direct_unread_counts for messages, and for group_messages each
+ * member's unread_count, recounted past their read cursor (cursors beyond
+ * the last imported id are pulled back to it).
+ *
+ * @param conn Database connection (for finishing steps).
+ * @param dir Directory holding the part files.
+ * @param jobs Parallel connections.
+ * @param tables Tables to import, or NULL for the defaults.
+ * @param table_count Number of tables.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int transfer_import(PGconn *conn, const char *dir, int jobs, const char **tables, int table_count) {
+    static const char *defaults[] = TRANSFER_DEFAULT_TABLES;
+    if (!tables || table_count == 0) {
+        tables = defaults;
+        table_count = (int)(sizeof(defaults) / sizeof(defaults[0]));
+    }
+    if (!conn || jobs < 1 || jobs > TRANSFER_MAX_PARTS || !check_tables(tables, table_count)) return -1;
+
+    static TransferPart parts[TRANSFER_MAX_PARTS];
+    int failed = 0;
+    for (int t = 0; t < table_count; t++) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        int count = find_parts(dir, tables[t], parts, TRANSFER_MAX_PARTS);
+        if (count == 0) {
+            printf("=== %s: no part files in %s ===\n", tables[t], dir);
+            continue;
+        }
+        static TransferPart planned[TRANSFER_MAX_PARTS];
+        int expected = read_plan(dir, tables[t], planned, TRANSFER_MAX_PARTS);
+        if (expected != 0 && expected != count) {
+            fprintf(stderr, "%s: %s%s lists %d part(s), found %d; finish the export first\n",
+                    tables[t], tables[t], TRANSFER_PLAN_SUFFIX, expected, count);
+            failed = 1;
+            continue;
+        }
+        printf("=== %s: %d part(s) ===\n", tables[t], count);
+        if (!run_parts(parts, count, jobs, import_part)) {
+            failed = 1;
+            continue;
+        }
+
+        char sql[256];
+        snprintf(sql, sizeof(sql),
+                "SELECT setval(pg_get_serial_sequence('%s', 'id'), GREATEST((SELECT MAX(id) FROM %s), 1))",
+                tables[t], tables[t]);
+        PGresult *res = PQexec(conn, sql);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) fprintf(stderr, "  %s", PQerrorMessage(conn));
+        PQclear(res);
+
+        if (strcmp(tables[t], "messages") == 0) {
+            res = PQexec(conn,
+                    "INSERT INTO direct_unread_counts (user_id, sender_id, unread_count) "
+                    "SELECT receiver_id, sender_id, COUNT(*) FROM messages "
+                    "WHERE is_delivered = FALSE AND receiver_id IS NOT NULL "
+                    "GROUP BY receiver_id, sender_id "
+                    "ON CONFLICT (user_id, sender_id) DO UPDATE SET unread_count = EXCLUDED.unread_count");
+            if (PQresultStatus(res) != PGRES_COMMAND_OK) fprintf(stderr, "  %s", PQerrorMessage(conn));
+            PQclear(res);
+        } else if (strcmp(tables[t], "group_messages") == 0) {
+            // Cursors past the last imported id would hide new messages;
+            // counters are recounted against the (clamped) cursors
+            res = PQexec(conn,
+                    "UPDATE group_members m SET "
+                    "    last_read_message_id = LEAST(m.last_read_message_id, COALESCE("
+                    "        (SELECT MAX(g.id) FROM group_messages g WHERE g.group_id = m.group_id), 0)), "
+                    "    unread_count = ("
+                    "        SELECT COUNT(*) FROM group_messages g "
+                    "        WHERE g.group_id = m.group_id AND g.id > m.last_read_message_id "
+                    "        AND g.sender_id != m.user_id)");
+            if (PQresultStatus(res) != PGRES_COMMAND_OK) fprintf(stderr, "  %s", PQerrorMessage(conn));
+            PQclear(res);
+        }
+        printf("  %s imported in %.1fs\n", tables[t], elapsed_since(&start));
+    }
+
+    if (failed) {
+        fprintf(stderr, "Import incomplete; re-run the same command to resume\n");
+        return -1;
+    }
+    printf("✓ Import complete\n");
+    return 0;
+}
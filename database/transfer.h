@@ -0,0 +1,43 @@
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include <libpq-fe.h>
+#include <stdint.h>
+
+// Bulk export/import of chat history through COPY (FORMAT binary).
+//
+// Each table is split into id ranges. Every range is written by its own
+// process and connection to <dir>/<table>.<part>.chc:
+//
+//   header  "CHATCOL1", u16 version, u16 columns, table name,
+//           per column (u32 type oid, name), i64 range_lo, i64 range_hi
+//   chunk*  "CHNK", u32 rows, i64 min_id, i64 max_id,
+//           u32 raw_len, u32 packed_len, u32 crc32, zlib(packed)
+//   footer  "CEND", u32 chunks, u64 rows
+//
+// Integers are big-endian. A chunk holds up to TRANSFER_CHUNK_ROWS rows of
+// COPY binary fields stored column by column (all ids, then all senders,
+// ...), which compresses much better than row order. An interrupted export
+// resumes after the last complete chunk; the ranges are saved in
+// <table>.plan before any part starts, so parts that never started are
+// exported on resume rather than skipped. An import loads each chunk in its
+// own COPY transaction and skips chunks whose first id is already present,
+// so it can be re-run after a failure.
+#define TRANSFER_MAGIC "CHATCOL1"
+#define TRANSFER_VERSION 1
+#define TRANSFER_SUFFIX ".chc"
+#define TRANSFER_PLAN_SUFFIX ".plan"        // <dir>/<table>.plan: magic, table, count, then "lo hi" per part
+#define TRANSFER_CHUNK_ROWS 65536
+#define TRANSFER_CHUNK_BYTES (8 * 1024 * 1024)   // Raw bytes per chunk before compression
+#define TRANSFER_MAX_COLUMNS 32
+#define TRANSFER_MAX_PARTS 256
+#define TRANSFER_DEFAULT_JOBS 4
+#define TRANSFER_DEFAULT_TABLES { "friends", "messages", "group_messages" }
+
+// Export tables (NULL/0 = the defaults) into dir with up to jobs parallel connections
+int transfer_export(PGconn *conn, const char *dir, int jobs, const char **tables, int table_count);
+
+// Import every <table>.<part>.chc file in dir
+int transfer_import(PGconn *conn, const char *dir, int jobs, const char **tables, int table_count);
+
+#endif
@@ -1,5 +1,6 @@
 #include "../server/server.h"
 #include "../database/database.h"
+#include "helper.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,51 +13,155 @@ void send_and_free(ClientSession *client, char *response) {
     free(response);
 }
 
+// Rows fetched per drain query; each batch is acknowledged with one DELETE
+#define NOTIFICATION_BATCH_ROWS 500
+
 /**
  * @brief Send pending notifications to client upon login
  */
 void send_pending_notifications(Server *server, ClientSession *client) {
+    send_pending_notifications_after(server, client, 0);
+}
+
+/**
+ * @brief Send pending notifications newer than after_id (RESUME replay)
+ *
+ * Notifications are read in id-ordered batches and packed back to back into
+ * writes of up to COMPRESSION_MAX_RAW_LENGTH bytes (one compressed frame when
+ * compression is on). Rows are deleted with a single DELETE ... WHERE id = ANY
+ * per batch, and only once the write carrying them has gone out completely.
+ * Each line carries its id so a reconnecting client can report the last one
+ * it saw; rows up to after_id are treated as acknowledged and deleted.
+ */
+void send_pending_notifications_after(Server *server, ClientSession *client, int after_id) {
     if (!server || !client || !client->is_authenticated) return;
     
-    char query[512];
-    snprintf(query, sizeof(query),
-            "SELECT id, notification_type, group_id, sender_username, message, created_at "
-            "FROM offline_notifications "
-            "WHERE user_id = %d AND notification_type != 'GROUP_MESSAGE' "
-            "ORDER BY created_at ASC",
-            client->user_id);
-    
-    PGresult *res = execute_query_with_result(server->db_conn, query);
-    if (!res) return;
+    if (after_id > 0) {
+        char ack[256];
+        snprintf(ack, sizeof(ack),
+                "DELETE FROM offline_notifications "
+                "WHERE user_id = %d AND notification_type != 'GROUP_MESSAGE' AND id <= %d",
+                client->user_id, after_id);
+        execute_query(server->db_conn, ack);
+    }
     
-    int count = PQntuples(res);
-    if (count == 0) {
-        PQclear(res);
+    size_t chunk_capacity = COMPRESSION_MAX_RAW_LENGTH + 1;
+    char *chunk = (char*)malloc(chunk_capacity);
+    int *sent_ids = (int*)malloc(NOTIFICATION_BATCH_ROWS * sizeof(int));
+    size_t id_array_size = NOTIFICATION_BATCH_ROWS * 12 + 3;
+    char *id_array = (char*)malloc(id_array_size);
+    if (!chunk || !sent_ids || !id_array) {
+        free(chunk);
+        free(sent_ids);
+        free(id_array);
         return;
     }
     
-    printf("Sending %d pending notification(s) to '%s'\n", count, client->username);
+    int cursor = after_id > 0 ? after_id : 0;
+    int first_batch = 1;
+    int total_sent = 0;
+    int send_failed = 0;
     
-    for (int i = 0; i < count; i++) {
-        int notif_id = atoi(PQgetvalue(res, i, 0));
-        char notification[1024];
-        snprintf(notification, sizeof(notification),
-                "OFFLINE_NOTIFICATION type=\"%s\" group_id=%d sender=\"%s\" "
-                "message=\"%s\" time=\"%s\"",
-                PQgetvalue(res, i, 1), atoi(PQgetvalue(res, i, 2)),
-                PQgetvalue(res, i, 3), PQgetvalue(res, i, 4), PQgetvalue(res, i, 5));
-        
-        char *response = build_response(STATUS_OFFLINE_NOTIFICATION, notification);
-        
-        if (server_send_response(client, response) > 0) {
-            char delete_query[256];
-            snprintf(delete_query, sizeof(delete_query),
-                    "DELETE FROM offline_notifications WHERE id = %d", notif_id);
-            execute_query(server->db_conn, delete_query);
+    while (!send_failed) {
+        char query[512];
+        snprintf(query, sizeof(query),
+                "SELECT id, notification_type, group_id, sender_username, message, created_at "
+                "FROM offline_notifications "
+                "WHERE user_id = %d AND notification_type != 'GROUP_MESSAGE' AND id > %d "
+                "ORDER BY id ASC LIMIT %d",
+                client->user_id, cursor, NOTIFICATION_BATCH_ROWS);
+        
+        PGresult *res = execute_query_with_result(server->db_conn, query);
+        if (!res) break;
+        
+        int count = PQntuples(res);
+        if (count == 0) {
+            PQclear(res);
+            break;
+        }
+        
+        if (first_batch) {
+            LOG_DEBUG("Sending pending notification(s) to '%s'", client->username);
+            first_batch = 0;
+        }
+        
+        size_t chunk_len = 0;
+        int chunk_start = 0;
+        int sent_count = 0;
+        
+        for (int i = 0; i <= count && !send_failed; i++) {
+            char *response = NULL;
+            size_t response_len = 0;
+            
+            if (i < count) {
+                char notification[1024];
+                snprintf(notification, sizeof(notification),
+                        "OFFLINE_NOTIFICATION id=%d type=\"%s\" group_id=%d sender=\"%s\" "
+                        "message=\"%s\" time=\"%s\"",
+                        atoi(PQgetvalue(res, i, 0)), PQgetvalue(res, i, 1), atoi(PQgetvalue(res, i, 2)),
+                        PQgetvalue(res, i, 3), PQgetvalue(res, i, 4), PQgetvalue(res, i, 5));
+                
+                response = build_response(STATUS_OFFLINE_NOTIFICATION, notification);
+                if (!response) {
+                    send_failed = 1;
+                    break;
+                }
+                response_len = strlen(response);
+            }
+            
+            // Flush when the next response would overflow the chunk, or at the end
+            if (chunk_len > 0 && (i == count || chunk_len + response_len >= chunk_capacity)) {
+                if (server_send_response(client, chunk) < 0) {
+                    send_failed = 1;
+                    free(response);
+                    break;
+                }
+                for (int j = chunk_start; j < i; j++) {
+                    sent_ids[sent_count++] = atoi(PQgetvalue(res, j, 0));
+                }
+                chunk_len = 0;
+                chunk_start = i;
+            }
+            
+            if (response) {
+                memcpy(chunk + chunk_len, response, response_len + 1);
+                chunk_len += response_len;
+                free(response);
+            }
         }
-        free(response);
+        
+        cursor = atoi(PQgetvalue(res, count - 1, 0));
+        PQclear(res);
+        
+        if (sent_count > 0) {
+            int offset = snprintf(id_array, id_array_size, "{");
+            for (int i = 0; i < sent_count; i++) {
+                offset += snprintf(id_array + offset, id_array_size - offset, "%s%d",
+                                  i > 0 ? "," : "", sent_ids[i]);
+            }
+            snprintf(id_array + offset, id_array_size - offset, "}");
+            
+            const char *paramValues[1] = {id_array};
+            PGresult *del = PQexecParams(server->db_conn,
+                    "DELETE FROM offline_notifications WHERE id = ANY($1::int[])",
+                    1, NULL, paramValues, NULL, NULL, 0);
+            if (PQresultStatus(del) != PGRES_COMMAND_OK) {
+                LOG_WARN("Failed to delete %d delivered notification(s): %s",
+                         sent_count, PQerrorMessage(server->db_conn));
+            }
+            PQclear(del);
+            total_sent += sent_count;
+        }
+        
+        if (count < NOTIFICATION_BATCH_ROWS) break;
     }
     
-    PQclear(res);
-    printf("All pending notifications processed for '%s'\n", client->username);
+    free(chunk);
+    free(sent_ids);
+    free(id_array);
+    
+    if (total_sent > 0 || send_failed) {
+        LOG_INFO("Delivered %d pending notification(s) to '%s'%s", total_sent,
+                 client->username, send_failed ? " (stopped on send error)" : "");
+    }
 }
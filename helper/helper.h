@@ -4,5 +4,6 @@
 
 void send_and_free(ClientSession *client, char *response);
 void send_pending_notifications(Server *server, ClientSession *client);
+void send_pending_notifications_after(Server *server, ClientSession *client, int after_id);
 
 #endif
\ No newline at end of file
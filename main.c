@@ -2,6 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include "database/database.h"
+#include "database/migrate.h"
+#include "database/partition.h"
+#include "database/seed.h"
+#include "database/show.h"
+#include "database/transfer.h"
 
 int main(int argc, char *argv[]) {
     PGconn *conn = connect_to_database();
@@ -16,31 +21,88 @@ int main(int argc, char *argv[]) {
         else if (strcmp(argv[1], "drop-tables") == 0) {
             drop_all_tables(conn);
         }
-        else if (strcmp(argv[1], "show-users") == 0) {
-            show_users(conn);
+        else if (strncmp(argv[1], "show-", 5) == 0) {
+            ShowFilter filter;
+            if (show_parse_args(argc - 2, argv + 2, &filter) < 0 ||
+                show_table(conn, argv[1] + 5, &filter) < 0) {
+                disconnect_database(conn);
+                return 1;
+            }
         }
-        else if (strcmp(argv[1], "show-friends") == 0) {
-            show_friends(conn);
+        else if (strcmp(argv[1], "migrate") == 0) {
+            if (migrate_apply(conn, argc > 2 ? argv[2] : MIGRATIONS_DIR) < 0) {
+                disconnect_database(conn);
+                return 1;
+            }
         }
-        else if (strcmp(argv[1], "show-groups") == 0) {
-            show_groups(conn);
+        else if (strcmp(argv[1], "migrate-status") == 0) {
+            migrate_status(conn, argc > 2 ? argv[2] : MIGRATIONS_DIR);
         }
-        else if (strcmp(argv[1], "show-group-members") == 0) {
-            show_group_members(conn);
+        else if (strcmp(argv[1], "partitions") == 0) {
+            partition_list(conn);
         }
-        else if (strcmp(argv[1], "show-messages") == 0) {
-            show_messages(conn);
+        else if (strcmp(argv[1], "partitions-create") == 0) {
+            int months = argc > 2 ? atoi(argv[2]) : PARTITION_MONTHS_AHEAD;
+            if (partition_create(conn, months) < 0) {
+                disconnect_database(conn);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[1], "partitions-archive") == 0) {
+            if (argc < 3) {
+                printf("Usage: %s partitions-archive <keep_months> [dir]\n", argv[0]);
+                disconnect_database(conn);
+                return 1;
+            }
+            if (partition_archive(conn, atoi(argv[2]), argc > 3 ? argv[3] : PARTITION_ARCHIVE_DIR) < 0) {
+                disconnect_database(conn);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[1], "seed") == 0) {
+            SeedConfig config = {
+                .scale = argc > 2 ? atoi(argv[2]) : SEED_DEFAULT_SCALE,
+                .seed = argc > 3 ? strtoull(argv[3], NULL, 10) : SEED_DEFAULT_SEED,
+                .jobs = argc > 4 ? atoi(argv[4]) : SEED_DEFAULT_JOBS,
+            };
+            if (seed_database(conn, &config) < 0) {
+                disconnect_database(conn);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[1], "export") == 0 || strcmp(argv[1], "import") == 0) {
+            if (argc < 3) {
+                printf("Usage: %s %s <dir> [jobs] [table...]\n", argv[0], argv[1]);
+                disconnect_database(conn);
+                return 1;
+            }
+            int jobs = argc > 3 ? atoi(argv[3]) : TRANSFER_DEFAULT_JOBS;
+            const char **tables = argc > 4 ? (const char**)(argv + 4) : NULL;
+            int result = strcmp(argv[1], "export") == 0
+                    ? transfer_export(conn, argv[2], jobs, tables, argc > 4 ? argc - 4 : 0)
+                    : transfer_import(conn, argv[2], jobs, tables, argc > 4 ? argc - 4 : 0);
+            if (result < 0) {
+                disconnect_database(conn);
+                return 1;
+            }
         }
         else {
             printf("Unknown command: %s\n", argv[1]);
             printf("Available commands:\n");
             printf("  create-tables\n");
             printf("  drop-tables\n");
-            printf("  show-users\n");
-            printf("  show-friends\n");
-            printf("  show-groups\n");
-            printf("  show-group-members\n");
-            printf("  show-messages\n");
+            printf("  show-users | show-friends | show-groups | show-group-members |\n");
+            printf("  show-messages | show-group-messages\n");
+            printf("      [--user name] [--group id] [--since ts] [--until ts] [--limit n]\n");
+            printf("      [--format table|csv|jsonl]\n");
+            printf("  migrate [dir]\n");
+            printf("  migrate-status [dir]\n");
+            printf("  partitions\n");
+            printf("  partitions-create [months_ahead]\n");
+            printf("  partitions-archive <keep_months> [dir]\n");
+            printf("  seed [scale] [seed] [jobs]\n");
+            printf("  export <dir> [jobs] [table...]\n");
+            printf("  import <dir> [jobs] [table...]\n");
         }
     }
     else {
@@ -2,13 +2,16 @@
 #include "../database/database.h"
 #include "../helper/helper.h"
 #include "../server/group.h"
+#include "../common/router.h"
 #include "friend.h"
+#include "auth.h"
+#include "auth_pool.h"
+#include "credentials.h"
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <openssl/sha.h>
 
 // ============================================================================
 // TASK 3: Register & Manage account
@@ -52,24 +55,6 @@ int validate_password(const char *password) {
     return 1;
 }
 
-/**
- * @function hash_password: Hash password using SHA-256.
- * 
- * @param password: The password to hash.
- * @param output: Buffer to store the resulting hash (must be at least 65 bytes
- * 
- * @return: None (void function).
- */
-void hash_password(const char *password, char *output) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char*)password, strlen(password), hash);
-    
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(output + (i * 2), "%02x", hash[i]);
-    }
-    output[SHA256_DIGEST_LENGTH * 2] = '\0';
-}
-
 /**
  * @function user_exists: Check if a username already exists in the database.
  * 
@@ -94,98 +79,242 @@ int user_exists(PGconn *conn, const char *username) {
 }
 
 /**
- * @function register_user: Register a new user in the database.
+ * @function check_auth: Check if client is authenticated.
  * 
- * @param conn: Pointer to the database connection.
- * @param username: The username for the new user.
- * @param password: The password for the new user.
+ * @param client: Pointer to the client session.
  * 
- * @return: 1 if registration successful, 0 otherwise.
+ * @return: true if authenticated, false otherwise (sends error response).
+ **/
+bool check_auth(ClientSession *client) {
+    if (!client->is_authenticated) {
+        char *response = build_response(STATUS_NOT_LOGGED_IN, 
+            "Please login first");
+        send_and_free(client, response);
+        return false;
+    }
+    return true;
+}
+// ============================================================================
+// Asynchronous Credential Checks
+// ============================================================================
+
+/**
+ * @function admit_auth_attempt: Apply rate limits before a credential command does any work.
+ * 
+ * Checks the per-IP bucket, the per-username bucket (when a username is
+ * given) and, for commands that hash, the concurrent auth cap. Everything
+ * is in memory, so a refused attempt never reaches the database.
+ * 
+ * @param server: Pointer to Server structure owning the limiter.
+ * @param client: Pointer to the client session issuing the command.
+ * @param username: Account being tried, or NULL.
+ * @param needs_hash: 1 if the command will submit an auth pool job.
+ * 
+ * @return: 1 if admitted, 0 if refused (response already sent).
  */
-int register_user(PGconn *conn, const char *username, const char *password) {
-    if (!conn || !username || !password) return 0;
-    
-    char password_hash[SHA256_DIGEST_LENGTH * 2 + 1];
-    hash_password(password, password_hash);
+static int admit_auth_attempt(Server *server, ClientSession *client, const char *username, int needs_hash) {
+    int retry_after = 0;
+    
+    if (!rate_limit_take(server->rate_limiter, RATE_SCOPE_AUTH_IP, client->client_ip, &retry_after) ||
+        (username && !rate_limit_take(server->rate_limiter, RATE_SCOPE_AUTH_USER, username, &retry_after))) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "Too many attempts, retry in %d s", retry_after);
+        char *response = build_response(STATUS_RATE_LIMITED, msg);
+        send_and_free(client, response);
+        return 0;
+    }
     
-    char query[512];
-    snprintf(query, sizeof(query),
-            "INSERT INTO users (username, password_hash, is_online) "
-            "VALUES ('%s', '%s', FALSE)",
-            username, password_hash);
+    if (needs_hash && !rate_limit_admit_auth(server->rate_limiter, server->auth_inflight)) {
+        char *response = build_response(STATUS_SERVER_BUSY, "Server busy, try again");
+        send_and_free(client, response);
+        return 0;
+    }
     
-    return execute_query(conn, query);
+    return 1;
 }
 
 /**
- * @function verify_login: Verify user login credentials.
+ * @function submit_auth_job: Hand password hashing for this command to the worker pool.
  * 
- * @param conn: Pointer to the database connection.
- * @param username: The username to verify.
- * @param password: The password to verify.
+ * While the job runs the session is marked auth_pending and its further
+ * commands stay buffered, so they are handled in order once it completes.
+ * 
+ * @param server: Pointer to Server structure owning the pool.
+ * @param client: Pointer to the client session issuing the command.
+ * @param type: AUTH_JOB_REGISTER or AUTH_JOB_LOGIN.
+ * @param cmd: Parsed command carrying username and password.
+ * @param user_id: User ID (login), or -1.
+ * @param stored_hash: Stored hash to verify against (login), or NULL.
  * 
- * @return: User ID if credentials are valid, -1 otherwise.
+ * @return: 1 if queued, 0 if refused (busy response already sent).
  */
-int verify_login(PGconn *conn, const char *username, const char *password) {
-    if (!conn || !username || !password) return -1;
+static int submit_auth_job(Server *server, ClientSession *client, AuthJobType type,
+                           ParsedCommand *cmd, int user_id, const char *stored_hash) {
+    AuthJob *job = (AuthJob*)calloc(1, sizeof(AuthJob));
+    if (job) {
+        job->type = type;
+        job->socket_fd = client->socket_fd;
+        job->session_serial = client->serial;
+        job->user_id = user_id;
+        snprintf(job->username, sizeof(job->username), "%s", cmd->username);
+        snprintf(job->password, sizeof(job->password), "%s", cmd->password);
+        if (stored_hash) snprintf(job->stored_hash, sizeof(job->stored_hash), "%s", stored_hash);
+        job->submitted_ns = metrics_now_ns();
+    }
     
-    char password_hash[SHA256_DIGEST_LENGTH * 2 + 1];
-    hash_password(password, password_hash);
+    if (!job || !auth_pool_submit(server->auth_pool, job)) {
+        free(job);
+        char *response = build_response(STATUS_SERVER_BUSY, "Server busy, try again");
+        send_and_free(client, response);
+        LOG_WARN("Auth queue full, refused %s for fd=%d", type == AUTH_JOB_LOGIN ? "LOGIN" : "REGISTER",
+                 client->socket_fd);
+        return 0;
+    }
     
-    char query[512];
-    snprintf(query, sizeof(query),
-            "SELECT id, password_hash FROM users WHERE username = '%s'",
-            username);
+    client->auth_pending = 1;
+    server->auth_inflight++;
+    return 1;
+}
+
+/**
+ * @function finish_register: Store the new account once its hash is ready.
+ * 
+ * @param server: Pointer to Server structure managing database connection.
+ * @param client: Pointer to the client session that registered.
+ * @param job: Completed job.
+ * 
+ * @return: None (void function).
+ */
+static void finish_register(Server *server, ClientSession *client, AuthJob *job) {
+    char *response = NULL;
     
-    PGresult *res = execute_query_with_result(conn, query);
-    if (!res || PQntuples(res) == 0) {
-        if (res) PQclear(res);
-        return -1; // User not found
+    if (!job->ok) {
+        response = build_response(STATUS_UNDEFINED_ERROR, "Failed to hash password");
+        send_and_free(client, response);
+        return;
     }
     
-    int user_id = atoi(PQgetvalue(res, 0, 0));
-    const char *stored_hash = PQgetvalue(res, 0, 1);
-    
-    int match = (strcmp(password_hash, stored_hash) == 0);
-    PQclear(res);
+    int user_id = -1;
+    CredentialStatus status = credential_create(server->db_conn, job->username, job->new_hash, &user_id);
     
-    return match ? user_id : -1;
+    if (status == CREDENTIAL_OK) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Registration successful for %s", job->username);
+        response = build_response(STATUS_REGISTER_OK, msg);
+        send_and_free(client, response);
+        LOG_INFO("New user registered: %s (id=%d)", job->username, user_id);
+    } else if (status == CREDENTIAL_EXISTS) {
+        response = build_response(STATUS_USERNAME_EXISTS, "Username already exists");
+        send_and_free(client, response);
+    } else {
+        response = build_response(STATUS_DATABASE_ERROR, "Failed to register user");
+        send_and_free(client, response);
+    }
 }
 
 /**
- * @function update_user_status: Update user's online status.
+ * @function finish_login: Complete a login once the password has been checked.
  * 
- * @param conn: Pointer to the database connection.
- * @param user_id: The user ID to update.
- * @param is_online: 1 to set online, 0 to set offline.
+ * @param server: Pointer to Server structure managing database connection.
+ * @param client: Pointer to the client session that logged in.
+ * @param job: Completed job.
  * 
- * @return: 1 if update successful, 0 otherwise.
+ * @return: None (void function).
  */
-int update_user_status(PGconn *conn, int user_id, int is_online) {
-    char query[256];
-    snprintf(query, sizeof(query),
-            "UPDATE users SET is_online = %s WHERE id = %d",
-            is_online ? "TRUE" : "FALSE", user_id);
+static void finish_login(Server *server, ClientSession *client, AuthJob *job) {
+    char *response = NULL;
+    
+    if (!job->ok) {
+        response = build_response(STATUS_WRONG_PASSWORD, "Incorrect password");
+        send_and_free(client, response);
+        return;
+    }
     
-    return execute_query(conn, query);
+    // Another connection may have logged in as this user while hashing
+    if (server_get_client_by_username(server, job->username)) {
+        response = build_response(STATUS_ALREADY_LOGGED_IN, "User already logged in from another session");
+        send_and_free(client, response);
+        return;
+    }
+    
+    client->user_id = job->user_id;
+    client->is_authenticated = 1;
+    strncpy(client->username, job->username, MAX_USERNAME_LENGTH - 1);
+    
+    if (job->new_hash[0] && credential_update_hash(server->db_conn, job->user_id, job->new_hash)) {
+        LOG_INFO("Upgraded password hash for %s", job->username);
+    }
+    server_mark_online(server, client);
+    
+    char msg[128];
+    char token[RESUME_TOKEN_LENGTH + 1];
+    if (resume_issue(server->resume_tokens, job->user_id, job->username, token, sizeof(token))) {
+        snprintf(msg, sizeof(msg), "Welcome %s resume=%s", job->username, token);
+    } else {
+        snprintf(msg, sizeof(msg), "Welcome %s", job->username);
+    }
+    response = build_response(STATUS_LOGIN_OK, msg);
+    send_and_free(client, response);
+    
+    LOG_INFO("User logged in: %s (id=%d, fd=%d)", 
+           job->username, job->user_id, client->socket_fd);
+    send_pending_notifications(server, client);
 }
 
 /**
- * @function check_auth: Check if client is authenticated.
+ * @function auth_handle_completions: Finish every REGISTER/LOGIN whose hashing is done.
  * 
- * @param client: Pointer to the client session.
+ * Called from the event loop when the pool's wakeup descriptor is readable.
+ * Jobs whose session disconnected meanwhile are discarded. Each completion
+ * is recorded in metrics and log.txt as the command's result, after which
+ * any commands the client sent while waiting are processed.
  * 
- * @return: true if authenticated, false otherwise (sends error response).
- **/
-bool check_auth(ClientSession *client) {
-    if (!client->is_authenticated) {
-        char *response = build_response(STATUS_NOT_LOGGED_IN, 
-            "Please login first");
-        send_and_free(client, response);
-        return false;
+ * @param server: Pointer to the server instance.
+ * 
+ * @return: None (void function).
+ */
+void auth_handle_completions(Server *server) {
+    if (!server) return;
+    
+    AuthJob *job = auth_pool_take_completed(server->auth_pool);
+    while (job) {
+        AuthJob *next = job->next;
+        ClientSession *client = server_get_client_by_fd(server, job->socket_fd);
+        server->auth_inflight--;
+        
+        if (client && client->serial == job->session_serial && client->auth_pending) {
+            CommandType cmd_type = job->type == AUTH_JOB_LOGIN ? CMD_LOGIN : CMD_REGISTER;
+            metrics_begin_request();
+            metrics_set_command(cmd_type);
+            client->auth_pending = 0;
+            
+            if (job->type == AUTH_JOB_LOGIN) {
+                finish_login(server, client, job);
+            } else {
+                finish_register(server, client, job);
+            }
+            
+            metrics_record_request(server->metrics, cmd_type, client->last_response_code,
+                                   metrics_now_ns() - job->submitted_ns);
+            
+            char cmd_detail[128];
+            char result_code[16];
+            snprintf(cmd_detail, sizeof(cmd_detail), "username=%s", job->username);
+            snprintf(result_code, sizeof(result_code), "%d", client->last_response_code);
+            log_activity(client->is_authenticated ? client->username : "Guest",
+                         job->type == AUTH_JOB_LOGIN ? "LOGIN" : "REGISTER", cmd_detail,
+                         result_code, router_status_detail(client->last_response_code));
+            
+            server_process_buffered(server, client);
+        } else {
+            LOG_DEBUG("Dropped auth result for closed fd=%d", job->socket_fd);
+        }
+        
+        free(job);
+        job = next;
     }
-    return true;
 }
+
 // ============================================================================
 // Command Handlers
 // ============================================================================
@@ -229,22 +358,10 @@ void handle_register_command(Server *server, ClientSession *client, ParsedComman
         return;
     }
     
-    if (user_exists(server->db_conn, cmd->username)) {
-        response = build_response(STATUS_USERNAME_EXISTS, "Username already exists");
-        send_and_free(client, response);
-        return;
-    }
+    if (!admit_auth_attempt(server, client, NULL, 1)) return;
     
-    if (register_user(server->db_conn, cmd->username, cmd->password)) {
-        char msg[128];
-        snprintf(msg, sizeof(msg), "Registration successful for %s", cmd->username);
-        response = build_response(STATUS_REGISTER_OK, msg);
-        send_and_free(client, response);
-        printf("New user registered: %s\n", cmd->username);
-    } else {
-        response = build_response(STATUS_DATABASE_ERROR, "Failed to register user");
-        send_and_free(client, response);
-    }
+    // Duplicate names are detected by the INSERT in finish_register()
+    submit_auth_job(server, client, AUTH_JOB_REGISTER, cmd, -1, NULL);
 }
 
 /**
@@ -280,32 +397,25 @@ void handle_login_command(Server *server, ClientSession *client, ParsedCommand *
         return;
     }
     
-    int user_id = verify_login(server->db_conn, cmd->username, cmd->password);
+    if (!admit_auth_attempt(server, client, cmd->username, 1)) return;
     
-    if (user_id < 0) {
-        if (user_exists(server->db_conn, cmd->username)) {
-            response = build_response(STATUS_WRONG_PASSWORD, "Incorrect password");
-        } else {
-            response = build_response(STATUS_USER_NOT_FOUND, "User does not exist");
-        }
+    Credential credential;
+    CredentialStatus status = credential_lookup(server->db_conn, cmd->username, &credential);
+    
+    if (status == CREDENTIAL_NOT_FOUND) {
+        response = build_response(STATUS_USER_NOT_FOUND, "User does not exist");
         send_and_free(client, response);
         return;
     }
     
-    client->user_id = user_id;
-    client->is_authenticated = 1;
-    strncpy(client->username, cmd->username, MAX_USERNAME_LENGTH - 1);
-    
-    update_user_status(server->db_conn, user_id, 1);
-    
-    char msg[128];
-    snprintf(msg, sizeof(msg), "Welcome %s", cmd->username);
-    response = build_response(STATUS_LOGIN_OK, msg);
-    send_and_free(client, response);
+    if (status != CREDENTIAL_OK) {
+        response = build_response(STATUS_DATABASE_ERROR, "Failed to look up user");
+        send_and_free(client, response);
+        return;
+    }
     
-    printf("User logged in: %s (id=%d, fd=%d)\n", 
-           cmd->username, user_id, client->socket_fd);
-    send_pending_notifications(server, client);
+    // The hash comparison runs on a worker; finish_login() completes the command
+    submit_auth_job(server, client, AUTH_JOB_LOGIN, cmd, credential.user_id, credential.password_hash);
 }
 
 /**
@@ -329,9 +439,10 @@ void handle_logout_command(Server *server, ClientSession *client, ParsedCommand
         notify_partner_offline(server, client->username);
     }
     
-    update_user_status(server->db_conn, client->user_id, 0);
+    server_mark_offline(server, client);
+    resume_revoke_user(server->resume_tokens, client->user_id);
     
-    printf("User logged out: %s (id=%d, fd=%d)\n", 
+    LOG_INFO("User logged out: %s (id=%d, fd=%d)", 
            client->username, client->user_id, client->socket_fd);
     
     char username_copy[MAX_USERNAME_LENGTH];
@@ -339,11 +450,91 @@ void handle_logout_command(Server *server, ClientSession *client, ParsedCommand
     
     client->user_id = -1;
     client->is_authenticated = 0;
+    client->presence_subscribed = 0;
+    client->friend_list_version = -1;
+    roster_free(&client->friends);
     memset(client->username, 0, MAX_USERNAME_LENGTH);
     memset(client->current_chat_partner, 0, MAX_USERNAME_LENGTH);
+    memset(client->catchup_group, 0, MAX_USERNAME_LENGTH);
     
     char msg[128];
     snprintf(msg, sizeof(msg), "Goodbye %s", username_copy);
     response = build_response(STATUS_LOGOUT_OK, msg);
     send_and_free(client, response);
 }
+
+/**
+ * @function handle_resume_command: Restore a session from a resume token.
+ * 
+ * Skips the password check entirely: the token is looked up in memory, the
+ * user is marked online and only notifications newer than last_seen_id are
+ * replayed. A session still registered for the same user (typically a dead
+ * mobile connection the server has not noticed yet) is closed first. The
+ * token is spent; the response carries its replacement.
+ * 
+ * @param server Pointer to Server structure managing database connection.
+ * @param client Pointer to the client session reconnecting.
+ * @param cmd Pointer to parsed command (password = token, message = last_seen_id).
+ * 
+ * @return: None (void function).
+ */
+void handle_resume_command(Server *server, ClientSession *client, ParsedCommand *cmd) {
+    if (!server || !client || !cmd) return;
+    
+    char *response = NULL;
+    
+    if (client->is_authenticated) {
+        response = build_simple_response(STATUS_ALREADY_LOGGED_IN);
+        send_and_free(client, response);
+        return;
+    }
+    
+    if (cmd->param_count < 1) {
+        response = build_response(STATUS_UNDEFINED_ERROR, "Resume token required");
+        send_and_free(client, response);
+        return;
+    }
+    
+    char *end = NULL;
+    long last_seen_id = cmd->message[0] ? strtol(cmd->message, &end, 10) : 0;
+    if ((end && *end != '\0') || last_seen_id < 0 || last_seen_id > 0x7fffffff) {
+        response = build_response(STATUS_UNDEFINED_ERROR, "Invalid last_seen_id");
+        send_and_free(client, response);
+        return;
+    }
+    
+    if (!admit_auth_attempt(server, client, NULL, 0)) return;
+    
+    int user_id = -1;
+    char username[MAX_USERNAME_LENGTH];
+    if (!resume_redeem(server->resume_tokens, cmd->password, &user_id, username, sizeof(username))) {
+        response = build_response(STATUS_RESUME_INVALID, "Resume token invalid or expired, please login");
+        send_and_free(client, response);
+        return;
+    }
+    
+    ClientSession *stale = server_get_client_by_username(server, username);
+    if (stale) {
+        LOG_INFO("Resume by %s replaces session fd=%d", username, stale->socket_fd);
+        server_remove_client(server, stale->socket_fd);
+    }
+    
+    client->user_id = user_id;
+    client->is_authenticated = 1;
+    strncpy(client->username, username, MAX_USERNAME_LENGTH - 1);
+    server_mark_online(server, client);
+    
+    char msg[128];
+    char token[RESUME_TOKEN_LENGTH + 1];
+    if (resume_issue(server->resume_tokens, user_id, username, token, sizeof(token))) {
+        snprintf(msg, sizeof(msg), "Welcome back %s resume=%s", username, token);
+    } else {
+        snprintf(msg, sizeof(msg), "Welcome back %s", username);
+    }
+    response = build_response(STATUS_RESUME_OK, msg);
+    send_and_free(client, response);
+    
+    LOG_INFO("User resumed: %s (id=%d, fd=%d, last_seen=%ld)",
+           username, user_id, client->socket_fd, last_seen_id);
+    send_pending_notifications_after(server, client, (int)last_seen_id);
+}
@@ -5,6 +5,10 @@
 void handle_register_command(Server *server, ClientSession *client, ParsedCommand *cmd);
 void handle_login_command(Server *server, ClientSession *client, ParsedCommand *cmd);
 void handle_logout_command(Server *server, ClientSession *client, ParsedCommand *cmd);
+void handle_resume_command(Server *server, ClientSession *client, ParsedCommand *cmd);
+
+// Finish REGISTER/LOGIN commands whose password hashing completed
+void auth_handle_completions(Server *server);
 
 // Validation functions
 int validate_username(const char *username);
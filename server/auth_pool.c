@@ -0,0 +1,349 @@
+#include "auth_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+#define PASSWORD_SCHEME "scrypt"
+#define LEGACY_HASH_LENGTH (SHA256_DIGEST_LENGTH * 2)
+
+struct AuthPool {
+    pthread_t threads[AUTH_POOL_MAX_WORKERS];
+    int workers;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    AuthJob *pending_head;               // FIFO: a login storm is served in arrival order
+    AuthJob *pending_tail;
+    int pending_count;
+    AuthJob *done;                       // Completed jobs, any order
+    int stopping;
+    int pipe_fds[2];                     // Workers write a byte per completion; the loop selects on [0]
+};
+
+// ============================================================================
+// Password Hashing
+// ============================================================================
+
+/**
+ * @function to_hex: Lowercase hex encoding.
+ */
+static void to_hex(const unsigned char *data, size_t len, char *out) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[i * 2] = digits[data[i] >> 4];
+        out[i * 2 + 1] = digits[data[i] & 0x0f];
+    }
+    out[len * 2] = '\0';
+}
+
+/**
+ * @function from_hex: Decode exactly len bytes of hex.
+ *
+ * @return 1 on success, 0 on malformed input.
+ */
+static int from_hex(const char *hex, unsigned char *out, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned int byte;
+        if (sscanf(hex + i * 2, "%2x", &byte) != 1) return 0;
+        out[i] = (unsigned char)byte;
+    }
+    return hex[len * 2] == '\0' || hex[len * 2] == '$';
+}
+
+/**
+ * @function scrypt_key: Derive the scrypt key for a password and salt.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int scrypt_key(const char *password, const unsigned char *salt, int log_n, int r, int p,
+                      unsigned char *key) {
+    uint64_t n = (uint64_t)1 << log_n;
+    uint64_t maxmem = 128 * (uint64_t)r * (n + (uint64_t)p + 2) + (1 << 20);
+    return EVP_PBE_scrypt(password, strlen(password), salt, PASSWORD_SALT_BYTES,
+                          n, (uint64_t)r, (uint64_t)p, maxmem, key, PASSWORD_KEY_BYTES) == 1;
+}
+
+/**
+ * @function password_hash: Hash a password with a fresh random salt.
+ *
+ * Output format: scrypt$<log2 N>$<r>$<p>$<salt hex>$<key hex>
+ *
+ * @param password Plain-text password.
+ * @param output Destination buffer.
+ * @param size Buffer size (PASSWORD_HASH_MAX is enough).
+ *
+ * @return 1 on success, 0 on failure.
+ */
+int password_hash(const char *password, char *output, size_t size) {
+    unsigned char salt[PASSWORD_SALT_BYTES];
+    unsigned char key[PASSWORD_KEY_BYTES];
+    char salt_hex[PASSWORD_SALT_BYTES * 2 + 1];
+    char key_hex[PASSWORD_KEY_BYTES * 2 + 1];
+
+    if (!password || RAND_bytes(salt, sizeof(salt)) != 1) return 0;
+    if (!scrypt_key(password, salt, PASSWORD_SCRYPT_LOG_N, PASSWORD_SCRYPT_R, PASSWORD_SCRYPT_P, key)) return 0;
+
+    to_hex(salt, sizeof(salt), salt_hex);
+    to_hex(key, sizeof(key), key_hex);
+    OPENSSL_cleanse(key, sizeof(key));
+
+    int len = snprintf(output, size, PASSWORD_SCHEME "$%d$%d$%d$%s$%s",
+                       PASSWORD_SCRYPT_LOG_N, PASSWORD_SCRYPT_R, PASSWORD_SCRYPT_P, salt_hex, key_hex);
+    return len > 0 && (size_t)len < size;
+}
+
+/**
+ * @function password_verify: Check a password against a stored hash.
+ *
+ * @param password Plain-text password.
+ * @param stored Stored hash (scrypt string or legacy SHA-256 hex).
+ * @param needs_upgrade Set to 1 when the stored hash uses an outdated scheme or cost.
+ *
+ * @return 1 if the password matches, 0 otherwise.
+ */
+int password_verify(const char *password, const char *stored, int *needs_upgrade) {
+    if (needs_upgrade) *needs_upgrade = 0;
+    if (!password || !stored) return 0;
+
+    if (strlen(stored) == LEGACY_HASH_LENGTH) {
+        unsigned char digest[SHA256_DIGEST_LENGTH];
+        char hex[LEGACY_HASH_LENGTH + 1];
+        SHA256((const unsigned char*)password, strlen(password), digest);
+        to_hex(digest, sizeof(digest), hex);
+        int match = CRYPTO_memcmp(hex, stored, LEGACY_HASH_LENGTH) == 0;
+        if (match && needs_upgrade) *needs_upgrade = 1;
+        return match;
+    }
+
+    int log_n, r, p, offset = 0;
+    if (sscanf(stored, PASSWORD_SCHEME "$%d$%d$%d$%n", &log_n, &r, &p, &offset) != 3 || offset == 0) return 0;
+    if (log_n < 1 || log_n > 24 || r < 1 || r > 32 || p < 1 || p > 16) return 0;
+
+    unsigned char salt[PASSWORD_SALT_BYTES];
+    unsigned char expected[PASSWORD_KEY_BYTES];
+    unsigned char key[PASSWORD_KEY_BYTES];
+    const char *salt_hex = stored + offset;
+    const char *key_hex = strchr(salt_hex, '$');
+    if (!key_hex || key_hex - salt_hex != PASSWORD_SALT_BYTES * 2) return 0;
+    if (!from_hex(salt_hex, salt, sizeof(salt)) || !from_hex(key_hex + 1, expected, sizeof(expected))) return 0;
+
+    if (!scrypt_key(password, salt, log_n, r, p, key)) return 0;
+    int match = CRYPTO_memcmp(key, expected, sizeof(key)) == 0;
+    OPENSSL_cleanse(key, sizeof(key));
+
+    if (match && needs_upgrade) {
+        *needs_upgrade = log_n != PASSWORD_SCRYPT_LOG_N || r != PASSWORD_SCRYPT_R || p != PASSWORD_SCRYPT_P;
+    }
+    return match;
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+/**
+ * @function run_job: Do the hashing for one job (worker thread).
+ */
+static void run_job(AuthJob *job) {
+    if (job->type == AUTH_JOB_REGISTER) {
+        job->ok = password_hash(job->password, job->new_hash, sizeof(job->new_hash));
+    } else {
+        int needs_upgrade = 0;
+        job->ok = password_verify(job->password, job->stored_hash, &needs_upgrade);
+        if (job->ok && needs_upgrade && !password_hash(job->password, job->new_hash, sizeof(job->new_hash))) {
+            job->new_hash[0] = '\0';
+        }
+    }
+    OPENSSL_cleanse(job->password, sizeof(job->password));
+}
+
+/**
+ * @function worker_main: Take pending jobs until the pool stops.
+ */
+static void *worker_main(void *arg) {
+    AuthPool *pool = (AuthPool*)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->pending_head && !pool->stopping) {
+            pthread_cond_wait(&pool->ready, &pool->lock);
+        }
+        if (pool->stopping) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        AuthJob *job = pool->pending_head;
+        pool->pending_head = job->next;
+        if (!pool->pending_head) pool->pending_tail = NULL;
+        pool->pending_count--;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_job(job);
+
+        pthread_mutex_lock(&pool->lock);
+        job->next = pool->done;
+        pool->done = job;
+        pthread_mutex_unlock(&pool->lock);
+
+        // Wake the event loop; a full pipe already guarantees a wakeup
+        char byte = 1;
+        ssize_t written;
+        do {
+            written = write(pool->pipe_fds[1], &byte, 1);
+        } while (written < 0 && errno == EINTR);
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @function auth_pool_create: Start the hashing workers.
+ *
+ * @param workers Thread count; <= 0 reads CHAT_AUTH_WORKERS, falling back to
+ *                one less than the online CPUs (at least 1).
+ *
+ * @return Pool, or NULL on failure.
+ */
+AuthPool* auth_pool_create(int workers) {
+    if (workers <= 0) {
+        const char *env = getenv("CHAT_AUTH_WORKERS");
+        workers = env ? atoi(env) : (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    }
+    if (workers < 1) workers = 1;
+    if (workers > AUTH_POOL_MAX_WORKERS) workers = AUTH_POOL_MAX_WORKERS;
+
+    AuthPool *pool = (AuthPool*)calloc(1, sizeof(AuthPool));
+    if (!pool) return NULL;
+
+    if (pipe(pool->pipe_fds) != 0) {
+        free(pool);
+        return NULL;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(pool->pipe_fds[i], F_SETFL, fcntl(pool->pipe_fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(pool->pipe_fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->ready, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) break;
+        pool->workers++;
+    }
+    if (pool->workers == 0) {
+        auth_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+/**
+ * @function auth_pool_destroy: Stop the workers and free all jobs.
+ *
+ * Jobs still queued are dropped; a worker finishes the hash it is on first.
+ */
+void auth_pool_destroy(AuthPool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->workers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    AuthJob *lists[2] = { pool->pending_head, pool->done };
+    for (int l = 0; l < 2; l++) {
+        while (lists[l]) {
+            AuthJob *next = lists[l]->next;
+            OPENSSL_cleanse(lists[l]->password, sizeof(lists[l]->password));
+            free(lists[l]);
+            lists[l] = next;
+        }
+    }
+
+    close(pool->pipe_fds[0]);
+    close(pool->pipe_fds[1]);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->ready);
+    free(pool);
+}
+
+/**
+ * @function auth_pool_submit: Queue a job; ownership passes to the pool.
+ *
+ * @return 1 if queued, 0 if the queue is full (caller still owns the job).
+ */
+int auth_pool_submit(AuthPool *pool, AuthJob *job) {
+    if (!pool || !job) return 0;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->pending_count >= AUTH_POOL_QUEUE_LIMIT) {
+        pthread_mutex_unlock(&pool->lock);
+        return 0;
+    }
+    job->next = NULL;
+    if (pool->pending_tail) pool->pending_tail->next = job;
+    else pool->pending_head = job;
+    pool->pending_tail = job;
+    pool->pending_count++;
+    pthread_cond_signal(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+    return 1;
+}
+
+/**
+ * @function auth_pool_fd: Descriptor that becomes readable when jobs complete.
+ */
+int auth_pool_fd(const AuthPool *pool) {
+    return pool ? pool->pipe_fds[0] : -1;
+}
+
+/**
+ * @function auth_pool_take_completed: Detach every completed job.
+ *
+ * Drains the wakeup pipe first, so a completion racing with this call
+ * leaves a byte behind and is picked up on the next select().
+ *
+ * @return Linked list of jobs (caller frees each), or NULL.
+ */
+AuthJob* auth_pool_take_completed(AuthPool *pool) {
+    if (!pool) return NULL;
+
+    char drain[64];
+    while (read(pool->pipe_fds[0], drain, sizeof(drain)) > 0) {}
+
+    pthread_mutex_lock(&pool->lock);
+    AuthJob *done = pool->done;
+    pool->done = NULL;
+    pthread_mutex_unlock(&pool->lock);
+    return done;
+}
+
+/**
+ * @function auth_pool_workers: Number of worker threads.
+ */
+int auth_pool_workers(const AuthPool *pool) {
+    return pool ? pool->workers : 0;
+}
+
+/**
+ * @function auth_pool_queued: Jobs waiting for a worker.
+ */
+int auth_pool_queued(AuthPool *pool) {
+    if (!pool) return 0;
+    pthread_mutex_lock(&pool->lock);
+    int queued = pool->pending_count;
+    pthread_mutex_unlock(&pool->lock);
+    return queued;
+}
@@ -0,0 +1,70 @@
+// ============================================================================
+// auth_pool.h - Password hashing off the event loop
+// ============================================================================
+//
+// Passwords are stored as salted scrypt hashes, which cost tens of
+// milliseconds of CPU each by design. REGISTER and LOGIN hand that work to a
+// small pool of worker threads; the event loop keeps serving other clients
+// and picks up finished jobs through a self-pipe that sits in its select()
+// set. Workers only hash: every database call and socket write stays on the
+// event-loop thread.
+//
+// Legacy unsalted SHA-256 hex hashes still verify, and are replaced with an
+// scrypt hash on the next successful login.
+
+#ifndef AUTH_POOL_H
+#define AUTH_POOL_H
+
+#include <stdint.h>
+#include "../common/protocol.h"
+
+#define PASSWORD_HASH_MAX 160
+#define PASSWORD_SCRYPT_LOG_N 14         // N = 2^14, r = 8: 16 MiB and ~50 ms per hash
+#define PASSWORD_SCRYPT_R 8
+#define PASSWORD_SCRYPT_P 1
+#define PASSWORD_SALT_BYTES 16
+#define PASSWORD_KEY_BYTES 32
+
+#define AUTH_POOL_MAX_WORKERS 16
+#define AUTH_POOL_QUEUE_LIMIT 256        // Jobs waiting for a worker before new ones are refused
+
+typedef enum {
+    AUTH_JOB_REGISTER,                   // Produce new_hash for password
+    AUTH_JOB_LOGIN                       // Check password against stored_hash
+} AuthJobType;
+
+typedef struct AuthJob {
+    AuthJobType type;
+    int socket_fd;                       // Session that asked, re-validated on completion
+    uint64_t session_serial;
+    int user_id;
+    char username[MAX_USERNAME_LENGTH];
+    char password[MAX_PASSWORD_LENGTH + 1];
+    char stored_hash[PASSWORD_HASH_MAX];
+    uint64_t submitted_ns;
+
+    // Results
+    int ok;                              // LOGIN: password matches; REGISTER: hash produced
+    char new_hash[PASSWORD_HASH_MAX];    // REGISTER, or LOGIN with a legacy hash to upgrade
+
+    struct AuthJob *next;
+} AuthJob;
+
+typedef struct AuthPool AuthPool;
+
+// Lifecycle (workers <= 0: CHAT_AUTH_WORKERS, else online CPUs - 1)
+AuthPool* auth_pool_create(int workers);
+void auth_pool_destroy(AuthPool *pool);
+
+// Event loop side
+int auth_pool_submit(AuthPool *pool, AuthJob *job);
+int auth_pool_fd(const AuthPool *pool);
+AuthJob* auth_pool_take_completed(AuthPool *pool);
+int auth_pool_workers(const AuthPool *pool);
+int auth_pool_queued(AuthPool *pool);
+
+// Password hashing (thread-safe, blocking)
+int password_hash(const char *password, char *output, size_t size);
+int password_verify(const char *password, const char *stored, int *needs_upgrade);
+
+#endif
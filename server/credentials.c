@@ -0,0 +1,105 @@
+#include "credentials.h"
+#include "../common/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @function credential_lookup: Fetch a user's id and stored password hash.
+ * 
+ * @param conn: Pointer to the database connection.
+ * @param username: The username to look up.
+ * @param out: Receives the user ID and hash when found.
+ * 
+ * @return: CREDENTIAL_OK, CREDENTIAL_NOT_FOUND or CREDENTIAL_ERROR.
+ */
+CredentialStatus credential_lookup(PGconn *conn, const char *username, Credential *out) {
+    if (!conn || !username || !out) return CREDENTIAL_ERROR;
+    
+    const char *paramValues[1] = {username};
+    PGresult *res = PQexecParams(conn,
+            "SELECT id, password_hash FROM users WHERE username = $1",
+            1, NULL, paramValues, NULL, NULL, 0);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("Credential lookup failed: %s", PQerrorMessage(conn));
+        PQclear(res);
+        return CREDENTIAL_ERROR;
+    }
+    
+    if (PQntuples(res) == 0) {
+        PQclear(res);
+        return CREDENTIAL_NOT_FOUND;
+    }
+    
+    out->user_id = atoi(PQgetvalue(res, 0, 0));
+    snprintf(out->password_hash, sizeof(out->password_hash), "%s", PQgetvalue(res, 0, 1));
+    PQclear(res);
+    return CREDENTIAL_OK;
+}
+
+/**
+ * @function credential_create: Insert a new account unless the username is taken.
+ * 
+ * ON CONFLICT DO NOTHING makes the uniqueness check part of the INSERT, so
+ * two clients registering the same name at once get one success and one
+ * CREDENTIAL_EXISTS instead of a constraint error.
+ * 
+ * @param conn: Pointer to the database connection.
+ * @param username: The username for the new user.
+ * @param password_hash: Salted hash produced by password_hash().
+ * @param user_id: Receives the new user ID (may be NULL).
+ * 
+ * @return: CREDENTIAL_OK, CREDENTIAL_EXISTS or CREDENTIAL_ERROR.
+ */
+CredentialStatus credential_create(PGconn *conn, const char *username, const char *password_hash, int *user_id) {
+    if (!conn || !username || !password_hash) return CREDENTIAL_ERROR;
+    
+    const char *paramValues[2] = {username, password_hash};
+    PGresult *res = PQexecParams(conn,
+            "INSERT INTO users (username, password_hash, is_online) "
+            "VALUES ($1, $2, FALSE) "
+            "ON CONFLICT (username) DO NOTHING RETURNING id",
+            2, NULL, paramValues, NULL, NULL, 0);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("Failed to create user %s: %s", username, PQerrorMessage(conn));
+        PQclear(res);
+        return CREDENTIAL_ERROR;
+    }
+    
+    CredentialStatus status = CREDENTIAL_EXISTS;
+    if (PQntuples(res) == 1) {
+        if (user_id) *user_id = atoi(PQgetvalue(res, 0, 0));
+        status = CREDENTIAL_OK;
+    }
+    PQclear(res);
+    return status;
+}
+
+/**
+ * @function credential_update_hash: Replace a user's stored hash (after a legacy-hash login).
+ * 
+ * @param conn: Pointer to the database connection.
+ * @param user_id: The user ID to update.
+ * @param password_hash: New salted hash.
+ * 
+ * @return: 1 if update successful, 0 otherwise.
+ */
+int credential_update_hash(PGconn *conn, int user_id, const char *password_hash) {
+    if (!conn || !password_hash) return 0;
+    
+    char id_str[16];
+    snprintf(id_str, sizeof(id_str), "%d", user_id);
+    const char *paramValues[2] = {password_hash, id_str};
+    PGresult *res = PQexecParams(conn,
+            "UPDATE users SET password_hash = $1 WHERE id = $2::int",
+            2, NULL, paramValues, NULL, NULL, 0);
+    
+    int success = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (!success) {
+        LOG_WARN("Failed to upgrade password hash for id=%d: %s", user_id, PQerrorMessage(conn));
+    }
+    PQclear(res);
+    return success;
+}
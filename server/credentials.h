@@ -0,0 +1,26 @@
+#ifndef CREDENTIALS_H
+#define CREDENTIALS_H
+
+#include <libpq-fe.h>
+#include "auth_pool.h"
+
+// Account storage for REGISTER/LOGIN. Each call is a single parameterized
+// statement on the users.username unique index, so LOGIN needs one lookup
+// and REGISTER one INSERT, with the existence check folded into the statement.
+typedef enum {
+    CREDENTIAL_OK,              // Lookup: user found. Create: account inserted
+    CREDENTIAL_NOT_FOUND,       // Lookup: no such user
+    CREDENTIAL_EXISTS,          // Create: username already taken
+    CREDENTIAL_ERROR            // Database error
+} CredentialStatus;
+
+typedef struct {
+    int user_id;
+    char password_hash[PASSWORD_HASH_MAX];
+} Credential;
+
+CredentialStatus credential_lookup(PGconn *conn, const char *username, Credential *out);
+CredentialStatus credential_create(PGconn *conn, const char *username, const char *password_hash, int *user_id);
+int credential_update_hash(PGconn *conn, int user_id, const char *password_hash);
+
+#endif
@@ -0,0 +1,682 @@
+#include "../server/exporter.h"
+#include "../common/metrics.h"
+#include "../common/query_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Growable text buffer for one scrape
+typedef struct {
+    char *data;
+    size_t len;
+    size_t capacity;
+} TextBuffer;
+
+static const double summary_quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+static const char *phase_labels[METRIC_KINDS] = { "total", "db", "send" };
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @function text_appendf: Append formatted text, growing the buffer as needed.
+ *
+ * @param buf Pointer to the TextBuffer.
+ * @param format printf-style format.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int text_appendf(TextBuffer *buf, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static int text_appendf(TextBuffer *buf, const char *format, ...) {
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int needed = vsnprintf(buf->data + buf->len, buf->capacity - buf->len, format, args);
+        va_end(args);
+
+        if (needed < 0) return 0;
+        if (buf->len + (size_t)needed < buf->capacity) {
+            buf->len += (size_t)needed;
+            return 1;
+        }
+
+        size_t capacity = buf->capacity * 2;
+        while (capacity <= buf->len + (size_t)needed) capacity *= 2;
+        char *grown = (char*)realloc(buf->data, capacity);
+        if (!grown) return 0;
+        buf->data = grown;
+        buf->capacity = capacity;
+    }
+}
+
+/**
+ * @function append_label_value: Append a label value with backslash, quote and newline escaped.
+ *
+ * @param buf Output buffer.
+ * @param value Raw label value.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int append_label_value(TextBuffer *buf, const char *value) {
+    char escaped[QUERY_SQL_MAX * 2];
+    size_t len = 0;
+    for (const char *p = value; *p && len + 2 < sizeof(escaped); p++) {
+        if (*p == '\\' || *p == '"') {
+            escaped[len++] = '\\';
+            escaped[len++] = *p;
+        } else if (*p == '\n') {
+            escaped[len++] = '\\';
+            escaped[len++] = 'n';
+        } else {
+            escaped[len++] = *p;
+        }
+    }
+    escaped[len] = '\0';
+    return text_appendf(buf, "%s", escaped);
+}
+
+/**
+ * @function set_nonblocking: Put a socket in non-blocking mode.
+ *
+ * @param fd Socket descriptor.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/**
+ * @function exporter_conn_close: Close a scrape connection and free its slot.
+ *
+ * @param conn Pointer to the ExporterConn.
+ *
+ * @return void
+ */
+static void exporter_conn_close(ExporterConn *conn) {
+    if (conn->fd >= 0) close(conn->fd);
+    free(conn->response);
+    memset(conn, 0, sizeof(ExporterConn));
+    conn->fd = -1;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+/**
+ * @function exporter_create: Open the metrics listener.
+ *
+ * @param address A TCP port number (bound to 127.0.0.1 only) or a Unix
+ *                socket path (anything containing '/').
+ *
+ * @return Pointer to the new Exporter, or NULL on failure.
+ */
+Exporter* exporter_create(const char *address) {
+    if (!address || !*address) return NULL;
+
+    Exporter *exporter = (Exporter*)calloc(1, sizeof(Exporter));
+    if (!exporter) return NULL;
+    for (int i = 0; i < EXPORTER_MAX_CONNS; i++) {
+        exporter->conns[i].fd = -1;
+    }
+
+    if (strchr(address, '/')) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(address) >= sizeof(addr.sun_path)) {
+            LOG_ERROR("Metrics socket path too long: %s", address);
+            free(exporter);
+            return NULL;
+        }
+        strcpy(addr.sun_path, address);
+        strcpy(exporter->unix_path, address);
+
+        exporter->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(address);
+        if (exporter->listen_fd < 0 ||
+            bind(exporter->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            perror("Metrics bind failed");
+            if (exporter->listen_fd >= 0) close(exporter->listen_fd);
+            free(exporter);
+            return NULL;
+        }
+    } else {
+        int port = atoi(address);
+        if (port <= 0 || port > 65535) {
+            LOG_ERROR("Invalid metrics port: %s", address);
+            free(exporter);
+            return NULL;
+        }
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+
+        exporter->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        if (exporter->listen_fd < 0 ||
+            setsockopt(exporter->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0 ||
+            bind(exporter->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            perror("Metrics bind failed");
+            if (exporter->listen_fd >= 0) close(exporter->listen_fd);
+            free(exporter);
+            return NULL;
+        }
+    }
+
+    if (listen(exporter->listen_fd, EXPORTER_MAX_CONNS) < 0 || set_nonblocking(exporter->listen_fd) < 0) {
+        perror("Metrics listen failed");
+        exporter_destroy(exporter);
+        return NULL;
+    }
+
+    LOG_INFO("Metrics endpoint listening on %s%s",
+           exporter->unix_path[0] ? "" : "127.0.0.1:", address);
+    return exporter;
+}
+
+/**
+ * @function exporter_destroy: Close the listener and every scrape connection.
+ *
+ * @param exporter Pointer to the Exporter.
+ *
+ * @return void
+ */
+void exporter_destroy(Exporter *exporter) {
+    if (!exporter) return;
+
+    for (int i = 0; i < EXPORTER_MAX_CONNS; i++) {
+        exporter_conn_close(&exporter->conns[i]);
+    }
+    if (exporter->listen_fd >= 0) close(exporter->listen_fd);
+    if (exporter->unix_path[0]) unlink(exporter->unix_path);
+    free(exporter);
+}
+
+// ============================================================================
+// Event Loop Integration
+// ============================================================================
+
+/**
+ * @function exporter_fill_fdsets: Add the listener and scrape connections to select() sets.
+ *
+ * Also drops scrapes that have been open longer than EXPORTER_IDLE_TIMEOUT.
+ *
+ * @param exporter Pointer to the Exporter (may be NULL).
+ * @param read_fds Read set to extend.
+ * @param write_fds Write set to extend.
+ * @param max_fd Current highest descriptor.
+ *
+ * @return New highest descriptor.
+ */
+int exporter_fill_fdsets(Exporter *exporter, fd_set *read_fds, fd_set *write_fds, int max_fd) {
+    if (!exporter) return max_fd;
+
+    time_t now = time(NULL);
+    FD_SET(exporter->listen_fd, read_fds);
+    if (exporter->listen_fd > max_fd) max_fd = exporter->listen_fd;
+
+    for (int i = 0; i < EXPORTER_MAX_CONNS; i++) {
+        ExporterConn *conn = &exporter->conns[i];
+        if (conn->fd < 0) continue;
+
+        if (now - conn->opened > EXPORTER_IDLE_TIMEOUT) {
+            exporter_conn_close(conn);
+            continue;
+        }
+
+        if (conn->response) {
+            FD_SET(conn->fd, write_fds);
+        } else {
+            FD_SET(conn->fd, read_fds);
+        }
+        if (conn->fd > max_fd) max_fd = conn->fd;
+    }
+
+    return max_fd;
+}
+
+/**
+ * @function exporter_prepare_response: Build the HTTP response for a complete request.
+ *
+ * @param server Pointer to the Server instance.
+ * @param conn Scrape connection whose request has been read.
+ *
+ * @return void
+ */
+static void exporter_prepare_response(Server *server, ExporterConn *conn) {
+    const char *status = "200 OK";
+    char *body = NULL;
+
+    if (strncmp(conn->request, "GET /metrics", 12) == 0 || strncmp(conn->request, "GET / ", 6) == 0) {
+        body = exporter_render(server);
+        if (!body) status = "500 Internal Server Error";
+    } else {
+        status = "404 Not Found";
+    }
+
+    const char *content = body ? body : "";
+    size_t body_len = strlen(content);
+    size_t size = body_len + 256;
+    conn->response = (char*)malloc(size);
+    if (conn->response) {
+        conn->response_len = (size_t)snprintf(conn->response, size,
+                "HTTP/1.0 %s\r\n"
+                "Content-Type: text/plain; version=0.0.4\r\n"
+                "Content-Length: %zu\r\n"
+                "Connection: close\r\n\r\n%s",
+                status, body_len, content);
+        conn->response_sent = 0;
+    }
+    free(body);
+}
+
+/**
+ * @function exporter_handle_events: Accept, read and write scrape connections that are ready.
+ *
+ * @param server Pointer to the Server instance.
+ * @param read_fds Readable descriptors from select().
+ * @param write_fds Writable descriptors from select().
+ *
+ * @return void
+ */
+void exporter_handle_events(Server *server, fd_set *read_fds, fd_set *write_fds) {
+    Exporter *exporter = server ? server->exporter : NULL;
+    if (!exporter) return;
+
+    if (FD_ISSET(exporter->listen_fd, read_fds)) {
+        for (;;) {
+            int fd = accept(exporter->listen_fd, NULL, NULL);
+            if (fd < 0) break;
+
+            ExporterConn *slot = NULL;
+            for (int i = 0; i < EXPORTER_MAX_CONNS && !slot; i++) {
+                if (exporter->conns[i].fd < 0) slot = &exporter->conns[i];
+            }
+            if (!slot || set_nonblocking(fd) < 0) {
+                close(fd);
+                continue;
+            }
+            slot->fd = fd;
+            slot->opened = time(NULL);
+        }
+    }
+
+    for (int i = 0; i < EXPORTER_MAX_CONNS; i++) {
+        ExporterConn *conn = &exporter->conns[i];
+        if (conn->fd < 0) continue;
+
+        if (!conn->response && FD_ISSET(conn->fd, read_fds)) {
+            ssize_t n = recv(conn->fd, conn->request + conn->request_len,
+                             sizeof(conn->request) - conn->request_len - 1, 0);
+            if (n <= 0) {
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+                exporter_conn_close(conn);
+                continue;
+            }
+            conn->request_len += (size_t)n;
+            conn->request[conn->request_len] = '\0';
+
+            if (strstr(conn->request, "\r\n\r\n") || strstr(conn->request, "\n\n") ||
+                conn->request_len >= sizeof(conn->request) - 1) {
+                exporter->scrapes++;
+                exporter_prepare_response(server, conn);
+                if (!conn->response) exporter_conn_close(conn);
+            }
+            continue;
+        }
+
+        if (conn->response && FD_ISSET(conn->fd, write_fds)) {
+            ssize_t n = send(conn->fd, conn->response + conn->response_sent,
+                             conn->response_len - conn->response_sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                exporter_conn_close(conn);
+                continue;
+            }
+            conn->response_sent += (size_t)n;
+            if (conn->response_sent >= conn->response_len) {
+                exporter_conn_close(conn);
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+/**
+ * @function render_sessions: Session counts and per-session buffer occupancy.
+ *
+ * @param server Pointer to the Server instance.
+ * @param buf Output buffer.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int render_sessions(Server *server, TextBuffer *buf) {
+    int connected = 0, authenticated = 0, compressed = 0;
+
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        ClientSession *client = server->clients[i];
+        if (!client) continue;
+        connected++;
+        if (client->is_authenticated) authenticated++;
+        if (client->compressor) compressed++;
+    }
+
+    int ok = text_appendf(buf,
+            "# HELP chat_sessions Client sessions by state.\n"
+            "# TYPE chat_sessions gauge\n"
+            "chat_sessions{state=\"connected\"} %d\n"
+            "chat_sessions{state=\"authenticated\"} %d\n"
+            "chat_sessions{state=\"compressed\"} %d\n"
+            "# HELP chat_sessions_max Session slots (MAX_CLIENTS).\n"
+            "# TYPE chat_sessions_max gauge\n"
+            "chat_sessions_max %d\n"
+            "# HELP chat_presence_online Users online in the presence registry.\n"
+            "# TYPE chat_presence_online gauge\n"
+            "chat_presence_online %d\n",
+            connected, authenticated, compressed, MAX_CLIENTS,
+            presence_online_count(server->presence));
+
+    ok = ok && text_appendf(buf,
+            "# HELP chat_session_recv_buffer_bytes Received bytes waiting for a delimiter.\n"
+            "# TYPE chat_session_recv_buffer_bytes gauge\n");
+    for (int i = 0; i < MAX_CLIENTS && ok; i++) {
+        ClientSession *client = server->clients[i];
+        if (!client || !client->recv_buffer) continue;
+        ok = text_appendf(buf, "chat_session_recv_buffer_bytes{fd=\"%d\",user=\"", client->socket_fd) &&
+             append_label_value(buf, client->is_authenticated ? client->username : "") &&
+             text_appendf(buf, "\"} %zu\n", client->recv_buffer->length);
+    }
+
+#ifdef TIOCOUTQ
+    ok = ok && text_appendf(buf,
+            "# HELP chat_session_send_queue_bytes Bytes queued in the kernel send buffer (TIOCOUTQ).\n"
+            "# TYPE chat_session_send_queue_bytes gauge\n");
+    for (int i = 0; i < MAX_CLIENTS && ok; i++) {
+        ClientSession *client = server->clients[i];
+        int queued = 0;
+        if (!client || ioctl(client->socket_fd, TIOCOUTQ, &queued) < 0) continue;
+        ok = text_appendf(buf, "chat_session_send_queue_bytes{fd=\"%d\",user=\"", client->socket_fd) &&
+             append_label_value(buf, client->is_authenticated ? client->username : "") &&
+             text_appendf(buf, "\"} %d\n", queued);
+    }
+#endif
+
+    return ok;
+}
+
+/**
+ * @function render_database: Connection state and aggregate query time.
+ *
+ * The server owns a single PGconn used synchronously by the event loop, so
+ * the "pool" is one connection that is never contended: there is no wait
+ * time to report, only time spent inside libpq.
+ *
+ * @param server Pointer to the Server instance.
+ * @param buf Output buffer.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int render_database(Server *server, TextBuffer *buf) {
+    uint64_t queries = 0;
+    double db_seconds = 0.0;
+
+    for (int c = 0; c < METRICS_COMMANDS; c++) {
+        const CommandMetrics *cm = &server->metrics->commands[c];
+        queries += cm->db_calls;
+        db_seconds += cm->latency[METRIC_DB]->sum / 1e6;
+    }
+
+    return text_appendf(buf,
+            "# HELP chat_db_connections Database connections by state.\n"
+            "# TYPE chat_db_connections gauge\n"
+            "chat_db_connections{state=\"open\"} %d\n"
+            "chat_db_connections{state=\"in_use\"} 0\n"
+            "# HELP chat_db_up Whether the database connection is healthy.\n"
+            "# TYPE chat_db_up gauge\n"
+            "chat_db_up %d\n"
+            "# HELP chat_db_queries_total Statements executed while handling requests.\n"
+            "# TYPE chat_db_queries_total counter\n"
+            "chat_db_queries_total %llu\n"
+            "# HELP chat_db_query_seconds_total Time spent inside libpq while handling requests.\n"
+            "# TYPE chat_db_query_seconds_total counter\n"
+            "chat_db_query_seconds_total %.6f\n",
+            server->db_conn ? 1 : 0,
+            server->db_conn && PQstatus(server->db_conn) == CONNECTION_OK ? 1 : 0,
+            (unsigned long long)queries, db_seconds);
+}
+
+/**
+ * @function render_commands: Router counters and latency summaries per command.
+ *
+ * @param server Pointer to the Server instance.
+ * @param buf Output buffer.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int render_commands(Server *server, TextBuffer *buf) {
+    const Metrics *metrics = server->metrics;
+    int ok = text_appendf(buf,
+            "# HELP chat_requests_total Requests routed, by command.\n"
+            "# TYPE chat_requests_total counter\n");
+
+    for (int c = 0; c < METRICS_COMMANDS && ok; c++) {
+        const CommandMetrics *cm = &metrics->commands[c];
+        if (cm->requests == 0) continue;
+        ok = text_appendf(buf, "chat_requests_total{command=\"%s\"} %llu\n",
+                          metrics_command_name((CommandType)c), (unsigned long long)cm->requests);
+    }
+
+    ok = ok && text_appendf(buf,
+            "# HELP chat_responses_total Final response status per command (status 0: no response).\n"
+            "# TYPE chat_responses_total counter\n");
+    for (int c = 0; c < METRICS_COMMANDS && ok; c++) {
+        const CommandMetrics *cm = &metrics->commands[c];
+        for (int s = 0; s < METRICS_MAX_STATUS && ok; s++) {
+            if (cm->status_counts[s] == 0) continue;
+            ok = text_appendf(buf, "chat_responses_total{command=\"%s\",status=\"%d\"} %llu\n",
+                              metrics_command_name((CommandType)c), s,
+                              (unsigned long long)cm->status_counts[s]);
+        }
+    }
+
+    ok = ok && text_appendf(buf,
+            "# HELP chat_request_duration_seconds Request time by command and phase (total, db, send).\n"
+            "# TYPE chat_request_duration_seconds summary\n");
+    for (int c = 0; c < METRICS_COMMANDS && ok; c++) {
+        const CommandMetrics *cm = &metrics->commands[c];
+        if (cm->requests == 0) continue;
+        const char *name = metrics_command_name((CommandType)c);
+
+        for (int k = 0; k < METRIC_KINDS && ok; k++) {
+            const Histogram *h = cm->latency[k];
+            for (size_t q = 0; q < sizeof(summary_quantiles) / sizeof(summary_quantiles[0]) && ok; q++) {
+                ok = text_appendf(buf,
+                        "chat_request_duration_seconds{command=\"%s\",phase=\"%s\",quantile=\"%g\"} %.6f\n",
+                        name, phase_labels[k], summary_quantiles[q],
+                        histogram_value_at_percentile(h, summary_quantiles[q] * 100.0) / 1e6);
+            }
+            ok = ok && text_appendf(buf,
+                    "chat_request_duration_seconds_sum{command=\"%s\",phase=\"%s\"} %.6f\n"
+                    "chat_request_duration_seconds_count{command=\"%s\",phase=\"%s\"} %llu\n",
+                    name, phase_labels[k], h->sum / 1e6,
+                    name, phase_labels[k], (unsigned long long)h->total_count);
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * @function render_statements: Per-statement DB timing keyed by normalized SQL and handler.
+ *
+ * The statement text is exported once in chat_db_statement_info; the other
+ * series carry only its id so each scrape stays small.
+ *
+ * @param buf Output buffer.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int render_statements(TextBuffer *buf) {
+    size_t count = 0;
+    const QueryStat *stats = query_stats_slots(&count);
+
+    int ok = text_appendf(buf,
+            "# HELP chat_db_statement_info Normalized text of each tracked statement.\n"
+            "# TYPE chat_db_statement_info gauge\n");
+    for (size_t i = 0; i < count && ok; i++) {
+        if (stats[i].fingerprint == 0) continue;
+        ok = text_appendf(buf, "chat_db_statement_info{id=\"%016llx\",handler=\"%s\",statement=\"",
+                          (unsigned long long)stats[i].fingerprint, stats[i].handler) &&
+             append_label_value(buf, stats[i].sql) &&
+             text_appendf(buf, "\"} 1\n");
+    }
+
+    static const struct {
+        const char *name;
+        const char *type;
+        const char *help;
+    } families[] = {
+        { "chat_db_statement_calls_total", "counter", "Executions per statement." },
+        { "chat_db_statement_rows_total", "counter", "Rows returned or affected per statement." },
+        { "chat_db_statement_seconds_total", "counter", "Wall time inside libpq per statement." },
+        { "chat_db_statement_max_seconds", "gauge", "Slowest execution per statement." },
+        { "chat_db_statement_slow_total", "counter", "Executions over the slow-query threshold." },
+    };
+
+    for (size_t f = 0; f < sizeof(families) / sizeof(families[0]) && ok; f++) {
+        ok = text_appendf(buf, "# HELP %s %s\n# TYPE %s %s\n",
+                          families[f].name, families[f].help, families[f].name, families[f].type);
+        for (size_t i = 0; i < count && ok; i++) {
+            const QueryStat *st = &stats[i];
+            if (st->fingerprint == 0) continue;
+
+            ok = text_appendf(buf, "%s{id=\"%016llx\",handler=\"%s\"} ",
+                              families[f].name, (unsigned long long)st->fingerprint, st->handler);
+            switch (f) {
+                case 0: ok = ok && text_appendf(buf, "%llu\n", (unsigned long long)st->calls); break;
+                case 1: ok = ok && text_appendf(buf, "%llu\n", (unsigned long long)st->rows); break;
+                case 2: ok = ok && text_appendf(buf, "%.6f\n", st->total_ns / 1e9); break;
+                case 3: ok = ok && text_appendf(buf, "%.6f\n", st->max_ns / 1e9); break;
+                default: ok = ok && text_appendf(buf, "%llu\n", (unsigned long long)st->slow); break;
+            }
+        }
+    }
+
+    return ok && text_appendf(buf,
+            "# HELP chat_db_statements_untracked_total Executions not tracked because the statement table was full.\n"
+            "# TYPE chat_db_statements_untracked_total counter\n"
+            "chat_db_statements_untracked_total %llu\n"
+            "# HELP chat_db_slow_statements_total Executions over the slow-query threshold.\n"
+            "# TYPE chat_db_slow_statements_total counter\n"
+            "chat_db_slow_statements_total %llu\n",
+            (unsigned long long)query_stats_untracked(),
+            (unsigned long long)query_stats_slow_total());
+}
+
+/**
+ * @function render_admission: Rate limiter rejections, paused sessions and auth pool load.
+ *
+ * @param server Pointer to the Server instance.
+ * @param buf Output buffer.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int render_admission(Server *server, TextBuffer *buf) {
+    int ok = text_appendf(buf,
+            "# HELP chat_rate_limited_total Requests refused by admission control, by scope.\n"
+            "# TYPE chat_rate_limited_total counter\n");
+    for (int scope = 0; scope < RATE_SCOPES && ok; scope++) {
+        ok = text_appendf(buf, "chat_rate_limited_total{scope=\"%s\"} %llu\n",
+                          rate_scope_name((RateScope)scope),
+                          (unsigned long long)rate_limit_rejected(server->rate_limiter, (RateScope)scope));
+    }
+
+    ok = ok && text_appendf(buf,
+            "# HELP chat_command_rate_limited_total Commands refused by per-session budgets, by class.\n"
+            "# TYPE chat_command_rate_limited_total counter\n");
+    for (int rate_class = 0; rate_class < RATE_CLASSES && ok; rate_class++) {
+        ok = text_appendf(buf, "chat_command_rate_limited_total{class=\"%s\"} %llu\n",
+                          rate_class_name((RateClass)rate_class),
+                          (unsigned long long)rate_class_rejected(server->rate_limiter, (RateClass)rate_class));
+    }
+
+    int paused = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (server->clients[i] && server->clients[i]->paused_until_ns) paused++;
+    }
+
+    return ok && text_appendf(buf,
+            "# HELP chat_session_read_pauses_total Times a flooding session stopped being read.\n"
+            "# TYPE chat_session_read_pauses_total counter\n"
+            "chat_session_read_pauses_total %llu\n"
+            "# HELP chat_sessions_paused Sessions currently not being read.\n"
+            "# TYPE chat_sessions_paused gauge\n"
+            "chat_sessions_paused %d\n"
+            "# HELP chat_auth_inflight Password checks queued or running on the auth pool.\n"
+            "# TYPE chat_auth_inflight gauge\n"
+            "chat_auth_inflight %d\n",
+            (unsigned long long)rate_limit_pauses(server->rate_limiter), paused,
+            server->auth_inflight);
+}
+
+/**
+ * @function exporter_render: Render every exported metric in Prometheus text format.
+ *
+ * @param server Pointer to the Server instance.
+ *
+ * @return Dynamically allocated exposition text, or NULL on failure.
+ */
+char* exporter_render(Server *server) {
+    if (!server || !server->metrics) return NULL;
+
+    TextBuffer buf;
+    buf.capacity = 16384;
+    buf.len = 0;
+    buf.data = (char*)malloc(buf.capacity);
+    if (!buf.data) return NULL;
+    buf.data[0] = '\0';
+
+    int ok = render_sessions(server, &buf) &&
+             render_admission(server, &buf) &&
+             render_database(server, &buf) &&
+             render_commands(server, &buf) &&
+             render_statements(&buf) &&
+             text_appendf(&buf,
+                     "# HELP chat_log_dropped_total Log lines dropped because the log sink could not keep up.\n"
+                     "# TYPE chat_log_dropped_total counter\n"
+                     "chat_log_dropped_total %llu\n"
+                     "# HELP chat_log_buffered_bytes Log bytes waiting to be written.\n"
+                     "# TYPE chat_log_buffered_bytes gauge\n"
+                     "chat_log_buffered_bytes %zu\n"
+                     "# HELP chat_metrics_scrapes_total Scrapes served by this endpoint.\n"
+                     "# TYPE chat_metrics_scrapes_total counter\n"
+                     "chat_metrics_scrapes_total %lu\n",
+                     (unsigned long long)log_dropped(), log_buffered(),
+                     server->exporter ? server->exporter->scrapes : 0UL);
+
+    if (!ok) {
+        free(buf.data);
+        return NULL;
+    }
+    return buf.data;
+}
@@ -0,0 +1,43 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <sys/select.h>
+#include "../server/server.h"
+
+// Prometheus text endpoint for server internals. Optional listener on
+// 127.0.0.1:<port> or a Unix socket path; scrapes are plain HTTP/1.0 GETs
+// served from the main select() loop over non-blocking sockets, so a slow
+// or stuck scraper never delays chat traffic.
+#define EXPORTER_MAX_CONNS 4
+#define EXPORTER_REQUEST_SIZE 2048
+#define EXPORTER_IDLE_TIMEOUT 5      // Seconds before an unfinished scrape is dropped
+
+typedef struct {
+    int fd;                          // -1 when the slot is free
+    char request[EXPORTER_REQUEST_SIZE];
+    size_t request_len;
+    char *response;                  // NULL until the request is complete
+    size_t response_len;
+    size_t response_sent;
+    time_t opened;
+} ExporterConn;
+
+struct Exporter {
+    int listen_fd;
+    char unix_path[108];             // Empty for TCP
+    ExporterConn conns[EXPORTER_MAX_CONNS];
+    unsigned long scrapes;
+};
+
+// Lifecycle
+Exporter* exporter_create(const char *address);
+void exporter_destroy(Exporter *exporter);
+
+// Event loop integration
+int exporter_fill_fdsets(Exporter *exporter, fd_set *read_fds, fd_set *write_fds, int max_fd);
+void exporter_handle_events(Server *server, fd_set *read_fds, fd_set *write_fds);
+
+// Rendering
+char* exporter_render(Server *server);
+
+#endif
@@ -6,6 +6,7 @@
 #include <string.h>
 
 #define BUFFER_SIZE 8192
+#define FRIEND_SYNC_PAGE_BYTES 3072  // Items per FRIEND_SYNC frame; keeps each frame one client read
 
 // ==================== Helper Functions ====================
 
@@ -72,13 +73,13 @@ int get_user_id_by_username(PGconn *db_conn, const char *username, int *user_id_
     
     PGresult *res = execute_query_with_result(db_conn, query);
     if (!res || PQntuples(res) == 0) {
-        printf("DEBUG: User '%s' not found\n", username);
+        LOG_DEBUG("User '%s' not found", username);
         if (res) PQclear(res);
         return 0;
     }
     
     *user_id_out = atoi(PQgetvalue(res, 0, 0));
-    printf("DEBUG: Found user '%s' with ID: %d\n", username, *user_id_out);
+    LOG_DEBUG("Found user '%s' with ID: %d", username, *user_id_out);
     PQclear(res);
     return 1;
 }
@@ -154,6 +155,43 @@ void send_error_response(ClientSession *client, int status_code, const char *mes
 
 // ==================== Friend Management Functions ====================
 
+/**
+ * @function friend_list_changed: Update the in-memory friend state of a user's sessions.
+ * 
+ * Drops the cached FRIEND_LIST_SYNC version and patches the rosters of
+ * subscribed sessions.
+ * 
+ * @param server: Pointer to Server structure.
+ * @param user_id: Owner of the friend list that changed.
+ * @param friend_id: Friend being added or removed.
+ * @param friend_name: Friend's username.
+ * @param add: 1 after FRIEND_ACCEPT, 0 after FRIEND_REMOVE.
+ * 
+ * @return: void. A new friend who is online is announced right away.
+ **/
+static void friend_list_changed(Server *server, int user_id, int friend_id, const char *friend_name, int add) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        ClientSession *session = server->clients[i];
+        if (!session || !session->is_authenticated || session->user_id != user_id) continue;
+        
+        session->friend_list_version = -1;
+        if (!session->presence_subscribed) continue;
+        
+        if (!add) {
+            roster_remove(&session->friends, friend_id);
+            continue;
+        }
+        if (roster_add(&session->friends, friend_id, friend_name) &&
+            presence_get(server->presence, friend_id) == PRESENCE_ONLINE) {
+            char event[128];
+            snprintf(event, sizeof(event), "PRESENCE %s online", friend_name);
+            char *notify_msg = build_response(STATUS_PRESENCE_NOTIFICATION, event);
+            server_send_response(session, notify_msg);
+            free(notify_msg);
+        }
+    }
+}
+
 /**
  * @function handle_friend_request: Send a friend request to another user.
  * 
@@ -175,7 +213,7 @@ void handle_friend_request(Server *server, ClientSession *client, ParsedCommand
         return;
     }
     
-    printf("DEBUG: Searching for user '%s'\n", username_clean);
+    LOG_DEBUG("Searching for user '%s'", username_clean);
     
     // Check if user exists
     int target_user_id;
@@ -232,7 +270,7 @@ void handle_friend_request(Server *server, ClientSession *client, ParsedCommand
         free(notify_msg);
     }
     
-    printf("Friend request: %s -> %s\n", client->username, username_clean);
+    LOG_INFO("Friend request: %s -> %s", client->username, username_clean);
 }
 
 /**
@@ -261,7 +299,7 @@ void handle_friend_pending(Server *server, ClientSession *client, ParsedCommand
             "ORDER BY f.created_at DESC",
             client->user_id);
     
-    printf("DEBUG: Querying pending requests for user ID %d\n", client->user_id);
+    LOG_DEBUG("Querying pending requests for user ID %d", client->user_id);
     
     PGresult *res = execute_query_with_result(server->db_conn, query);
     if (!res) {
@@ -314,7 +352,7 @@ void handle_friend_pending(Server *server, ClientSession *client, ParsedCommand
     server_send_response(client, response);
     free(response);
     
-    printf("Sent %d pending requests to user %s\n", num_pending, client->username);
+    LOG_DEBUG("Sent %d pending requests to user %s", num_pending, client->username);
 }
 
 /**
@@ -338,7 +376,7 @@ void handle_friend_accept(Server *server, ClientSession *client, ParsedCommand *
         return;
     }
     
-    printf("DEBUG: Accepting friend request from '%s'\n", username_clean);
+    LOG_DEBUG("Accepting friend request from '%s'", username_clean);
     
     // Check if user exists
     int requester_user_id;
@@ -356,20 +394,24 @@ void handle_friend_accept(Server *server, ClientSession *client, ParsedCommand *
     
     PGresult *res = execute_query_with_result(server->db_conn, query);
     if (!res || PQntuples(res) == 0) {
-        printf("DEBUG: No pending request from '%s' to current user\n", username_clean);
+        LOG_DEBUG("No pending request from '%s' to current user", username_clean);
         if (res) PQclear(res);
         send_error_response(client, STATUS_NO_PENDING_REQUEST, "No pending friend request from this user");
         return;
     }
     
     int friend_request_id = atoi(PQgetvalue(res, 0, 0));
-    printf("DEBUG: Found pending request ID: %d\n", friend_request_id);
+    LOG_DEBUG("Found pending request ID: %d", friend_request_id);
     PQclear(res);
     
-    // Update status to 'accepted'
+    // Update status to 'accepted' and bump both friend list versions in one statement
     snprintf(query, sizeof(query),
-            "UPDATE friends SET status = 'accepted', created_at = NOW() "
-            "WHERE id = %d",
+            "WITH accepted AS ("
+            "  UPDATE friends SET status = 'accepted', created_at = NOW() "
+            "  WHERE id = %d RETURNING user_id, friend_id) "
+            "INSERT INTO friend_list_changes (user_id, friend_id, added) "
+            "SELECT user_id, friend_id, TRUE FROM accepted "
+            "UNION ALL SELECT friend_id, user_id, TRUE FROM accepted",
             friend_request_id);
     
     if (!execute_query(server->db_conn, query)) {
@@ -396,7 +438,10 @@ void handle_friend_accept(Server *server, ClientSession *client, ParsedCommand *
         free(notify_msg);
     }
     
-    printf("Friend accepted: %s <-> %s\n", username_clean, client->username);
+    friend_list_changed(server, client->user_id, requester_user_id, username_clean, 1);
+    friend_list_changed(server, requester_user_id, client->user_id, client->username, 1);
+    
+    LOG_INFO("Friend accepted: %s <-> %s", username_clean, client->username);
 }
 
 /**
@@ -420,7 +465,7 @@ void handle_friend_decline(Server *server, ClientSession *client, ParsedCommand
         return;
     }
     
-    printf("DEBUG: Declining friend request from '%s'\n", username_clean);
+    LOG_DEBUG("Declining friend request from '%s'", username_clean);
     
     // Check if user exists
     int requester_user_id;
@@ -438,14 +483,14 @@ void handle_friend_decline(Server *server, ClientSession *client, ParsedCommand
     
     PGresult *res = execute_query_with_result(server->db_conn, query);
     if (!res || PQntuples(res) == 0) {
-        printf("DEBUG: No pending request from '%s' to current user\n", username_clean);
+        LOG_DEBUG("No pending request from '%s' to current user", username_clean);
         if (res) PQclear(res);
         send_error_response(client, STATUS_NO_PENDING_REQUEST, "No pending friend request from this user");
         return;
     }
     
     int friend_request_id = atoi(PQgetvalue(res, 0, 0));
-    printf("DEBUG: Found pending request ID: %d\n", friend_request_id);
+    LOG_DEBUG("Found pending request ID: %d", friend_request_id);
     PQclear(res);
     
     // Delete friend request (decline = delete)
@@ -477,7 +522,7 @@ void handle_friend_decline(Server *server, ClientSession *client, ParsedCommand
     //     free(notify_msg);
     // }
     
-    printf("Friend declined: %s declined request from %s\n", client->username, username_clean);
+    LOG_INFO("Friend declined: %s declined request from %s", client->username, username_clean);
 }
 
 /**
@@ -501,7 +546,7 @@ void handle_friend_remove(Server *server, ClientSession *client, ParsedCommand *
         return;
     }
     
-    printf("DEBUG: Removing friend '%s'\n", username_clean);
+    LOG_DEBUG("Removing friend '%s'", username_clean);
     
     // Check if user exists
     int friend_user_id;
@@ -531,12 +576,16 @@ void handle_friend_remove(Server *server, ClientSession *client, ParsedCommand *
     
     PGresult *res = execute_query_with_result(server->db_conn, query);
     int friendship_id = atoi(PQgetvalue(res, 0, 0));
-    printf("DEBUG: Found friendship ID: %d\n", friendship_id);
+    LOG_DEBUG("Found friendship ID: %d", friendship_id);
     PQclear(res);
     
-    // Delete friendship relationship
+    // Delete friendship relationship and bump both friend list versions in one statement
     snprintf(query, sizeof(query),
-            "DELETE FROM friends WHERE id = %d",
+            "WITH removed AS ("
+            "  DELETE FROM friends WHERE id = %d RETURNING user_id, friend_id) "
+            "INSERT INTO friend_list_changes (user_id, friend_id, added) "
+            "SELECT user_id, friend_id, FALSE FROM removed "
+            "UNION ALL SELECT friend_id, user_id, FALSE FROM removed",
             friendship_id);
     
     if (!execute_query(server->db_conn, query)) {
@@ -563,7 +612,10 @@ void handle_friend_remove(Server *server, ClientSession *client, ParsedCommand *
     //     free(notify_msg);
     // }
     
-    printf("Friend removed: %s unfriended %s\n", client->username, username_clean);
+    friend_list_changed(server, client->user_id, friend_user_id, username_clean, 0);
+    friend_list_changed(server, friend_user_id, client->user_id, client->username, 0);
+    
+    LOG_INFO("Friend removed: %s unfriended %s", client->username, username_clean);
 }
 
 /**
@@ -579,28 +631,18 @@ void handle_friend_list(Server *server, ClientSession *client) {
     // Check if logged in
     if (!validate_authentication(client)) return;
     
-    // Query to get friend list (status = 'accepted')
-    char query[1024];
+    // Query to get friend list (status = 'accepted'); online status comes from the presence registry
+    char query[512];
     snprintf(query, sizeof(query),
-            "SELECT DISTINCT "
-            "CASE "
-            "  WHEN f.user_id = %d THEN u2.username "
-            "  ELSE u1.username "
-            "END as friend_username, "
-            "CASE "
-            "  WHEN f.user_id = %d THEN u2.is_online "
-            "  ELSE u1.is_online "
-            "END as is_online "
+            "SELECT u.id, u.username "
             "FROM friends f "
-            "JOIN users u1 ON f.user_id = u1.id "
-            "JOIN users u2 ON f.friend_id = u2.id "
+            "JOIN users u ON u.id = CASE WHEN f.user_id = %d THEN f.friend_id ELSE f.user_id END "
             "WHERE (f.user_id = %d OR f.friend_id = %d) "
             "AND f.status = 'accepted' "
-            "ORDER BY friend_username",
-            client->user_id, client->user_id, 
-            client->user_id, client->user_id);
+            "ORDER BY u.username",
+            client->user_id, client->user_id, client->user_id);
     
-    printf("DEBUG: Querying friend list for user ID %d\n", client->user_id);
+    LOG_DEBUG("Querying friend list for user ID %d", client->user_id);
     
     PGresult *res = execute_query_with_result(server->db_conn, query);
     if (!res) {
@@ -632,14 +674,10 @@ void handle_friend_list(Server *server, ClientSession *client) {
     
     // Rows
     for (int i = 0; i < num_friends && offset < BUFFER_SIZE - 200; i++) {
-        const char *username = PQgetvalue(res, i, 0);
-        const char *is_online_str = PQgetvalue(res, i, 1);
-        
-        // Convert is_online
-        const char *status = "Offline";
-        if (is_online_str && (is_online_str[0] == 't')) {
-            status = "Online";
-        }
+        int friend_id = atoi(PQgetvalue(res, i, 0));
+        const char *username = PQgetvalue(res, i, 1);
+        const char *status = presence_get(server->presence, friend_id) == PRESENCE_ONLINE
+                             ? "Online" : "Offline";
         
         offset += snprintf(friend_list + offset, BUFFER_SIZE - offset,
                           "| %-3d | %-20s | %-10s |\n", 
@@ -658,5 +696,226 @@ void handle_friend_list(Server *server, ClientSession *client) {
     server_send_response(client, response);
     free(response);
     
-    printf("Sent friend list (%d friends) to user %s\n", num_friends, client->username);
-}
\ No newline at end of file
+    LOG_DEBUG("Sent friend list (%d friends) to user %s", num_friends, client->username);
+}
+
+/**
+ * @function handle_presence_subscribe: Push friends' online/offline changes to this session.
+ * 
+ * Loads the user's friends into the session roster once; from then on the
+ * server sends "253 PRESENCE <user> online|offline" whenever a friend's
+ * state changes, and the client no longer needs to poll FRIEND_LIST. The
+ * reply is followed by one PRESENCE line per friend currently online.
+ * 
+ * @param server: Pointer to Server structure managing database connection.
+ * @param client: Pointer to the user session subscribing.
+ * 
+ * @return: void (sends 128 with the friend count, or 400 if the roster cannot be loaded).
+ **/
+void handle_presence_subscribe(Server *server, ClientSession *client) {
+    if (!validate_authentication(client)) return;
+    
+    if (!roster_load(&client->friends, server->db_conn, client->user_id)) {
+        send_error_response(client, STATUS_DATABASE_ERROR, "UNKNOWN_ERROR - Failed to load friends");
+        return;
+    }
+    client->presence_subscribed = 1;
+    
+    int online = 0;
+    for (int i = 0; i < client->friends.count; i++) {
+        if (presence_get(server->presence, client->friends.links[i].user_id) == PRESENCE_ONLINE) online++;
+    }
+    
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Subscribed to %d friend(s), %d online", client->friends.count, online);
+    char *response = build_response(STATUS_PRESENCE_SUBSCRIBE_OK, msg);
+    server_send_response(client, response);
+    free(response);
+    
+    for (int i = 0; i < client->friends.count && online > 0; i++) {
+        const FriendLink *link = &client->friends.links[i];
+        if (presence_get(server->presence, link->user_id) != PRESENCE_ONLINE) continue;
+        
+        char event[128];
+        snprintf(event, sizeof(event), "PRESENCE %s online", link->username);
+        char *notify_msg = build_response(STATUS_PRESENCE_NOTIFICATION, event);
+        server_send_response(client, notify_msg);
+        free(notify_msg);
+        online--;
+    }
+    
+    LOG_DEBUG("%s subscribed to presence of %d friend(s)", client->username, client->friends.count);
+}
+
+/**
+ * @function fetch_friend_list_version: Current friend list version of a user.
+ * 
+ * @param db_conn: Database connection.
+ * @param user_id: Owner of the friend list.
+ * 
+ * @return: Largest friend_list_changes id for the user (0 if none), or -1 on database error.
+ **/
+static long long fetch_friend_list_version(PGconn *db_conn, int user_id) {
+    char id_str[16];
+    snprintf(id_str, sizeof(id_str), "%d", user_id);
+    const char *paramValues[1] = {id_str};
+    
+    PGresult *res = PQexecParams(db_conn,
+            "SELECT COALESCE(MAX(id), 0) FROM friend_list_changes WHERE user_id = $1",
+            1, NULL, paramValues, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1) {
+        LOG_WARN("Failed to read friend list version for id=%d: %s", user_id, PQerrorMessage(db_conn));
+        PQclear(res);
+        return -1;
+    }
+    
+    long long version = strtoll(PQgetvalue(res, 0, 0), NULL, 10);
+    PQclear(res);
+    return version;
+}
+
+/**
+ * @function send_friend_sync_frame: Send one FRIEND_SYNC frame.
+ * 
+ * @param client: Receiving session.
+ * @param version: Friend list version the frame brings the client to.
+ * @param mode: "unchanged", "full" or "delta".
+ * @param page: 1-based page number.
+ * @param count: Items in this frame.
+ * @param end: 1 on the last frame.
+ * @param items: Item lines ("+<user> <online>" or "-<user>"), may be empty.
+ * 
+ * @return: 1 if sent, 0 on failure.
+ **/
+static int send_friend_sync_frame(ClientSession *client, long long version, const char *mode,
+                                  int page, int count, int end, const char *items) {
+    size_t size = strlen(items) + 128;
+    char *frame = (char*)malloc(size);
+    if (!frame) return 0;
+    
+    snprintf(frame, size, "FRIEND_SYNC version=%lld mode=%s page=%d count=%d end=%d%s%s",
+             version, mode, page, count, end, items[0] ? "\n" : "", items);
+    
+    char *response = build_large_response(STATUS_FRIEND_LIST_SYNC_OK, frame);
+    int sent = response ? server_send_response(client, response) : -1;
+    free(response);
+    free(frame);
+    return sent >= 0;
+}
+
+/**
+ * @function handle_friend_list_sync: Versioned, machine-readable friend list.
+ * 
+ * The client sends the version from its last sync (0 or nothing for none).
+ * The reply is "unchanged" when it is current, otherwise the friends added
+ * or removed since then ("delta"), or the whole list when the client has no
+ * usable version ("full"). The current version is cached on the session, so
+ * an unchanged list costs no query at all. Items are paged into frames of
+ * at most FRIEND_SYNC_PAGE_BYTES.
+ * 
+ * @param server: Pointer to Server structure managing database connection.
+ * @param client: Pointer to the user session requesting the sync.
+ * @param cmd: Pointer to parsed command (message = known version).
+ * 
+ * @return: void (sends one or more 129 FRIEND_SYNC frames, or an error).
+ **/
+void handle_friend_list_sync(Server *server, ClientSession *client, ParsedCommand *cmd) {
+    if (!validate_authentication(client)) return;
+    
+    char *end = NULL;
+    long long known = cmd->message[0] ? strtoll(cmd->message, &end, 10) : 0;
+    if ((end && *end != '\0') || known < 0) {
+        send_error_response(client, STATUS_UNDEFINED_ERROR, "Invalid version");
+        return;
+    }
+    
+    if (client->friend_list_version < 0) {
+        client->friend_list_version = fetch_friend_list_version(server->db_conn, client->user_id);
+        if (client->friend_list_version < 0) {
+            send_error_response(client, STATUS_DATABASE_ERROR, "UNKNOWN_ERROR - Failed to read friend list version");
+            return;
+        }
+    }
+    long long version = client->friend_list_version;
+    
+    if (known > 0 && known == version) {
+        send_friend_sync_frame(client, version, "unchanged", 1, 0, 1, "");
+        return;
+    }
+    
+    // A version newer than ours (e.g. from before a database reset) gets the full list
+    int delta = known > 0 && known < version;
+    
+    char user_id_str[16], known_str[24];
+    snprintf(user_id_str, sizeof(user_id_str), "%d", client->user_id);
+    snprintf(known_str, sizeof(known_str), "%lld", known);
+    const char *paramValues[2] = {user_id_str, known_str};
+    
+    PGresult *res;
+    if (delta) {
+        // Last change per friend since the client's version
+        res = PQexecParams(server->db_conn,
+                "SELECT DISTINCT ON (c.friend_id) c.friend_id, u.username, c.added "
+                "FROM friend_list_changes c "
+                "JOIN users u ON u.id = c.friend_id "
+                "WHERE c.user_id = $1 AND c.id > $2 "
+                "ORDER BY c.friend_id, c.id DESC",
+                2, NULL, paramValues, NULL, NULL, 0);
+    } else {
+        res = PQexecParams(server->db_conn,
+                "SELECT u.id, u.username, TRUE "
+                "FROM friends f "
+                "JOIN users u ON u.id = CASE WHEN f.user_id = $1 THEN f.friend_id ELSE f.user_id END "
+                "WHERE (f.user_id = $1 OR f.friend_id = $1) "
+                "AND f.status = 'accepted' "
+                "ORDER BY u.username",
+                1, NULL, paramValues, NULL, NULL, 0);
+    }
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_WARN("Friend list sync failed for %s: %s", client->username, PQerrorMessage(server->db_conn));
+        PQclear(res);
+        send_error_response(client, STATUS_DATABASE_ERROR, "UNKNOWN_ERROR - Failed to fetch friend list");
+        return;
+    }
+    
+    const char *mode = delta ? "delta" : "full";
+    int rows = PQntuples(res);
+    char items[FRIEND_SYNC_PAGE_BYTES + MAX_USERNAME_LENGTH + 8];
+    int offset = 0;
+    int count = 0;
+    int page = 1;
+    int ok = 1;
+    
+    items[0] = '\0';
+    for (int i = 0; i < rows; i++) {
+        int friend_id = atoi(PQgetvalue(res, i, 0));
+        const char *username = PQgetvalue(res, i, 1);
+        int added = PQgetvalue(res, i, 2)[0] == 't';
+        
+        if (offset >= FRIEND_SYNC_PAGE_BYTES) {
+            ok = send_friend_sync_frame(client, version, mode, page, count, 0, items);
+            if (!ok) break;
+            offset = 0;
+            count = 0;
+            page++;
+            items[0] = '\0';
+        }
+        
+        if (added) {
+            offset += snprintf(items + offset, sizeof(items) - offset, "%s+%s %d", offset ? "\n" : "",
+                               username, presence_get(server->presence, friend_id) == PRESENCE_ONLINE);
+        } else {
+            offset += snprintf(items + offset, sizeof(items) - offset, "%s-%s", offset ? "\n" : "", username);
+        }
+        count++;
+    }
+    PQclear(res);
+    
+    if (ok) {
+        send_friend_sync_frame(client, version, mode, page, count, 1, items);
+    }
+    
+    LOG_DEBUG("Friend list sync for %s: %s %d item(s), version %lld -> %lld",
+              client->username, mode, rows, known, version);
+}
@@ -18,5 +18,7 @@ void handle_friend_pending(Server *server, ClientSession *client, ParsedCommand
 void handle_friend_decline(Server *server, ClientSession *client, ParsedCommand *cmd);
 void handle_friend_remove(Server *server, ClientSession *client, ParsedCommand *cmd);
 void handle_friend_list(Server *server, ClientSession *client);
+void handle_presence_subscribe(Server *server, ClientSession *client);
+void handle_friend_list_sync(Server *server, ClientSession *client, ParsedCommand *cmd);
 
 #endif // FRIEND_H
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "server.h"
 #include "auth.h"
+#include "message.h"
 #include "../database/database.h"
 #include "../helper/helper.h"
 #include <stdio.h>
@@ -98,7 +99,7 @@ bool store_offline_notification(PGconn *db_conn, int user_id, int group_id,
             user_id, group_id, escaped_owner, status, escaped_group_name, escaped_owner);
     
     bool result = execute_query(db_conn, query);
-    printf("%s offline notification for user_id=%d\n", 
+    LOG_DEBUG("%s offline notification for user_id=%d", 
            result ? "Stored" : "Failed to store", user_id);
     
     return result;
@@ -136,15 +137,15 @@ void send_notification(Server *server, int target_user_id,
         char *response = build_response(status_code, notification);
         
         if (server_send_response(target, response) > 0) {
-            printf("Real-time notification sent to '%s'\n", username);
+            LOG_DEBUG("Real-time notification sent to '%s'", username);
         } else {
-            printf("Failed to send, storing offline for '%s'\n", username);
+            LOG_DEBUG("Failed to send, storing offline for '%s'", username);
             store_offline_notification(server->db_conn, target_user_id,
                                       group_id, sender, group_name, offline_status);
         }
         free(response);
     } else {
-        printf("User '%s' offline, storing notification\n", username);
+        LOG_DEBUG("User '%s' offline, storing notification", username);
         store_offline_notification(server->db_conn, target_user_id,
                                   group_id, sender, group_name, offline_status);
     }
@@ -526,7 +527,7 @@ void handle_group_create_command(Server *server, ClientSession *client, ParsedCo
     response = build_response(STATUS_GROUP_CREATE_OK, msg);
     send_and_free(client, response);
     
-    printf("Group created: %s (id=%d) by %s\n", 
+    LOG_INFO("Group created: %s (id=%d) by %s", 
            cmd->group_name, group_id, client->username);
 }
 
@@ -546,8 +547,10 @@ void handle_group_create_command(Server *server, ClientSession *client, ParsedCo
 int add_user_to_group(PGconn *conn, int group_id, int user_id) {
     char query[512];
     snprintf(query, sizeof(query),
-            "INSERT INTO group_members (group_id, user_id, role) "
-            "VALUES (%d, %d, 'member')", group_id, user_id);
+            "INSERT INTO group_members (group_id, user_id, role, last_read_message_id) "
+            "SELECT %d, %d, 'member', COALESCE(MAX(id), 0) "
+            "FROM group_messages WHERE group_id = %d",
+            group_id, user_id, group_id);
     
     return execute_query(conn, query);
 }
@@ -608,10 +611,10 @@ void handle_group_invite_command(Server *server, ClientSession *client, ParsedCo
     response = build_response(STATUS_GROUP_INVITE_OK, msg);
     send_and_free(client, response);
     
-    printf("User '%s' added to group '%s' by '%s'\n", 
+    LOG_INFO("User '%s' added to group '%s' by '%s'", 
            cmd->target_user, group_name, client->username);
     
-    printf("User '%s' added to group '%s' by '%s'\n", 
+    LOG_INFO("User '%s' added to group '%s' by '%s'", 
            cmd->target_user, group_name, client->username);
     
     // Send notification
@@ -716,7 +719,7 @@ void handle_group_kick_command(Server *server, ClientSession *client, ParsedComm
     response = build_response(STATUS_GROUP_KICK_OK, msg);
     send_and_free(client, response);
     
-    printf("User %s kicked from group %s by %s\n", 
+    LOG_INFO("User %s kicked from group %s by %s", 
            cmd->target_user, group_name, client->username);
     
     char notif_format[512];
@@ -790,7 +793,7 @@ void handle_group_leave_command(Server *server, ClientSession *client, ParsedCom
     response = build_response(STATUS_GROUP_LEAVE_OK, msg);
     send_and_free(client, response);
     
-    printf("User %s left group %s\n", client->username, cmd->group_name);
+    LOG_INFO("User %s left group %s", client->username, cmd->group_name);
 }
 
 // ============================================================================
@@ -869,7 +872,7 @@ void handle_group_join_command(Server *server, ClientSession *client, ParsedComm
     response = build_response(STATUS_JOIN_REQUEST_SENT, msg);
     send_and_free(client, response);
     
-    printf("User '%s' requested to join group '%s'\n", client->username, group_name);
+    LOG_INFO("User '%s' requested to join group '%s'", client->username, group_name);
     
     int owner_id = get_group_owner_id(server->db_conn, group_id);
     if (owner_id <= 0) return;
@@ -890,7 +893,7 @@ void handle_group_join_command(Server *server, ClientSession *client, ParsedComm
                                               notification);
         
         if (server_send_response(owner, notify_response) > 0) {
-            printf("Join request notification sent to owner '%s'\n", owner_username);
+            LOG_DEBUG("Join request notification sent to owner '%s'", owner_username);
         } else {
             store_join_request_notification(server->db_conn, owner_id, 
                                           group_id, client->username, group_name);
@@ -1030,7 +1033,7 @@ void handle_group_approve_command(Server *server, ClientSession *client, ParsedC
     char *response = build_response(STATUS_GROUP_APPROVE_OK, msg);
     send_and_free(client, response);
     
-    printf("Owner '%s' approved '%s' to join group '%s'\n",
+    LOG_INFO("Owner '%s' approved '%s' to join group '%s'",
            client->username, cmd->target_user, group_name);
     
     // Notify requester
@@ -1047,7 +1050,7 @@ void handle_group_approve_command(Server *server, ClientSession *client, ParsedC
         server_send_response(requester, notify_response);
         free(notify_response);
         
-        printf("Approval notification sent to '%s'\n", cmd->target_user);
+        LOG_DEBUG("Approval notification sent to '%s'", cmd->target_user);
     } else {
         store_offline_notification(server->db_conn, requester_id, group_id,
                                   client->username, group_name, "approved to join");
@@ -1083,7 +1086,7 @@ void handle_group_reject_command(Server *server, ClientSession *client, ParsedCo
     char *response = build_response(STATUS_GROUP_REJECT_OK, msg);
     send_and_free(client, response);
     
-    printf("Owner '%s' rejected '%s' from joining group '%s'\n",
+    LOG_INFO("Owner '%s' rejected '%s' from joining group '%s'",
            client->username, cmd->target_user, group_name);
     
     // Notify requester
@@ -1100,7 +1103,7 @@ void handle_group_reject_command(Server *server, ClientSession *client, ParsedCo
         server_send_response(requester, notify_response);
         free(notify_response);
         
-        printf("Rejection notification sent to '%s'\n", cmd->target_user);
+        LOG_DEBUG("Rejection notification sent to '%s'", cmd->target_user);
     } else {
         store_offline_notification(server->db_conn, requester_id, group_id,
                                   client->username, group_name, "rejected from");
@@ -1231,6 +1234,132 @@ int set_group_messaging_status(PGconn *db_conn, int user_id, int group_id, int i
     return execute_query(db_conn, query);
 }
 
+/**
+ * @function get_group_read_cursor: Get the id of the last group message a member has read
+ * 
+ * @param db_conn: Database connection
+ * @param group_id: Group ID
+ * @param user_id: User ID
+ * 
+ * @return Last read message id (0 if none), or -1 on error
+ */
+int get_group_read_cursor(PGconn *db_conn, int group_id, int user_id) {
+    char query[256];
+    snprintf(query, sizeof(query),
+            "SELECT last_read_message_id FROM group_members "
+            "WHERE group_id = %d AND user_id = %d",
+            group_id, user_id);
+    
+    PGresult *res = execute_query_with_result(db_conn, query);
+    if (!res || PQntuples(res) == 0) {
+        if (res) PQclear(res);
+        return -1;
+    }
+    
+    int cursor = atoi(PQgetvalue(res, 0, 0));
+    PQclear(res);
+    
+    return cursor;
+}
+
+/**
+ * @function advance_group_read_cursors: Move members' read cursors forward to a message id
+ * 
+ * Cursors never move backwards, so late or repeated updates are harmless.
+ * The members' unread counters drop by the number of messages delivered in
+ * the same statement, so a catch-up costs O(page) rather than a recount.
+ * 
+ * @param db_conn: Database connection
+ * @param group_id: Group ID
+ * @param user_ids: Members whose cursor should advance
+ * @param count: Number of entries in user_ids
+ * @param message_id: Id of the last message the members have received
+ * @param delivered: Number of counted (not self-sent) messages up to message_id
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int advance_group_read_cursors(PGconn *db_conn, int group_id, const int *user_ids,
+                               int count, int message_id, int delivered) {
+    if (!db_conn || !user_ids || count <= 0) return 0;
+    
+    size_t size = (size_t)count * 12 + 3;
+    char *id_array = (char*)malloc(size);
+    if (!id_array) return 0;
+    
+    int offset = snprintf(id_array, size, "{");
+    for (int i = 0; i < count; i++) {
+        offset += snprintf(id_array + offset, size - offset, "%s%d",
+                          i > 0 ? "," : "", user_ids[i]);
+    }
+    snprintf(id_array + offset, size - offset, "}");
+    
+    char group_str[32], message_str[32], delivered_str[32];
+    snprintf(group_str, sizeof(group_str), "%d", group_id);
+    snprintf(message_str, sizeof(message_str), "%d", message_id);
+    snprintf(delivered_str, sizeof(delivered_str), "%d", delivered);
+    
+    // Clamped at zero: counters predating the cursor may undercount
+    const char *query =
+            "UPDATE group_members m SET last_read_message_id = $3, "
+            "unread_count = GREATEST(m.unread_count - $4::int, 0) "
+            "WHERE m.group_id = $1 AND m.user_id = ANY($2::int[]) "
+            "AND m.last_read_message_id < $3";
+    const char *paramValues[4] = {group_str, id_array, message_str, delivered_str};
+    
+    PGresult *res = PQexecParams(db_conn, query, 4, NULL, paramValues, NULL, NULL, 0);
+    int success = (PQresultStatus(res) == PGRES_COMMAND_OK);
+    if (!success) {
+        LOG_ERROR("Failed to advance read cursors: %s", PQerrorMessage(db_conn));
+    }
+    
+    PQclear(res);
+    free(id_array);
+    
+    return success;
+}
+
+/**
+ * @function fetch_group_page: Fetch one keyset page of group messages after a cursor
+ * 
+ * Served by the (group_id, id) index, so the cost is proportional to the
+ * page size rather than to the group's history.
+ * 
+ * @param db_conn: Database connection
+ * @param group_id: Group ID
+ * @param user_id: Reading member (their own messages are skipped)
+ * @param cursor: Only messages with id greater than this are returned
+ * 
+ * @return PGresult with (id, username, content, created_at) rows, or NULL on error
+ */
+static PGresult* fetch_group_page(PGconn *db_conn, int group_id, int user_id, int cursor) {
+    const char *query =
+            "SELECT gm.id, u.username, gm.content, gm.created_at "
+            "FROM group_messages gm "
+            "JOIN users u ON gm.sender_id = u.id "
+            "WHERE gm.group_id = $1 "
+            "  AND gm.id > $2 "
+            "  AND gm.sender_id != $3 "
+            "ORDER BY gm.id ASC "
+            "LIMIT $4";
+    
+    char group_str[32], cursor_str[32], user_str[32], limit_str[32];
+    snprintf(group_str, sizeof(group_str), "%d", group_id);
+    snprintf(cursor_str, sizeof(cursor_str), "%d", cursor);
+    snprintf(user_str, sizeof(user_str), "%d", user_id);
+    snprintf(limit_str, sizeof(limit_str), "%d", OFFLINE_PAGE_ROWS);
+    
+    const char *paramValues[4] = {group_str, cursor_str, user_str, limit_str};
+    
+    PGresult *res = PQexecParams(db_conn, query, 4, NULL, paramValues, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("Group page query failed: %s", PQerrorMessage(db_conn));
+        PQclear(res);
+        return NULL;
+    }
+    
+    return res;
+}
+
 /**
  * @function broadcast_group_message: Broadcast message to group members
  * 
@@ -1249,8 +1378,8 @@ void broadcast_group_message(Server *server, int group_id, const char *group_nam
                              const char *message, int message_id) {
     if (!server || !group_name || !sender_username || !message) return;
     
-    printf("\n=== BROADCASTING GROUP MESSAGE ===\n");
-    printf("Group '%s' (ID:%d), Message ID: %d, From '%s': %s\n", 
+    LOG_DEBUG("=== BROADCASTING GROUP MESSAGE ===");
+    LOG_TRACE("Group '%s' (ID:%d), Message ID: %d, From '%s': %s", 
            group_name, group_id, message_id, sender_username, message);
     
     char query[512];
@@ -1262,14 +1391,15 @@ void broadcast_group_message(Server *server, int group_id, const char *group_nam
     
     PGresult *res = execute_query_with_result(server->db_conn, query);
     if (!res) {
-        printf("ERROR: Failed to get group members\n");
+        LOG_ERROR("Failed to get group members");
         return;
     }
     
     int member_count = PQntuples(res);
     int online_count = 0, offline_count = 0;
+    int *delivered_ids = (int*)malloc((member_count > 0 ? member_count : 1) * sizeof(int));
     
-    printf("Group has %d member(s)\n", member_count);
+    LOG_DEBUG("Group has %d member(s)", member_count);
     
     for (int i = 0; i < member_count; i++) {
         const char *member_username = PQgetvalue(res, i, 0);
@@ -1277,7 +1407,7 @@ void broadcast_group_message(Server *server, int group_id, const char *group_nam
         
         // Skip sender
         if (member_id == sender_id) {
-            printf("Skipping sender '%s'\n", member_username);
+            LOG_TRACE("Skipping sender '%s'", member_username);
             continue;
         }
         
@@ -1296,22 +1426,29 @@ void broadcast_group_message(Server *server, int group_id, const char *group_nam
             free(response);
             
             if (send_result > 0) {
-                printf("Message sent to ONLINE user '%s' (in messaging mode)\n", member_username);
+                LOG_TRACE("Message sent to ONLINE user '%s' (in messaging mode)", member_username);
+                if (delivered_ids) delivered_ids[online_count] = member_id;
                 online_count++;
             } else {
-                printf("Failed to send to '%s', will fetch offline later\n", member_username);
+                LOG_DEBUG("Failed to send to '%s', will fetch offline later", member_username);
                 offline_count++;
             }
         } else {
-            printf("User '%s' is OFFLINE or not in messaging mode, will fetch later\n", member_username);
+            LOG_TRACE("User '%s' is OFFLINE or not in messaging mode, will fetch later", member_username);
             offline_count++;
         }
     }
     
     PQclear(res);
     
-    printf("Broadcast complete - Online: %d, Offline: %d\n", online_count, offline_count);
-    printf("=== END BROADCASTING ===\n\n");
+    // Members who got the message live must not see it again on catch-up
+    if (delivered_ids && online_count > 0) {
+        advance_group_read_cursors(server->db_conn, group_id, delivered_ids,
+                                   online_count, message_id, 1);
+    }
+    free(delivered_ids);
+    
+    LOG_DEBUG("Broadcast complete - Online: %d, Offline: %d", online_count, offline_count);
 }
 
 
@@ -1327,34 +1464,34 @@ void broadcast_group_message(Server *server, int group_id, const char *group_nam
 void handle_group_msg_command(Server *server, ClientSession *client, ParsedCommand *cmd) {
     if (!server || !client || !cmd) return;
     
-    printf("\n=== HANDLE GROUP MESSAGE ===\n");
-    printf("From user '%s' (ID:%d)\n", client->username, client->user_id);
+    LOG_DEBUG("=== HANDLE GROUP MESSAGE ===");
+    LOG_DEBUG("From user '%s' (ID:%d)", client->username, client->user_id);
     
     if (!check_auth(client)) return;
     
     if (cmd->param_count < 2 || !cmd->group_name || !cmd->message) {
-        printf("ERROR: Invalid parameters\n");
+        LOG_DEBUG("Invalid parameters");
         char *response = build_response(STATUS_UNDEFINED_ERROR, 
             "Group name and message required");
         send_and_free(client, response);
         return;
     }
     
-    printf("Target group: '%s', Message: '%s'\n", cmd->group_name, cmd->message);
+    LOG_TRACE("Target group: '%s', Message: '%s'", cmd->group_name, cmd->message);
     
     int group_id = find_group_id(server->db_conn, cmd->group_name);
     if (group_id < 0) {
-        printf("ERROR: Group not found\n");
+        LOG_DEBUG("Group not found");
         char *response = build_response(STATUS_GROUP_NOT_FOUND, 
             "Group does not exist");
         send_and_free(client, response);
         return;
     }
     
-    printf("Found group '%s' with ID: %d\n", cmd->group_name, group_id);
+    LOG_DEBUG("Found group '%s' with ID: %d", cmd->group_name, group_id);
     
     if (!is_in_group(server->db_conn, group_id, client->user_id)) {
-        printf("ERROR: User not in group\n");
+        LOG_DEBUG("User not in group");
         char *response = build_response(STATUS_NOT_IN_GROUP, 
             "You are not a member of this group");
         send_and_free(client, response);
@@ -1362,7 +1499,7 @@ void handle_group_msg_command(Server *server, ClientSession *client, ParsedComma
     }
     
     if (strlen(cmd->message) > MAX_MESSAGE_LENGTH - 1) {
-        printf("ERROR: Message too long (%zu bytes)\n", strlen(cmd->message));
+        LOG_DEBUG("Message too long (%zu bytes)", strlen(cmd->message));
         char *response = build_response(STATUS_MESSAGE_TOO_LONG, 
             "Message exceeds maximum length");
         send_and_free(client, response);
@@ -1373,7 +1510,7 @@ void handle_group_msg_command(Server *server, ClientSession *client, ParsedComma
     char *escaped_message = PQescapeLiteral(server->db_conn, cmd->message, 
                                            strlen(cmd->message));
     if (!escaped_message) {
-        printf("ERROR: Failed to escape message\n");
+        LOG_ERROR("Failed to escape message");
         char *response = build_response(STATUS_DATABASE_ERROR, 
             "Failed to save message");
         send_and_free(client, response);
@@ -1390,7 +1527,7 @@ void handle_group_msg_command(Server *server, ClientSession *client, ParsedComma
     PGresult *res = execute_query_with_result(server->db_conn, query);
     if (!res || PQntuples(res) == 0) {
         if (res) PQclear(res);
-        printf("ERROR: Failed to save message to database\n");
+        LOG_ERROR("Failed to save message to database");
         char *response = build_response(STATUS_DATABASE_ERROR, 
             "Failed to save message");
         send_and_free(client, response);
@@ -1400,7 +1537,17 @@ void handle_group_msg_command(Server *server, ClientSession *client, ParsedComma
     int message_id = atoi(PQgetvalue(res, 0, 0));
     PQclear(res);
     
-    printf("Message saved to database with ID: %d\n", message_id);
+    LOG_DEBUG("Message saved to database with ID: %d", message_id);
+    
+    // Everyone but the sender has one more unread message; members who get
+    // it live are reset by the cursor advance in broadcast_group_message
+    snprintf(query, sizeof(query),
+            "UPDATE group_members SET unread_count = unread_count + 1 "
+            "WHERE group_id = %d AND user_id != %d",
+            group_id, client->user_id);
+    if (!execute_query(server->db_conn, query)) {
+        LOG_WARN("Failed to update unread counters for group %d", group_id);
+    }
     
     broadcast_group_message(server, group_id, cmd->group_name, 
                           client->username, client->user_id,
@@ -1410,7 +1557,6 @@ void handle_group_msg_command(Server *server, ClientSession *client, ParsedComma
         "Group message sent successfully");
     send_and_free(client, response);
     
-    printf("=== END HANDLE GROUP MESSAGE ===\n\n");
 }
 
 /**
@@ -1426,8 +1572,8 @@ void handle_get_group_offline_messages(Server *server, ClientSession *client,
                                        ParsedCommand *cmd) {
     if (!server || !client || !cmd) return;
 
-    printf("\n=== GET GROUP OFFLINE MESSAGES ===\n");
-    printf("User '%s' (ID:%d) entering group messaging mode\n", 
+    LOG_DEBUG("=== GET GROUP OFFLINE MESSAGES ===");
+    LOG_DEBUG("User '%s' (ID:%d) entering group messaging mode", 
            client->username, client->user_id);
     
     if (!check_auth(client)) return;
@@ -1439,11 +1585,11 @@ void handle_get_group_offline_messages(Server *server, ClientSession *client,
         return;
     }
     
-    printf("Entering messaging mode for group '%s'\n", cmd->group_name);
+    LOG_DEBUG("Entering messaging mode for group '%s'", cmd->group_name);
     
     int group_id = find_group_id(server->db_conn, cmd->group_name);
     if (group_id < 0) {
-        printf("ERROR: Group not found\n");
+        LOG_DEBUG("Group not found");
         char *response = build_response(STATUS_GROUP_NOT_FOUND, 
             "Group does not exist");
         send_and_free(client, response);
@@ -1451,98 +1597,140 @@ void handle_get_group_offline_messages(Server *server, ClientSession *client,
     }
     
     if (!is_in_group(server->db_conn, group_id, client->user_id)) {
-        printf("ERROR: User not in group\n");
+        LOG_DEBUG("User not in group");
         char *response = build_response(STATUS_NOT_IN_GROUP, 
             "You are not a member");
         send_and_free(client, response);
         return;
     }
     
-    if (!set_group_messaging_status(server->db_conn, client->user_id, group_id, 1)) {
-        printf("ERROR: Failed to set messaging status\n");
+    LOG_DEBUG("Fetching offline messages...");
+    
+    int cursor = get_group_read_cursor(server->db_conn, group_id, client->user_id);
+    if (cursor < 0) {
         char *response = build_response(STATUS_DATABASE_ERROR, 
-            "Failed to enter messaging mode");
+            "Failed to fetch offline messages");
         send_and_free(client, response);
         return;
     }
     
-    printf("Messaging mode activated. Fetching offline messages...\n");
-    
-    char query[1024];
-    snprintf(query, sizeof(query),
-            "SELECT gm.id, u.username, gm.content, gm.created_at "
-            "FROM group_messages gm "
-            "JOIN users u ON gm.sender_id = u.id "
-            "JOIN group_members gm_receiver ON gm_receiver.group_id = gm.group_id "
-            "  AND gm_receiver.user_id = %d "
-            "WHERE gm.group_id = %d "
-            "  AND gm.sender_id != %d "
-            "  AND gm.created_at > gm_receiver.last_read_at "
-            "ORDER BY gm.created_at ASC",
-            client->user_id, group_id, client->user_id);
-    
-    PGresult *res = execute_query_with_result(server->db_conn, query);
-    if (!res) {
+    size_t page_capacity = MAX_MESSAGE_LENGTH + 128;
+    char *page_text = (char*)malloc(page_capacity);
+    char *frame_text = (char*)malloc(page_capacity + 256);
+    if (!page_text || !frame_text) {
+        free(page_text);
+        free(frame_text);
         char *response = build_response(STATUS_DATABASE_ERROR, 
             "Failed to fetch offline messages");
         send_and_free(client, response);
         return;
     }
     
-    int num_messages = PQntuples(res);
-    
-    if (num_messages == 0) {
+    int pages_sent = 0;
+    int total_sent = 0;
+    int more = 1;
+    
+    // Each page is its own frame; the member's read cursor advances only
+    // after the page has been fully written, so the next GROUP_SEND_OFFLINE_MSG
+    // resumes exactly where this one stopped.
+    // Messaging mode (live delivery) is switched on only once the backlog is
+    // exhausted: a live broadcast moves the cursor to the new message, which
+    // would skip any pages still waiting for the next window.
+    while (more && pages_sent < OFFLINE_PAGE_WINDOW) {
+        PGresult *res = fetch_group_page(server->db_conn, group_id, client->user_id, cursor);
+        if (!res) {
+            char *response = build_response(STATUS_DATABASE_ERROR, 
+                "Failed to fetch offline messages");
+            send_and_free(client, response);
+            break;
+        }
+        
+        int num_rows = PQntuples(res);
+        if (num_rows == 0) {
+            PQclear(res);
+            more = 0;
+            LOG_DEBUG("No (more) unread messages for group '%s'", cmd->group_name);
+            char *response = build_response(STATUS_NOT_HAVE_OFFLINE_MESSAGE, 
+                "No unread messages");
+            send_and_free(client, response);
+            break;
+        }
+        
+        int offset = 0;
+        int count = 0;
+        int page_cursor = cursor;
+        
+        for (int i = 0; i < num_rows; i++) {
+            const char *sender = PQgetvalue(res, i, 1);
+            const char *content = PQgetvalue(res, i, 2);
+            const char *created_at = PQgetvalue(res, i, 3);
+            int line_len = snprintf(NULL, 0, "[%s] %s: %s\n", created_at, sender, content);
+            
+            if (count > 0 && offset + line_len > OFFLINE_PAGE_BYTES) {
+                break;
+            }
+            if (offset + line_len >= (int)page_capacity) {
+                line_len = (int)page_capacity - offset - 1;
+            }
+            
+            snprintf(page_text + offset, page_capacity - offset,
+                    "[%s] %s: %s\n", created_at, sender, content);
+            offset += line_len;
+            
+            page_cursor = atoi(PQgetvalue(res, i, 0));
+            count++;
+        }
+        
+        more = (count < num_rows) || (num_rows == OFFLINE_PAGE_ROWS);
         PQclear(res);
-        printf("No unread messages for group '%s'\n", cmd->group_name);
         
-        char update_query[256];
-        snprintf(update_query, sizeof(update_query),
-                "UPDATE group_members SET last_read_at = NOW() "
-                "WHERE user_id = %d AND group_id = %d",
-                client->user_id, group_id);
-        execute_query(server->db_conn, update_query);
+        int end = !more || (pages_sent + 1 == OFFLINE_PAGE_WINDOW);
+        snprintf(frame_text, page_capacity + 256,
+                "GROUP_OFFLINE_PAGE group=%s page=%d count=%d cursor=%d more=%d end=%d\n"
+                "=== OFFLINE MESSAGES FROM GROUP '%s' ===\n%.*s",
+                cmd->group_name, pages_sent + 1, count, page_cursor, more, end,
+                cmd->group_name, offset, page_text);
         
-        char *response = build_response(STATUS_NOT_HAVE_OFFLINE_MESSAGE, 
-            "No unread messages");
-        send_and_free(client, response);
-        return;
-    }
-    
-    printf("Found %d unread message(s)\n", num_messages);
-    
-    char message_list[BUFFER_SIZE * 2];
-    int offset = 0;
-    
-    offset += snprintf(message_list + offset, sizeof(message_list) - offset,
-                      "\n=== OFFLINE MESSAGES FROM GROUP '%s' ===\n", cmd->group_name);
-    
-    for (int i = 0; i < num_messages && offset < (int)sizeof(message_list) - 500; i++) {
-        const char *sender = PQgetvalue(res, i, 1);
-        const char *content = PQgetvalue(res, i, 2);
-        const char *created_at = PQgetvalue(res, i, 3);
+        char *response = build_large_response(STATUS_GET_OFFLINE_MSG_OK, frame_text);
+        int sent = response ? server_send_response(client, response) : -1;
+        free(response);
+        
+        if (sent < 0) {
+            LOG_ERROR("Failed to send group page %d, read cursor unchanged", pages_sent + 1);
+            break;
+        }
         
-        offset += snprintf(message_list + offset, sizeof(message_list) - offset,
-                          "[%s] %s: %s\n", created_at, sender, content);
+        advance_group_read_cursors(server->db_conn, group_id, &client->user_id, 1,
+                                   page_cursor, count);
+        cursor = page_cursor;
+        total_sent += count;
+        pages_sent++;
     }
     
-    offset += snprintf(message_list + offset, sizeof(message_list) - offset,
-                      "=== END OF UNREAD MESSAGES (%d total) ===", num_messages);
+    free(page_text);
+    free(frame_text);
     
-    PQclear(res);
-    
-    char update_query[256];
-    snprintf(update_query, sizeof(update_query),
-            "UPDATE group_members SET last_read_at = NOW() "
-            "WHERE user_id = %d AND group_id = %d",
-            client->user_id, group_id);
-    execute_query(server->db_conn, update_query);
-    
-    printf("Marked messages as read\n");
+    // The client's next GROUP_SEND_OFFLINE_MSG for this group continues a read
+    // that already made progress, so the router lets it past the READ budget
+    if (more && pages_sent > 0) {
+        snprintf(client->catchup_group, sizeof(client->catchup_group), "%s", cmd->group_name);
+    } else {
+        client->catchup_group[0] = '\0';
+    }
     
-    char *response = build_response(STATUS_GET_OFFLINE_MSG_OK, message_list);
-    send_and_free(client, response);
+    if (!set_group_messaging_status(server->db_conn, client->user_id, group_id, !more)) {
+        LOG_ERROR("Failed to set messaging status");
+        if (!more) {
+            char *response = build_response(STATUS_DATABASE_ERROR, 
+                "Failed to enter messaging mode");
+            send_and_free(client, response);
+        }
+    } else if (!more) {
+        LOG_DEBUG("Messaging mode activated for group '%s'", cmd->group_name);
+    }
     
-    printf("=== END GET GROUP OFFLINE MESSAGES ===\n\n");
+    LOG_DEBUG("Streamed %d page(s), %d message(s), read cursor now %d%s",
+           pages_sent, total_sent, cursor, more ? " (more pending)" : "");
 }
 
 /**
@@ -1557,8 +1745,8 @@ void handle_get_group_offline_messages(Server *server, ClientSession *client,
 void handle_exit_group_messaging(Server *server, ClientSession *client, ParsedCommand *cmd) {
     if (!server || !client || !cmd) return;
     
-    printf("\n=== EXIT GROUP MESSAGING ===\n");
-    printf("User '%s' (ID:%d) exiting group messaging mode\n", 
+    LOG_DEBUG("=== EXIT GROUP MESSAGING ===");
+    LOG_DEBUG("User '%s' (ID:%d) exiting group messaging mode", 
            client->username, client->user_id);
     
     if (!check_auth(client)) return;
@@ -1574,6 +1762,5 @@ void handle_exit_group_messaging(Server *server, ClientSession *client, ParsedCo
     
     set_group_messaging_status(server->db_conn, client->user_id, group_id, 0);
     
-    printf("Messaging mode deactivated for group '%s'\n", cmd->group_name);
-    printf("=== END EXIT GROUP MESSAGING ===\n\n");
+    LOG_DEBUG("Messaging mode deactivated for group '%s'", cmd->group_name);
 }
@@ -13,4 +13,8 @@ void handle_group_reject_command(Server *server, ClientSession *client, ParsedCo
 void handle_list_join_requests_command(Server *server, ClientSession *client, ParsedCommand *cmd);
 void handle_exit_group_messaging(Server *server, ClientSession *client, ParsedCommand *cmd);
 
+int get_group_read_cursor(PGconn *db_conn, int group_id, int user_id);
+int advance_group_read_cursors(PGconn *db_conn, int group_id, const int *user_ids,
+                               int count, int message_id, int delivered);
+
 #endif
@@ -21,7 +21,7 @@
  **/
 static int check_authentication(Server *server __attribute__((unused)), ClientSession *client) {
     if (!client->is_authenticated) {
-        printf("ERROR: User not authenticated\n");
+        LOG_DEBUG("User not authenticated");
         char *response = build_response(STATUS_NOT_LOGGED_IN, "NOT_LOGGED_IN - Please login first");
         server_send_response(client, response);
         free(response);
@@ -42,7 +42,7 @@ static int check_authentication(Server *server __attribute__((unused)), ClientSe
  **/
 static void send_error_response(ClientSession *client, int status_code, const char *message, const char *log_msg) {
     if (log_msg) {
-        printf("ERROR: %s\n", log_msg);
+        LOG_DEBUG("%s", log_msg);
     }
     char *response = build_response(status_code, message);
     server_send_response(client, response);
@@ -124,22 +124,51 @@ int mark_messages_as_delivered(PGconn *conn, int *message_ids, int count) {
         return 0;
     }
     
-    char query[512];
-    int success_count = 0;
+    // One statement per batch: build a '{id,id,...}' array literal
+    size_t size = (size_t)count * 12 + 3;
+    char *id_array = (char*)malloc(size);
+    if (!id_array) {
+        return 0;
+    }
     
+    int offset = snprintf(id_array, size, "{");
     for (int i = 0; i < count; i++) {
-        snprintf(query, sizeof(query),
-                "UPDATE messages SET is_delivered = TRUE WHERE id = %d",
-                message_ids[i]);
-        
-        if (execute_query(conn, query)) {
-            success_count++;
-        } else {
-            printf("WARNING: Failed to mark message %d as delivered\n", message_ids[i]);
-        }
+        offset += snprintf(id_array + offset, size - offset, "%s%d",
+                          i > 0 ? "," : "", message_ids[i]);
+    }
+    snprintf(id_array + offset, size - offset, "}");
+    
+    // Flip the flags and decrement the matching unread counters in one round trip
+    const char *query =
+            "WITH d AS ("
+            "    UPDATE messages SET is_delivered = TRUE "
+            "    WHERE id = ANY($1::int[]) AND is_delivered = FALSE "
+            "    RETURNING receiver_id, sender_id"
+            "), c AS ("
+            "    SELECT receiver_id, sender_id, COUNT(*) AS n FROM d GROUP BY receiver_id, sender_id"
+            "), u AS ("
+            "    UPDATE direct_unread_counts duc "
+            "    SET unread_count = GREATEST(duc.unread_count - c.n, 0) "
+            "    FROM c WHERE duc.user_id = c.receiver_id AND duc.sender_id = c.sender_id "
+            "    RETURNING 1"
+            ") "
+            "SELECT COALESCE(SUM(n), 0) FROM c";
+    const char *paramValues[1] = {id_array};
+    
+    PGresult *res = PQexecParams(conn, query, 1, NULL, paramValues, NULL, NULL, 0);
+    int success_count = 0;
+    
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1) {
+        success_count = atoi(PQgetvalue(res, 0, 0));
+    } else {
+        LOG_WARN("Failed to mark %d message(s) as delivered: %s",
+               count, PQerrorMessage(conn));
     }
     
-    printf("DEBUG: Marked %d/%d message(s) as delivered\n", success_count, count);
+    PQclear(res);
+    free(id_array);
+    
+    LOG_DEBUG("Marked %d/%d message(s) as delivered", success_count, count);
     return success_count;
 }
 
@@ -156,15 +185,21 @@ int mark_messages_as_delivered(PGconn *conn, int *message_ids, int count) {
 int mark_message_as_delivered(PGconn *conn, int sender_id, int receiver_id, const char *message_text) {
     // Use parameterized query to avoid escape errors
     const char *query = 
-            "UPDATE messages SET is_delivered = TRUE "
-            "WHERE id = ("
-            "    SELECT id FROM messages "
-            "    WHERE sender_id = $1 AND receiver_id = $2 "
-            "    AND content = $3 "
-            "    AND is_delivered = FALSE "
-            "    ORDER BY created_at DESC "
-            "    LIMIT 1"
-            ")";
+            "WITH d AS ("
+            "    UPDATE messages SET is_delivered = TRUE "
+            "    WHERE id = ("
+            "        SELECT id FROM messages "
+            "        WHERE sender_id = $1 AND receiver_id = $2 "
+            "        AND content = $3 "
+            "        AND is_delivered = FALSE "
+            "        ORDER BY created_at DESC "
+            "        LIMIT 1"
+            "    ) "
+            "    RETURNING receiver_id, sender_id"
+            ") "
+            "UPDATE direct_unread_counts duc "
+            "SET unread_count = GREATEST(duc.unread_count - 1, 0) "
+            "FROM d WHERE duc.user_id = d.receiver_id AND duc.sender_id = d.sender_id";
     
     char sender_str[32], receiver_str[32];
     snprintf(sender_str, sizeof(sender_str), "%d", sender_id);
@@ -176,9 +211,9 @@ int mark_message_as_delivered(PGconn *conn, int sender_id, int receiver_id, cons
     int success = (PQresultStatus(res) == PGRES_COMMAND_OK);
     
     if (success) {
-        printf("DEBUG: Message marked as delivered in database\n");
+        LOG_DEBUG("Message marked as delivered in database");
     } else {
-        printf("ERROR: Failed to update delivery status: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("Failed to update delivery status: %s", PQerrorMessage(conn));
     }
     
     PQclear(res);
@@ -202,8 +237,8 @@ int mark_message_as_delivered(PGconn *conn, int sender_id, int receiver_id, cons
 void handle_send_message(Server *server, ClientSession *client, ParsedCommand *cmd) {
     char *response = NULL;
     
-    printf("\n=== HANDLE SEND MESSAGE ===\n");
-    printf("DEBUG: From user '%s' (ID:%d)\n", client->username, client->user_id);
+    LOG_DEBUG("=== HANDLE SEND MESSAGE ===");
+    LOG_DEBUG("From user '%s' (ID:%d)", client->username, client->user_id);
     
     // Check authentication
     if (!check_authentication(server, client)) {
@@ -213,15 +248,15 @@ void handle_send_message(Server *server, ClientSession *client, ParsedCommand *c
     const char *receiver_username = cmd->target_user;
     const char *message_text = cmd->message;
     
-    printf("DEBUG: Target user: '%s'\n", receiver_username);
-    printf("DEBUG: Message: '%s'\n", message_text);
+    LOG_DEBUG("Target user: '%s'", receiver_username);
+    LOG_TRACE("Message: '%s'", message_text);
     
     // Validate and get receiver ID
     int receiver_id = validate_target_user(server, client, receiver_username, "Receiver");
     if (receiver_id < 0) {
         return;
     }
-    printf("DEBUG: Found receiver '%s' with ID: %d\n", receiver_username, receiver_id);
+    LOG_DEBUG("Found receiver '%s' with ID: %d", receiver_username, receiver_id);
     
     // Check not send message to yourself
     if (receiver_id == client->user_id) {
@@ -238,7 +273,7 @@ void handle_send_message(Server *server, ClientSession *client, ParsedCommand *c
                           "Users are not friends");
         return;
     }
-    printf("DEBUG: Users are friends - OK\n");
+    LOG_DEBUG("Users are friends - OK");
     
     // Check message text is blank?
     if (!message_text || strlen(message_text) == 0) {
@@ -265,7 +300,7 @@ void handle_send_message(Server *server, ClientSession *client, ParsedCommand *c
                           "Failed to save message to database");
         return;
     }
-    printf("DEBUG: Message saved to database - OK\n");
+    LOG_DEBUG("Message saved to database - OK");
     
     // Set current chat partner for both sender and receiver
     strncpy(client->current_chat_partner, receiver_username, MAX_USERNAME_LENGTH - 1);
@@ -275,7 +310,7 @@ void handle_send_message(Server *server, ClientSession *client, ParsedCommand *c
     
     if (receiver_client && receiver_client->is_authenticated) {
         // Receiver is online - Forward message realtime
-        printf("DEBUG: Receiver is ONLINE - Forwarding message\n");
+        LOG_DEBUG("Receiver is ONLINE - Forwarding message");
         
         // Set chat partner for receiver as well
         strncpy(receiver_client->current_chat_partner, client->username, MAX_USERNAME_LENGTH - 1);
@@ -287,14 +322,13 @@ void handle_send_message(Server *server, ClientSession *client, ParsedCommand *c
         response = build_response(STATUS_MSG_OK, "OK - Message sent successfully (delivered)");
     } else {
         // Receiver offline - Only save to database (is_read = FALSE by default)
-        printf("DEBUG: Receiver is OFFLINE - Message saved for later\n");
+        LOG_DEBUG("Receiver is OFFLINE - Message saved for later");
         response = build_response(STATUS_OFFLINE_MSG_OK, "OK - Message sent successfully (stored for offline)");
     }
     
     server_send_response(client, response);
     free(response);
     
-    printf("=== END HANDLE SEND MESSAGE ===\n\n");
 }
 
 /**
@@ -337,7 +371,16 @@ int check_friendship(PGconn *conn, int user_id1, int user_id2) {
  **/
 int save_message_to_database(PGconn *conn, int sender_id, int receiver_id, const char *message_text) {
     // Use parameterized query to avoid SQL injection and escape errors
-    const char *query = "INSERT INTO messages (sender_id, receiver_id, content) VALUES ($1, $2, $3)";
+    // The receiver's unread counter for this sender is bumped in the same statement
+    const char *query =
+            "WITH m AS ("
+            "    INSERT INTO messages (sender_id, receiver_id, content) VALUES ($1, $2, $3) "
+            "    RETURNING receiver_id, sender_id"
+            ") "
+            "INSERT INTO direct_unread_counts (user_id, sender_id, unread_count) "
+            "SELECT receiver_id, sender_id, 1 FROM m "
+            "ON CONFLICT (user_id, sender_id) "
+            "DO UPDATE SET unread_count = direct_unread_counts.unread_count + 1";
     
     // Convert int to string
     char sender_str[32], receiver_str[32];
@@ -349,7 +392,7 @@ int save_message_to_database(PGconn *conn, int sender_id, int receiver_id, const
     PGresult *res = PQexecParams(conn, query, 3, NULL, paramValues, NULL, NULL, 0);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "ERROR: Failed to insert message into database: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("Failed to insert message into database: %s", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
@@ -375,7 +418,7 @@ int forward_message_to_online_user(Server *server, int receiver_id, const char *
         return 0;  // Receiver not online
     }
     
-    printf("DEBUG: Forwarding message to online user ID:%d\n", receiver_id);
+    LOG_DEBUG("Forwarding message to online user ID:%d", receiver_id);
     
     // Create notification message
     char notification[BUFFER_SIZE];
@@ -417,19 +460,67 @@ ClientSession* find_client_by_user_id(Server *server, int user_id) {
 }
 
 /**
- * @function handle_get_offline_messages: Handle retrieving offline messages from a specific sender.
+ * @function fetch_offline_page: Fetch one keyset page of undelivered messages.
+ * 
+ * @param conn: Database connection.
+ * @param sender_id: Sender's user ID.
+ * @param receiver_id: Receiver's user ID.
+ * @param cursor: Only messages with id greater than this are returned.
+ * 
+ * @return: PGresult with (id, content, created_at) rows ordered by id, or NULL on error.
+ **/
+static PGresult* fetch_offline_page(PGconn *conn, int sender_id, int receiver_id, int cursor) {
+    const char *query =
+            "SELECT id, content, created_at "
+            "FROM messages "
+            "WHERE sender_id = $1 AND receiver_id = $2 AND is_delivered = FALSE "
+            "AND id > $3 "
+            "ORDER BY id ASC "
+            "LIMIT $4";
+    
+    char sender_str[32], receiver_str[32], cursor_str[32], limit_str[32];
+    snprintf(sender_str, sizeof(sender_str), "%d", sender_id);
+    snprintf(receiver_str, sizeof(receiver_str), "%d", receiver_id);
+    snprintf(cursor_str, sizeof(cursor_str), "%d", cursor);
+    snprintf(limit_str, sizeof(limit_str), "%d", OFFLINE_PAGE_ROWS);
+    
+    const char *paramValues[4] = {sender_str, receiver_str, cursor_str, limit_str};
+    
+    PGresult *res = PQexecParams(conn, query, 4, NULL, paramValues, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("Offline page query failed: %s", PQerrorMessage(conn));
+        PQclear(res);
+        return NULL;
+    }
+    
+    return res;
+}
+
+/**
+ * @function handle_get_offline_messages: Stream offline messages from a specific sender in pages.
+ * 
+ * Messages are read with keyset pagination (id > cursor) and each page is sent
+ * as its own "118" frame of at most OFFLINE_PAGE_BYTES of text. A request sends
+ * up to OFFLINE_PAGE_WINDOW pages; the last frame of the window carries end=1,
+ * and if more=1 the client requests the rest with the returned cursor. The
+ * stream terminates with more=0 or with a 218 frame. A page is marked
+ * delivered only after it has been completely written to the socket.
+ * 
+ * Frame format:
+ *   118 OFFLINE_PAGE from=<sender> page=<n> count=<rows> cursor=<last_id> more=<0|1> end=<0|1>\n
+ *   [created_at] content\n ...
  * 
  * @param server: Pointer to Server structure managing database connection.
  * @param client: Pointer to the client session requesting offline messages.
- * @param cmd: Pointer to parsed command containing sender's username.
+ * @param cmd: Pointer to parsed command containing sender's username and optional cursor.
  * 
  * @return: None (void function, sends messages to client).
  **/
 void handle_get_offline_messages(Server *server, ClientSession *client, ParsedCommand *cmd) {
     char *response = NULL;
     
-    printf("\n=== OFFLINE MESSAGES ===\n");
-    printf("DEBUG: User '%s' (ID:%d) requesting offline messages\n", 
+    LOG_DEBUG("=== OFFLINE MESSAGES ===");
+    LOG_DEBUG("User '%s' (ID:%d) requesting offline messages", 
            client->username, client->user_id);
     
     // Check authentication
@@ -439,80 +530,209 @@ void handle_get_offline_messages(Server *server, ClientSession *client, ParsedCo
     
     // Validate and get sender ID
     const char *sender_username = cmd->target_user;
-    printf("DEBUG: Fetching offline messages from '%s'\n", sender_username);
+    int cursor = (cmd->message[0] != '\0') ? atoi(cmd->message) : 0;
+    if (cursor < 0) cursor = 0;
+    LOG_DEBUG("Fetching offline messages from '%s' after id %d", sender_username, cursor);
     
     int sender_id = validate_target_user(server, client, sender_username, "Sender");
     if (sender_id < 0) {
         return;
     }
-    printf("DEBUG: Found sender '%s' with ID: %d\n", sender_username, sender_id);
-    
-    // Get unread messages (is_delivered = FALSE)
-    char query[512];
-    snprintf(query, sizeof(query),
-            "SELECT id, content, created_at "
-            "FROM messages "
-            "WHERE sender_id = %d AND receiver_id = %d AND is_delivered = FALSE "
-            "ORDER BY created_at ASC",
-            sender_id, client->user_id);
-    
-    PGresult *res = execute_query_with_result(server->db_conn, query);
-    if (!res) {
+    LOG_DEBUG("Found sender '%s' with ID: %d", sender_username, sender_id);
+    
+    // A page may exceed the budget only by its first row, which is bounded by
+    // the protocol's message length
+    size_t page_capacity = MAX_MESSAGE_LENGTH + 128;
+    char *page_text = (char*)malloc(page_capacity);
+    char *frame_text = (char*)malloc(page_capacity + 256);
+    int *page_ids = (int*)malloc(OFFLINE_PAGE_ROWS * sizeof(int));
+    if (!page_text || !frame_text || !page_ids) {
+        free(page_text);
+        free(frame_text);
+        free(page_ids);
         send_error_response(client, STATUS_DATABASE_ERROR,
-                          "UNKNOWN_ERROR - Failed to fetch offline messages",
-                          "Database query failed");
+                          "UNKNOWN_ERROR - Out of memory", "malloc failed");
         return;
     }
     
-    int num_messages = PQntuples(res);
-    
-    if (num_messages == 0) {
+    int pages_sent = 0;
+    int total_delivered = 0;
+    int more = 1;
+    
+    while (more && pages_sent < OFFLINE_PAGE_WINDOW) {
+        PGresult *res = fetch_offline_page(server->db_conn, sender_id, client->user_id, cursor);
+        if (!res) {
+            send_error_response(client, STATUS_DATABASE_ERROR,
+                              "UNKNOWN_ERROR - Failed to fetch offline messages",
+                              "Database query failed");
+            break;
+        }
+        
+        // An empty page also terminates a stream whose previous page ended
+        // exactly on a page boundary
+        int num_rows = PQntuples(res);
+        if (num_rows == 0) {
+            PQclear(res);
+            more = 0;
+            LOG_DEBUG("No (more) offline messages from '%s'", sender_username);
+            response = build_response(STATUS_NOT_HAVE_OFFLINE_MESSAGE, "No offline messages");
+            server_send_response(client, response);
+            free(response);
+            break;
+        }
+        
+        // Fill the page up to the byte budget; rows that do not fit are left
+        // for the next page. The first row is always taken so a single long
+        // message cannot stall the stream.
+        int offset = 0;
+        int id_count = 0;
+        int page_cursor = cursor;
+        
+        for (int i = 0; i < num_rows; i++) {
+            const char *created_at = PQgetvalue(res, i, 2);
+            const char *content = PQgetvalue(res, i, 1);
+            int line_len = snprintf(NULL, 0, "[%s] %s\n", created_at, content);
+            
+            if (id_count > 0 && offset + line_len > OFFLINE_PAGE_BYTES) {
+                break;
+            }
+            
+            if (offset + line_len >= (int)page_capacity) {
+                line_len = (int)page_capacity - offset - 1;
+            }
+            snprintf(page_text + offset, page_capacity - offset,
+                    "[%s] %s\n", created_at, content);
+            offset += line_len;
+            
+            page_ids[id_count++] = atoi(PQgetvalue(res, i, 0));
+            page_cursor = page_ids[id_count - 1];
+        }
+        
+        // A short result set means this page reaches the end of the backlog
+        more = (id_count < num_rows) || (num_rows == OFFLINE_PAGE_ROWS);
         PQclear(res);
-        printf("DEBUG: No offline messages from '%s'\n", sender_username);
-        response = build_response(STATUS_NOT_HAVE_OFFLINE_MESSAGE, "No offline messages");
-        server_send_response(client, response);
+        
+        int end = !more || (pages_sent + 1 == OFFLINE_PAGE_WINDOW);
+        snprintf(frame_text, page_capacity + 256,
+                "OFFLINE_PAGE from=%s page=%d count=%d cursor=%d more=%d end=%d\n%.*s",
+                sender_username, pages_sent + 1, id_count, page_cursor, more, end,
+                offset, page_text);
+        
+        response = build_large_response(STATUS_GET_OFFLINE_MSG_OK, frame_text);
+        int sent = response ? server_send_response(client, response) : -1;
         free(response);
-        return;
+        
+        if (sent < 0) {
+            LOG_ERROR("Failed to send offline page %d, leaving it undelivered",
+                   pages_sent + 1);
+            break;
+        }
+        
+        mark_messages_as_delivered(server->db_conn, page_ids, id_count);
+        total_delivered += id_count;
+        cursor = page_cursor;
+        pages_sent++;
     }
     
-    printf("DEBUG: Found %d offline message(s)\n", num_messages);
+    free(page_text);
+    free(frame_text);
+    free(page_ids);
     
-    // Create response containing all messages
-    char message_list[BUFFER_SIZE * 2];
-    int offset = 0;
-    
-    offset += snprintf(message_list + offset, sizeof(message_list) - offset,
-                      "\n=== SHOW OFFLINE MESSAGES FROM %s ===\n", sender_username);
+    LOG_DEBUG("Streamed %d page(s), %d message(s), next cursor %d%s",
+           pages_sent, total_delivered, cursor, more ? " (more pending)" : "");
+}
+
+// ============================================================================
+// MAIN HANDLER: Unread Summary
+// ============================================================================
+
+/**
+ * @function handle_unread_summary: Report unread counts for every conversation in one read.
+ * 
+ * Counters are maintained on insert and on delivery/read, so this is a pair
+ * of indexed lookups rather than a scan of message history.
+ * 
+ * Response format:
+ *   125 UNREAD_SUMMARY direct=<n> groups=<n>, followed by one
+ *   "DM <sender> <count>" or "GROUP <group_name> <count>" line per conversation.
+ *   Lines that would not fit in one response are dropped whole and replaced
+ *   by a final "... <n> more" line; the totals always cover every row.
+ * 
+ * @param server: Pointer to Server structure managing database connection.
+ * @param client: Pointer to the client session requesting the summary.
+ * @param cmd: Pointer to parsed command (no parameters).
+ * 
+ * @return: None (void function, sends summary to client).
+ **/
+void handle_unread_summary(Server *server, ClientSession *client, ParsedCommand *cmd __attribute__((unused))) {
+    if (!check_authentication(server, client)) {
+        return;
+    }
     
-    // Store message IDs for update later
-    int message_ids[100];  // Maximum 100 messages
-    int id_count = 0;
+    const char *query =
+            "SELECT 'DM', u.username, d.unread_count "
+            "FROM direct_unread_counts d JOIN users u ON u.id = d.sender_id "
+            "WHERE d.user_id = $1 AND d.unread_count > 0 "
+            "UNION ALL "
+            "SELECT 'GROUP', g.group_name, m.unread_count "
+            "FROM group_members m JOIN groups g ON g.id = m.group_id "
+            "WHERE m.user_id = $1 AND m.unread_count > 0";
+    
+    char user_str[32];
+    snprintf(user_str, sizeof(user_str), "%d", client->user_id);
+    const char *paramValues[1] = {user_str};
+    
+    PGresult *res = PQexecParams(server->db_conn, query, 1, NULL, paramValues, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("Unread summary query failed: %s", PQerrorMessage(server->db_conn));
+        PQclear(res);
+        send_error_response(client, STATUS_DATABASE_ERROR,
+                          "DATABASE_ERROR - Failed to load unread counts", NULL);
+        return;
+    }
     
-    for (int i = 0; i < num_messages && offset < (int)sizeof(message_list) - 500; i++) {
-        const char *content = PQgetvalue(res, i, 1);
-        const char *created_at = PQgetvalue(res, i, 2);
-        int msg_id = atoi(PQgetvalue(res, i, 0));
+    // Room for the header, status code and delimiter, and the "more" line
+    char lines[MAX_MESSAGE_LENGTH - 128];
+    int limit = (int)sizeof(lines) - 32;
+    int offset = 0;
+    int omitted = 0;
+    long direct_total = 0, group_total = 0;
+    int rows = PQntuples(res);
+    
+    lines[0] = '\0';
+    for (int i = 0; i < rows; i++) {
+        const char *kind = PQgetvalue(res, i, 0);
+        int count = atoi(PQgetvalue(res, i, 2));
         
-        if (id_count < 100) {
-            message_ids[id_count++] = msg_id;
+        if (strcmp(kind, "DM") == 0) {
+            direct_total += count;
+        } else {
+            group_total += count;
         }
         
-        offset += snprintf(message_list + offset, sizeof(message_list) - offset,
-                          "[%s] %s\n", created_at, content);
+        const char *name = PQgetvalue(res, i, 1);
+        int line_len = snprintf(NULL, 0, "\n%s %s %d", kind, name, count);
+        if (omitted > 0 || offset + line_len > limit) {
+            omitted++;
+            continue;
+        }
+        offset += snprintf(lines + offset, sizeof(lines) - offset,
+                          "\n%s %s %d", kind, name, count);
     }
-    
-    offset += snprintf(message_list + offset, sizeof(message_list) - offset,
-                      "=== END OF OFFLINE MESSAGES (%d total) ===", num_messages);
-    
     PQclear(res);
     
-    // Update is_delivered = TRUE for all sent messages
-    mark_messages_as_delivered(server->db_conn, message_ids, id_count);
+    if (omitted > 0) {
+        snprintf(lines + offset, sizeof(lines) - offset, "\n... %d more", omitted);
+    }
     
-    // Send response
-    response = build_response(STATUS_GET_OFFLINE_MSG_OK, message_list);
+    char summary[MAX_MESSAGE_LENGTH];
+    snprintf(summary, sizeof(summary), "UNREAD_SUMMARY direct=%ld groups=%ld%s",
+            direct_total, group_total, lines);
+    
+    char *response = build_response(STATUS_UNREAD_SUMMARY_OK, summary);
     server_send_response(client, response);
     free(response);
     
-    printf("=== END HANDLE GET OFFLINE MESSAGES ===\n\n");
-}
\ No newline at end of file
+    LOG_DEBUG("Unread summary for '%s': direct=%ld groups=%ld",
+           client->username, direct_total, group_total);
+}
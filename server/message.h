@@ -4,13 +4,22 @@
 #include "../server/server.h"
 #include "../common/protocol.h"
 
+// Offline delivery paging: rows fetched per page query, text budget per page
+// frame (kept well inside the client's stream buffer) and pages sent per
+// GET_OFFLINE_MSG request before the client must ask again.
+#define OFFLINE_PAGE_ROWS 50
+#define OFFLINE_PAGE_BYTES (MAX_MESSAGE_LENGTH - 256)
+#define OFFLINE_PAGE_WINDOW 4
+
 // Main handler functions
 void handle_send_message(Server *server, ClientSession *client, ParsedCommand *cmd);
 void handle_get_offline_messages(Server *server, ClientSession *client, ParsedCommand *cmd);
+void handle_unread_summary(Server *server, ClientSession *client, ParsedCommand *cmd);
 
 int check_friendship(PGconn *conn, int user_id1, int user_id2);
 int save_message_to_database(PGconn *conn, int sender_id, int receiver_id, const char *message_text);
 int forward_message_to_online_user(Server *server, int receiver_id, const char *sender_username, const char *message_text);
+int mark_messages_as_delivered(PGconn *conn, int *message_ids, int count);
 ClientSession* find_client_by_user_id(Server *server, int user_id);
 
 #endif
\ No newline at end of file
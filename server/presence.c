@@ -0,0 +1,390 @@
+#include "presence.h"
+#include "../common/metrics.h"
+#include "../common/log.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int user_id;                         // 0 = empty slot
+    PresenceState state;
+    PresenceState stored;                // Last value written to users.is_online
+    time_t last_seen;                    // Time of the last state change
+    PresenceState announced;             // Last state pushed to subscribed friends
+    uint64_t announced_ns;
+    uint64_t due_ns;                     // Non-zero while on the pending list
+} PresenceEntry;
+
+struct PresenceRegistry {
+    PresenceEntry *entries;              // Open addressing, linear probing, never shrinks
+    size_t capacity;                     // Power of two
+    size_t count;
+    int online;
+    int dirty;                           // Entries whose state != stored
+    time_t last_flush;
+    int *pending;                        // user_ids waiting for their window to close
+    int pending_count;
+    int pending_capacity;
+    uint64_t coalesce_ns;
+};
+
+// ============================================================================
+// Table
+// ============================================================================
+
+/**
+ * @function slot_for: Find user_id's slot, or the empty slot where it belongs.
+ */
+static PresenceEntry* slot_for(PresenceEntry *entries, size_t capacity, int user_id) {
+    size_t i = ((uint32_t)user_id * 2654435761u) & (capacity - 1);
+    while (entries[i].user_id != 0 && entries[i].user_id != user_id) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &entries[i];
+}
+
+/**
+ * @function grow: Double the table.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int grow(PresenceRegistry *registry) {
+    size_t capacity = registry->capacity * 2;
+    PresenceEntry *entries = (PresenceEntry*)calloc(capacity, sizeof(PresenceEntry));
+    if (!entries) return 0;
+
+    for (size_t i = 0; i < registry->capacity; i++) {
+        if (registry->entries[i].user_id == 0) continue;
+        *slot_for(entries, capacity, registry->entries[i].user_id) = registry->entries[i];
+    }
+    free(registry->entries);
+    registry->entries = entries;
+    registry->capacity = capacity;
+    return 1;
+}
+
+/**
+ * @function lookup: Find an entry without inserting.
+ */
+static const PresenceEntry* lookup(const PresenceRegistry *registry, int user_id) {
+    if (!registry || user_id <= 0) return NULL;
+    const PresenceEntry *entry = slot_for(registry->entries, registry->capacity, user_id);
+    return entry->user_id == user_id ? entry : NULL;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+/**
+ * @function presence_create: Allocate an empty registry (everyone offline).
+ *
+ * @return Registry, or NULL on allocation failure.
+ */
+PresenceRegistry* presence_create(void) {
+    PresenceRegistry *registry = (PresenceRegistry*)calloc(1, sizeof(PresenceRegistry));
+    if (!registry) return NULL;
+
+    registry->capacity = PRESENCE_INITIAL_CAPACITY;
+    registry->entries = (PresenceEntry*)calloc(registry->capacity, sizeof(PresenceEntry));
+    if (!registry->entries) {
+        free(registry);
+        return NULL;
+    }
+    registry->last_flush = time(NULL);
+    
+    long coalesce_ms = PRESENCE_DEFAULT_COALESCE_MS;
+    const char *env = getenv("CHAT_PRESENCE_COALESCE_MS");
+    if (env && *env) {
+        char *end;
+        long value = strtol(env, &end, 10);
+        if (*end == '\0' && value >= 0) {
+            coalesce_ms = value;
+        } else {
+            LOG_WARN("Invalid CHAT_PRESENCE_COALESCE_MS '%s', using %ld", env, coalesce_ms);
+        }
+    }
+    registry->coalesce_ns = (uint64_t)coalesce_ms * 1000000ULL;
+    return registry;
+}
+
+/**
+ * @function presence_destroy: Free the registry (flush first to persist it).
+ */
+void presence_destroy(PresenceRegistry *registry) {
+    if (!registry) return;
+    free(registry->entries);
+    free(registry->pending);
+    free(registry);
+}
+
+// ============================================================================
+// Updates and Queries
+// ============================================================================
+
+/**
+ * @function presence_set: Record a user going online or offline.
+ *
+ * @param registry Presence registry.
+ * @param user_id User whose state changed.
+ * @param state New state.
+ */
+void presence_set(PresenceRegistry *registry, int user_id, PresenceState state) {
+    if (!registry || user_id <= 0) return;
+
+    PresenceEntry *entry = slot_for(registry->entries, registry->capacity, user_id);
+    if (entry->user_id == 0) {
+        if ((registry->count + 1) * 4 > registry->capacity * 3) {
+            if (!grow(registry)) {
+                LOG_ERROR("Presence registry full, dropping update for id=%d", user_id);
+                return;
+            }
+            entry = slot_for(registry->entries, registry->capacity, user_id);
+        }
+        entry->user_id = user_id;
+        entry->state = PRESENCE_OFFLINE;
+        entry->stored = PRESENCE_OFFLINE;   // presence_reset_database() cleared the column
+        registry->count++;
+    }
+
+    entry->last_seen = time(NULL);
+    if (entry->state == state) return;
+
+    int was_dirty = entry->state != entry->stored;
+    entry->state = state;
+    registry->online += state == PRESENCE_ONLINE ? 1 : -1;
+    registry->dirty += (entry->state != entry->stored) - was_dirty;
+    
+    if (entry->due_ns) return;           // Already waiting; the final state is what gets sent
+    
+    if (registry->pending_count == registry->pending_capacity) {
+        int capacity = registry->pending_capacity ? registry->pending_capacity * 2 : 64;
+        int *pending = (int*)realloc(registry->pending, capacity * sizeof(int));
+        if (!pending) {
+            LOG_ERROR("Presence announcement queue full, dropping change for id=%d", user_id);
+            return;
+        }
+        registry->pending = pending;
+        registry->pending_capacity = capacity;
+    }
+    
+    uint64_t now_ns = metrics_now_ns();
+    uint64_t window_end = entry->announced_ns ? entry->announced_ns + registry->coalesce_ns : 0;
+    entry->due_ns = window_end > now_ns ? window_end : now_ns;
+    registry->pending[registry->pending_count++] = user_id;
+}
+
+/**
+ * @function presence_set_all_offline: Mark every user offline (server shutdown).
+ */
+void presence_set_all_offline(PresenceRegistry *registry) {
+    if (!registry) return;
+    for (size_t i = 0; i < registry->capacity; i++) {
+        if (registry->entries[i].user_id != 0 && registry->entries[i].state == PRESENCE_ONLINE) {
+            presence_set(registry, registry->entries[i].user_id, PRESENCE_OFFLINE);
+        }
+    }
+}
+
+/**
+ * @function presence_get: Current state of a user (unknown users are offline).
+ */
+PresenceState presence_get(const PresenceRegistry *registry, int user_id) {
+    const PresenceEntry *entry = lookup(registry, user_id);
+    return entry ? entry->state : PRESENCE_OFFLINE;
+}
+
+/**
+ * @function presence_last_seen: When the user last logged in or out (0 = not since startup).
+ */
+time_t presence_last_seen(const PresenceRegistry *registry, int user_id) {
+    const PresenceEntry *entry = lookup(registry, user_id);
+    return entry ? entry->last_seen : 0;
+}
+
+/**
+ * @function presence_online_count: Users currently online.
+ */
+int presence_online_count(const PresenceRegistry *registry) {
+    return registry ? registry->online : 0;
+}
+
+// ============================================================================
+// Announcements
+// ============================================================================
+
+/**
+ * @function presence_take_due: Collect changes whose coalescing window has closed.
+ *
+ * A user whose state is back to what was last announced is dropped from the
+ * queue without producing a change.
+ *
+ * @param registry Presence registry.
+ * @param now_ns Current monotonic time.
+ * @param out Receives the changes to announce.
+ * @param max Capacity of out.
+ *
+ * @return Number of changes written to out.
+ */
+int presence_take_due(PresenceRegistry *registry, uint64_t now_ns, PresenceChange *out, int max) {
+    if (!registry || !out) return 0;
+
+    int n = 0;
+    int i = 0;
+    while (i < registry->pending_count && n < max) {
+        PresenceEntry *entry = slot_for(registry->entries, registry->capacity, registry->pending[i]);
+        if (entry->due_ns > now_ns) {
+            i++;
+            continue;
+        }
+
+        entry->due_ns = 0;
+        if (entry->state != entry->announced) {
+            entry->announced = entry->state;
+            entry->announced_ns = now_ns;
+            out[n].user_id = entry->user_id;
+            out[n].state = entry->state;
+            n++;
+        }
+        registry->pending[i] = registry->pending[--registry->pending_count];
+    }
+    return n;
+}
+
+/**
+ * @function presence_next_due_ns: When the earliest held-back change is due.
+ *
+ * @return Monotonic time in ns, or 0 if nothing is pending.
+ */
+uint64_t presence_next_due_ns(const PresenceRegistry *registry) {
+    if (!registry) return 0;
+
+    uint64_t next = 0;
+    for (int i = 0; i < registry->pending_count; i++) {
+        const PresenceEntry *entry = lookup(registry, registry->pending[i]);
+        if (entry && (next == 0 || entry->due_ns < next)) next = entry->due_ns;
+    }
+    return next;
+}
+
+// ============================================================================
+// Durability
+// ============================================================================
+
+/**
+ * @function write_batch: One UPDATE for up to PRESENCE_FLUSH_BATCH changed users.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int write_batch(PGconn *conn, const char *ids, const char *states) {
+    const char *paramValues[2] = {ids, states};
+    PGresult *res = PQexecParams(conn,
+            "UPDATE users u SET is_online = v.online "
+            "FROM unnest($1::int[], $2::bool[]) AS v(id, online) "
+            "WHERE u.id = v.id",
+            2, NULL, paramValues, NULL, NULL, 0);
+
+    int ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (!ok) {
+        LOG_WARN("Failed to persist presence: %s", PQerrorMessage(conn));
+    }
+    PQclear(res);
+    return ok;
+}
+
+/**
+ * @function presence_flush: Write changed states to users.is_online.
+ *
+ * Entries are marked stored only after their batch commits, so a failed
+ * write is retried at the next flush.
+ *
+ * @param registry Presence registry.
+ * @param conn Database connection.
+ * @param force Write now even if PRESENCE_FLUSH_INTERVAL has not passed.
+ *
+ * @return Users written, or -1 if a batch failed.
+ */
+int presence_flush(PresenceRegistry *registry, PGconn *conn, int force) {
+    if (!registry || !conn || registry->dirty == 0) return 0;
+
+    time_t now = time(NULL);
+    if (!force && now - registry->last_flush < PRESENCE_FLUSH_INTERVAL) return 0;
+    registry->last_flush = now;
+
+    size_t ids_size = PRESENCE_FLUSH_BATCH * 12 + 3;
+    size_t states_size = PRESENCE_FLUSH_BATCH * 2 + 3;
+    char *ids = (char*)malloc(ids_size);
+    char *states = (char*)malloc(states_size);
+    size_t *batch = (size_t*)malloc(PRESENCE_FLUSH_BATCH * sizeof(size_t));
+    if (!ids || !states || !batch) {
+        free(ids);
+        free(states);
+        free(batch);
+        return -1;
+    }
+
+    int written = 0;
+    int failed = 0;
+    size_t i = 0;
+    while (i < registry->capacity && !failed) {
+        int n = 0;
+        int ids_len = snprintf(ids, ids_size, "{");
+        int states_len = snprintf(states, states_size, "{");
+
+        for (; i < registry->capacity && n < PRESENCE_FLUSH_BATCH; i++) {
+            PresenceEntry *entry = &registry->entries[i];
+            if (entry->user_id == 0 || entry->state == entry->stored) continue;
+            ids_len += snprintf(ids + ids_len, ids_size - ids_len, "%s%d", n ? "," : "", entry->user_id);
+            states_len += snprintf(states + states_len, states_size - states_len, "%s%c",
+                                   n ? "," : "", entry->state == PRESENCE_ONLINE ? 't' : 'f');
+            batch[n++] = i;
+        }
+        if (n == 0) break;
+
+        snprintf(ids + ids_len, ids_size - ids_len, "}");
+        snprintf(states + states_len, states_size - states_len, "}");
+
+        if (!write_batch(conn, ids, states)) {
+            failed = 1;
+            break;
+        }
+        for (int j = 0; j < n; j++) {
+            registry->entries[batch[j]].stored = registry->entries[batch[j]].state;
+        }
+        registry->dirty -= n;
+        written += n;
+    }
+
+    free(ids);
+    free(states);
+    free(batch);
+
+    if (written > 0) {
+        LOG_DEBUG("Persisted presence for %d user(s)", written);
+    }
+    return failed ? -1 : written;
+}
+
+/**
+ * @function presence_reset_database: Clear users.is_online left over from a previous run.
+ *
+ * At startup nobody is connected, which is what the empty registry says.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+int presence_reset_database(PGconn *conn) {
+    if (!conn) return 0;
+    PGresult *res = PQexec(conn, "UPDATE users SET is_online = FALSE WHERE is_online");
+    int ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (ok) {
+        const char *rows = PQcmdTuples(res);
+        if (rows && atoi(rows) > 0) {
+            LOG_INFO("Cleared stale online flag for %s user(s)", rows);
+        }
+    } else {
+        LOG_WARN("Failed to reset users.is_online: %s", PQerrorMessage(conn));
+    }
+    PQclear(res);
+    return ok;
+}
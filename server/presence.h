@@ -0,0 +1,67 @@
+// ============================================================================
+// presence.h - In-memory online status
+// ============================================================================
+//
+// The server knows which users are connected, so it keeps presence itself
+// instead of writing users.is_online on every login, logout and disconnect
+// and reading it back in FRIEND_LIST. The registry maps user_id to state and
+// last change time and is the source of truth while the server runs.
+//
+// users.is_online is still maintained for other readers (db_manager, ad-hoc
+// SQL), but lazily: changed entries are written in one batched UPDATE at
+// most every PRESENCE_FLUSH_INTERVAL seconds, and at shutdown. A user who
+// logs in and out within one interval costs no database write at all.
+//
+// Changes are also announced to subscribed friends (PRESENCE_SUBSCRIBE).
+// The first change after a quiet period is announced at once; further
+// changes within CHAT_PRESENCE_COALESCE_MS (default 2000) are held back and
+// only the final state is sent, so a flapping connection produces at most
+// one announcement per window and a flap that ends where it started
+// produces none.
+
+#ifndef PRESENCE_H
+#define PRESENCE_H
+
+#include <stdint.h>
+#include <time.h>
+#include <libpq-fe.h>
+
+#define PRESENCE_INITIAL_CAPACITY 256
+#define PRESENCE_FLUSH_INTERVAL 5        // Seconds between batched is_online writes
+#define PRESENCE_FLUSH_BATCH 1000        // Users per UPDATE statement
+#define PRESENCE_DEFAULT_COALESCE_MS 2000
+
+typedef enum {
+    PRESENCE_OFFLINE,
+    PRESENCE_ONLINE
+} PresenceState;
+
+typedef struct {
+    int user_id;
+    PresenceState state;
+} PresenceChange;
+
+typedef struct PresenceRegistry PresenceRegistry;
+
+// Lifecycle
+PresenceRegistry* presence_create(void);
+void presence_destroy(PresenceRegistry *registry);
+
+// Updates (event loop only)
+void presence_set(PresenceRegistry *registry, int user_id, PresenceState state);
+void presence_set_all_offline(PresenceRegistry *registry);
+
+// Queries
+PresenceState presence_get(const PresenceRegistry *registry, int user_id);
+time_t presence_last_seen(const PresenceRegistry *registry, int user_id);
+int presence_online_count(const PresenceRegistry *registry);
+
+// Announcements: changes whose coalescing window has closed (0 = none pending)
+int presence_take_due(PresenceRegistry *registry, uint64_t now_ns, PresenceChange *out, int max);
+uint64_t presence_next_due_ns(const PresenceRegistry *registry);
+
+// Durability (force: ignore PRESENCE_FLUSH_INTERVAL); returns rows written or -1
+int presence_flush(PresenceRegistry *registry, PGconn *conn, int force);
+int presence_reset_database(PGconn *conn);
+
+#endif
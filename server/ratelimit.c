@@ -0,0 +1,385 @@
+#include "ratelimit.h"
+#include "../common/metrics.h"
+#include "../common/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef struct {
+    char key[RATE_KEY_LENGTH];           // Empty: free slot
+    double tokens;
+    uint64_t updated_ns;
+} RateBucket;
+
+typedef struct {
+    double per_second;                   // Refill rate; 0 disables the scope
+    double burst;                        // Bucket capacity
+    RateBucket *buckets;
+} RateTable;
+
+struct RateLimiter {
+    RateTable tables[RATE_SCOPES];
+    int max_inflight;
+    uint64_t rejected[RATE_SCOPES];
+    RateTable classes[RATE_CLASSES];     // Rates only; the buckets live in each session
+    uint64_t class_rejected[RATE_CLASSES];
+    uint64_t pauses;
+};
+
+static const char *scope_names[RATE_SCOPES] = {
+    [RATE_SCOPE_CONNECT] = "connect",
+    [RATE_SCOPE_AUTH_IP] = "auth_ip",
+    [RATE_SCOPE_AUTH_USER] = "auth_user",
+    [RATE_SCOPE_AUTH_INFLIGHT] = "auth_inflight",
+};
+
+static const char *class_names[RATE_CLASSES] = {
+    [RATE_CLASS_SESSION] = "session",
+    [RATE_CLASS_MESSAGE] = "message",
+    [RATE_CLASS_READ] = "read",
+    [RATE_CLASS_ADMIN] = "admin",
+};
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @function key_hash: FNV-1a over the key.
+ */
+static uint32_t key_hash(const char *key) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char*)key; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @function refill: Bring a bucket's token count up to now.
+ */
+static void refill(const RateTable *table, RateBucket *bucket, uint64_t now_ns) {
+    double elapsed = (now_ns - bucket->updated_ns) / 1e9;
+    bucket->tokens = fmin(table->burst, bucket->tokens + elapsed * table->per_second);
+    bucket->updated_ns = now_ns;
+}
+
+/**
+ * @function find_bucket: Locate key's bucket, claiming one if it has none.
+ *
+ * Probes RATE_PROBE_LIMIT slots. A new key takes the first free slot, else a
+ * slot whose bucket has refilled completely (indistinguishable from a fresh
+ * one), else the least recently updated slot in the window.
+ */
+static RateBucket* find_bucket(RateTable *table, const char *key, uint64_t now_ns) {
+    uint32_t start = key_hash(key) % RATE_TABLE_SIZE;
+    RateBucket *victim = NULL;
+
+    for (int i = 0; i < RATE_PROBE_LIMIT; i++) {
+        RateBucket *bucket = &table->buckets[(start + i) % RATE_TABLE_SIZE];
+        if (bucket->key[0] == '\0') {
+            if (!victim || victim->key[0] != '\0') victim = bucket;
+            continue;
+        }
+        if (strcmp(bucket->key, key) == 0) return bucket;
+        if (victim && victim->key[0] == '\0') continue;
+
+        double idle = (now_ns - bucket->updated_ns) / 1e9;
+        if (bucket->tokens + idle * table->per_second >= table->burst) {
+            victim = bucket;   // Full again: forgetting it changes nothing
+        } else if (!victim || bucket->updated_ns < victim->updated_ns) {
+            victim = bucket;
+        }
+    }
+
+    snprintf(victim->key, sizeof(victim->key), "%s", key);
+    victim->tokens = table->burst;
+    victim->updated_ns = now_ns;
+    return victim;
+}
+
+/**
+ * @function parse_limit: Read "<per minute>[/<burst>]" from the environment.
+ */
+static void parse_limit(RateTable *table, const char *name, double per_minute, double burst) {
+    const char *env = getenv(name);
+    if (env && *env) {
+        char *end;
+        double value = strtod(env, &end);
+        double value_burst = value;
+        if (*end == '/') value_burst = strtod(end + 1, &end);
+        if (*end == '\0' && value >= 0 && (value == 0 || value_burst >= 1)) {
+            per_minute = value;
+            burst = value_burst;
+        } else {
+            LOG_WARN("Invalid %s '%s', using %.0f/%.0f", name, env, per_minute, burst);
+        }
+    }
+    table->per_second = per_minute / 60.0;
+    table->burst = burst;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+/**
+ * @function rate_limiter_create: Allocate the bucket tables from CHAT_RATE_* settings.
+ *
+ * @return Limiter, or NULL on allocation failure.
+ */
+RateLimiter* rate_limiter_create(void) {
+    RateLimiter *limiter = (RateLimiter*)calloc(1, sizeof(RateLimiter));
+    if (!limiter) return NULL;
+
+    parse_limit(&limiter->tables[RATE_SCOPE_CONNECT], "CHAT_RATE_CONNECT", 60, 30);
+    parse_limit(&limiter->tables[RATE_SCOPE_AUTH_IP], "CHAT_RATE_AUTH_IP", 60, 20);
+    parse_limit(&limiter->tables[RATE_SCOPE_AUTH_USER], "CHAT_RATE_AUTH_USER", 10, 5);
+
+    for (int i = 0; i < RATE_SCOPE_AUTH_INFLIGHT; i++) {
+        if (limiter->tables[i].per_second <= 0) continue;
+        limiter->tables[i].buckets = (RateBucket*)calloc(RATE_TABLE_SIZE, sizeof(RateBucket));
+        if (!limiter->tables[i].buckets) {
+            rate_limiter_destroy(limiter);
+            return NULL;
+        }
+    }
+
+    parse_limit(&limiter->classes[RATE_CLASS_SESSION], "CHAT_RATE_SESSION", 600, 120);
+    parse_limit(&limiter->classes[RATE_CLASS_MESSAGE], "CHAT_RATE_MESSAGE", 300, 60);
+    parse_limit(&limiter->classes[RATE_CLASS_READ], "CHAT_RATE_READ", 120, 30);
+    parse_limit(&limiter->classes[RATE_CLASS_ADMIN], "CHAT_RATE_ADMIN", 60, 30);
+
+    limiter->max_inflight = RATE_DEFAULT_MAX_INFLIGHT;
+    const char *env = getenv("CHAT_AUTH_MAX_INFLIGHT");
+    if (env && *env) limiter->max_inflight = atoi(env);
+
+    LOG_INFO("Rate limits per minute: connect %.0f/%.0f, auth/IP %.0f/%.0f, auth/user %.0f/%.0f, "
+             "max %d concurrent auth",
+             limiter->tables[RATE_SCOPE_CONNECT].per_second * 60, limiter->tables[RATE_SCOPE_CONNECT].burst,
+             limiter->tables[RATE_SCOPE_AUTH_IP].per_second * 60, limiter->tables[RATE_SCOPE_AUTH_IP].burst,
+             limiter->tables[RATE_SCOPE_AUTH_USER].per_second * 60, limiter->tables[RATE_SCOPE_AUTH_USER].burst,
+             limiter->max_inflight);
+    return limiter;
+}
+
+/**
+ * @function rate_limiter_destroy: Free the bucket tables.
+ */
+void rate_limiter_destroy(RateLimiter *limiter) {
+    if (!limiter) return;
+    for (int i = 0; i < RATE_SCOPES; i++) {
+        free(limiter->tables[i].buckets);
+    }
+    free(limiter);
+}
+
+// ============================================================================
+// Admission
+// ============================================================================
+
+/**
+ * @function rate_limit_take: Spend one token from key's bucket in scope.
+ *
+ * @param limiter Rate limiter (NULL allows everything).
+ * @param scope Bucket scope.
+ * @param key Client IP or username.
+ * @param retry_after Receives seconds until a token is available (may be NULL).
+ *
+ * @return 1 if allowed, 0 if the bucket is empty.
+ */
+int rate_limit_take(RateLimiter *limiter, RateScope scope, const char *key, int *retry_after) {
+    if (!limiter || scope < 0 || scope >= RATE_SCOPE_AUTH_INFLIGHT || !key || !*key) return 1;
+
+    RateTable *table = &limiter->tables[scope];
+    if (!table->buckets) return 1;
+
+    uint64_t now_ns = metrics_now_ns();
+    RateBucket *bucket = find_bucket(table, key, now_ns);
+    refill(table, bucket, now_ns);
+
+    if (bucket->tokens >= 1.0) {
+        bucket->tokens -= 1.0;
+        return 1;
+    }
+
+    limiter->rejected[scope]++;
+    if (retry_after) *retry_after = (int)ceil((1.0 - bucket->tokens) / table->per_second);
+    return 0;
+}
+
+/**
+ * @function rate_limit_admit_auth: Check the concurrent password check cap.
+ *
+ * @param limiter Rate limiter (NULL allows everything).
+ * @param inflight Password checks currently queued or running.
+ *
+ * @return 1 if another may start, 0 otherwise.
+ */
+int rate_limit_admit_auth(RateLimiter *limiter, int inflight) {
+    if (!limiter || limiter->max_inflight <= 0 || inflight < limiter->max_inflight) return 1;
+    limiter->rejected[RATE_SCOPE_AUTH_INFLIGHT]++;
+    return 0;
+}
+
+/**
+ * @function rate_command_class: Budget class a command spends from.
+ *
+ * @param cmd_type Parsed command type.
+ *
+ * @return RateClass, or RATE_CLASS_NONE for commands outside the budgets.
+ */
+RateClass rate_command_class(CommandType cmd_type) {
+    switch (cmd_type) {
+        case CMD_MSG:
+        case CMD_GROUP_MSG:
+        case CMD_SEND_OFFLINE_MSG:
+            return RATE_CLASS_MESSAGE;
+
+        case CMD_FRIEND_LIST:
+        case CMD_FRIEND_PENDING:
+        case CMD_PRESENCE_SUBSCRIBE:
+        case CMD_FRIEND_LIST_SYNC:
+        case CMD_GET_OFFLINE_MSG:
+        case CMD_UNREAD_SUMMARY:
+        case CMD_LIST_JOIN_REQUESTS:
+        case CMD_GROUP_SEND_OFFLINE_MSG:
+        case CMD_STATS:
+            return RATE_CLASS_READ;
+
+        case CMD_FRIEND_REQ:
+        case CMD_FRIEND_ACCEPT:
+        case CMD_FRIEND_DECLINE:
+        case CMD_FRIEND_REMOVE:
+        case CMD_GROUP_CREATE:
+        case CMD_GROUP_INVITE:
+        case CMD_GROUP_JOIN:
+        case CMD_GROUP_LEAVE:
+        case CMD_GROUP_KICK:
+        case CMD_GROUP_APPROVE:
+        case CMD_GROUP_REJECT:
+            return RATE_CLASS_ADMIN;
+
+        case CMD_REGISTER:
+        case CMD_LOGIN:
+        case CMD_RESUME:
+        case CMD_LOGOUT:
+        case CMD_COMPRESS:
+        case CMD_GROUP_EXIT_MESSAGING:
+            return RATE_CLASS_NONE;
+
+        default:
+            return RATE_CLASS_SESSION;
+    }
+}
+
+/**
+ * @function rate_session_take: Spend from a session's budget before dispatching a command.
+ *
+ * The command needs a token in both the session bucket and its class
+ * bucket. A refused command is still charged to every bucket it found
+ * empty, down to one burst of debt. Reaching that floor sets pause_until_ns
+ * to the time the debt is repaid.
+ *
+ * @param limiter Rate limiter (NULL allows everything).
+ * @param budget The session's buckets.
+ * @param cmd_type Command about to run.
+ * @param pause_until_ns Set (monotonic ns) when reads from the session should stop.
+ * @param retry_after Receives seconds until the command would be accepted.
+ *
+ * @return 1 if allowed, 0 if over budget.
+ */
+int rate_session_take(RateLimiter *limiter, SessionBudget *budget, CommandType cmd_type,
+                      uint64_t *pause_until_ns, int *retry_after) {
+    RateClass rate_class = rate_command_class(cmd_type);
+    if (!limiter || !budget || rate_class == RATE_CLASS_NONE) return 1;
+
+    uint64_t now_ns = metrics_now_ns();
+    double elapsed = budget->updated_ns ? (now_ns - budget->updated_ns) / 1e9 : 0;
+    for (int i = 0; i < RATE_CLASSES; i++) {
+        const RateTable *table = &limiter->classes[i];
+        budget->tokens[i] = budget->updated_ns
+                ? fmin(table->burst, budget->tokens[i] + elapsed * table->per_second)
+                : table->burst;
+    }
+    budget->updated_ns = now_ns;
+
+    RateClass checked[2] = {RATE_CLASS_SESSION, rate_class};
+    int count = rate_class == RATE_CLASS_SESSION ? 1 : 2;
+    int allowed = 1;
+    for (int i = 0; i < count; i++) {
+        if (limiter->classes[checked[i]].per_second > 0 && budget->tokens[checked[i]] < 1.0) allowed = 0;
+    }
+
+    if (allowed) {
+        for (int i = 0; i < count; i++) budget->tokens[checked[i]] -= 1.0;
+        return 1;
+    }
+
+    double wait = 0;
+    for (int i = 0; i < count; i++) {
+        const RateTable *table = &limiter->classes[checked[i]];
+        double *tokens = &budget->tokens[checked[i]];
+        if (table->per_second <= 0 || *tokens >= 1.0) continue;
+
+        limiter->class_rejected[checked[i]]++;
+        *tokens = fmax(-table->burst, *tokens - 1.0);
+        wait = fmax(wait, (1.0 - *tokens) / table->per_second);
+
+        // Refill between commands leaves the floor a hair above -burst
+        if (*tokens <= -table->burst + 0.01 && pause_until_ns) {
+            uint64_t until = now_ns + (uint64_t)(-*tokens / table->per_second * 1e9);
+            if (until > *pause_until_ns) {
+                *pause_until_ns = until;
+                limiter->pauses++;
+            }
+        }
+    }
+
+    if (retry_after) *retry_after = (int)ceil(wait);
+    return 0;
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+/**
+ * @function rate_limit_rejected: Requests refused in a scope since startup.
+ */
+uint64_t rate_limit_rejected(const RateLimiter *limiter, RateScope scope) {
+    if (!limiter || scope < 0 || scope >= RATE_SCOPES) return 0;
+    return limiter->rejected[scope];
+}
+
+/**
+ * @function rate_scope_name: Label used in metrics.
+ */
+const char* rate_scope_name(RateScope scope) {
+    if (scope < 0 || scope >= RATE_SCOPES) return "unknown";
+    return scope_names[scope];
+}
+
+/**
+ * @function rate_class_rejected: Commands refused for a budget class since startup.
+ */
+uint64_t rate_class_rejected(const RateLimiter *limiter, RateClass rate_class) {
+    if (!limiter || rate_class < 0 || rate_class >= RATE_CLASSES) return 0;
+    return limiter->class_rejected[rate_class];
+}
+
+/**
+ * @function rate_limit_pauses: Times a session's reads were paused for debt.
+ */
+uint64_t rate_limit_pauses(const RateLimiter *limiter) {
+    return limiter ? limiter->pauses : 0;
+}
+
+/**
+ * @function rate_class_name: Label used in metrics.
+ */
+const char* rate_class_name(RateClass rate_class) {
+    if (rate_class < 0 || rate_class >= RATE_CLASSES) return "unknown";
+    return class_names[rate_class];
+}
@@ -0,0 +1,86 @@
+// ============================================================================
+// ratelimit.h - Admission control for connections and authentication
+// ============================================================================
+//
+// Token buckets keyed by client IP or username, checked before any database
+// work. A reconnect storm or a password-guessing client is turned away with
+// a 429 from memory instead of queueing auth queries on the single DB
+// connection. Each scope has a fixed-size table; when it is full the least
+// recently touched bucket is recycled.
+//
+// Limits are "<per minute>[/<burst>]" strings, "0" disables a scope:
+//   CHAT_RATE_CONNECT    new connections per IP          (default 60/30)
+//   CHAT_RATE_AUTH_IP    LOGIN/REGISTER/RESUME per IP    (default 60/20)
+//   CHAT_RATE_AUTH_USER  LOGIN attempts per username     (default 10/5)
+// CHAT_AUTH_MAX_INFLIGHT caps concurrent password checks (default 32).
+//
+// Every session also carries its own buckets, checked by the router before
+// dispatch: one for all commands and one per command class.
+//   CHAT_RATE_SESSION    all commands                    (default 600/120)
+//   CHAT_RATE_MESSAGE    MSG, GROUP_MSG                  (default 300/60)
+//   CHAT_RATE_READ       listings, history, STATS        (default 120/30)
+//   CHAT_RATE_ADMIN      friend and group changes        (default 60/30)
+// A GROUP_SEND_OFFLINE_MSG that continues a catch-up with pages left is not
+// budgeted (the router checks ClientSession.catchup_group).
+// A rejected command still costs a token, so a client that keeps flooding
+// goes into debt. Once a bucket is a full burst below zero, the server stops
+// reading that socket until the debt is repaid.
+
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+#include <stdint.h>
+#include "../common/protocol.h"
+
+#define RATE_TABLE_SIZE 4096
+#define RATE_PROBE_LIMIT 16
+#define RATE_KEY_LENGTH 64
+#define RATE_DEFAULT_MAX_INFLIGHT 32
+
+typedef enum {
+    RATE_CLASS_NONE = -1,                // Not budgeted (auth has its own limits, LOGOUT, COMPRESS)
+    RATE_CLASS_SESSION,                  // Every budgeted command also spends from this one
+    RATE_CLASS_MESSAGE,
+    RATE_CLASS_READ,
+    RATE_CLASS_ADMIN,
+    RATE_CLASSES
+} RateClass;
+
+typedef struct {
+    double tokens[RATE_CLASSES];
+    uint64_t updated_ns;                 // 0: not yet used, buckets start full
+} SessionBudget;
+
+typedef enum {
+    RATE_SCOPE_CONNECT,
+    RATE_SCOPE_AUTH_IP,
+    RATE_SCOPE_AUTH_USER,
+    RATE_SCOPE_AUTH_INFLIGHT,            // Not a bucket: the concurrent password check cap
+    RATE_SCOPES
+} RateScope;
+
+typedef struct RateLimiter RateLimiter;
+
+// Lifecycle (reads the CHAT_RATE_* variables)
+RateLimiter* rate_limiter_create(void);
+void rate_limiter_destroy(RateLimiter *limiter);
+
+// Take one token for key; retry_after receives whole seconds until the next one
+int rate_limit_take(RateLimiter *limiter, RateScope scope, const char *key, int *retry_after);
+
+// 1 if another password check may start while inflight are running
+int rate_limit_admit_auth(RateLimiter *limiter, int inflight);
+
+// Per-session budgets; pause_until_ns is set when reads should stop
+RateClass rate_command_class(CommandType cmd_type);
+int rate_session_take(RateLimiter *limiter, SessionBudget *budget, CommandType cmd_type,
+                      uint64_t *pause_until_ns, int *retry_after);
+
+// Reporting
+uint64_t rate_limit_rejected(const RateLimiter *limiter, RateScope scope);
+const char* rate_scope_name(RateScope scope);
+uint64_t rate_class_rejected(const RateLimiter *limiter, RateClass rate_class);
+uint64_t rate_limit_pauses(const RateLimiter *limiter);
+const char* rate_class_name(RateClass rate_class);
+
+#endif
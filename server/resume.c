@@ -0,0 +1,288 @@
+#include "resume.h"
+#include "../common/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+typedef struct {
+    unsigned char digest[SHA256_DIGEST_LENGTH];   // SHA-256 of the token, never the token itself
+    int user_id;                                  // 0 = free slot
+    char username[MAX_USERNAME_LENGTH];
+    time_t expires_at;
+} ResumeEntry;
+
+struct ResumeTable {
+    ResumeEntry entries[RESUME_TABLE_SIZE];
+    int ttl;
+    char path[256];                               // Empty: memory only
+    int dirty;
+    time_t last_flush;
+};
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @function token_digest: Hash a hex token; rejects anything that is not one.
+ *
+ * @return 1 on success, 0 on malformed token.
+ */
+static int token_digest(const char *token, unsigned char *digest) {
+    if (!token || strlen(token) != RESUME_TOKEN_LENGTH) return 0;
+    for (size_t i = 0; i < RESUME_TOKEN_LENGTH; i++) {
+        char c = token[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return 0;
+    }
+    SHA256((const unsigned char*)token, RESUME_TOKEN_LENGTH, digest);
+    return 1;
+}
+
+/**
+ * @function entry_clear: Free a slot.
+ */
+static void entry_clear(ResumeTable *table, ResumeEntry *entry) {
+    memset(entry, 0, sizeof(*entry));
+    table->dirty = 1;
+}
+
+/**
+ * @function resume_table_load: Read entries saved by resume_table_flush, dropping expired ones.
+ */
+static void resume_table_load(ResumeTable *table) {
+    FILE *file = fopen(table->path, "r");
+    if (!file) return;
+
+    time_t now = time(NULL);
+    int loaded = 0;
+    char line[256];
+    while (loaded < RESUME_TABLE_SIZE && fgets(line, sizeof(line), file)) {
+        // Format: <digest hex> <user_id> <expires_at> <username>
+        char hex[SHA256_DIGEST_LENGTH * 2 + 1];
+        int user_id;
+        long long expires_at;
+        char username[MAX_USERNAME_LENGTH];
+        if (sscanf(line, "%64s %d %lld %49s", hex, &user_id, &expires_at, username) != 4) continue;
+        if (user_id <= 0 || (time_t)expires_at <= now || strlen(hex) != SHA256_DIGEST_LENGTH * 2) continue;
+
+        ResumeEntry *entry = &table->entries[loaded];
+        int valid = 1;
+        for (int i = 0; i < SHA256_DIGEST_LENGTH && valid; i++) {
+            unsigned int byte;
+            valid = sscanf(hex + i * 2, "%2x", &byte) == 1;
+            entry->digest[i] = (unsigned char)byte;
+        }
+        if (!valid) continue;
+
+        entry->user_id = user_id;
+        entry->expires_at = (time_t)expires_at;
+        snprintf(entry->username, sizeof(entry->username), "%s", username);
+        loaded++;
+    }
+    fclose(file);
+    LOG_INFO("Loaded %d resume token(s) from %s", loaded, table->path);
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+/**
+ * @function resume_table_create: Allocate the token table.
+ *
+ * CHAT_RESUME_TTL sets the token lifetime in seconds. CHAT_RESUME_FILE, when
+ * set, is loaded now and rewritten as tokens change so reconnects survive a
+ * server restart.
+ *
+ * @return Table, or NULL on allocation failure.
+ */
+ResumeTable* resume_table_create(void) {
+    ResumeTable *table = (ResumeTable*)calloc(1, sizeof(ResumeTable));
+    if (!table) return NULL;
+
+    table->ttl = RESUME_DEFAULT_TTL;
+    const char *ttl = getenv("CHAT_RESUME_TTL");
+    if (ttl && *ttl) {
+        char *end;
+        long value = strtol(ttl, &end, 10);
+        if (*end == '\0' && value > 0) {
+            table->ttl = (int)value;
+        } else {
+            LOG_WARN("Invalid CHAT_RESUME_TTL '%s', using %d", ttl, table->ttl);
+        }
+    }
+
+    const char *path = getenv("CHAT_RESUME_FILE");
+    if (path && *path) {
+        snprintf(table->path, sizeof(table->path), "%s", path);
+        resume_table_load(table);
+    }
+    table->last_flush = time(NULL);
+    return table;
+}
+
+/**
+ * @function resume_table_destroy: Save (if persistent) and free the table.
+ */
+void resume_table_destroy(ResumeTable *table) {
+    if (!table) return;
+    resume_table_flush(table, 1);
+    OPENSSL_cleanse(table, sizeof(*table));
+    free(table);
+}
+
+/**
+ * @function resume_table_flush: Rewrite CHAT_RESUME_FILE with the live entries.
+ *
+ * The file is written to a temporary name with mode 0600 and renamed over the
+ * old one, so a crash mid-write leaves the previous copy intact.
+ *
+ * @param table Token table.
+ * @param force Write now even if RESUME_FLUSH_INTERVAL has not passed.
+ */
+void resume_table_flush(ResumeTable *table, int force) {
+    if (!table || !table->path[0] || !table->dirty) return;
+
+    time_t now = time(NULL);
+    if (!force && now - table->last_flush < RESUME_FLUSH_INTERVAL) return;
+
+    char tmp_path[sizeof(table->path) + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", table->path);
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FILE *file = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!file) {
+        if (fd >= 0) close(fd);
+        LOG_WARN("Cannot write resume tokens to %s", tmp_path);
+        table->last_flush = now;
+        return;
+    }
+
+    int saved = 0;
+    for (int i = 0; i < RESUME_TABLE_SIZE; i++) {
+        const ResumeEntry *entry = &table->entries[i];
+        if (entry->user_id <= 0 || entry->expires_at <= now) continue;
+        for (int j = 0; j < SHA256_DIGEST_LENGTH; j++) {
+            fprintf(file, "%02x", entry->digest[j]);
+        }
+        fprintf(file, " %d %lld %s\n", entry->user_id, (long long)entry->expires_at, entry->username);
+        saved++;
+    }
+
+    int failed = fflush(file) != 0 || fsync(fileno(file)) != 0;
+    failed |= fclose(file) != 0;
+    if (failed || rename(tmp_path, table->path) != 0) {
+        LOG_WARN("Failed to save resume tokens to %s", table->path);
+        unlink(tmp_path);
+    } else {
+        table->dirty = 0;
+        LOG_DEBUG("Saved %d resume token(s) to %s", saved, table->path);
+    }
+    table->last_flush = now;
+}
+
+// ============================================================================
+// Tokens
+// ============================================================================
+
+/**
+ * @function resume_issue: Create a token for a user, replacing any previous one.
+ *
+ * When the table is full the entry closest to expiry is evicted.
+ *
+ * @param table Token table.
+ * @param user_id Authenticated user.
+ * @param username Authenticated username.
+ * @param token Receives the hex token (at least RESUME_TOKEN_LENGTH + 1 bytes).
+ * @param size Size of token.
+ *
+ * @return 1 on success, 0 on failure (no token issued).
+ */
+int resume_issue(ResumeTable *table, int user_id, const char *username, char *token, size_t size) {
+    if (!table || user_id <= 0 || !username || !token || size < RESUME_TOKEN_LENGTH + 1) return 0;
+
+    unsigned char raw[RESUME_TOKEN_BYTES];
+    if (RAND_bytes(raw, sizeof(raw)) != 1) return 0;
+    for (int i = 0; i < RESUME_TOKEN_BYTES; i++) {
+        snprintf(token + i * 2, 3, "%02x", raw[i]);
+    }
+    OPENSSL_cleanse(raw, sizeof(raw));
+
+    time_t now = time(NULL);
+    ResumeEntry *slot = NULL;
+    for (int i = 0; i < RESUME_TABLE_SIZE; i++) {
+        ResumeEntry *entry = &table->entries[i];
+        if (entry->user_id == user_id || (entry->user_id > 0 && entry->expires_at <= now)) {
+            entry_clear(table, entry);
+        }
+        if (entry->user_id == 0) {
+            if (!slot || slot->user_id != 0) slot = entry;
+        } else if (!slot || (slot->user_id != 0 && entry->expires_at < slot->expires_at)) {
+            slot = entry;
+        }
+    }
+
+    if (slot->user_id != 0) {
+        LOG_DEBUG("Resume table full, evicting token of %s", slot->username);
+    }
+    token_digest(token, slot->digest);
+    slot->user_id = user_id;
+    snprintf(slot->username, sizeof(slot->username), "%s", username);
+    slot->expires_at = now + table->ttl;
+    table->dirty = 1;
+    return 1;
+}
+
+/**
+ * @function resume_redeem: Consume a token and report whose session it was.
+ *
+ * @param table Token table.
+ * @param token Hex token presented by the client.
+ * @param user_id Receives the user ID.
+ * @param username Receives the username.
+ * @param size Size of username.
+ *
+ * @return 1 if the token was valid (and is now spent), 0 otherwise.
+ */
+int resume_redeem(ResumeTable *table, const char *token, int *user_id, char *username, size_t size) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    if (!table || !user_id || !username || !token_digest(token, digest)) return 0;
+
+    time_t now = time(NULL);
+    for (int i = 0; i < RESUME_TABLE_SIZE; i++) {
+        ResumeEntry *entry = &table->entries[i];
+        if (entry->user_id <= 0 || CRYPTO_memcmp(entry->digest, digest, sizeof(digest)) != 0) continue;
+
+        int valid = entry->expires_at > now;
+        if (valid) {
+            *user_id = entry->user_id;
+            snprintf(username, size, "%s", entry->username);
+        }
+        entry_clear(table, entry);
+        return valid;
+    }
+    return 0;
+}
+
+/**
+ * @function resume_revoke_user: Drop a user's token (explicit LOGOUT).
+ */
+void resume_revoke_user(ResumeTable *table, int user_id) {
+    if (!table || user_id <= 0) return;
+    for (int i = 0; i < RESUME_TABLE_SIZE; i++) {
+        if (table->entries[i].user_id == user_id) {
+            entry_clear(table, &table->entries[i]);
+        }
+    }
+}
+
+/**
+ * @function resume_table_ttl: Token lifetime in seconds.
+ */
+int resume_table_ttl(const ResumeTable *table) {
+    return table ? table->ttl : 0;
+}
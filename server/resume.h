@@ -0,0 +1,42 @@
+// ============================================================================
+// resume.h - Session resume tokens
+// ============================================================================
+//
+// A successful LOGIN hands the client an opaque token. After a dropped
+// connection, `RESUME <token> <last_seen_id>` restores the identity without
+// a password check. Only notifications newer than last_seen_id are replayed.
+//
+// Tokens are single use: RESUME consumes the presented token and returns a
+// new one. LOGOUT revokes it; a plain disconnect keeps it until it expires.
+// Only a SHA-256 digest of each token is kept, in memory and in the optional
+// CHAT_RESUME_FILE, so neither the table nor the file can be replayed.
+
+#ifndef RESUME_H
+#define RESUME_H
+
+#include <stddef.h>
+#include <time.h>
+#include "../common/protocol.h"
+
+#define RESUME_TOKEN_BYTES 24
+#define RESUME_TOKEN_LENGTH (RESUME_TOKEN_BYTES * 2)   // Hex characters on the wire
+#define RESUME_TABLE_SIZE 1024                         // Tokens outlive connections, so well above MAX_CLIENTS
+#define RESUME_DEFAULT_TTL (24 * 60 * 60)              // Seconds, CHAT_RESUME_TTL overrides
+#define RESUME_FLUSH_INTERVAL 30                       // Seconds between saves when changed
+
+typedef struct ResumeTable ResumeTable;
+
+// Lifecycle (reads CHAT_RESUME_TTL and CHAT_RESUME_FILE; loads the file if present)
+ResumeTable* resume_table_create(void);
+void resume_table_destroy(ResumeTable *table);
+
+// Write the table to CHAT_RESUME_FILE if it changed (force: ignore the interval)
+void resume_table_flush(ResumeTable *table, int force);
+
+// Tokens
+int resume_issue(ResumeTable *table, int user_id, const char *username, char *token, size_t size);
+int resume_redeem(ResumeTable *table, const char *token, int *user_id, char *username, size_t size);
+void resume_revoke_user(ResumeTable *table, int user_id);
+int resume_table_ttl(const ResumeTable *table);
+
+#endif
@@ -0,0 +1,144 @@
+#include "roster.h"
+#include "../common/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @function roster_index: Binary search for user_id.
+ *
+ * @return Index of the link, or -(insertion point) - 1 if absent.
+ */
+static int roster_index(const FriendRoster *roster, int user_id) {
+    int lo = 0, hi = roster->count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        int id = roster->links[mid].user_id;
+        if (id == user_id) return mid;
+        if (id < user_id) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -lo - 1;
+}
+
+/**
+ * @function roster_reserve: Make room for at least capacity links.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int roster_reserve(FriendRoster *roster, int capacity) {
+    if (capacity <= roster->capacity) return 1;
+
+    int new_capacity = roster->capacity ? roster->capacity : 16;
+    while (new_capacity < capacity) new_capacity *= 2;
+
+    FriendLink *links = (FriendLink*)realloc(roster->links, new_capacity * sizeof(FriendLink));
+    if (!links) return 0;
+    roster->links = links;
+    roster->capacity = new_capacity;
+    return 1;
+}
+
+/**
+ * @function roster_load: Replace the roster with user_id's accepted friends.
+ *
+ * @param roster Roster to fill.
+ * @param conn Database connection.
+ * @param user_id Owner of the roster.
+ *
+ * @return 1 on success, 0 on database or allocation failure (roster unchanged).
+ */
+int roster_load(FriendRoster *roster, PGconn *conn, int user_id) {
+    if (!roster || !conn) return 0;
+
+    char id_str[16];
+    snprintf(id_str, sizeof(id_str), "%d", user_id);
+    const char *paramValues[1] = {id_str};
+
+    PGresult *res = PQexecParams(conn,
+            "SELECT u.id, u.username "
+            "FROM friends f "
+            "JOIN users u ON u.id = CASE WHEN f.user_id = $1 THEN f.friend_id ELSE f.user_id END "
+            "WHERE (f.user_id = $1 OR f.friend_id = $1) "
+            "AND f.status = 'accepted' "
+            "ORDER BY u.id",
+            1, NULL, paramValues, NULL, NULL, 0);
+
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_WARN("Failed to load friends of id=%d: %s", user_id, PQerrorMessage(conn));
+        PQclear(res);
+        return 0;
+    }
+
+    int rows = PQntuples(res);
+    if (!roster_reserve(roster, rows)) {
+        PQclear(res);
+        return 0;
+    }
+
+    roster->count = 0;
+    for (int i = 0; i < rows; i++) {
+        FriendLink *link = &roster->links[roster->count];
+        link->user_id = atoi(PQgetvalue(res, i, 0));
+        snprintf(link->username, sizeof(link->username), "%s", PQgetvalue(res, i, 1));
+        // A pair stored in both directions would appear twice
+        if (roster->count == 0 || roster->links[roster->count - 1].user_id != link->user_id) {
+            roster->count++;
+        }
+    }
+    roster->loaded = 1;
+    PQclear(res);
+    return 1;
+}
+
+/**
+ * @function roster_free: Release the roster's memory and mark it unloaded.
+ */
+void roster_free(FriendRoster *roster) {
+    if (!roster) return;
+    free(roster->links);
+    memset(roster, 0, sizeof(*roster));
+}
+
+/**
+ * @function roster_find: Look up a friend by user id.
+ *
+ * @return The link, or NULL if user_id is not in the roster.
+ */
+const FriendLink* roster_find(const FriendRoster *roster, int user_id) {
+    if (!roster || roster->count == 0) return NULL;
+    int i = roster_index(roster, user_id);
+    return i >= 0 ? &roster->links[i] : NULL;
+}
+
+/**
+ * @function roster_add: Insert a new friend, keeping the roster sorted.
+ *
+ * @return 1 if added or already present, 0 on allocation failure.
+ */
+int roster_add(FriendRoster *roster, int user_id, const char *username) {
+    if (!roster || !username) return 0;
+
+    int i = roster_index(roster, user_id);
+    if (i >= 0) return 1;
+    i = -i - 1;
+
+    if (!roster_reserve(roster, roster->count + 1)) return 0;
+    memmove(&roster->links[i + 1], &roster->links[i], (roster->count - i) * sizeof(FriendLink));
+    roster->links[i].user_id = user_id;
+    snprintf(roster->links[i].username, sizeof(roster->links[i].username), "%s", username);
+    roster->count++;
+    return 1;
+}
+
+/**
+ * @function roster_remove: Drop a friend if present.
+ */
+void roster_remove(FriendRoster *roster, int user_id) {
+    if (!roster || roster->count == 0) return;
+
+    int i = roster_index(roster, user_id);
+    if (i < 0) return;
+    memmove(&roster->links[i], &roster->links[i + 1], (roster->count - i - 1) * sizeof(FriendLink));
+    roster->count--;
+}
@@ -0,0 +1,35 @@
+// ============================================================================
+// roster.h - In-memory friend adjacency for a session
+// ============================================================================
+//
+// A session that subscribes to presence loads its accepted friends once and
+// keeps them sorted by user id. Presence pushes then check "is X my friend"
+// with a binary search instead of a friends-table join. FRIEND_ACCEPT and
+// FRIEND_REMOVE patch loaded rosters in place, so they never need reloading.
+
+#ifndef ROSTER_H
+#define ROSTER_H
+
+#include <libpq-fe.h>
+#include "../common/protocol.h"
+
+typedef struct {
+    int user_id;
+    char username[MAX_USERNAME_LENGTH];
+} FriendLink;
+
+typedef struct {
+    FriendLink *links;                   // Sorted by user_id
+    int count;
+    int capacity;
+    int loaded;                          // 0 until roster_load() succeeds
+} FriendRoster;
+
+int roster_load(FriendRoster *roster, PGconn *conn, int user_id);
+void roster_free(FriendRoster *roster);
+
+const FriendLink* roster_find(const FriendRoster *roster, int user_id);
+int roster_add(FriendRoster *roster, int user_id, const char *username);
+void roster_remove(FriendRoster *roster, int user_id);
+
+#endif
@@ -1,6 +1,8 @@
 #include "server.h"
 #include "../database/database.h"
 #include "../common/router.h" 
+#include "exporter.h"
+#include "auth.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -118,13 +120,51 @@ Server* server_create(int port) {
     
     server->db_conn = connect_to_database();
     if (!server->db_conn) {
-        fprintf(stderr, "Failed to connect to database\n");
+        LOG_ERROR("Failed to connect to database");
         close(server->listen_fd);
         free(server);
         return NULL;
     }
     
-    printf("Server created on port %d\n", port);
+    server->metrics = metrics_create();
+    if (!server->metrics) {
+        LOG_ERROR("Failed to allocate metrics");
+        disconnect_database(server->db_conn);
+        close(server->listen_fd);
+        free(server);
+        return NULL;
+    }
+    
+    server->auth_pool = auth_pool_create(0);
+    if (!server->auth_pool) {
+        LOG_ERROR("Failed to start auth workers");
+        metrics_destroy(server->metrics);
+        disconnect_database(server->db_conn);
+        close(server->listen_fd);
+        free(server);
+        return NULL;
+    }
+    
+    server->resume_tokens = resume_table_create();
+    server->rate_limiter = rate_limiter_create();
+    server->presence = presence_create();
+    if (!server->resume_tokens || !server->rate_limiter || !server->presence) {
+        LOG_ERROR("Failed to allocate resume tokens / rate limiter / presence");
+        resume_table_destroy(server->resume_tokens);
+        rate_limiter_destroy(server->rate_limiter);
+        presence_destroy(server->presence);
+        auth_pool_destroy(server->auth_pool);
+        metrics_destroy(server->metrics);
+        disconnect_database(server->db_conn);
+        close(server->listen_fd);
+        free(server);
+        return NULL;
+    }
+    
+    // Nobody is connected yet; drop flags left by a crash or kill -9
+    presence_reset_database(server->db_conn);
+    
+    LOG_INFO("Server created on port %d (%d auth workers)", port, auth_pool_workers(server->auth_pool));
     return server;
 }
 
@@ -150,11 +190,19 @@ void server_destroy(Server *server) {
     }
     
     if (server->db_conn) {
+        presence_set_all_offline(server->presence);
+        presence_flush(server->presence, server->db_conn, 1);
         disconnect_database(server->db_conn);
     }
     
+    presence_destroy(server->presence);
+    auth_pool_destroy(server->auth_pool);
+    resume_table_destroy(server->resume_tokens);
+    rate_limiter_destroy(server->rate_limiter);
+    exporter_destroy(server->exporter);
+    metrics_destroy(server->metrics);
     free(server);
-    printf("Server destroyed\n");
+    LOG_INFO("Server destroyed");
 }
 
 /**
@@ -168,7 +216,7 @@ int server_start(Server *server) {
     if (!server) return 0;
     
     server->running = 1;
-    printf("Server started and listening...\n");
+    LOG_INFO("Server started and listening...");
     return 1;
 }
 
@@ -183,7 +231,7 @@ void server_stop(Server *server) {
     if (!server) return;
     
     server->running = 0;
-    printf("Server stopping...\n");
+    LOG_INFO("Server stopping...");
 }
 
 /**
@@ -199,14 +247,64 @@ void server_run(Server *server) {
     server_start(server);
     
     while (server->running) {
+        presence_flush(server->presence, server->db_conn, 0);
+        server_push_presence(server);
+        
         server->read_fds = server->master_set;
+        fd_set write_fds;
+        FD_ZERO(&write_fds);
+        int max_fd = exporter_fill_fdsets(server->exporter, &server->read_fds, &write_fds, server->max_fd);
+        max_fd = log_fill_fdset(&write_fds, max_fd);
+        int auth_fd = auth_pool_fd(server->auth_pool);
+        FD_SET(auth_fd, &server->read_fds);
+        if (auth_fd > max_fd) max_fd = auth_fd;
+        
+        // Sessions with queued output wait for their socket to drain
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            ClientSession *client = server->clients[i];
+            if (!client || client->send_queue.len == 0) continue;
+            FD_SET(client->socket_fd, &write_fds);
+            if (client->socket_fd > max_fd) max_fd = client->socket_fd;
+        }
         
         // Time to check server running status
         struct timeval timeout;
         timeout.tv_sec = 1;
         timeout.tv_usec = 0;
         
-        int activity = select(server->max_fd + 1, &server->read_fds, NULL, NULL, &timeout);
+        // Sessions paused for flooding are not read; wake when the first one is due
+        uint64_t now_ns = metrics_now_ns();
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            ClientSession *client = server->clients[i];
+            if (!client || !client->paused_until_ns) continue;
+            
+            if (client->paused_until_ns <= now_ns) {
+                client->paused_until_ns = 0;
+                LOG_DEBUG("Resuming reads from fd=%d", client->socket_fd);
+                server_process_buffered(server, client);
+            }
+            // server_process_buffered may have paused it again
+            if (server->clients[i] == client && client->paused_until_ns) {
+                FD_CLR(client->socket_fd, &server->read_fds);
+                uint64_t wait_us = (client->paused_until_ns - now_ns) / 1000 + 1;
+                if (wait_us < (uint64_t)timeout.tv_sec * 1000000 + timeout.tv_usec) {
+                    timeout.tv_sec = wait_us / 1000000;
+                    timeout.tv_usec = wait_us % 1000000;
+                }
+            }
+        }
+        
+        // Presence changes held back for coalescing go out when their window closes
+        uint64_t due_ns = presence_next_due_ns(server->presence);
+        if (due_ns) {
+            uint64_t wait_us = due_ns > now_ns ? (due_ns - now_ns) / 1000 + 1 : 0;
+            if (wait_us < (uint64_t)timeout.tv_sec * 1000000 + timeout.tv_usec) {
+                timeout.tv_sec = wait_us / 1000000;
+                timeout.tv_usec = wait_us % 1000000;
+            }
+        }
+        
+        int activity = select(max_fd + 1, &server->read_fds, &write_fds, NULL, &timeout);
         
         if (activity < 0) {
             if (errno == EINTR) continue;
@@ -215,6 +313,8 @@ void server_run(Server *server) {
         }
         
         if (activity == 0) {
+            resume_table_flush(server->resume_tokens, 0);
+            log_flush();
             continue;
         }
         
@@ -222,20 +322,40 @@ void server_run(Server *server) {
             server_accept_connection(server);
         }
         
+        exporter_handle_events(server, &server->read_fds, &write_fds);
+        
+        if (FD_ISSET(auth_fd, &server->read_fds)) {
+            auth_handle_completions(server);
+        }
+        
         for (int i = 0; i < MAX_CLIENTS; i++) {
             ClientSession *client = server->clients[i];
             if (!client) continue;
             
+            if (FD_ISSET(client->socket_fd, &write_fds)) {
+                server_flush_send_queue(client);
+            }
             if (FD_ISSET(client->socket_fd, &server->read_fds)) {
                 if (server_receive_data(server, client) <= 0) {
-                    printf("Client disconnected: fd=%d\n", client->socket_fd);
+                    LOG_INFO("Client disconnected: fd=%d", client->socket_fd);
                     server_remove_client(server, client->socket_fd);
                 }
             }
         }
+        
+        // Sends may fail anywhere (broadcasts, pushes); drop those peers in one place
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            ClientSession *client = server->clients[i];
+            if (client && client->send_failed) {
+                LOG_INFO("Client dropped after send failure: fd=%d", client->socket_fd);
+                server_remove_client(server, client->socket_fd);
+            }
+        }
+        
+        log_flush();
     }
     
-    printf("Server stopped\n");
+    LOG_INFO("Server stopped");
 }
 
 /**
@@ -259,11 +379,24 @@ int server_accept_connection(Server *server) {
     
     char client_ip[INET_ADDRSTRLEN];
     inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
-    printf("New connection from %s:%d (fd=%d)\n", 
+    
+    // Refuse reconnect storms before allocating a session (no log.txt write either)
+    int retry_after = 0;
+    if (!rate_limit_take(server->rate_limiter, RATE_SCOPE_CONNECT, client_ip, &retry_after)) {
+        char reject[96];
+        int len = snprintf(reject, sizeof(reject), "%d Too many connections, retry in %d s%s",
+                           STATUS_RATE_LIMITED, retry_after, PROTOCOL_DELIMITER);
+        send(client_fd, reject, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        close(client_fd);
+        LOG_DEBUG("Connection from %s rate limited", client_ip);
+        return -1;
+    }
+    
+    LOG_INFO("New connection from %s:%d (fd=%d)", 
            client_ip, ntohs(client_addr.sin_port), client_fd);
     
     if (!server_add_client(server, client_fd)) {
-        fprintf(stderr, "Failed to add client, rejecting connection\n");
+        LOG_ERROR("Failed to add client, rejecting connection");
         close(client_fd);
         return -1;
     }
@@ -300,7 +433,7 @@ int server_receive_data(Server *server, ClientSession *client) {
     
     if (bytes_received <= 0) {
         if (bytes_received == 0) {
-            printf("Client %d closed connection\n", client->socket_fd);
+            LOG_INFO("Client %d closed connection", client->socket_fd);
         } else {
             perror("Recv error");
         }
@@ -308,32 +441,113 @@ int server_receive_data(Server *server, ClientSession *client) {
     }
     
     buffer[bytes_received] = '\0';
-    printf("Received %d bytes from fd=%d: %s\n", bytes_received, client->socket_fd, buffer);
+    LOG_TRACE("Received %d bytes from fd=%d: %s", bytes_received, client->socket_fd, buffer);
     
     if (!stream_buffer_append(client->recv_buffer, buffer, bytes_received)) {
-        fprintf(stderr, "Buffer overflow for client %d\n", client->socket_fd);
+        LOG_ERROR("Buffer overflow for client %d", client->socket_fd);
         return -1;
     }
     
+    server_process_buffered(server, client);
+    
+    client->last_activity = time(NULL);
+    
+    return bytes_received;
+}
+
+/**
+ * @function server_process_buffered: Handle every complete message in a client's buffer
+ * 
+ * Stops while a REGISTER/LOGIN is on the auth pool so commands keep their
+ * order; auth_handle_completions() calls this again when it finishes. Also
+ * stops while the session is paused for flooding; server_run() resumes it.
+ * 
+ * @param server Pointer to the Server instance
+ * @param client Pointer to the ClientSession instance
+ * 
+ * @return void
+ */
+void server_process_buffered(Server *server, ClientSession *client) {
+    if (!server || !client) return;
+    
     char *message;
-    while ((message = stream_buffer_extract_message(client->recv_buffer)) != NULL) {
-        printf("Processing message from fd=%d: %s\n", client->socket_fd, message);
+    while (!client->auth_pending && !client->paused_until_ns &&
+           (message = stream_buffer_extract_message(client->recv_buffer)) != NULL) {
+        LOG_TRACE("Processing message from fd=%d: %s", client->socket_fd, message);
         server_handle_client_message(server, client, message);
         free(message);
     }
+}
+
+/**
+ * @function server_flush_send_queue: Write as much of a session's queued output as the socket takes
+ * 
+ * Never blocks: stops at EAGAIN and leaves the rest for the next writable
+ * select(). A hard error marks the session send_failed.
+ * 
+ * @param client Pointer to the ClientSession instance
+ * 
+ * @return 0 if the session is still usable, -1 if it failed
+ */
+int server_flush_send_queue(ClientSession *client) {
+    if (!client) return -1;
+    if (client->send_failed) return -1;
+    
+    SendQueue *queue = &client->send_queue;
+    size_t written = 0;
+    while (written < queue->len) {
+        ssize_t sent = send(client->socket_fd, queue->data + written, queue->len - written,
+                            MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            LOG_DEBUG("Send to fd=%d failed: %s", client->socket_fd, strerror(errno));
+            client->send_failed = 1;
+            return -1;
+        }
+        written += (size_t)sent;
+    }
     
-    client->last_activity = time(NULL);
-    
-    return bytes_received;
+    if (written > 0) {
+        memmove(queue->data, queue->data + written, queue->len - written);
+        queue->len -= written;
+    }
+    return 0;
+}
+
+/**
+ * @function send_queue_append: Queue bytes behind anything already waiting
+ * 
+ * @return 1 on success, 0 if SEND_QUEUE_LIMIT would be exceeded or on allocation failure
+ */
+static int send_queue_append(SendQueue *queue, const char *data, size_t len) {
+    if (queue->len + len > SEND_QUEUE_LIMIT) return 0;
+    
+    if (queue->len + len > queue->cap) {
+        size_t cap = queue->cap ? queue->cap : 4096;
+        while (cap < queue->len + len) cap *= 2;
+        char *grown = (char*)realloc(queue->data, cap);
+        if (!grown) return 0;
+        queue->data = grown;
+        queue->cap = cap;
+    }
+    memcpy(queue->data + queue->len, data, len);
+    queue->len += len;
+    return 1;
 }
 
 /**
  * @function server_send_response: Send a response message to a client
  * 
+ * The frame is written without blocking; whatever the kernel does not take
+ * is queued on the session and flushed as the socket drains, so one slow
+ * reader never stalls the event loop. A client that falls SEND_QUEUE_LIMIT
+ * bytes behind is marked send_failed and disconnected.
+ * 
  * @param client Pointer to the ClientSession instance
  * @param response The response message to send
  * 
- * @return Number of bytes sent, or -1 on error
+ * @return Number of bytes sent or queued (the whole response), or -1 on error
  */
 int server_send_response(ClientSession *client, const char *response) {
     if (!client || !response) return -1;
@@ -344,16 +558,38 @@ int server_send_response(ClientSession *client, const char *response) {
         client->last_response_code = status_code;
     }
     
-    int len = strlen(response);
-    int sent = send(client->socket_fd, response, len, 0);
+    uint64_t send_start_ns = metrics_now_ns();
+    size_t len = strlen(response);
+    const char *wire = response;
+    size_t wire_len = len;
+    
+    // Large responses go out as one compressed frame once negotiated
+    char *frame = NULL;
+    if (client->compressor) {
+        frame = compressor_encode(client->compressor, response, len, &wire_len);
+        if (frame) {
+            wire = frame;
+        } else {
+            wire_len = len;
+        }
+    }
     
-    if (sent < 0) {
-        perror("Send error");
-        return -1;
+    // Queue behind earlier output so frames never interleave, then write
+    // what the socket will take now
+    int ok = !client->send_failed;
+    if (ok && !send_queue_append(&client->send_queue, wire, wire_len)) {
+        LOG_WARN("Client fd=%d is %zu bytes behind, disconnecting", client->socket_fd,
+                 client->send_queue.len);
+        client->send_failed = 1;
+        ok = 0;
     }
+    if (ok && server_flush_send_queue(client) < 0) ok = 0;
+    free(frame);
+    metrics_add_send_time(metrics_now_ns() - send_start_ns);
     
-    printf("Sent to fd=%d: %s", client->socket_fd, response);
-    return sent;
+    if (!ok) return -1;
+    LOG_TRACE("Sent to fd=%d: %s", client->socket_fd, response);
+    return (int)wire_len;
 }
 
 // ============================================================================
@@ -379,6 +615,7 @@ ClientSession* client_session_create(int socket_fd) {
     session->client_ip[0] = '\0';
     session->recv_buffer = stream_buffer_create();
     session->last_activity = time(NULL);
+    session->friend_list_version = -1;
     memset(session->current_chat_partner, 0, MAX_USERNAME_LENGTH);
     
     if (!session->recv_buffer) {
@@ -407,6 +644,12 @@ void client_session_destroy(ClientSession *session) {
         stream_buffer_destroy(session->recv_buffer);
     }
     
+    if (session->compressor) {
+        compressor_destroy(session->compressor);
+    }
+    
+    roster_free(&session->friends);
+    free(session->send_queue.data);
     free(session);
 }
 
@@ -426,6 +669,7 @@ int server_add_client(Server *server, int socket_fd) {
             ClientSession *session = client_session_create(socket_fd);
             if (!session) return 0;
             
+            session->serial = ++server->next_session_serial;
             server->clients[i] = session;
             
             FD_SET(socket_fd, &server->master_set);
@@ -433,12 +677,12 @@ int server_add_client(Server *server, int socket_fd) {
                 server->max_fd = socket_fd;
             }
             
-            printf("Client added: fd=%d, slot=%d\n", socket_fd, i);
+            LOG_DEBUG("Client added: fd=%d, slot=%d", socket_fd, i);
             return 1;
         }
     }
     
-    fprintf(stderr, "Server full, cannot add more clients\n");
+    LOG_WARN("Server full, cannot add more clients");
     return 0;
 }
 
@@ -463,12 +707,8 @@ void server_remove_client(Server *server, int socket_fd) {
                     notify_partner_offline(server, client->username);
                 }
                 
-                char query[256];
-                snprintf(query, sizeof(query),
-                        "UPDATE users SET is_online = FALSE WHERE id = %d",
-                        client->user_id);
-                execute_query(server->db_conn, query);
-                printf("User %s logged out (disconnected)\n", client->username);
+                server_mark_offline(server, client);
+                LOG_INFO("User %s logged out (disconnected)", client->username);
             }
             
             FD_CLR(socket_fd, &server->master_set);
@@ -476,7 +716,7 @@ void server_remove_client(Server *server, int socket_fd) {
             client_session_destroy(client);
             server->clients[i] = NULL;
             
-            printf("Client removed: fd=%d, slot=%d\n", socket_fd, i);
+            LOG_DEBUG("Client removed: fd=%d, slot=%d", socket_fd, i);
             return;
         }
     }
@@ -528,7 +768,7 @@ void notify_partner_offline(Server *server, const char *offline_username) {
                 server_send_response(client, notify_msg);
                 free(notify_msg);
                 
-                printf("Sent offline notification to %s about %s\n", 
+                LOG_DEBUG("Sent offline notification to %s about %s", 
                        client->username, offline_username);
                 
                 // Clear their chat partner since conversation ended
@@ -559,3 +799,176 @@ ClientSession* server_get_client_by_username(Server *server, const char *usernam
     
     return NULL;
 }
+
+/**
+ * @function server_mark_online: Record that an authenticated session's user is online
+ * 
+ * @param server Pointer to the Server instance
+ * @param client Session that just logged in or resumed
+ * 
+ * @return void
+ */
+void server_mark_online(Server *server, ClientSession *client) {
+    if (!server || !client || client->user_id <= 0) return;
+    presence_set(server->presence, client->user_id, PRESENCE_ONLINE);
+}
+
+/**
+ * @function server_mark_offline: Record that a session's user went away
+ * 
+ * The user stays online while another authenticated session of theirs is
+ * still connected.
+ * 
+ * @param server Pointer to the Server instance
+ * @param client Session that is logging out or disconnecting
+ * 
+ * @return void
+ */
+void server_mark_offline(Server *server, ClientSession *client) {
+    if (!server || !client || client->user_id <= 0) return;
+    
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        ClientSession *other = server->clients[i];
+        if (other && other != client && other->is_authenticated &&
+            other->user_id == client->user_id) {
+            return;
+        }
+    }
+    presence_set(server->presence, client->user_id, PRESENCE_OFFLINE);
+}
+
+/**
+ * @function server_push_presence: Announce presence changes to subscribed friends
+ * 
+ * Sends "PRESENCE <user> online|offline" to every subscribed session that
+ * has the user in its roster. Only changes whose coalescing window has
+ * closed are sent (see presence.h).
+ * 
+ * @param server Pointer to the Server instance
+ * 
+ * @return void
+ */
+void server_push_presence(Server *server) {
+    if (!server) return;
+    
+    PresenceChange changes[64];
+    int count;
+    while ((count = presence_take_due(server->presence, metrics_now_ns(), changes, 64)) > 0) {
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            ClientSession *client = server->clients[i];
+            if (!client || !client->is_authenticated || !client->presence_subscribed) continue;
+            
+            for (int c = 0; c < count; c++) {
+                const FriendLink *link = roster_find(&client->friends, changes[c].user_id);
+                if (!link) continue;
+                
+                char event[128];
+                snprintf(event, sizeof(event), "PRESENCE %s %s", link->username,
+                         changes[c].state == PRESENCE_ONLINE ? "online" : "offline");
+                char *notify_msg = build_response(STATUS_PRESENCE_NOTIFICATION, event);
+                server_send_response(client, notify_msg);
+                free(notify_msg);
+            }
+        }
+    }
+}
+
+/**
+ * @function handle_compress_command: Negotiate payload compression for this connection
+ * 
+ * @param server Pointer to the Server instance
+ * @param client Pointer to the ClientSession requesting compression
+ * @param cmd Parsed command carrying the requested algorithm
+ * 
+ * @return void
+ */
+void handle_compress_command(Server *server, ClientSession *client, ParsedCommand *cmd) {
+    if (!server || !client || !cmd) return;
+    
+    char *response = NULL;
+    
+    if (cmd->param_count < 1 || strcmp(cmd->message, COMPRESSION_ALGORITHM) != 0) {
+        response = build_response(STATUS_COMPRESS_UNSUPPORTED, "Supported algorithms: " COMPRESSION_ALGORITHM);
+        server_send_response(client, response);
+        free(response);
+        return;
+    }
+    
+    if (!client->compressor) {
+        Compressor *comp = compressor_create(COMPRESSION_DEFAULT_THRESHOLD);
+        if (!comp) {
+            response = build_response(STATUS_UNDEFINED_ERROR, "Failed to initialize compression");
+            server_send_response(client, response);
+            free(response);
+            return;
+        }
+        
+        // Acknowledge uncompressed, then switch the stream over
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%s threshold=%d", COMPRESSION_ALGORITHM, COMPRESSION_DEFAULT_THRESHOLD);
+        response = build_response(STATUS_COMPRESS_OK, msg);
+        server_send_response(client, response);
+        free(response);
+        
+        client->compressor = comp;
+        LOG_INFO("Compression enabled for fd=%d", client->socket_fd);
+        return;
+    }
+    
+    response = build_response(STATUS_COMPRESS_OK, COMPRESSION_ALGORITHM " already enabled");
+    server_send_response(client, response);
+    free(response);
+}
+
+/**
+ * @function handle_stats_command: Report per-command request metrics
+ * 
+ * Read-only: the counters are global and also feed the metrics exporter,
+ * so no chat user can clear them. The report is split at line boundaries
+ * into "STATS page=<n> end=<0|1>" frames that each fit in MAX_MESSAGE_LENGTH.
+ * 
+ * @param server Pointer to the Server instance
+ * @param client Pointer to the ClientSession requesting the stats
+ * @param cmd Parsed command (no parameters)
+ * 
+ * @return void
+ */
+void handle_stats_command(Server *server, ClientSession *client, ParsedCommand *cmd) {
+    if (!server || !client || !cmd) return;
+    
+    if (!client->is_authenticated) {
+        char *response = build_simple_response(STATUS_NOT_LOGGED_IN);
+        server_send_response(client, response);
+        free(response);
+        return;
+    }
+    
+    char *report = metrics_format(server->metrics);
+    if (!report) {
+        char *response = build_response(STATUS_UNDEFINED_ERROR, "Failed to format stats");
+        server_send_response(client, response);
+        free(response);
+        return;
+    }
+    
+    char frame[MAX_MESSAGE_LENGTH];
+    const char *p = report;
+    for (int page = 1; ; page++) {
+        size_t take = strlen(p);
+        if (take > STATS_PAGE_BYTES) {
+            take = STATS_PAGE_BYTES;
+            while (take > 0 && p[take - 1] != '\n') take--;
+            if (take == 0) take = STATS_PAGE_BYTES;     // One overlong line: cut it
+        }
+        int end = p[take] == '\0';
+        
+        snprintf(frame, sizeof(frame), "STATS page=%d end=%d\n%.*s", page, end, (int)take, p);
+        char *response = build_response(STATUS_STATS_OK, frame);
+        int sent = server_send_response(client, response);
+        free(response);
+        
+        p += take;
+        if (end || sent < 0) break;
+    }
+    free(report);
+}
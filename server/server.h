@@ -5,10 +5,27 @@
 #include <netinet/in.h>
 #include <libpq-fe.h>
 #include "../common/protocol.h"
+#include "../common/compress.h"
+#include "../common/metrics.h"
+#include "../common/log.h"
+#include "auth_pool.h"
+#include "resume.h"
+#include "ratelimit.h"
+#include "presence.h"
+#include "roster.h"
 
 #define MAX_CLIENTS 100
 #define PORT 8888
 #define BACKLOG 10
+#define STATS_PAGE_BYTES (MAX_MESSAGE_LENGTH - 128)   // Report text per STATS frame
+#define SEND_QUEUE_LIMIT (1024 * 1024)                 // Unsent bytes per session before it is dropped
+
+// Bytes the kernel would not take yet; flushed when select() reports the socket writable
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} SendQueue;
 
 // Client session structure
 typedef struct {
@@ -21,8 +38,22 @@ typedef struct {
     StreamBuffer *recv_buffer;
     time_t last_activity;
     char current_chat_partner[MAX_USERNAME_LENGTH];  // Track who user is chatting with
+    Compressor *compressor;  // NULL unless the client negotiated COMPRESS
+    uint64_t serial;  // Unique per connection; fd numbers are reused
+    int auth_pending;  // REGISTER/LOGIN hashing on the auth pool; later commands wait
+    SessionBudget budget;  // Per-class command token buckets
+    uint64_t paused_until_ns;  // Far over budget: socket not read until then (0 = reading)
+    int rate_limited_streak;  // Consecutive refused commands (only the first is logged)
+    int presence_subscribed;  // PRESENCE_SUBSCRIBE sent: friends' changes are pushed
+    FriendRoster friends;  // Loaded on subscribe; patched by FRIEND_ACCEPT / FRIEND_REMOVE
+    long long friend_list_version;  // Cached FRIEND_LIST_SYNC version (-1 = not read yet)
+    char catchup_group[MAX_USERNAME_LENGTH];  // Group catch-up left pages here; its follow-up is not budgeted
+    SendQueue send_queue;  // Responses waiting for the socket to drain
+    int send_failed;  // Peer gone or SEND_QUEUE_LIMIT exceeded: removed after this loop pass
 } ClientSession;
 
+typedef struct Exporter Exporter;
+
 // Server structure
 typedef struct {
     int listen_fd;
@@ -32,6 +63,14 @@ typedef struct {
     ClientSession *clients[MAX_CLIENTS];
     PGconn *db_conn;
     int running;
+    Metrics *metrics;  // Per-command counters and latency histograms
+    Exporter *exporter;  // Optional Prometheus endpoint (NULL when disabled)
+    AuthPool *auth_pool;  // Password hashing workers
+    ResumeTable *resume_tokens;  // Issued on LOGIN, redeemed by RESUME
+    RateLimiter *rate_limiter;  // Per-IP / per-username admission before any DB work
+    int auth_inflight;  // Jobs submitted to auth_pool and not yet completed
+    PresenceRegistry *presence;  // Who is online; users.is_online is written from here in batches
+    uint64_t next_session_serial;
 } Server;
 
 // Server lifecycle functions
@@ -48,11 +87,16 @@ int server_add_client(Server *server, int socket_fd);
 void server_remove_client(Server *server, int socket_fd);
 ClientSession* server_get_client_by_fd(Server *server, int socket_fd);
 ClientSession* server_get_client_by_username(Server *server, const char *username);
+void server_mark_online(Server *server, ClientSession *client);
+void server_mark_offline(Server *server, ClientSession *client);
+void server_push_presence(Server *server);
 
 // Network I/O
 int server_accept_connection(Server *server);
 int server_receive_data(Server *server, ClientSession *client);
+void server_process_buffered(Server *server, ClientSession *client);
 int server_send_response(ClientSession *client, const char *response);
+int server_flush_send_queue(ClientSession *client);
 int server_broadcast_to_group(Server *server, int group_id, const char *message, int exclude_fd);
 
 // Logging
@@ -67,5 +111,8 @@ void server_handle_client_message(Server *server, ClientSession *client, const c
 void handle_register_command(Server *server, ClientSession *client, ParsedCommand *cmd);
 void handle_login_command(Server *server, ClientSession *client, ParsedCommand *cmd);
 void handle_logout_command(Server *server, ClientSession *client, ParsedCommand *cmd);
+void handle_resume_command(Server *server, ClientSession *client, ParsedCommand *cmd);
+void handle_compress_command(Server *server, ClientSession *client, ParsedCommand *cmd);
+void handle_stats_command(Server *server, ClientSession *client, ParsedCommand *cmd);
 
 #endif
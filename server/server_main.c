@@ -1,7 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <unistd.h>
 #include "server.h"
+#include "exporter.h"
+#include "../common/query_stats.h"
 #include "../database/database.h"
 
 Server *g_server = NULL;
@@ -18,6 +21,10 @@ int main(int argc, char *argv[]) {
     printf("       Chat Server Starting...         \n");
     printf("========================================\n\n");
     
+    // Server logs go through the buffered sink; see common/log.h for levels
+    log_init(STDOUT_FILENO);
+    query_stats_init();
+    
     int port = PORT;
     if (argc > 1) {
         port = atoi(argv[1]);
@@ -33,6 +40,17 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    // Optional metrics endpoint: a localhost TCP port or a Unix socket path
+    const char *metrics_address = argc > 2 ? argv[2] : NULL;
+    if (metrics_address) {
+        g_server->exporter = exporter_create(metrics_address);
+        if (!g_server->exporter) {
+            fprintf(stderr, "Failed to start metrics endpoint on %s\n", metrics_address);
+            server_destroy(g_server);
+            return 1;
+        }
+    }
+    
     signal(SIGINT, signal_handler); 
     signal(SIGTERM, signal_handler); 
     
@@ -42,16 +60,20 @@ int main(int argc, char *argv[]) {
     printf("========================================\n");
     printf("  Port:          %d\n", port);
     printf("  Max Clients:   %d\n", MAX_CLIENTS);
+    printf("  Metrics:       %s\n", metrics_address ? metrics_address : "disabled");
     printf("  Protocol:      Text-based (\\r\\n)\n");
     printf("========================================\n\n");
     
     printf("Waiting for connections...\n");
     printf("Press Ctrl+C to stop the server\n\n");
+    fflush(stdout);
     
     server_run(g_server);
     
     server_destroy(g_server);
     g_server = NULL;
+    query_stats_shutdown();
+    log_shutdown();
     
     printf("\n========================================\n");
     printf("       Server Shutdown Complete        \n");